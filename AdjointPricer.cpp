@@ -0,0 +1,203 @@
+#include "AdjointPricer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <stdexcept>
+
+#include "Bond.h"
+#include "Swap.h"
+#include "EuropeanTrade.h"
+#include "MathUtils.h"
+
+namespace {
+
+// Rate curve lookup shared by the three products: null if missing or empty (Pv returns 0).
+const RateCurve* rateCurveFor(const Market& mkt, const Trade& trade, PvGradient& g,
+                              std::shared_ptr<const RateCurve>& holder) {
+    g.rateCurveName = trade.getRateCurveName();
+    holder = mkt.getCurve(trade.getRateCurveId());
+    if (!holder || holder->isEmpty()) return nullptr;
+    g.rateAdjoints.assign(holder->getCompiled().size(), 0.0);
+    return holder.get();
+}
+
+PvGradient bondAdjoint(const Bond& bond, const Market& mkt) {
+    PvGradient g;
+    g.underlyingName = bond.getUnderlyingName();
+    std::shared_ptr<const RateCurve> holder;
+    const RateCurve* curve = rateCurveFor(mkt, bond, g, holder);
+    const long asOfSerial = mkt.asOf.getSerialDate();
+    if (!(mkt.asOf < bond.getMaturityDate())) {
+        return g; // Matured: Pv is 0 and reads no curve
+    }
+    if (!curve) {
+        g.rateAdjoints.clear();
+        return g;
+    }
+
+    // Forward pass, as Bond::Pv: flows strictly after the valuation date.
+    const std::vector<long>& serials = bond.getCashflowSerials();
+    const std::vector<double>& amounts = bond.getCashflowAmounts();
+    const size_t first = static_cast<size_t>(std::upper_bound(serials.begin(), serials.end(), asOfSerial) - serials.begin());
+    const size_t n = serials.size() - first;
+    std::vector<double> discountFactors(n);
+    curve->getDiscountFactors(asOfSerial, serials.data() + first, discountFactors.data(), n);
+    for (size_t k = 0; k < n; ++k) {
+        g.pv += amounts[first + k] * discountFactors[k];
+    }
+
+    // Backward pass: pv_bar = 1, df = exp(-r T) so r_bar = -T * amount * df.
+    const CompiledCurve& compiled = curve->getCompiled();
+    for (size_t k = 0; k < n; ++k) {
+        const long serial = serials[first + k];
+        const double T = static_cast<double>(serial - asOfSerial) / 365.0;
+        compiled.valueAtAdjoint(serial, -T * amounts[first + k] * discountFactors[k], g.rateAdjoints.data());
+    }
+    return g;
+}
+
+PvGradient swapAdjoint(const Swap& swap, const Market& mkt) {
+    PvGradient g;
+    g.underlyingName = swap.getUnderlyingName();
+    std::shared_ptr<const RateCurve> holder;
+    const RateCurve* curve = rateCurveFor(mkt, swap, g, holder);
+    const std::vector<Date>& schedule = swap.getFixedLegSchedule();
+    if (!(mkt.asOf < swap.getMaturityDate()) || schedule.size() < 2) {
+        return g;
+    }
+    if (!curve) {
+        g.rateAdjoints.clear();
+        return g;
+    }
+
+    const CompiledCurve& compiled = curve->getCompiled();
+    const long asOfSerial = mkt.asOf.getSerialDate();
+    const double notional = swap.getNotional();
+    const double fixedRate = swap.getFixedRate();
+
+    // Same period loop as Swap::Pv; each discount factor has its own adjoint, so both passes
+    // can run together.
+    double fixedLegPv = 0.0;
+    for (size_t i = 1; i < schedule.size(); ++i) {
+        const long periodStart = schedule[i - 1].getSerialDate();
+        const long periodEnd = schedule[i].getSerialDate();
+        if (periodEnd <= asOfSerial) continue;
+
+        const double tau = static_cast<double>(periodEnd - periodStart) / 360.0;
+        if (tau <= 1e-9) continue;
+
+        const double T = static_cast<double>(periodEnd - asOfSerial) / 365.0;
+        const double df = std::exp(-compiled.valueAt(periodEnd) * T);
+        const double fixedCashflow = notional * fixedRate * tau;
+        fixedLegPv += fixedCashflow * df;
+        compiled.valueAtAdjoint(periodEnd, -T * fixedCashflow * df, g.rateAdjoints.data());
+    }
+
+    const long maturity = swap.getMaturityDate().getSerialDate();
+    const double T_maturity = static_cast<double>(maturity - asOfSerial) / 365.0;
+    const double dfMaturity = std::exp(-compiled.valueAt(maturity) * T_maturity);
+    const double floatingLegPv = (-notional) + (notional * dfMaturity);
+    compiled.valueAtAdjoint(maturity, -T_maturity * notional * dfMaturity, g.rateAdjoints.data());
+
+    g.pv = fixedLegPv + floatingLegPv;
+    return g;
+}
+
+PvGradient europeanAdjoint(const EuropeanOption& option, const Market& mkt) {
+    PvGradient g;
+    g.underlyingName = option.getUnderlyingName();
+    g.volCurveName = option.getVolCurveName();
+    std::shared_ptr<const RateCurve> rateHolder;
+    const RateCurve* rateCurve = rateCurveFor(mkt, option, g, rateHolder);
+    std::shared_ptr<const VolCurve> volCurve = mkt.getVolCurve(option.getVolCurveId());
+    if (!rateCurve || !volCurve || volCurve->isEmpty()) {
+        g.rateAdjoints.clear();
+        return g;
+    }
+    g.volAdjoints.assign(volCurve->getCompiled().size(), 0.0);
+
+    const double rawSpot = mkt.getStockPrice(option.getUnderlyingId());
+    const double S = std::max(0.0, rawSpot);
+    const double spotScale = (rawSpot < 0) ? 0.0 : 1.0; // Pv floors S at 0
+    const OptionType type = option.getOptionType();
+    const double K = option.getStrike();
+    const Date& expiry = option.GetExpiry();
+
+    // Expired trades fail here as they do in the pricers, rather than yielding zero adjoints.
+    if (expiry - mkt.asOf < -1e-9) {
+        throw std::runtime_error("Option already expired in adjointPv.");
+    }
+
+    // Each branch mirrors EuropeanOption::Pv and yields the adjoints of its three inputs.
+    double rBar = 0.0, sigmaBar = 0.0, spotBar = 0.0;
+    if (!(mkt.asOf < expiry)) {
+        g.pv = option.Payoff(S);
+        if (type == OptionType::Call && S > K) spotBar = 1.0;
+        if (type == OptionType::Put && K > S) spotBar = -1.0;
+        g.spotAdjoint = spotBar * spotScale;
+        return g;
+    }
+
+    const long expirySerial = expiry.getSerialDate();
+    const double T = (expiry - mkt.asOf);
+    const double r = rateCurve->getCompiled().valueAt(expirySerial);
+    const double sigma = volCurve->getCompiled().valueAt(expirySerial);
+
+    if (S <= 1e-9) {
+        if (type == OptionType::Put && K > 1e-9) {
+            g.pv = K * std::exp(-r * T);
+            rBar = -T * g.pv;
+        }
+    } else if (sigma <= 1e-9) {
+        const double discountedK = K * std::exp(-r * T);
+        if (type == OptionType::Call && S - discountedK > 0.0) {
+            g.pv = S - discountedK;
+            spotBar = 1.0;
+            rBar = T * discountedK;
+        } else if (type == OptionType::Put && discountedK - S > 0.0) {
+            g.pv = discountedK - S;
+            spotBar = -1.0;
+            rBar = -T * discountedK;
+        }
+    } else if (T <= 1e-9) {
+        g.pv = option.Payoff(S);
+    } else if (type == OptionType::Call || type == OptionType::Put) {
+        const BlackScholesGreeks greeks = blackScholesGreeks(type, S, K, T, r, sigma);
+        g.pv = greeks.price;
+        spotBar = greeks.delta;
+        sigmaBar = greeks.vega;
+        rBar = greeks.rho;
+    }
+
+    rateCurve->getCompiled().valueAtAdjoint(expirySerial, rBar, g.rateAdjoints.data());
+    volCurve->getCompiled().valueAtAdjoint(expirySerial, sigmaBar, g.volAdjoints.data());
+    g.spotAdjoint = spotBar * spotScale;
+    return g;
+}
+
+} // namespace
+
+bool supportsAdjoint(const Trade& trade) {
+    switch (trade.getKind()) {
+    case InstrumentKind::Bond:
+    case InstrumentKind::Swap:
+    case InstrumentKind::EuropeanOption:
+        return true;
+    default:
+        return false;
+    }
+}
+
+PvGradient adjointPv(const Trade& trade, const Market& mkt) {
+    switch (trade.getKind()) {
+    case InstrumentKind::Bond:
+        return bondAdjoint(static_cast<const Bond&>(trade), mkt);
+    case InstrumentKind::Swap:
+        return swapAdjoint(static_cast<const Swap&>(trade), mkt);
+    case InstrumentKind::EuropeanOption:
+        return europeanAdjoint(static_cast<const EuropeanOption&>(trade), mkt);
+    default:
+        throw std::invalid_argument("adjointPv: no adjoint for trade type " + trade.getType());
+    }
+}
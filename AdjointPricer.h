@@ -0,0 +1,36 @@
+#ifndef ADJOINT_PRICER_H
+#define ADJOINT_PRICER_H
+
+#include <string>
+#include <vector>
+
+#include "Market.h"
+#include "Trade.h"
+
+// PV of a trade together with its gradient with respect to every pillar of the curves it
+// reads and to the spot of its underlying, from one forward pass (the Pv computation) and
+// one backward pass through it. Gradients are per unit move (1.0 = 100%) of each input.
+struct PvGradient {
+    double pv = 0.0;
+
+    std::string rateCurveName;
+    std::vector<double> rateAdjoints; // dPV / d(rate of pillar j), one entry per pillar
+
+    std::string volCurveName;
+    std::vector<double> volAdjoints;  // dPV / d(vol of pillar j); empty without a vol curve
+
+    std::string underlyingName;
+    double spotAdjoint = 0.0;         // dPV / dS; 0 for trades without a stock underlying
+};
+
+// True for the closed-form products: Bond, Swap and EuropeanOption.
+bool supportsAdjoint(const Trade& trade);
+
+// Adjoint of Bond::Pv, Swap::Pv and EuropeanOption::Pv. pv equals what Pv returns, including
+// its degenerate branches (expiring today, zero vol/spot). A missing or empty curve gives
+// pv = 0 with empty adjoints, without a message (RiskEngine reports missing curves itself).
+// Throws std::invalid_argument for trades without an adjoint (see supportsAdjoint), and
+// std::runtime_error for an option that expired before the market date, as the pricers do.
+PvGradient adjointPv(const Trade& trade, const Market& mkt);
+
+#endif // ADJOINT_PRICER_H
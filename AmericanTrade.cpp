@@ -11,8 +11,11 @@ AmericanOption::AmericanOption()
       strike(0.0),
       expiryDate(Date()), 
       discountCurveName("USD-SOFR"),
-      volatilityCurveName("VOL_CURVE_DEFAULT") {
+      volatilityCurveName("VOL_CURVE_DEFAULT"),
+      discountCurveId(internMarketDataName(discountCurveName)),
+      volatilityCurveId(internMarketDataName(volatilityCurveName)) {
     tradeType = "AmericanOption"; 
+    kind = InstrumentKind::AmericanOption;
 }
 
 AmericanOption::AmericanOption(OptionType optType,
@@ -26,8 +29,11 @@ AmericanOption::AmericanOption(OptionType optType,
       strike(strikePrice),
       expiryDate(expiryDt),
       discountCurveName(discCurveName),
-      volatilityCurveName(volCurveName) {
+      volatilityCurveName(volCurveName),
+      discountCurveId(internMarketDataName(discountCurveName)),
+      volatilityCurveId(internMarketDataName(volatilityCurveName)) {
     tradeType = "AmericanOption"; 
+    kind = InstrumentKind::AmericanOption;
 }
 
 double AmericanOption::Pv([[maybe_unused]] const Market& mkt) const {
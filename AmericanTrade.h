@@ -30,10 +30,12 @@ public:
     
     std::string getRateCurveName() const override { return discountCurveName; }
     std::string getVolCurveName() const override { return volatilityCurveName; }
+    MarketDataId getRateCurveId() const override { return discountCurveId; }
+    MarketDataId getVolCurveId() const override { return volatilityCurveId; }
 
     
-    OptionType getOptionType() const { return optionType; }
-    double getStrike() const { return strike; }
+    OptionType getOptionType() const override { return optionType; }
+    double getStrike() const override { return strike; }
 
 protected:
     OptionType optionType;
@@ -42,6 +44,8 @@ protected:
     
     std::string discountCurveName;
     std::string volatilityCurveName;
+    MarketDataId discountCurveId;
+    MarketDataId volatilityCurveId;
 };
 
 
@@ -0,0 +1,565 @@
+#include "BinarySnapshot.h"
+#include "Instrumentation.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <type_traits>
+
+namespace {
+    constexpr char kMagic[8] = {'P', 'R', 'C', 'S', 'N', 'A', 'P', '\0'};
+    constexpr uint32_t kByteOrderMark = 0x01020304u;
+
+    enum TradeKindCode : uint8_t {
+        kBondCode = 0,
+        kSwapCode = 1,
+        kEuropeanCode = 2,
+        kAmericanCode = 3
+    };
+
+    const char* const kKindTypeNames[] = {"bond", "swap", "european", "american"};
+
+    uint8_t kindCodeFor(const std::string& type) {
+        for (uint8_t code = 0; code < 4; ++code) {
+            if (type == kKindTypeNames[code]) return code;
+        }
+        throw std::invalid_argument("writeBinarySnapshot: unsupported trade type '" + type + "'");
+    }
+}
+
+struct SnapshotArray {
+    uint64_t offset;
+    uint64_t count;
+};
+
+struct BinarySnapshotReader::Header {
+    char magic[8];
+    uint32_t version;
+    uint32_t byteOrder;
+    int64_t asOfSerial;
+    uint32_t marketNameId;
+    uint32_t reserved;
+
+    SnapshotArray stringOffsets; // uint64_t, strings + 1 entries
+    SnapshotArray stringBytes;   // char
+
+    SnapshotArray rateCurveKeys;   // uint32_t string id: name in the market
+    SnapshotArray rateCurveLabels; // uint32_t string id: RateCurve::getName()
+    SnapshotArray rateCurveFirst;  // uint64_t index of the first pillar
+    SnapshotArray rateCurveCount;  // uint64_t pillar count
+    SnapshotArray ratePillarSerials; // int64_t
+    SnapshotArray ratePillarValues;  // double
+
+    SnapshotArray volCurveKeys;
+    SnapshotArray volCurveLabels;
+    SnapshotArray volCurveFirst;
+    SnapshotArray volCurveCount;
+    SnapshotArray volPillarSerials;
+    SnapshotArray volPillarValues;
+
+    SnapshotArray stockNames;  // uint32_t
+    SnapshotArray stockPrices; // double
+    SnapshotArray bondNames;
+    SnapshotArray bondPrices;
+
+    SnapshotArray tradeIds;         // uint32_t
+    SnapshotArray tradeKinds;       // uint8_t TradeKindCode
+    SnapshotArray tradeDates;       // int64_t serials
+    SnapshotArray startDates;
+    SnapshotArray endDates;
+    SnapshotArray notionals;        // double
+    SnapshotArray instruments;      // uint32_t
+    SnapshotArray rates;            // double
+    SnapshotArray strikes;          // double
+    SnapshotArray frequencies;      // int32_t
+    SnapshotArray optionTypes;      // uint8_t OptionType
+    SnapshotArray discountCurves;   // uint32_t
+    SnapshotArray volCurves;        // uint32_t
+    SnapshotArray floatCurves;      // uint32_t
+};
+
+static_assert(std::is_trivially_copyable<BinarySnapshotReader::Header>::value, "Header is written with memcpy");
+
+namespace {
+    // Append-only image of the file; arrays are placed at 8-byte aligned offsets.
+    class SnapshotBuffer {
+    public:
+        SnapshotBuffer() : bytes(sizeof(BinarySnapshotReader::Header), 0) {}
+
+        template <typename T>
+        SnapshotArray append(const std::vector<T>& values) {
+            static_assert(std::is_trivially_copyable<T>::value, "snapshot columns must be plain data");
+            bytes.resize((bytes.size() + 7) & ~size_t(7), 0);
+            SnapshotArray ref{static_cast<uint64_t>(bytes.size()), static_cast<uint64_t>(values.size())};
+            if (!values.empty()) {
+                const size_t n = values.size() * sizeof(T);
+                bytes.resize(bytes.size() + n);
+                std::memcpy(bytes.data() + ref.offset, values.data(), n);
+            }
+            return ref;
+        }
+
+        void setHeader(const BinarySnapshotReader::Header& header) {
+            std::memcpy(bytes.data(), &header, sizeof(header));
+        }
+
+        const std::vector<char>& data() const { return bytes; }
+
+    private:
+        std::vector<char> bytes;
+    };
+
+    class StringTable {
+    public:
+        uint32_t idOf(const std::string& s) {
+            auto it = ids.find(s);
+            if (it != ids.end()) return it->second;
+            const uint32_t id = static_cast<uint32_t>(list.size());
+            ids.emplace(s, id);
+            list.push_back(s);
+            return id;
+        }
+
+        void write(SnapshotBuffer& buffer, SnapshotArray& offsetsRef, SnapshotArray& bytesRef) const {
+            std::vector<uint64_t> offsets;
+            std::vector<char> blob;
+            offsets.reserve(list.size() + 1);
+            for (const std::string& s : list) {
+                offsets.push_back(blob.size());
+                blob.insert(blob.end(), s.begin(), s.end());
+            }
+            offsets.push_back(blob.size());
+            offsetsRef = buffer.append(offsets);
+            bytesRef = buffer.append(blob);
+        }
+
+    private:
+        std::unordered_map<std::string, uint32_t> ids;
+        std::vector<std::string> list;
+    };
+
+    void appendCurve(const std::string& key, const std::string& label,
+                     const std::vector<Date>& pillars, const std::vector<double>& pillarValues,
+                     StringTable& strings,
+                     std::vector<uint32_t>& keys, std::vector<uint32_t>& labels,
+                     std::vector<uint64_t>& first, std::vector<uint64_t>& count,
+                     std::vector<int64_t>& serials, std::vector<double>& values) {
+        keys.push_back(strings.idOf(key));
+        labels.push_back(strings.idOf(label));
+        first.push_back(serials.size());
+        count.push_back(pillars.size());
+        for (size_t i = 0; i < pillars.size(); ++i) {
+            serials.push_back(pillars[i].getSerialDate());
+            values.push_back(pillarValues[i]);
+        }
+    }
+}
+
+void writeBinarySnapshot(const std::string& filePath, const Market& market, const std::vector<TradeRecord>& trades) {
+    if (market.isOverlay()) {
+        throw std::invalid_argument("writeBinarySnapshot: cannot snapshot an overlay market; copy it into a full market first.");
+    }
+    BinarySnapshotReader::Header header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, kMagic, sizeof(kMagic));
+    header.version = kBinarySnapshotVersion;
+    header.byteOrder = kByteOrderMark;
+    header.asOfSerial = market.asOf.getSerialDate();
+
+    StringTable strings;
+    SnapshotBuffer buffer;
+    header.marketNameId = strings.idOf(market.name);
+
+    {
+        std::vector<uint32_t> keys, labels;
+        std::vector<uint64_t> first, count;
+        std::vector<int64_t> serials;
+        std::vector<double> values;
+        for (const std::string& key : market.getCurveNames()) {
+            const std::shared_ptr<const RateCurve> curve = market.getCurve(key);
+            appendCurve(key, curve->getName(), curve->getTenorDates(), curve->getRates(),
+                        strings, keys, labels, first, count, serials, values);
+        }
+        header.rateCurveKeys = buffer.append(keys);
+        header.rateCurveLabels = buffer.append(labels);
+        header.rateCurveFirst = buffer.append(first);
+        header.rateCurveCount = buffer.append(count);
+        header.ratePillarSerials = buffer.append(serials);
+        header.ratePillarValues = buffer.append(values);
+    }
+    {
+        std::vector<uint32_t> keys, labels;
+        std::vector<uint64_t> first, count;
+        std::vector<int64_t> serials;
+        std::vector<double> values;
+        for (const std::string& key : market.getVolCurveNames()) {
+            const std::shared_ptr<const VolCurve> curve = market.getVolCurve(key);
+            appendCurve(key, curve->getName(), curve->getTenors(), curve->getVols(),
+                        strings, keys, labels, first, count, serials, values);
+        }
+        header.volCurveKeys = buffer.append(keys);
+        header.volCurveLabels = buffer.append(labels);
+        header.volCurveFirst = buffer.append(first);
+        header.volCurveCount = buffer.append(count);
+        header.volPillarSerials = buffer.append(serials);
+        header.volPillarValues = buffer.append(values);
+    }
+
+    auto appendPrices = [&](const std::unordered_map<std::string, double>& prices,
+                            SnapshotArray& namesRef, SnapshotArray& valuesRef) {
+        std::vector<std::string> sorted;
+        for (const auto& pair : prices) sorted.push_back(pair.first);
+        std::sort(sorted.begin(), sorted.end()); // Deterministic files for identical input
+        std::vector<uint32_t> names;
+        std::vector<double> values;
+        for (const std::string& n : sorted) {
+            names.push_back(strings.idOf(n));
+            values.push_back(prices.at(n));
+        }
+        namesRef = buffer.append(names);
+        valuesRef = buffer.append(values);
+    };
+    appendPrices(market.getStockPrices(), header.stockNames, header.stockPrices);
+    appendPrices(market.getBondPrices(), header.bondNames, header.bondPrices);
+
+    {
+        const size_t n = trades.size();
+        std::vector<uint32_t> ids(n), instruments(n), discountCurves(n), volCurves(n), floatCurves(n);
+        std::vector<uint8_t> kinds(n), optionTypes(n);
+        std::vector<int64_t> tradeDates(n), startDates(n), endDates(n);
+        std::vector<double> notionals(n), rates(n), strikes(n);
+        std::vector<int32_t> frequencies(n);
+        for (size_t i = 0; i < n; ++i) {
+            const TradeRecord& r = trades[i];
+            ids[i] = strings.idOf(r.id);
+            kinds[i] = kindCodeFor(r.type);
+            tradeDates[i] = r.tradeDate.getSerialDate();
+            startDates[i] = r.startDate.getSerialDate();
+            endDates[i] = r.endDate.getSerialDate();
+            notionals[i] = r.notional;
+            instruments[i] = strings.idOf(r.instrument);
+            rates[i] = r.rate;
+            strikes[i] = r.strike;
+            frequencies[i] = r.frequency;
+            optionTypes[i] = static_cast<uint8_t>(r.optionType);
+            discountCurves[i] = strings.idOf(r.discountCurve);
+            volCurves[i] = strings.idOf(r.volCurve);
+            floatCurves[i] = strings.idOf(r.floatCurve);
+        }
+        header.tradeIds = buffer.append(ids);
+        header.tradeKinds = buffer.append(kinds);
+        header.tradeDates = buffer.append(tradeDates);
+        header.startDates = buffer.append(startDates);
+        header.endDates = buffer.append(endDates);
+        header.notionals = buffer.append(notionals);
+        header.instruments = buffer.append(instruments);
+        header.rates = buffer.append(rates);
+        header.strikes = buffer.append(strikes);
+        header.frequencies = buffer.append(frequencies);
+        header.optionTypes = buffer.append(optionTypes);
+        header.discountCurves = buffer.append(discountCurves);
+        header.volCurves = buffer.append(volCurves);
+        header.floatCurves = buffer.append(floatCurves);
+    }
+
+    strings.write(buffer, header.stringOffsets, header.stringBytes);
+    buffer.setHeader(header);
+
+    // Write to a temporary name and rename, so readers never map a half-written file.
+    const std::string tmpPath = filePath + ".tmp";
+    {
+        std::ofstream out(tmpPath, std::ios::binary | std::ios::trunc);
+        if (!out.is_open()) {
+            throw std::runtime_error("writeBinarySnapshot: could not open '" + tmpPath + "' for writing.");
+        }
+        out.write(buffer.data().data(), static_cast<std::streamsize>(buffer.data().size()));
+        if (!out) {
+            throw std::runtime_error("writeBinarySnapshot: write to '" + tmpPath + "' failed.");
+        }
+    }
+    std::remove(filePath.c_str());
+    if (std::rename(tmpPath.c_str(), filePath.c_str()) != 0) {
+        throw std::runtime_error("writeBinarySnapshot: could not rename '" + tmpPath + "' to '" + filePath + "'.");
+    }
+}
+
+namespace {
+    template <typename T>
+    const T* column(const MappedFile& file, const SnapshotArray& ref) {
+        return reinterpret_cast<const T*>(file.data() + ref.offset);
+    }
+
+    template <typename T>
+    void checkColumn(const MappedFile& file, const SnapshotArray& ref, const char* what) {
+        const uint64_t size = file.size();
+        if (ref.offset % alignof(T) != 0 || ref.offset > size || ref.count > (size - ref.offset) / sizeof(T)) {
+            throw std::runtime_error(std::string("Binary snapshot: array '") + what + "' lies outside the file.");
+        }
+    }
+
+    // Every date serial in [from, from + count) is one Date::setFromSerial accepts.
+    bool serialsInRange(const int64_t* from, uint64_t count) {
+        for (uint64_t i = 0; i < count; ++i) {
+            if (from[i] < 1 || from[i] > Date::kMaxSerial) return false;
+        }
+        return true;
+    }
+
+    void checkCount(const SnapshotArray& ref, uint64_t expected, const char* what) {
+        if (ref.count != expected) {
+            throw std::runtime_error(std::string("Binary snapshot: array '") + what + "' has the wrong length.");
+        }
+    }
+}
+
+bool BinarySnapshotReader::open(const std::string& filePath) {
+    PRICING_SCOPED_TIMER(LoadSnapshot);
+    PRICING_COUNT(FileLoads, 1);
+    header = nullptr;
+    strings.clear();
+    if (!file.open(filePath)) {
+        return false;
+    }
+    if (file.size() < sizeof(Header)) {
+        throw std::runtime_error("Binary snapshot: '" + filePath + "' is too small to be a snapshot.");
+    }
+    const Header* h = reinterpret_cast<const Header*>(file.data());
+    if (std::memcmp(h->magic, kMagic, sizeof(kMagic)) != 0) {
+        throw std::runtime_error("Binary snapshot: '" + filePath + "' has no snapshot signature.");
+    }
+    if (h->byteOrder != kByteOrderMark) {
+        throw std::runtime_error("Binary snapshot: '" + filePath + "' was written with a different byte order.");
+    }
+    if (h->version != kBinarySnapshotVersion) {
+        throw std::runtime_error("Binary snapshot: '" + filePath + "' is version " + std::to_string(h->version) +
+                                 ", expected " + std::to_string(kBinarySnapshotVersion) + ". Rebuild it from the text files.");
+    }
+
+    checkColumn<uint64_t>(file, h->stringOffsets, "stringOffsets");
+    checkColumn<char>(file, h->stringBytes, "stringBytes");
+    if (h->stringOffsets.count == 0) {
+        throw std::runtime_error("Binary snapshot: empty string table.");
+    }
+    const uint64_t* offsets = column<uint64_t>(file, h->stringOffsets);
+    const char* blob = column<char>(file, h->stringBytes);
+    strings.reserve(h->stringOffsets.count - 1);
+    for (uint64_t i = 0; i + 1 < h->stringOffsets.count; ++i) {
+        if (offsets[i] > offsets[i + 1] || offsets[i + 1] > h->stringBytes.count) {
+            throw std::runtime_error("Binary snapshot: corrupt string table.");
+        }
+        strings.emplace_back(blob + offsets[i], offsets[i + 1] - offsets[i]);
+    }
+
+    auto checkCurves = [&](const SnapshotArray& keys, const SnapshotArray& labels, const SnapshotArray& first,
+                           const SnapshotArray& count, const SnapshotArray& serials, const SnapshotArray& values) {
+        checkColumn<uint32_t>(file, keys, "curveKeys");
+        checkColumn<uint32_t>(file, labels, "curveLabels");
+        checkColumn<uint64_t>(file, first, "curveFirst");
+        checkColumn<uint64_t>(file, count, "curveCount");
+        checkColumn<int64_t>(file, serials, "pillarSerials");
+        checkColumn<double>(file, values, "pillarValues");
+        checkCount(labels, keys.count, "curveLabels");
+        checkCount(first, keys.count, "curveFirst");
+        checkCount(count, keys.count, "curveCount");
+        checkCount(values, serials.count, "pillarValues");
+        const uint64_t* f = column<uint64_t>(file, first);
+        const uint64_t* c = column<uint64_t>(file, count);
+        for (uint64_t i = 0; i < keys.count; ++i) {
+            if (f[i] > serials.count || c[i] > serials.count - f[i]) {
+                throw std::runtime_error("Binary snapshot: curve pillars out of range.");
+            }
+        }
+    };
+    checkCurves(h->rateCurveKeys, h->rateCurveLabels, h->rateCurveFirst, h->rateCurveCount,
+                h->ratePillarSerials, h->ratePillarValues);
+    checkCurves(h->volCurveKeys, h->volCurveLabels, h->volCurveFirst, h->volCurveCount,
+                h->volPillarSerials, h->volPillarValues);
+
+    checkColumn<uint32_t>(file, h->stockNames, "stockNames");
+    checkColumn<double>(file, h->stockPrices, "stockPrices");
+    checkCount(h->stockPrices, h->stockNames.count, "stockPrices");
+    checkColumn<uint32_t>(file, h->bondNames, "bondNames");
+    checkColumn<double>(file, h->bondPrices, "bondPrices");
+    checkCount(h->bondPrices, h->bondNames.count, "bondPrices");
+
+    const uint64_t n = h->tradeIds.count;
+    checkColumn<uint32_t>(file, h->tradeIds, "tradeIds");
+    checkColumn<uint8_t>(file, h->tradeKinds, "tradeKinds");
+    checkColumn<int64_t>(file, h->tradeDates, "tradeDates");
+    checkColumn<int64_t>(file, h->startDates, "startDates");
+    checkColumn<int64_t>(file, h->endDates, "endDates");
+    checkColumn<double>(file, h->notionals, "notionals");
+    checkColumn<uint32_t>(file, h->instruments, "instruments");
+    checkColumn<double>(file, h->rates, "rates");
+    checkColumn<double>(file, h->strikes, "strikes");
+    checkColumn<int32_t>(file, h->frequencies, "frequencies");
+    checkColumn<uint8_t>(file, h->optionTypes, "optionTypes");
+    checkColumn<uint32_t>(file, h->discountCurves, "discountCurves");
+    checkColumn<uint32_t>(file, h->volCurves, "volCurves");
+    checkColumn<uint32_t>(file, h->floatCurves, "floatCurves");
+    const SnapshotArray* tradeColumns[] = {&h->tradeKinds, &h->tradeDates, &h->startDates, &h->endDates,
+                                           &h->notionals, &h->instruments, &h->rates, &h->strikes,
+                                           &h->frequencies, &h->optionTypes, &h->discountCurves,
+                                           &h->volCurves, &h->floatCurves};
+    for (const SnapshotArray* ref : tradeColumns) {
+        checkCount(*ref, n, "trade column");
+    }
+
+    // A corrupt serial would otherwise only surface when the dates are built.
+    const SnapshotArray* serialColumns[] = {&h->ratePillarSerials, &h->volPillarSerials, &h->tradeDates,
+                                            &h->startDates, &h->endDates};
+    bool datesValid = serialsInRange(&h->asOfSerial, 1);
+    for (const SnapshotArray* ref : serialColumns) {
+        datesValid = datesValid && serialsInRange(column<int64_t>(file, *ref), ref->count);
+    }
+    if (!datesValid) {
+        std::cerr << "Error: Binary snapshot '" << filePath << "' holds a date serial outside [1, "
+                  << Date::kMaxSerial << "]." << std::endl;
+        strings.clear();
+        return false;
+    }
+
+    header = h;
+    return true;
+}
+
+const std::string& BinarySnapshotReader::stringAt(uint32_t id) const {
+    if (id >= strings.size()) {
+        throw std::runtime_error("Binary snapshot: string id out of range.");
+    }
+    return strings[id];
+}
+
+Date BinarySnapshotReader::getAsOf() const {
+    if (!header) throw std::logic_error("BinarySnapshotReader: no snapshot open.");
+    Date d;
+    d.setFromSerial(static_cast<long>(header->asOfSerial));
+    return d;
+}
+
+size_t BinarySnapshotReader::getTradeCount() const {
+    return header ? static_cast<size_t>(header->tradeIds.count) : 0;
+}
+
+Market BinarySnapshotReader::buildMarket() const {
+    if (!header) throw std::logic_error("BinarySnapshotReader: no snapshot open.");
+    Market market(getAsOf(), stringAt(header->marketNameId));
+
+    auto pillarDates = [](const int64_t* serials, uint64_t count) {
+        std::vector<Date> dates(count);
+        for (uint64_t k = 0; k < count; ++k) dates[k].setFromSerial(static_cast<long>(serials[k]));
+        return dates;
+    };
+
+    {
+        const uint32_t* keys = column<uint32_t>(file, header->rateCurveKeys);
+        const uint32_t* labels = column<uint32_t>(file, header->rateCurveLabels);
+        const uint64_t* first = column<uint64_t>(file, header->rateCurveFirst);
+        const uint64_t* count = column<uint64_t>(file, header->rateCurveCount);
+        const int64_t* serials = column<int64_t>(file, header->ratePillarSerials);
+        const double* values = column<double>(file, header->ratePillarValues);
+        for (uint64_t i = 0; i < header->rateCurveKeys.count; ++i) {
+            auto curve = std::make_shared<RateCurve>(stringAt(labels[i]));
+            curve->setPillars(pillarDates(serials + first[i], count[i]),
+                              std::vector<double>(values + first[i], values + first[i] + count[i]));
+            market.addCurve(stringAt(keys[i]), curve);
+        }
+    }
+    {
+        const uint32_t* keys = column<uint32_t>(file, header->volCurveKeys);
+        const uint32_t* labels = column<uint32_t>(file, header->volCurveLabels);
+        const uint64_t* first = column<uint64_t>(file, header->volCurveFirst);
+        const uint64_t* count = column<uint64_t>(file, header->volCurveCount);
+        const int64_t* serials = column<int64_t>(file, header->volPillarSerials);
+        const double* values = column<double>(file, header->volPillarValues);
+        for (uint64_t i = 0; i < header->volCurveKeys.count; ++i) {
+            auto curve = std::make_shared<VolCurve>(stringAt(labels[i]));
+            curve->setPillars(pillarDates(serials + first[i], count[i]),
+                              std::vector<double>(values + first[i], values + first[i] + count[i]));
+            market.addVolCurve(stringAt(keys[i]), curve);
+        }
+    }
+
+    const uint32_t* stockNames = column<uint32_t>(file, header->stockNames);
+    const double* stockPrices = column<double>(file, header->stockPrices);
+    for (uint64_t i = 0; i < header->stockNames.count; ++i) {
+        market.addStockPrice(stringAt(stockNames[i]), stockPrices[i]);
+    }
+    const uint32_t* bondNames = column<uint32_t>(file, header->bondNames);
+    const double* bondPrices = column<double>(file, header->bondPrices);
+    for (uint64_t i = 0; i < header->bondNames.count; ++i) {
+        market.addBondPrice(stringAt(bondNames[i]), bondPrices[i]);
+    }
+    return market;
+}
+
+TradeRecord BinarySnapshotReader::recordAt(size_t i, DateCache& dates) const {
+    auto dateFor = [&dates](int64_t serial) {
+        auto it = dates.find(serial);
+        if (it == dates.end()) {
+            Date d;
+            d.setFromSerial(static_cast<long>(serial));
+            it = dates.emplace(serial, d).first;
+        }
+        return it->second;
+    };
+    const uint8_t kind = column<uint8_t>(file, header->tradeKinds)[i];
+    if (kind > kAmericanCode) {
+        throw std::runtime_error("Binary snapshot: unknown trade kind code " + std::to_string(kind));
+    }
+    TradeRecord r;
+    r.lineNumber = 0; // Not from a text file
+    r.id = stringAt(column<uint32_t>(file, header->tradeIds)[i]);
+    r.type = kKindTypeNames[kind];
+    r.tradeDate = dateFor(column<int64_t>(file, header->tradeDates)[i]);
+    r.startDate = dateFor(column<int64_t>(file, header->startDates)[i]);
+    r.endDate = dateFor(column<int64_t>(file, header->endDates)[i]);
+    r.notional = column<double>(file, header->notionals)[i];
+    r.instrument = stringAt(column<uint32_t>(file, header->instruments)[i]);
+    r.rate = column<double>(file, header->rates)[i];
+    r.strike = column<double>(file, header->strikes)[i];
+    r.frequency = column<int32_t>(file, header->frequencies)[i];
+    r.optionType = static_cast<OptionType>(column<uint8_t>(file, header->optionTypes)[i]);
+    r.discountCurve = stringAt(column<uint32_t>(file, header->discountCurves)[i]);
+    r.volCurve = stringAt(column<uint32_t>(file, header->volCurves)[i]);
+    r.floatCurve = stringAt(column<uint32_t>(file, header->floatCurves)[i]);
+    return r;
+}
+
+std::vector<TradeRecord> BinarySnapshotReader::readTradeRecords() const {
+    if (!header) throw std::logic_error("BinarySnapshotReader: no snapshot open.");
+    std::vector<TradeRecord> records;
+    records.reserve(getTradeCount());
+    DateCache dates;
+    for (size_t i = 0; i < getTradeCount(); ++i) {
+        records.push_back(recordAt(i, dates));
+    }
+    return records;
+}
+
+void BinarySnapshotReader::buildPortfolio(std::vector<std::shared_ptr<Trade>>& portfolio,
+                                          TradeFactory& bondFactory,
+                                          TradeFactory& swapFactory,
+                                          TradeFactory& euroOptFactory,
+                                          TradeFactory& amerOptFactory,
+                                          ThreadPool* pool) const {
+    if (!header) throw std::logic_error("BinarySnapshotReader: no snapshot open.");
+    const size_t n = getTradeCount();
+    const size_t first = portfolio.size();
+    portfolio.resize(first + n);
+    auto buildRange = [&](size_t begin, size_t end, size_t) {
+        DateCache dates;
+        for (size_t i = begin; i < end; ++i) {
+            portfolio[first + i] = buildTradeFromRecord(recordAt(i, dates), bondFactory, swapFactory,
+                                                        euroOptFactory, amerOptFactory);
+        }
+    };
+    if (pool) {
+        pool->parallelFor(n, 1024, buildRange);
+    } else {
+        buildRange(0, n, 0);
+    }
+}
@@ -0,0 +1,77 @@
+#ifndef BINARY_SNAPSHOT_H
+#define BINARY_SNAPSHOT_H
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+
+#include "Market.h"
+#include "Trade.h"
+#include "TradeFactory.h"
+#include "TradeLoader.h"
+#include "ThreadPool.h"
+#include "MappedFile.h"
+
+// Versioned binary image of a Market plus a portfolio, meant to be memory-mapped.
+// Text files stay the source of truth; a snapshot is a cache built from them (see
+// tools/SnapshotTool.cpp) for runs that reload the same data many times.
+//
+// Layout (native byte order, checked on open; every array 8-byte aligned):
+//   header     magic "PRCSNAP", version, byte-order mark, as-of serial, and an
+//              {offset, count} reference for each array below
+//   strings    uint64 offsets[n + 1] into one char blob; all names are string ids
+//   curves     per curve: name id, first pillar, pillar count; pillars as two columns
+//              (int64 serials, double values), separately for rate and vol curves
+//   prices     stock and bond prices as (name id, double) columns
+//   trades     one column per TradeRecord field (ids, kind, serial dates, notional,
+//              instrument, rate, strike, frequency, option type, curve names)
+constexpr uint32_t kBinarySnapshotVersion = 1;
+
+// Writes market (which must not be an overlay) and trades to filePath.
+// Throws std::invalid_argument for an overlay market and std::runtime_error on I/O failure.
+void writeBinarySnapshot(const std::string& filePath, const Market& market, const std::vector<TradeRecord>& trades);
+
+class BinarySnapshotReader {
+public:
+    BinarySnapshotReader() = default;
+
+    // Maps the file and validates its header, array bounds and date serials. Returns false if
+    // the file cannot be opened or holds a date outside [1, Date::kMaxSerial]; throws
+    // std::runtime_error if it is not a valid snapshot of this version.
+    bool open(const std::string& filePath);
+    bool isOpen() const { return header != nullptr; }
+
+    Date getAsOf() const;
+    size_t getTradeCount() const;
+
+    // Rebuilds the market: one setPillars per curve straight from the pillar columns.
+    Market buildMarket() const;
+
+    std::vector<TradeRecord> readTradeRecords() const;
+
+    // Appends the snapshot's trades to portfolio through the factories, in parallel over
+    // 'pool' when given (factories must then be safe to call concurrently).
+    void buildPortfolio(std::vector<std::shared_ptr<Trade>>& portfolio,
+                        TradeFactory& bondFactory,
+                        TradeFactory& swapFactory,
+                        TradeFactory& euroOptFactory,
+                        TradeFactory& amerOptFactory,
+                        ThreadPool* pool = nullptr) const;
+
+    struct Header; // Defined in BinarySnapshot.cpp
+
+private:
+    using DateCache = std::unordered_map<int64_t, Date>;
+
+    const std::string& stringAt(uint32_t id) const;
+    TradeRecord recordAt(size_t i, DateCache& dates) const;
+
+    MappedFile file;
+    const Header* header = nullptr;
+    std::vector<std::string> strings; // Decoded once on open; names are few and short
+};
+
+#endif // BINARY_SNAPSHOT_H
@@ -0,0 +1,293 @@
+#include "BinomialLattice.h"
+#include "TreeProduct.h"
+#include "EuropeanTrade.h"
+#include "AmericanTrade.h"
+#include "Instrumentation.h"
+#include "MathUtils.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+#include <typeinfo>
+
+void LatticeWorkspace::reserve(int nSteps) {
+    const size_t nodes = static_cast<size_t>(nSteps) + 1;
+    if (values.size() < nodes) {
+        values.resize(nodes);
+        upPowers.resize(nodes);
+        downPowers.resize(nodes);
+    }
+}
+
+LatticeWorkspace& LatticeWorkspace::forThisThread() {
+    static thread_local LatticeWorkspace workspace;
+    return workspace;
+}
+
+void buildSpotPowers(const TreeParams& params, LatticeWorkspace& ws) {
+    ws.reserve(params.N);
+    double* up = ws.upPowers.data();
+    double* down = ws.downPowers.data();
+    up[0] = 1.0;
+    down[0] = 1.0;
+    for (int k = 1; k <= params.N; ++k) {
+        up[k] = up[k - 1] * params.u;
+        down[k] = down[k - 1] * params.d;
+    }
+}
+
+namespace {
+
+// Node rules for latticeInduction: the terminal payoff and, where kExercises, the value at
+// an interior node given its continuation value.
+
+// Calls back into the product, so any TreeProduct can be priced.
+struct ProductRule {
+    static constexpr bool kExercises = true;
+    const TreeProduct& product;
+    double payoff(double S) const { return product.Payoff(S); }
+    double atNode(double S, double t, double continuation) const { return product.ValueAtNode(S, t, continuation); }
+};
+
+// PAYOFF::VanillaOption with the option type fixed at compile time.
+template <OptionType Type>
+inline double vanillaPayoff(double strike, double S);
+template <>
+inline double vanillaPayoff<Call>(double strike, double S) { return S > strike ? S - strike : 0.0; }
+template <>
+inline double vanillaPayoff<Put>(double strike, double S) { return S < strike ? strike - S : 0.0; }
+template <>
+inline double vanillaPayoff<BinaryCall>(double strike, double S) { return S >= strike ? 1.0 : 0.0; }
+template <>
+inline double vanillaPayoff<BinaryPut>(double strike, double S) { return S <= strike ? 1.0 : 0.0; }
+
+// EuropeanOption/AmericanOption::ValueAtNode, inlined. Europeans keep the continuation
+// value, so the exercise pass is compiled out.
+template <OptionType Type, bool American>
+struct VanillaRule {
+    static constexpr bool kExercises = American;
+    double strike;
+    double payoff(double S) const { return vanillaPayoff<Type>(strike, S); }
+    double atNode(double S, double, double continuation) const {
+        const double exercise = payoff(S);
+        return (exercise < continuation) ? continuation : exercise; // std::max(exercise, continuation)
+    }
+};
+
+template <typename Rule>
+double latticeInduction(const TreeParams& params, double S0, const Rule& rule, LatticeWorkspace& ws,
+                        TreeGreeks* greeks, const LastStepClosedForm* lastStep) {
+    const int N = params.N;
+    buildSpotPowers(params, ws);
+    double* V = ws.values.data();
+    const double* up = ws.upPowers.data();
+    const double* down = ws.downPowers.data();
+
+    // Level 2 values, kept for gamma/theta once level 1 has overwritten them.
+    double v20 = 0.0, v21 = 0.0, v22 = 0.0;
+    double s20 = 0.0, s21 = 0.0, s22 = 0.0;
+    double v10 = 0.0, v11 = 0.0;
+    auto keepForGreeks = [&](int i) {
+        if (greeks && i == 2) {
+            v20 = V[0]; v21 = V[1]; v22 = V[2];
+            s20 = S0 * down[2]; s21 = S0 * up[1] * down[1]; s22 = S0 * up[2];
+        } else if (greeks && i == 1) {
+            v10 = V[0]; v11 = V[1];
+        }
+    };
+
+    int firstLevel = N - 1; // Highest level reached by backward induction
+    if (lastStep) {
+        // Level N-1 from the one-step Black-Scholes price at each node
+        PRICING_COUNT(LatticeNodes, static_cast<uint64_t>(N) * static_cast<uint64_t>(N + 1) / 2);
+        if (N <= 2) {
+            // Short trees read greeks off the terminal level, which the closed form skips.
+            for (int j = 0; j <= N; ++j) V[j] = rule.payoff(S0 * up[j] * down[N - j]);
+            keepForGreeks(N);
+        }
+        const int i = N - 1;
+        const double t = i * params.deltaT;
+        for (int j = 0; j <= i; ++j) {
+            const double S = S0 * up[j] * down[i - j];
+            const double continuation = blackScholesPrice(lastStep->type, S, lastStep->strike, params.deltaT,
+                                                          params.rate, params.vol);
+            V[j] = Rule::kExercises ? rule.atNode(S, t, continuation) : continuation;
+        }
+        keepForGreeks(i);
+        firstLevel = N - 2;
+    } else {
+        PRICING_COUNT(LatticeNodes, static_cast<uint64_t>(N + 1) * static_cast<uint64_t>(N + 2) / 2);
+        // Initialize values at expiry (time N); j is the number of up steps
+        for (int j = 0; j <= N; ++j) {
+            V[j] = rule.payoff(S0 * up[j] * down[N - j]);
+        }
+        keepForGreeks(N); // Levels 1 and 2 are terminal on one- and two-step trees
+    }
+
+    const double discUp = params.df_step * params.p_up;
+    const double discDown = params.df_step * params.p_down;
+
+    // Backward induction
+    for (int i = firstLevel; i >= 0; --i) {
+        // Discounted expectation; V[j + 1] is read before it is overwritten.
+        for (int j = 0; j <= i; ++j) {
+            V[j] = discUp * V[j + 1] + discDown * V[j];
+        }
+        if constexpr (Rule::kExercises) {
+            const double t = i * params.deltaT;
+            for (int j = 0; j <= i; ++j) {
+                V[j] = rule.atNode(S0 * up[j] * down[i - j], t, V[j]);
+            }
+        }
+        keepForGreeks(i);
+    }
+
+    if (greeks) {
+        *greeks = TreeGreeks();
+        greeks->pv = V[0];
+        const double s10 = S0 * down[1];
+        const double s11 = S0 * up[1];
+        if (s11 > s10) {
+            greeks->delta = (v11 - v10) / (s11 - s10);
+        }
+        if (N >= 2 && s22 > s21 && s21 > s20) {
+            const double deltaUp = (v22 - v21) / (s22 - s21);
+            const double deltaDown = (v21 - v20) / (s21 - s20);
+            greeks->gamma = (deltaUp - deltaDown) / (0.5 * (s22 - s20));
+            // The middle node at level 2 sits at S0 for CRR (u * d == 1); for other trees
+            // (e.g. Leisen-Reimer) its value is first moved back to S0 along the level-2 delta.
+            double v21AtSpot = v21;
+            if (std::abs(s21 - S0) > 1e-12 * S0) {
+                v21AtSpot -= (v22 - v20) / (s22 - s20) * (s21 - S0);
+            }
+            greeks->theta = (v21AtSpot - V[0]) / (2.0 * params.deltaT);
+        }
+    }
+    return V[0];
+}
+
+template <bool American>
+double priceVanilla(const TreeParams& params, double S0, const LatticeOption& option, LatticeWorkspace& ws,
+                    TreeGreeks* greeks, const LastStepClosedForm* lastStep) {
+    switch (option.type) {
+    case Call: return latticeInduction(params, S0, VanillaRule<Call, American>{option.strike}, ws, greeks, lastStep);
+    case Put: return latticeInduction(params, S0, VanillaRule<Put, American>{option.strike}, ws, greeks, lastStep);
+    case BinaryCall:
+        return latticeInduction(params, S0, VanillaRule<BinaryCall, American>{option.strike}, ws, greeks, lastStep);
+    case BinaryPut:
+        return latticeInduction(params, S0, VanillaRule<BinaryPut, American>{option.strike}, ws, greeks, lastStep);
+    case None: break;
+    }
+    throw std::invalid_argument("priceOptionOnLattice: option type has no payoff.");
+}
+
+} // namespace
+
+double priceOnLattice(const TreeParams& params, double S0, const TreeProduct& product, LatticeWorkspace& ws,
+                      TreeGreeks* greeks, const LastStepClosedForm* lastStep) {
+    return latticeInduction(params, S0, ProductRule{product}, ws, greeks, lastStep);
+}
+
+bool latticeOptionFor(const TreeProduct& product, LatticeOption& option) {
+    // The exact classes only: a subclass may override Payoff or ValueAtNode, which the kernels inline.
+    const std::type_info& dynamicType = typeid(product);
+    const bool american = dynamicType == typeid(AmericanOption);
+    if (!american && dynamicType != typeid(EuropeanOption)) return false;
+    const OptionType type = product.getOptionType();
+    if (type != Call && type != Put && type != BinaryCall && type != BinaryPut) return false;
+    option.exercise = american ? ExerciseStyle::American : ExerciseStyle::European;
+    option.type = type;
+    option.strike = product.getStrike();
+    return true;
+}
+
+double priceOptionOnLattice(const TreeParams& params, double S0, const LatticeOption& option, LatticeWorkspace& ws,
+                            TreeGreeks* greeks, const LastStepClosedForm* lastStep) {
+    if (option.exercise == ExerciseStyle::American) {
+        return priceVanilla<true>(params, S0, option, ws, greeks, lastStep);
+    }
+    return priceVanilla<false>(params, S0, option, ws, greeks, lastStep);
+}
+
+void priceStripOnLattice(const TreeParams& params, double S0, const StripLane* lanes, size_t count,
+                         LatticeWorkspace& ws, double* pvs, bool closedFormLastStep) {
+    const int N = params.N;
+    const size_t L = (count + kStripLaneWidth - 1) / kStripLaneWidth * kStripLaneWidth;
+    buildSpotPowers(params, ws);
+    const size_t nodes = static_cast<size_t>(N) + 1;
+    if (ws.laneValues.size() < nodes * L) ws.laneValues.resize(nodes * L);
+    if (ws.laneParams.size() < 3 * L) ws.laneParams.resize(3 * L);
+    double* V = ws.laneValues.data();
+    const double* up = ws.upPowers.data();
+    const double* down = ws.downPowers.data();
+
+    // Payoff max(sign * (S - K), 0); exercise value payoff + offset, with offset -inf for
+    // Europeans so max(exercise, continuation) leaves them untouched. Padding lanes are zero.
+    double* sign = ws.laneParams.data();
+    double* strike = sign + L;
+    double* offset = strike + L;
+    bool anyAmerican = false;
+    for (size_t k = 0; k < L; ++k) {
+        const bool used = k < count;
+        sign[k] = !used ? 0.0 : (lanes[k].type == Call ? 1.0 : -1.0);
+        strike[k] = used ? lanes[k].strike : 0.0;
+        offset[k] = (used && lanes[k].american) ? 0.0 : -std::numeric_limits<double>::infinity();
+        anyAmerican = anyAmerican || (used && lanes[k].american);
+    }
+    // Exercise against the continuation values v of one node, a lane block at a time (fixed
+    // trip count, so the compiler vectorizes it).
+    auto exerciseNode = [&](double S, double* __restrict v) {
+        for (size_t b = 0; b < L; b += kStripLaneWidth) {
+            for (size_t k = b; k < b + kStripLaneWidth; ++k) {
+                const double exercise = std::max(sign[k] * (S - strike[k]), 0.0) + offset[k];
+                v[k] = (exercise < v[k]) ? v[k] : exercise;
+            }
+        }
+    };
+
+    int firstLevel = N - 1;
+    if (closedFormLastStep) {
+        PRICING_COUNT(LatticeNodes, static_cast<uint64_t>(N) * static_cast<uint64_t>(N + 1) / 2 * count);
+        const int i = N - 1;
+        for (int j = 0; j <= i; ++j) {
+            const double S = S0 * up[j] * down[i - j];
+            double* v = V + static_cast<size_t>(j) * L;
+            for (size_t k = 0; k < L; ++k) {
+                v[k] = (k < count) ? blackScholesPrice(lanes[k].type, S, strike[k], params.deltaT, params.rate, params.vol)
+                                   : 0.0;
+            }
+            if (anyAmerican) exerciseNode(S, v);
+        }
+        firstLevel = N - 2;
+    } else {
+        PRICING_COUNT(LatticeNodes, static_cast<uint64_t>(N + 1) * static_cast<uint64_t>(N + 2) / 2 * count);
+        for (int j = 0; j <= N; ++j) {
+            const double S = S0 * up[j] * down[N - j];
+            double* v = V + static_cast<size_t>(j) * L;
+            for (size_t k = 0; k < L; ++k) {
+                v[k] = std::max(sign[k] * (S - strike[k]), 0.0);
+            }
+        }
+    }
+
+    const double discUp = params.df_step * params.p_up;
+    const double discDown = params.df_step * params.p_down;
+    // One node: discounted expectation of node j + 1 ('above') and node j (in place).
+    auto expectNode = [&](const double* __restrict above, double* __restrict v) {
+        for (size_t b = 0; b < L; b += kStripLaneWidth) {
+            for (size_t k = b; k < b + kStripLaneWidth; ++k) {
+                v[k] = discUp * above[k] + discDown * v[k];
+            }
+        }
+    };
+    for (int i = firstLevel; i >= 0; --i) {
+        for (int j = 0; j <= i; ++j) {
+            double* v = V + static_cast<size_t>(j) * L;
+            expectNode(v + L, v);
+            if (anyAmerican) exerciseNode(S0 * up[j] * down[i - j], v);
+        }
+    }
+
+    for (size_t k = 0; k < count; ++k) pvs[k] = V[k];
+}
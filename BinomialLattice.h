@@ -0,0 +1,109 @@
+#ifndef BINOMIAL_LATTICE_H
+#define BINOMIAL_LATTICE_H
+
+#include <cstddef>
+#include <vector>
+
+#include "Types.h"
+
+class TreeProduct;
+
+// Parameters of one recombining binomial tree (filled by a model such as CRR).
+struct TreeParams {
+    int N = 0;            // Number of time steps
+    double deltaT = 0.0;  // Time step duration
+    double u = 1.0;       // Up factor
+    double d = 1.0;       // Down factor
+    double p_up = 0.5;    // Risk-neutral probability of up move
+    double p_down = 0.5;  // Risk-neutral probability of down move
+    double df_step = 1.0; // Discount factor per step
+    double rate = 0.0;    // Model inputs the tree was built from (for closed-form steps)
+    double vol = 0.0;
+};
+
+// Closed-form final step (binomial Black-Scholes): level N-1 node values come from the
+// Black-Scholes price over one step instead of the expectation of terminal payoffs.
+struct LastStepClosedForm {
+    OptionType type = Call; // Call or Put
+    double strike = 0.0;
+};
+
+// PV and spot/time sensitivities read off the first lattice levels.
+// theta is per year of calendar time (dV/dt, typically negative for long options).
+struct TreeGreeks {
+    double pv = 0.0;
+    double delta = 0.0;
+    double gamma = 0.0;
+    double theta = 0.0;
+};
+
+// Scratch buffers for lattice pricing. Buffers only grow, so after warm-up a
+// pricing call performs no allocation. Use forThisThread() for the per-thread instance.
+struct LatticeWorkspace {
+    std::vector<double> values;     // Option values of the current level, N + 1 nodes
+    std::vector<double> upPowers;   // u^j,  j = 0..N
+    std::vector<double> downPowers; // d^k,  k = 0..N
+    std::vector<double> laneValues; // Strip pricing: (N + 1) nodes x padded lane count
+    std::vector<double> laneParams; // Strip pricing: per-lane sign, strike and exercise offset
+
+    void reserve(int nSteps);
+
+    static LatticeWorkspace& forThisThread();
+};
+
+// Fills ws.upPowers/ws.downPowers by multiplicative recurrence, so the spot at
+// node (i, j) is S0 * upPowers[j] * downPowers[i - j] with no std::pow calls.
+void buildSpotPowers(const TreeParams& params, LatticeWorkspace& ws);
+
+// Prices 'product' on the tree described by params (params.N >= 1) using ws as scratch.
+// Terminal payoffs come from product.Payoff and interior nodes from product.ValueAtNode.
+// The discounted-expectation step runs as a separate tight loop over the level so the
+// compiler can vectorize it; the product callbacks are applied in a second pass.
+// If greeks is non-null it is filled in the same sweep: delta from level 1, gamma and
+// theta from level 2, the terminal level included on short trees (gamma/theta need
+// params.N >= 2 and are left at 0 otherwise).
+// With lastStep, level N-1 is taken from the closed form (product.ValueAtNode still applies).
+double priceOnLattice(const TreeParams& params, double S0, const TreeProduct& product, LatticeWorkspace& ws,
+                      TreeGreeks* greeks = nullptr, const LastStepClosedForm* lastStep = nullptr);
+
+enum class ExerciseStyle { European, American };
+
+// A vanilla or binary option in the form the specialized lattice kernels take.
+struct LatticeOption {
+    ExerciseStyle exercise = ExerciseStyle::European;
+    OptionType type = Call; // Call, Put, BinaryCall or BinaryPut
+    double strike = 0.0;
+};
+
+// Describes a built-in EuropeanOption or AmericanOption as a LatticeOption. False for other
+// products, classes derived from those two included, and other option types: they need
+// priceOnLattice.
+bool latticeOptionFor(const TreeProduct& product, LatticeOption& option);
+
+// As priceOnLattice, on a kernel instantiated for the option's exercise style and payoff:
+// payoff and exercise are inlined instead of virtual calls per node, and Europeans skip the
+// exercise pass altogether. Gives the same values as priceOnLattice on the product
+// latticeOptionFor described. Throws std::invalid_argument for OptionType None.
+double priceOptionOnLattice(const TreeParams& params, double S0, const LatticeOption& option, LatticeWorkspace& ws,
+                            TreeGreeks* greeks = nullptr, const LastStepClosedForm* lastStep = nullptr);
+
+// One lane of a strip: a vanilla call or put. Europeans take the continuation value at every
+// node; Americans max(payoff, continuation), as EuropeanOption/AmericanOption::ValueAtNode.
+struct StripLane {
+    OptionType type = Call; // Call or Put
+    double strike = 0.0;
+    bool american = false;
+};
+
+// Lanes padded to a multiple of this width, so the per-node lane loops vectorize cleanly.
+constexpr size_t kStripLaneWidth = 4;
+
+// Prices 'count' vanilla options that share one tree (same spot, r, sigma, expiry) in a single
+// backward induction: values are stored node-major with the lanes of a node contiguous, so
+// each step is an elementwise loop over lanes. Writes pvs[0..count); params.N >= 1. With
+// closedFormLastStep, level N-1 of each lane comes from its one-step Black-Scholes price.
+// Gives the same values as priceOnLattice on each product alone.
+void priceStripOnLattice(const TreeParams& params, double S0, const StripLane* lanes, size_t count,
+                         LatticeWorkspace& ws, double* pvs, bool closedFormLastStep = false);
+
+#endif // BINOMIAL_LATTICE_H
@@ -23,11 +23,17 @@ public:
     Date getMaturityDate() const override;
     std::string getUnderlyingName() const override; // Bond name itself
     std::string getRateCurveName() const override;  // Discount curve for this bond
+    MarketDataId getUnderlyingId() const override { return instrumentId; }
+    MarketDataId getRateCurveId() const override { return discountCurveId; }
+    MarketDataId getVolCurveId() const override { return volCurveId; } // Bonds have no vol curve
 
     // Specific getters for Bond properties (optional, but can be useful)
     double getPrincipal() const { return principal; }
     double getCouponRate() const { return couponRate; }
     int getCouponFrequency() const { return couponFrequency; }
+    const Date& getIssueDate() const { return issueDate; }
+    const std::vector<long>& getCashflowSerials() const { return cashflowSerials; }
+    const std::vector<double>& getCashflowAmounts() const { return cashflowAmounts; }
 
 private:
     std::string instrumentName; // e.g., "US Treasury Bond 2.5% 2030"
@@ -37,10 +43,15 @@ private:
     double couponRate;       // Annual rate
     int couponFrequency;    // Payments per year
     std::string discountCurveName; // Name of the rate curve to use for discounting
+    MarketDataId instrumentId;
+    MarketDataId discountCurveId;
+    MarketDataId volCurveId;
 
-    // Helper to generate cashflow dates and amounts (optional internal detail)
-    // struct Cashflow { Date paymentDate; double amount; };
-    // std::vector<Cashflow> generateCashflows(const Date& settlementDate) const;
+    // Builds the immutable cashflow arrays below once, at construction.
+    // Pv then only selects the flows after the valuation date and discounts them.
+    void generateCashflows();
+    std::vector<long> cashflowSerials;   // Payment dates (serial numbers), ascending
+    std::vector<double> cashflowAmounts; // Coupon, plus principal on the maturity date
 };
 
 #endif // BOND_H
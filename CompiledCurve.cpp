@@ -0,0 +1,93 @@
+#include "CompiledCurve.h"
+#include <algorithm>
+#include <cmath>
+
+void CompiledCurve::build(const std::vector<Date>& pillars, const std::vector<double>& values_in) {
+    const size_t n = std::min(pillars.size(), values_in.size());
+    serials.resize(n);
+    values.assign(values_in.begin(), values_in.begin() + n);
+    for (size_t i = 0; i < n; ++i) {
+        serials[i] = pillars[i].getSerialDate();
+    }
+    slopes.assign(n, 0.0);
+    for (size_t i = 0; i + 1 < n; ++i) {
+        const long width = serials[i + 1] - serials[i];
+        slopes[i] = (width != 0) ? (values[i + 1] - values[i]) / static_cast<double>(width) : 0.0;
+    }
+}
+
+size_t CompiledCurve::segmentFor(long x) const {
+    // First pillar strictly greater than x; caller guarantees front < x < back.
+    auto it = std::upper_bound(serials.begin(), serials.end(), x);
+    return static_cast<size_t>(it - serials.begin()) - 1;
+}
+
+double CompiledCurve::valueAt(long serial) const {
+    if (serials.empty()) {
+        return 0.0;
+    }
+    if (serial <= serials.front()) {
+        return values.front();
+    }
+    if (serial >= serials.back()) {
+        return values.back();
+    }
+    const size_t i = segmentFor(serial);
+    return values[i] + static_cast<double>(serial - serials[i]) * slopes[i];
+}
+
+void CompiledCurve::valueAtAdjoint(long serial, double adjoint, double* pillarAdjoints) const {
+    if (serials.empty()) {
+        return;
+    }
+    if (serial <= serials.front()) {
+        pillarAdjoints[0] += adjoint;
+        return;
+    }
+    if (serial >= serials.back()) {
+        pillarAdjoints[serials.size() - 1] += adjoint;
+        return;
+    }
+    const size_t i = segmentFor(serial);
+    const long width = serials[i + 1] - serials[i];
+    const double t = (width != 0) ? static_cast<double>(serial - serials[i]) / static_cast<double>(width) : 0.0;
+    pillarAdjoints[i] += adjoint * (1.0 - t);
+    pillarAdjoints[i + 1] += adjoint * t;
+}
+
+void CompiledCurve::valuesAt(const long* serialsIn, double* out, size_t n) const {
+    if (serials.empty()) {
+        std::fill(out, out + n, 0.0);
+        return;
+    }
+    const long front = serials.front();
+    const long back = serials.back();
+    size_t seg = 0; // Cursor for ascending runs of input
+    long previous = front;
+    for (size_t k = 0; k < n; ++k) {
+        const long x = serialsIn[k];
+        if (x <= front) {
+            out[k] = values.front();
+            continue;
+        }
+        if (x >= back) {
+            out[k] = values.back();
+            continue;
+        }
+        if (x < previous) {
+            seg = segmentFor(x); // Input went backwards: restart the walk
+        } else {
+            while (serials[seg + 1] <= x) ++seg;
+        }
+        previous = x;
+        out[k] = values[seg] + static_cast<double>(x - serials[seg]) * slopes[seg];
+    }
+}
+
+void CompiledCurve::discountFactors(long asOfSerial, const long* serialsIn, double* out, size_t n) const {
+    valuesAt(serialsIn, out, n);
+    for (size_t k = 0; k < n; ++k) {
+        const double T = static_cast<double>(serialsIn[k] - asOfSerial) / 365.0;
+        out[k] = std::exp(-out[k] * T);
+    }
+}
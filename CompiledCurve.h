@@ -0,0 +1,50 @@
+#ifndef COMPILED_CURVE_H
+#define COMPILED_CURVE_H
+
+#include <vector>
+#include <cstddef>
+
+#include "Date.h"
+
+// Frozen lookup form of a pillar curve (zero rates or vols), held as contiguous arrays:
+// pillar serial numbers, values and precomputed segment slopes. Interpolation is linear
+// in the serial date with flat extrapolation, exactly as RateCurve/VolCurve define it.
+// RateCurve and VolCurve rebuild their CompiledCurve whenever their pillars change.
+class CompiledCurve {
+public:
+    CompiledCurve() = default;
+
+    // pillars must be sorted ascending and the same length as values.
+    void build(const std::vector<Date>& pillars, const std::vector<double>& values);
+
+    bool isEmpty() const { return serials.empty(); }
+    size_t size() const { return serials.size(); }
+
+    // Value at a serial date; 0.0 for an empty curve.
+    double valueAt(long serial) const;
+
+    // out[i] = valueAt(serialsIn[i]) for i in [0, n). Ascending input (a cashflow schedule)
+    // is resolved with a single forward walk over the pillars.
+    void valuesAt(const long* serialsIn, double* out, size_t n) const;
+
+    // out[i] = exp(-valueAt(s) * (s - asOfSerial) / 365), treating values as continuously
+    // compounded zero rates with the same Act/365 year fraction as operator-(Date, Date).
+    void discountFactors(long asOfSerial, const long* serialsIn, double* out, size_t n) const;
+
+    // Reverse mode of valueAt: pillarAdjoints[j] += adjoint * d valueAt(serial) / d value j,
+    // for the (at most two) pillars the lookup interpolates between. pillarAdjoints holds size() entries.
+    void valueAtAdjoint(long serial, double adjoint, double* pillarAdjoints) const;
+
+    const std::vector<long>& getSerials() const { return serials; }
+    const std::vector<double>& getValues() const { return values; }
+
+private:
+    // Index of the segment [serials[i], serials[i + 1]) containing x, for interior x.
+    size_t segmentFor(long x) const;
+
+    std::vector<long> serials;
+    std::vector<double> values;
+    std::vector<double> slopes; // slopes[i] applies on [serials[i], serials[i + 1])
+};
+
+#endif // COMPILED_CURVE_H
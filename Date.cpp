@@ -12,6 +12,36 @@ std::string toLowerDateCpp(const std::string& str) { // Renamed for clarity
                    [](unsigned char c){ return std::tolower(c); });
     return lower_str;
 }
+
+// Gregorian days in the years 1900 .. y-1.
+constexpr long daysBeforeYear(int y) {
+    auto leapsThrough = [](long x) { return x / 4 - x / 100 + x / 400; };
+    return 365L * (y - 1900) + leapsThrough(y - 1) - leapsThrough(1899);
+}
+
+// Conversion tables, indexed [leap]: days before month m (1..12), and the month of
+// 1-based day-of-year d (1..366).
+struct CalendarTables {
+    int daysBeforeMonth[2][13] = {};
+    unsigned char monthOfDay[2][367] = {};
+
+    constexpr CalendarTables() {
+        const int monthLengths[13] = {0, 31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+        for (int leap = 0; leap < 2; ++leap) {
+            int dayOfYear = 0;
+            for (int m = 1; m <= 12; ++m) {
+                daysBeforeMonth[leap][m] = dayOfYear;
+                const int length = monthLengths[m] + ((leap && m == 2) ? 1 : 0);
+                for (int d = 1; d <= length; ++d) monthOfDay[leap][dayOfYear + d] = static_cast<unsigned char>(m);
+                dayOfYear += length;
+            }
+        }
+    }
+};
+
+constexpr CalendarTables kCalendar;
+constexpr const int (&kDaysBeforeMonth)[2][13] = kCalendar.daysBeforeMonth;
+constexpr const unsigned char (&kMonthOfDay)[2][367] = kCalendar.monthOfDay;
 } 
 
 bool Date::isGregorianLeap(int y_val) {
@@ -19,22 +49,10 @@ bool Date::isGregorianLeap(int y_val) {
 }
 
 void Date::calculateSerialNumber() {
-    long excelSerial = 0;
-    for (int y_iter = 1900; y_iter < year; ++y_iter) {
-        bool leap = (y_iter % 4 == 0 && (y_iter % 100 != 0 || y_iter % 400 == 0));
-        if (y_iter == 1900) leap = true; 
-        excelSerial += leap ? 366 : 365;
-    }
-    
-    int monthDays[] = {0, 31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31}; 
-    bool currentYearIsExcelLeap = (year % 4 == 0 && (year % 100 != 0 || year % 400 == 0));
-    if (year == 1900) currentYearIsExcelLeap = true; 
-    
-    if (currentYearIsExcelLeap) monthDays[2] = 29;
-
-    for (int m_iter = 1; m_iter < month; ++m_iter) {
-        excelSerial += monthDays[m_iter];
-    }
+    // Excel counts 1900 as a leap year; years before 1900 start from serial 0.
+    const bool excelLeap = isGregorianLeap(year) || year == 1900;
+    long excelSerial = (year > 1900) ? daysBeforeYear(year) + 1 : 0;
+    excelSerial += kDaysBeforeMonth[excelLeap][month];
     excelSerial += day;
     this->serialNumber = excelSerial;
 }
@@ -54,38 +72,16 @@ void Date::calculateYMD() {
         dayNumForCalc--;
     }
 
-    this->year = 1900;
-    while (true) {
-        bool leap = isGregorianLeap(this->year); 
-        long daysInYear = leap ? 366 : 365;
-        if (dayNumForCalc <= daysInYear) {
-            break;
-        }
-        dayNumForCalc -= daysInYear;
-        this->year++;
-    }
-
-    int monthDays[] = {0, 31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
-    if (isGregorianLeap(this->year)) { 
-        monthDays[2] = 29;
-    }
+    // Estimate the year from the mean Gregorian year length, then correct by at most a year.
+    int y = 1900 + static_cast<int>((dayNumForCalc - 1) * 400 / 146097);
+    while (y > 1900 && dayNumForCalc <= daysBeforeYear(y)) --y;
+    while (dayNumForCalc > daysBeforeYear(y + 1)) ++y;
+    this->year = y;
 
-    this->month = 1;
-    while (true) {
-        if (this->month > 12) throw std::logic_error("Month calculation failed in Date::calculateYMD - month exceeded 12");
-        if (dayNumForCalc <= monthDays[this->month]) {
-            break;
-        }
-        dayNumForCalc -= monthDays[this->month];
-        this->month++;
-    }
-    this->day = static_cast<int>(dayNumForCalc);
-     if (this->day == 0 && dayNumForCalc > 0 && sn > 0) { 
-        // This case should ideally not be hit if serial number is valid and logic is perfect.
-        // If day becomes 0, it might indicate an issue with the last day of a month or serial 0.
-        // For serial 1 (1900-01-01), dayNumForCalc = 1, month = 1, day = 1. Correct.
-        throw std::logic_error("Day calculation resulted in 0 incorrectly in Date::calculateYMD.");
-    }
+    const int dayOfYear = static_cast<int>(dayNumForCalc - daysBeforeYear(y)); // 1-based
+    const bool leap = isGregorianLeap(y);
+    this->month = kMonthOfDay[leap][dayOfYear];
+    this->day = dayOfYear - kDaysBeforeMonth[leap][this->month];
 }
 
 Date::Date(int y, int m, int d) : year(y), month(m), day(d) {
@@ -127,10 +123,19 @@ void Date::setFromSerial(long serial) {
     if (serial <= 0) { 
         throw std::out_of_range("Serial number must be positive for Date::setFromSerial.");
     }
+    if (serial > kMaxSerial) {
+        throw std::out_of_range("Serial number " + std::to_string(serial) + " is after 9999-12-31 in Date::setFromSerial.");
+    }
     this->serialNumber = serial;
     calculateYMD();
 }
 
+Date Date::fromSerial(long serial) {
+    Date date;
+    date.setFromSerial(serial);
+    return date;
+}
+
 bool Date::operator<(const Date& other) const { return this->serialNumber < other.serialNumber; }
 bool Date::operator<=(const Date& other) const { return this->serialNumber <= other.serialNumber; }
 bool Date::operator>(const Date& other) const { return this->serialNumber > other.serialNumber; }
@@ -147,42 +152,38 @@ std::string Date::toString() const {
     return std::string(buffer);
 }
 
-Date dateAddTenor(const Date& startDate, const std::string& tenorStr) {
+Tenor Tenor::parse(const std::string& tenorStr) {
     std::string lowerTenor = toLowerDateCpp(tenorStr);
-    long currentSerial = startDate.getSerialDate();
-    long newSerial = currentSerial;
-
     if (lowerTenor == "on" || lowerTenor == "o/n") {
-        newSerial = currentSerial + 1;
-    } else {
-        if (lowerTenor.empty()) throw std::runtime_error("Empty tenor string in dateAddTenor.");
-        char unit = lowerTenor.back();
-        std::string numPartStr = lowerTenor.substr(0, lowerTenor.length() - 1);
-        if (numPartStr.empty()) throw std::runtime_error("Tenor string missing number: " + tenorStr);
-        
-        int numUnits = 0;
-        try {
-            numUnits = std::stoi(numPartStr);
-        } catch (const std::exception& e) {
-            throw std::runtime_error("Invalid number in tenor string '" + tenorStr + "': " + e.what());
-        }
+        return Tenor(1, Unit::Days);
+    }
+    if (lowerTenor.empty()) throw std::runtime_error("Empty tenor string in dateAddTenor.");
+    char unit = lowerTenor.back();
+    std::string numPartStr = lowerTenor.substr(0, lowerTenor.length() - 1);
+    if (numPartStr.empty()) throw std::runtime_error("Tenor string missing number: " + tenorStr);
 
-        if (unit == 'd') {
-            newSerial = currentSerial + numUnits;
-        } else if (unit == 'w') {
-            newSerial = currentSerial + numUnits * 7;
-        } else if (unit == 'm') { 
-            newSerial = currentSerial + numUnits * 30; // Approximation
-        } else if (unit == 'y') { 
-            newSerial = currentSerial + numUnits * 360; // Approximation
-        } else {
-            throw std::runtime_error("Unsupported tenor unit '" + std::string(1, unit) + "' in tenor: " + tenorStr);
-        }
+    int numUnits = 0;
+    try {
+        numUnits = std::stoi(numPartStr);
+    } catch (const std::exception& e) {
+        throw std::runtime_error("Invalid number in tenor string '" + tenorStr + "': " + e.what());
     }
+
+    if (unit == 'd') return Tenor(numUnits, Unit::Days);
+    if (unit == 'w') return Tenor(numUnits, Unit::Weeks);
+    if (unit == 'm') return Tenor(numUnits, Unit::Months);
+    if (unit == 'y') return Tenor(numUnits, Unit::Years);
+    throw std::runtime_error("Unsupported tenor unit '" + std::string(1, unit) + "' in tenor: " + tenorStr);
+}
+
+Date dateAddTenor(const Date& startDate, const std::string& tenorStr) {
+    return dateAddTenor(startDate, Tenor::parse(tenorStr));
+}
+
+Date dateAddTenor(const Date& startDate, const Tenor& tenor) {
+    long newSerial = startDate.getSerialDate() + tenor.days();
     if (newSerial <= 0) throw std::runtime_error("Calculated new serial is non-positive in dateAddTenor");
-    Date newDate; 
-    newDate.setFromSerial(newSerial);
-    return newDate;
+    return Date::fromSerial(newSerial);
 }
 
 double operator-(const Date& d1, const Date& d2) {
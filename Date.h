@@ -18,8 +18,10 @@ public:
     explicit Date(const std::string& dateStr); // From \"YYYY-MM-DD\"
 
     // Serial date functions
+    static constexpr long kMaxSerial = 2958465; // 9999-12-31, the last date the constructor accepts
     long getSerialDate() const;
-    void setFromSerial(long serial); // Sets y,m,d from an Excel-compatible serial
+    void setFromSerial(long serial); // Sets y,m,d from an Excel-compatible serial; throws std::out_of_range outside [1, kMaxSerial]
+    static Date fromSerial(long serial); // As setFromSerial on a new Date
 
     // Comparison operators
     bool operator<(const Date& other) const;
@@ -38,8 +40,94 @@ private:
     static bool isGregorianLeap(int y_val); // Standard Gregorian leap year
 };
 
+// A pre-parsed tenor ("6M", "1Y", "2W", "ON"), so schedule loops do not re-parse strings.
+// Months and years keep dateAddTenor's 30- and 360-day approximations; "ON"/"O/N" is one day.
+// Literals parse at compile time when used in a constant expression:
+//   constexpr Tenor sixMonths("6M");
+class Tenor {
+public:
+    enum class Unit { Days, Weeks, Months, Years };
+
+    constexpr Tenor() : count(0), unit(Unit::Days) {}
+    constexpr Tenor(int count_in, Unit unit_in) : count(count_in), unit(unit_in) {}
+    constexpr explicit Tenor(const char* text) : count(0), unit(Unit::Days) {
+        if (isOvernight(text)) {
+            count = 1;
+            return;
+        }
+        int i = 0;
+        bool negative = false;
+        if (text[i] == '-' || text[i] == '+') negative = (text[i++] == '-');
+        if (text[i] < '0' || text[i] > '9') throw std::runtime_error("Tenor string missing number");
+        while (text[i] >= '0' && text[i] <= '9') count = count * 10 + (text[i++] - '0');
+        if (negative) count = -count;
+        switch (text[i]) {
+        case 'd': case 'D': unit = Unit::Days; break;
+        case 'w': case 'W': unit = Unit::Weeks; break;
+        case 'm': case 'M': unit = Unit::Months; break;
+        case 'y': case 'Y': unit = Unit::Years; break;
+        default: throw std::runtime_error("Unsupported tenor unit");
+        }
+        if (text[i + 1] != '\0') throw std::runtime_error("Unexpected characters after tenor unit");
+    }
+
+    // Runtime parse with dateAddTenor's rules and error messages (throws std::runtime_error).
+    static Tenor parse(const std::string& tenorStr);
+
+    // Serial offset the tenor adds.
+    constexpr long days() const {
+        switch (unit) {
+        case Unit::Weeks: return count * 7L;
+        case Unit::Months: return count * 30L; // Approximation
+        case Unit::Years: return count * 360L; // Approximation
+        default: return count;
+        }
+    }
+
+    constexpr int getCount() const { return count; }
+    constexpr Unit getUnit() const { return unit; }
+
+private:
+    static constexpr bool isOvernight(const char* text) {
+        const char c0 = text[0] | 0x20;
+        if (c0 != 'o') return false;
+        if ((text[1] | 0x20) == 'n') return text[2] == '\0';
+        return text[1] == '/' && (text[2] | 0x20) == 'n' && text[3] == '\0';
+    }
+
+    int count;
+    Unit unit;
+};
+
+// A date as its Excel serial alone, for loops that only step and compare dates. Same
+// ordering and Act/365 difference as Date; toDate() fills in year/month/day when needed.
+struct SerialDate {
+    long serial = 0;
+
+    constexpr SerialDate() = default;
+    constexpr explicit SerialDate(long serial_in) : serial(serial_in) {}
+    explicit SerialDate(const Date& date) : serial(date.serialNumber) {}
+
+    Date toDate() const { return Date::fromSerial(serial); }
+
+    constexpr SerialDate operator+(const Tenor& tenor) const { return SerialDate(serial + tenor.days()); }
+    constexpr SerialDate operator+(long days) const { return SerialDate(serial + days); }
+
+    constexpr bool operator<(const SerialDate& other) const { return serial < other.serial; }
+    constexpr bool operator<=(const SerialDate& other) const { return serial <= other.serial; }
+    constexpr bool operator>(const SerialDate& other) const { return serial > other.serial; }
+    constexpr bool operator==(const SerialDate& other) const { return serial == other.serial; }
+    constexpr bool operator!=(const SerialDate& other) const { return serial != other.serial; }
+};
+
+// Difference in years (Act/365 simple), as for Date
+constexpr double operator-(const SerialDate& d1, const SerialDate& d2) {
+    return static_cast<double>(d1.serial - d2.serial) / 365.0;
+}
+
 // Standalone utility functions related to Date
 Date dateAddTenor(const Date& startDate, const std::string& tenorStr);
+Date dateAddTenor(const Date& startDate, const Tenor& tenor);
 double operator-(const Date& d1, const Date& d2); // Difference in years (Act/365 simple)
 
 std::ostream& operator<<(std::ostream& os, const Date& date);
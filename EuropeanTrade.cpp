@@ -13,8 +13,11 @@ EuropeanOption::EuropeanOption()
       strike(0.0), 
       expiryDate(Date()), 
       discountCurveName("USD-SOFR"),
-      volatilityCurveName("VOL_CURVE_DEFAULT") {
+      volatilityCurveName("VOL_CURVE_DEFAULT"),
+      discountCurveId(internMarketDataName(discountCurveName)),
+      volatilityCurveId(internMarketDataName(volatilityCurveName)) {
     tradeType = "EuropeanOption"; 
+    kind = InstrumentKind::EuropeanOption;
 }
 
 EuropeanOption::EuropeanOption(OptionType optType,
@@ -28,13 +31,16 @@ EuropeanOption::EuropeanOption(OptionType optType,
       strike(strikePrice),
       expiryDate(expiryDt),
       discountCurveName(discCurveName),
-      volatilityCurveName(volCurveName) {
+      volatilityCurveName(volCurveName),
+      discountCurveId(internMarketDataName(discountCurveName)),
+      volatilityCurveId(internMarketDataName(volatilityCurveName)) {
     tradeType = "EuropeanOption"; 
+    kind = InstrumentKind::EuropeanOption;
 }
 
 double EuropeanOption::Pv(const Market& mkt) const {
-    std::shared_ptr<const RateCurve> rateCurve = mkt.getCurve(discountCurveName);
-    std::shared_ptr<const VolCurve> volCurve = mkt.getVolCurve(volatilityCurveName);
+    std::shared_ptr<const RateCurve> rateCurve = mkt.getCurve(discountCurveId);
+    std::shared_ptr<const VolCurve> volCurve = mkt.getVolCurve(volatilityCurveId);
     Date valuationDate = mkt.asOf;
 
     if (!rateCurve || rateCurve->isEmpty()) {
@@ -46,7 +52,7 @@ double EuropeanOption::Pv(const Market& mkt) const {
         return 0.0;
     }
 
-    double S = mkt.getStockPrice(underlying); 
+    double S = mkt.getStockPrice(underlyingId); 
     if (S < 0) S = 0; // Guard against negative stock price
 
     double K = this->strike;
@@ -61,6 +67,10 @@ double EuropeanOption::Pv(const Market& mkt) const {
     double r = rateCurve->getRate(T_expiry); 
     double sigma = volCurve->getVol(T_expiry); 
 
+    return BlackScholesPv(optionType, S, K, T, r, sigma);
+}
+
+double EuropeanOption::BlackScholesPv(OptionType optionType, double S, double K, double T, double r, double sigma) {
     if (S <= 1e-9) { 
         if (optionType == OptionType::Call) return 0.0;
         if (optionType == OptionType::Put) {
@@ -78,7 +88,7 @@ double EuropeanOption::Pv(const Market& mkt) const {
         return intrinsic_at_expiry_no_vol; 
     }
     if (T <= 1e-9) { 
-         return Payoff(S); 
+         return PAYOFF::VanillaOption(optionType, K, S); 
     }
 
     double d1 = (std::log(S / K) + (r + 0.5 * sigma * sigma) * T) / (sigma * std::sqrt(T));
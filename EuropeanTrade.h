@@ -31,10 +31,17 @@ public:
     // std::string getUnderlyingName() const override { return underlying; } // If 'underlying' is a member here or in TreeProduct
     std::string getRateCurveName() const override { return discountCurveName; }
     std::string getVolCurveName() const override { return volatilityCurveName; }
+    MarketDataId getRateCurveId() const override { return discountCurveId; }
+    MarketDataId getVolCurveId() const override { return volatilityCurveId; }
 
     // Specific getters for EuropeanOption properties
-    OptionType getOptionType() const { return optionType; }
-    double getStrike() const { return strike; }
+    OptionType getOptionType() const override { return optionType; }
+    double getStrike() const override { return strike; }
+
+    // What Pv returns once the curves are read and the option has not expired (S >= 0, T in
+    // years), degenerate inputs (zero spot or vol, T ~ 0) included. TradeStore prices its
+    // irregular rows through it.
+    static double BlackScholesPv(OptionType optType, double S, double K, double T, double r, double sigma);
 
 protected:
     OptionType optionType;
@@ -43,6 +50,8 @@ protected:
     // underlying is in TreeProduct
     std::string discountCurveName;
     std::string volatilityCurveName;
+    MarketDataId discountCurveId;
+    MarketDataId volatilityCurveId;
 };
 
 // EuroCallSpread is more complex, we'll focus on EuropeanOption first as per main requirements.
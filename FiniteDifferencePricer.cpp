@@ -0,0 +1,270 @@
+#include "FiniteDifferencePricer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+#include <vector>
+
+#include "Market.h"
+#include "TreeProduct.h"
+#include "Instrumentation.h"
+
+namespace {
+
+// One theta-scheme step on the interior nodes 1..M-1:
+//   (I - theta dt L) V_new = (I + (1 - theta) dt L) V_old
+// L has constant coefficients (lower, diag, upper) on a uniform log-spot grid.
+struct StepOperator {
+    double lhsLower = 0.0, lhsDiag = 1.0, lhsUpper = 0.0;
+    double rhsLower = 0.0, rhsDiag = 1.0, rhsUpper = 0.0;
+    std::vector<double> upperPrime;   // Thomas factorization of the left-hand side
+    std::vector<double> pivotInverse;
+
+    void build(double lower, double diag, double upper, double dt, double theta, int M) {
+        lhsLower = -theta * dt * lower;
+        lhsDiag = 1.0 - theta * dt * diag;
+        lhsUpper = -theta * dt * upper;
+        rhsLower = (1.0 - theta) * dt * lower;
+        rhsDiag = 1.0 + (1.0 - theta) * dt * diag;
+        rhsUpper = (1.0 - theta) * dt * upper;
+
+        const size_t n = static_cast<size_t>(M - 1);
+        upperPrime.assign(n, 0.0);
+        pivotInverse.assign(n, 0.0);
+        pivotInverse[0] = 1.0 / lhsDiag;
+        upperPrime[0] = lhsUpper * pivotInverse[0];
+        for (size_t k = 1; k < n; ++k) {
+            pivotInverse[k] = 1.0 / (lhsDiag - lhsLower * upperPrime[k - 1]);
+            upperPrime[k] = lhsUpper * pivotInverse[k];
+        }
+    }
+
+    // Solves the factorized system in place: d holds the right-hand side of the n unknowns.
+    void solve(double* d) const {
+        const size_t n = upperPrime.size();
+        d[0] *= pivotInverse[0];
+        for (size_t k = 1; k < n; ++k) {
+            d[k] = (d[k] - lhsLower * d[k - 1]) * pivotInverse[k];
+        }
+        for (size_t k = n - 1; k-- > 0;) {
+            d[k] -= upperPrime[k] * d[k + 1];
+        }
+    }
+};
+
+struct OperatorKey {
+    double S0, r, sigma, T, numStdDevs;
+    int M, N;
+
+    bool operator==(const OperatorKey& o) const {
+        return S0 == o.S0 && r == o.r && sigma == o.sigma && T == o.T && numStdDevs == o.numStdDevs &&
+               M == o.M && N == o.N;
+    }
+};
+
+struct GridOperators {
+    OperatorKey key;
+    double dx = 0.0;
+    std::vector<double> spots;  // S_i at node i; spots[M / 2] == S0
+    StepOperator crankNicolson; // theta = 1/2, full step
+    StepOperator implicitHalf;  // theta = 1, half step (Rannacher start-up)
+};
+
+std::unique_ptr<GridOperators> buildOperators(const OperatorKey& key) {
+    auto ops = std::make_unique<GridOperators>();
+    ops->key = key;
+    const int M = key.M;
+    const double halfWidth = key.numStdDevs * key.sigma * std::sqrt(key.T);
+    const double x0 = std::log(key.S0);
+    ops->dx = 2.0 * halfWidth / M;
+    ops->spots.resize(static_cast<size_t>(M) + 1);
+    for (int i = 0; i <= M; ++i) {
+        ops->spots[i] = std::exp(x0 - halfWidth + i * ops->dx);
+    }
+    ops->spots[M / 2] = key.S0;
+
+    // L V = a V_xx + b V_x - r V with a = sigma^2 / 2, b = r - sigma^2 / 2, central differences.
+    const double diffusion = 0.5 * key.sigma * key.sigma / (ops->dx * ops->dx);
+    const double drift = (key.r - 0.5 * key.sigma * key.sigma) / (2.0 * ops->dx);
+    const double lower = diffusion - drift;
+    const double diag = -2.0 * diffusion - key.r;
+    const double upper = diffusion + drift;
+    const double dt = key.T / key.N;
+    ops->crankNicolson.build(lower, diag, upper, dt, 0.5, M);
+    ops->implicitHalf.build(lower, diag, upper, 0.5 * dt, 1.0, M);
+    return ops;
+}
+
+// This thread's recently used operators, most recent first.
+const GridOperators& operatorsFor(const OperatorKey& key) {
+    constexpr size_t kCacheSize = 8;
+    static thread_local std::vector<std::unique_ptr<GridOperators>> cache;
+    for (size_t k = 0; k < cache.size(); ++k) {
+        if (cache[k]->key == key) {
+            std::rotate(cache.begin(), cache.begin() + k, cache.begin() + k + 1);
+            return *cache.front();
+        }
+    }
+    if (cache.size() == kCacheSize) cache.pop_back();
+    cache.insert(cache.begin(), buildOperators(key));
+    return *cache.front();
+}
+
+struct GridWorkspace {
+    std::vector<double> values, rhs, obstacle, unconstrained;
+};
+
+// Projected SOR for min(A x - d, x - g) = 0, starting from x (already >= g on entry).
+void projectedSor(const StepOperator& op, const double* d, const double* g, double* x, size_t n) {
+    constexpr double kOmega = 1.5;
+    constexpr int kMaxIterations = 1000;
+    const double invDiag = 1.0 / op.lhsDiag;
+    for (int iter = 0; iter < kMaxIterations; ++iter) {
+        double maxChange = 0.0;
+        double maxValue = 0.0;
+        for (size_t k = 0; k < n; ++k) {
+            double residual = d[k] - op.lhsDiag * x[k];
+            if (k > 0) residual -= op.lhsLower * x[k - 1];
+            if (k + 1 < n) residual -= op.lhsUpper * x[k + 1];
+            const double updated = std::max(g[k], x[k] + kOmega * residual * invDiag);
+            maxChange = std::max(maxChange, std::abs(updated - x[k]));
+            maxValue = std::max(maxValue, std::abs(updated));
+            x[k] = updated;
+        }
+        if (maxChange <= 1e-10 * std::max(1.0, maxValue)) break;
+    }
+}
+
+} // namespace
+
+FiniteDifferencePricer::FiniteDifferencePricer(int spaceSteps_in, int timeSteps_in, double numStdDevs_in)
+    : spaceSteps(spaceSteps_in + (spaceSteps_in % 2)), timeSteps(timeSteps_in), numStdDevs(numStdDevs_in) {
+    if (spaceSteps < 4 || timeSteps < 1 || !(numStdDevs > 0.0)) {
+        throw std::invalid_argument("FiniteDifferencePricer: need at least 4 space steps, 1 time step and a positive width.");
+    }
+}
+
+double FiniteDifferencePricer::PriceTree(const Market& mkt, const TreeProduct& product) const {
+    return Solve(mkt, product, nullptr);
+}
+
+TreeGreeks FiniteDifferencePricer::PriceWithGreeks(const Market& mkt, const TreeProduct& product) const {
+    TreeGreeks greeks;
+    greeks.pv = Solve(mkt, product, &greeks);
+    return greeks;
+}
+
+double FiniteDifferencePricer::Solve(const Market& mkt, const TreeProduct& product, TreeGreeks* greeks) const {
+    PRICING_SCOPED_TIMER(PricePde);
+    const double S0 = mkt.getStockPrice(product.getUnderlyingId());
+    if (S0 < 0) {
+        throw std::runtime_error("Initial stock price cannot be negative.");
+    }
+    const Date& expiryDate = product.GetExpiry();
+    double T = (expiryDate - mkt.asOf);
+    if (T < -1e-9) {
+        throw std::runtime_error("Option already expired in FiniteDifferencePricer.");
+    }
+    T = std::max(0.0, T);
+
+    std::shared_ptr<const RateCurve> rCurve = mkt.getCurve(product.getRateCurveId());
+    std::shared_ptr<const VolCurve> vCurve = mkt.getVolCurve(product.getVolCurveId());
+    if (!rCurve || rCurve->isEmpty()) {
+        throw std::runtime_error("Rate curve '" + product.getRateCurveName() + "' not found or empty for finite-difference setup.");
+    }
+    if (!vCurve || vCurve->isEmpty()) {
+        throw std::runtime_error("Volatility curve '" + product.getVolCurveName() + "' not found or empty for finite-difference setup.");
+    }
+    const double r = rCurve->getRate(expiryDate);
+    const double sigma = std::abs(vCurve->getVol(expiryDate));
+
+    // Degenerate cases, as the trees: on expiry, zero spot or zero vol have no diffusion to solve.
+    if (T <= 1e-9) {
+        return product.Payoff(S0);
+    }
+    if (S0 <= 1e-12 || sigma <= 1e-9) {
+        const double forward = S0 * std::exp(r * T);
+        return product.ValueAtNode(S0, 0.0, std::exp(-r * T) * product.Payoff(forward));
+    }
+
+    const int M = spaceSteps;
+    const int N = timeSteps;
+    const GridOperators& ops = operatorsFor(OperatorKey{S0, r, sigma, T, numStdDevs, M, N});
+    const double* S = ops.spots.data();
+    const size_t n = static_cast<size_t>(M - 1); // Interior unknowns
+    const double lowestValue = -std::numeric_limits<double>::infinity();
+    PRICING_COUNT(LatticeNodes, static_cast<uint64_t>(M + 1) * static_cast<uint64_t>(N + 1));
+
+    static thread_local GridWorkspace ws;
+    ws.values.resize(static_cast<size_t>(M) + 1);
+    ws.rhs.resize(n);
+    ws.obstacle.resize(n);
+    ws.unconstrained.resize(n);
+    double* V = ws.values.data();
+    double* d = ws.rhs.data();
+    double* g = ws.obstacle.data();
+
+    for (int i = 0; i <= M; ++i) V[i] = product.Payoff(S[i]);
+
+    const double dt = T / N;
+    double centreOneStepLater = V[M / 2];
+    double tau = 0.0; // Time to expiry of the current values
+    auto step = [&](const StepOperator& op, double stepLength) {
+        const double tauNew = tau + stepLength;
+        const double t = std::max(0.0, T - tauNew);
+        // Boundaries: discounted payoff of the forward, through ValueAtNode (early exercise).
+        const double growth = std::exp(r * tauNew);
+        const double lowBoundary = product.ValueAtNode(S[0], t, product.Payoff(S[0] * growth) / growth);
+        const double highBoundary = product.ValueAtNode(S[M], t, product.Payoff(S[M] * growth) / growth);
+
+        for (size_t k = 0; k < n; ++k) {
+            const size_t i = k + 1;
+            d[k] = op.rhsLower * V[i - 1] + op.rhsDiag * V[i] + op.rhsUpper * V[i + 1];
+        }
+        d[0] -= op.lhsLower * lowBoundary;
+        d[n - 1] -= op.lhsUpper * highBoundary;
+
+        bool constrained = false;
+        for (size_t k = 0; k < n; ++k) {
+            g[k] = product.ValueAtNode(S[k + 1], t, lowestValue);
+            constrained = constrained || g[k] > lowestValue;
+        }
+        if (constrained) {
+            // The unconstrained solution, projected onto the obstacle, is the starting point for PSOR.
+            double* start = ws.unconstrained.data();
+            std::copy(d, d + n, start);
+            op.solve(start);
+            for (size_t k = 0; k < n; ++k) V[k + 1] = std::max(g[k], start[k]);
+            projectedSor(op, d, g, V + 1, n);
+        } else {
+            op.solve(d);
+            for (size_t k = 0; k < n; ++k) V[k + 1] = d[k];
+        }
+        V[0] = lowBoundary;
+        V[M] = highBoundary;
+        tau = tauNew;
+    };
+
+    // Rannacher start-up: the first step as two implicit half steps, then Crank-Nicolson.
+    step(ops.implicitHalf, 0.5 * dt);
+    step(ops.implicitHalf, 0.5 * dt);
+    for (int s = 1; s < N; ++s) {
+        if (s == N - 1) centreOneStepLater = V[M / 2];
+        step(ops.crankNicolson, dt);
+    }
+    if (N == 1) centreOneStepLater = product.Payoff(S0);
+
+    const int i0 = M / 2;
+    const double pv = V[i0];
+    if (greeks) {
+        *greeks = TreeGreeks();
+        greeks->pv = pv;
+        const double firstX = (V[i0 + 1] - V[i0 - 1]) / (2.0 * ops.dx);
+        const double secondX = (V[i0 + 1] - 2.0 * V[i0] + V[i0 - 1]) / (ops.dx * ops.dx);
+        greeks->delta = firstX / S0;
+        greeks->gamma = (secondX - firstX) / (S0 * S0);
+        greeks->theta = (centreOneStepLater - pv) / dt; // Value one step later minus today's
+    }
+    return pv;
+}
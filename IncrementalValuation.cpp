@@ -0,0 +1,97 @@
+#include "IncrementalValuation.h"
+
+#include <numeric>
+
+IncrementalValuationService::IncrementalValuationService(PortfolioEngine& portfolioEngine)
+    : engine(portfolioEngine) {}
+
+std::vector<MarketDataKey> IncrementalValuationService::dependenciesOf(const Trade& trade) {
+    std::vector<MarketDataKey> keys;
+    const std::string rateCurve = trade.getRateCurveName();
+    if (!rateCurve.empty()) keys.push_back({MarketDataType::RateCurve, rateCurve});
+    const std::string volCurve = trade.getVolCurveName();
+    if (!volCurve.empty()) keys.push_back({MarketDataType::VolCurve, volCurve});
+    const std::string underlying = trade.getUnderlyingName();
+    if (!underlying.empty()) {
+        // Trades do not say which price table their underlying lives in; track both.
+        keys.push_back({MarketDataType::StockPrice, underlying});
+        keys.push_back({MarketDataType::BondPrice, underlying});
+    }
+    return keys;
+}
+
+void IncrementalValuationService::setPortfolio(const std::vector<std::shared_ptr<Trade>>& trades) {
+    portfolio = trades;
+    cachedResults.assign(portfolio.size(), TradeResult());
+    reverseIndex.clear();
+    valued = false;
+    for (size_t i = 0; i < portfolio.size(); ++i) {
+        if (!portfolio[i]) continue;
+        for (MarketDataKey& key : dependenciesOf(*portfolio[i])) {
+            std::vector<size_t>& dependentTrades = reverseIndex[std::move(key)].trades;
+            if (dependentTrades.empty() || dependentTrades.back() != i) dependentTrades.push_back(i);
+        }
+    }
+}
+
+const std::vector<size_t>& IncrementalValuationService::dependents(const MarketDataKey& key) const {
+    static const std::vector<size_t> none;
+    auto it = reverseIndex.find(key);
+    return (it != reverseIndex.end()) ? it->second.trades : none;
+}
+
+void IncrementalValuationService::revalueAll(const Market& mkt) {
+    std::vector<size_t> all(portfolio.size());
+    std::iota(all.begin(), all.end(), size_t(0));
+    for (auto& entry : reverseIndex) {
+        entry.second.seenVersion = mkt.getVersion(entry.first);
+    }
+    reprice(mkt, all);
+    valued = true;
+    valuedAsOf = mkt.asOf;
+}
+
+std::vector<size_t> IncrementalValuationService::refresh(const Market& mkt) {
+    if (!valued || !(mkt.asOf == valuedAsOf)) {
+        revalueAll(mkt);
+        std::vector<size_t> all(portfolio.size());
+        std::iota(all.begin(), all.end(), size_t(0));
+        return all;
+    }
+
+    std::vector<char> affected(portfolio.size(), 0);
+    size_t affectedCount = 0;
+    for (auto& entry : reverseIndex) {
+        const uint64_t version = mkt.getVersion(entry.first);
+        if (version == entry.second.seenVersion) continue;
+        entry.second.seenVersion = version;
+        for (size_t i : entry.second.trades) {
+            if (!affected[i]) {
+                affected[i] = 1;
+                ++affectedCount;
+            }
+        }
+    }
+
+    std::vector<size_t> indices;
+    indices.reserve(affectedCount);
+    for (size_t i = 0; i < affected.size(); ++i) {
+        if (affected[i]) indices.push_back(i);
+    }
+    if (!indices.empty()) reprice(mkt, indices);
+    return indices;
+}
+
+void IncrementalValuationService::reprice(const Market& mkt, const std::vector<size_t>& indices) {
+    if (indices.size() == portfolio.size()) {
+        cachedResults = engine.run(portfolio, mkt);
+        return;
+    }
+    std::vector<std::shared_ptr<Trade>> subset;
+    subset.reserve(indices.size());
+    for (size_t i : indices) subset.push_back(portfolio[i]);
+    std::vector<TradeResult> fresh = engine.run(subset, mkt);
+    for (size_t k = 0; k < indices.size(); ++k) {
+        cachedResults[indices[k]] = std::move(fresh[k]);
+    }
+}
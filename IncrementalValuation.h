@@ -0,0 +1,72 @@
+#ifndef INCREMENTAL_VALUATION_H
+#define INCREMENTAL_VALUATION_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#include "Date.h"
+#include "Market.h"
+#include "Trade.h"
+#include "PortfolioEngine.h"
+
+// Keeps PV/DV01/Vega for a portfolio current against a changing Market, repricing only the
+// trades that depend on entries whose Market::getVersion changed since the last valuation.
+//
+// Dependencies come from what each trade declares: getRateCurveName(), getVolCurveName() and
+// getUnderlyingName() (as both a stock and a bond price, whichever the market holds). A reverse
+// index maps every such key to the trades that use it, so a refresh costs one version lookup
+// per distinct key plus the repricing of the affected trades, independent of the book size.
+//
+//   IncrementalValuationService service(portfolioEngine);
+//   service.setPortfolio(portfolio);
+//   service.refresh(market);                 // First call: full valuation
+//   market.addStockPrice("APPL", 190.0);
+//   service.refresh(market);                 // Reprices only trades on APPL
+//
+// Curves changed in place through a pointer obtained earlier must be reported with
+// Market::markChanged. A change of market.asOf revalues everything.
+class IncrementalValuationService {
+public:
+    explicit IncrementalValuationService(PortfolioEngine& engine);
+
+    // Replaces the portfolio and clears all cached results.
+    void setPortfolio(const std::vector<std::shared_ptr<Trade>>& portfolio);
+
+    // Reprices the trades affected since the previous call (all of them on the first call)
+    // and returns their portfolio indices, ascending.
+    std::vector<size_t> refresh(const Market& mkt);
+
+    // Reprices everything, e.g. after trades were amended in place.
+    void revalueAll(const Market& mkt);
+
+    // Cached results, indexed like the portfolio (TradeResult::hasTrade is false for null entries).
+    const std::vector<TradeResult>& results() const { return cachedResults; }
+
+    // Trades depending on 'key', ascending; empty if none.
+    const std::vector<size_t>& dependents(const MarketDataKey& key) const;
+
+    // The market data keys a trade's valuation reads.
+    static std::vector<MarketDataKey> dependenciesOf(const Trade& trade);
+
+private:
+    // Prices portfolio[indices] through the engine and stores the results.
+    void reprice(const Market& mkt, const std::vector<size_t>& indices);
+
+    struct KeyState {
+        std::vector<size_t> trades;
+        uint64_t seenVersion = 0;
+    };
+
+    PortfolioEngine& engine;
+    std::vector<std::shared_ptr<Trade>> portfolio;
+    std::vector<TradeResult> cachedResults;
+    std::unordered_map<MarketDataKey, KeyState, MarketDataKeyHash> reverseIndex;
+
+    bool valued = false;
+    Date valuedAsOf;
+};
+
+#endif // INCREMENTAL_VALUATION_H
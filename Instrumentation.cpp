@@ -0,0 +1,244 @@
+#include "Instrumentation.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <vector>
+
+namespace instrumentation {
+
+namespace {
+
+const char* const kCounterNames[kCounterCount] = {
+    "lattice_nodes", "market_copies", "curve_lookups", "curve_interpolations", "file_loads"};
+
+const char* const kTimerNames[kTimerCount] = {
+    "Pricer::Price", "PriceTree", "FiniteDifferencePricer::Solve", "RiskEngine::computeDv01", "RiskEngine::computeVega",
+    "RiskEngine::computeRisk", "ScenarioEngine::run", "Market::copy", "Market::load", "parseTradeFile", "BinarySnapshotReader::open"};
+
+const char* const kKindNames[kKindCount] = {"Bond", "Swap", "EuropeanOption", "AmericanOption", "Other"};
+
+// Owns every thread's slots so they outlive their thread. Never destroyed, so the at-exit
+// report can run after other statics are gone.
+struct Registry {
+    std::mutex mutex;
+    std::vector<std::unique_ptr<ThreadSlots>> slots;
+    std::string exitPath;
+    ReportFormat exitFormat = ReportFormat::Text;
+    bool exitHandlerInstalled = false;
+};
+
+Registry& registry() {
+    static Registry* instance = new Registry();
+    return *instance;
+}
+
+void updateMax(std::atomic<uint64_t>& slot, uint64_t value) {
+    if (value > slot.load(std::memory_order_relaxed)) slot.store(value, std::memory_order_relaxed);
+}
+
+size_t latencyBucket(uint64_t nanos) {
+    size_t bucket = 0;
+    while (nanos > 1 && bucket + 1 < kLatencyBuckets) {
+        nanos >>= 1;
+        ++bucket;
+    }
+    return bucket;
+}
+
+// Summed view of all threads' slots.
+struct Totals {
+    size_t threads = 0;
+    uint64_t counters[kCounterCount] = {};
+    uint64_t timerCalls[kTimerCount] = {};
+    uint64_t timerNanos[kTimerCount] = {};
+    uint64_t timerMax[kTimerCount] = {};
+    uint64_t latency[kKindCount][kLatencyBuckets] = {};
+    uint64_t latencyNanos[kKindCount] = {};
+
+    uint64_t tradesPriced(size_t kind) const {
+        uint64_t n = 0;
+        for (size_t b = 0; b < kLatencyBuckets; ++b) n += latency[kind][b];
+        return n;
+    }
+
+    // Upper edge of the bucket holding quantile q, in ns (0 when empty).
+    uint64_t quantileNanos(size_t kind, double q) const {
+        const uint64_t n = tradesPriced(kind);
+        if (n == 0) return 0;
+        const uint64_t rank = std::max<uint64_t>(1, static_cast<uint64_t>(q * static_cast<double>(n) + 0.5));
+        uint64_t seen = 0;
+        for (size_t b = 0; b < kLatencyBuckets; ++b) {
+            seen += latency[kind][b];
+            if (seen >= rank) return uint64_t(2) << b;
+        }
+        return uint64_t(2) << (kLatencyBuckets - 1);
+    }
+};
+
+Totals collect() {
+    Totals t;
+    Registry& reg = registry();
+    std::lock_guard<std::mutex> lock(reg.mutex);
+    t.threads = reg.slots.size();
+    for (const std::unique_ptr<ThreadSlots>& s : reg.slots) {
+        for (size_t c = 0; c < kCounterCount; ++c) t.counters[c] += s->counters[c].load(std::memory_order_relaxed);
+        for (size_t i = 0; i < kTimerCount; ++i) {
+            t.timerCalls[i] += s->timers[i].calls.load(std::memory_order_relaxed);
+            t.timerNanos[i] += s->timers[i].totalNanos.load(std::memory_order_relaxed);
+            t.timerMax[i] = std::max(t.timerMax[i], s->timers[i].maxNanos.load(std::memory_order_relaxed));
+        }
+        for (size_t k = 0; k < kKindCount; ++k) {
+            for (size_t b = 0; b < kLatencyBuckets; ++b) t.latency[k][b] += s->latency[k][b].load(std::memory_order_relaxed);
+            t.latencyNanos[k] += s->latencyNanos[k].load(std::memory_order_relaxed);
+        }
+    }
+    return t;
+}
+
+void writeText(std::ostream& os, const Totals& t) {
+    char line[256];
+    os << "# Pricing instrumentation (" << (enabled() ? "enabled" : "disabled: build with -DPRICING_INSTRUMENTATION")
+       << ", " << t.threads << " threads)\n";
+    os << "[counters]\n";
+    for (size_t c = 0; c < kCounterCount; ++c) {
+        std::snprintf(line, sizeof(line), "%-28s %llu\n", kCounterNames[c], static_cast<unsigned long long>(t.counters[c]));
+        os << line;
+    }
+    os << "[timers]                     calls      total_ms     mean_us      max_us\n";
+    for (size_t i = 0; i < kTimerCount; ++i) {
+        const double meanUs = t.timerCalls[i] ? t.timerNanos[i] / 1e3 / static_cast<double>(t.timerCalls[i]) : 0.0;
+        std::snprintf(line, sizeof(line), "%-28s %9llu %13.3f %11.3f %11.3f\n", kTimerNames[i],
+                      static_cast<unsigned long long>(t.timerCalls[i]), t.timerNanos[i] / 1e6, meanUs, t.timerMax[i] / 1e3);
+        os << line;
+    }
+    os << "[trades]                     priced       mean_us      p50_us      p99_us\n";
+    for (size_t k = 0; k < kKindCount; ++k) {
+        const uint64_t n = t.tradesPriced(k);
+        const double meanUs = n ? t.latencyNanos[k] / 1e3 / static_cast<double>(n) : 0.0;
+        std::snprintf(line, sizeof(line), "%-28s %9llu %13.3f %11.3f %11.3f\n", kKindNames[k],
+                      static_cast<unsigned long long>(n), meanUs, t.quantileNanos(k, 0.50) / 1e3, t.quantileNanos(k, 0.99) / 1e3);
+        os << line;
+    }
+}
+
+void writeJson(std::ostream& os, const Totals& t) {
+    os << "{\n  \"enabled\": " << (enabled() ? "true" : "false") << ",\n  \"threads\": " << t.threads
+       << ",\n  \"counters\": {";
+    for (size_t c = 0; c < kCounterCount; ++c) {
+        os << (c ? ", " : "") << "\"" << kCounterNames[c] << "\": " << t.counters[c];
+    }
+    os << "},\n  \"timers\": {";
+    for (size_t i = 0; i < kTimerCount; ++i) {
+        os << (i ? "," : "") << "\n    \"" << kTimerNames[i] << "\": {\"calls\": " << t.timerCalls[i]
+           << ", \"total_ns\": " << t.timerNanos[i] << ", \"max_ns\": " << t.timerMax[i] << "}";
+    }
+    os << "\n  },\n  \"trades\": {";
+    for (size_t k = 0; k < kKindCount; ++k) {
+        os << (k ? "," : "") << "\n    \"" << kKindNames[k] << "\": {\"priced\": " << t.tradesPriced(k)
+           << ", \"total_ns\": " << t.latencyNanos[k] << ", \"latency_log2_ns\": [";
+        // Trailing empty buckets are dropped; entry b counts latencies in [2^b, 2^(b+1)) ns.
+        size_t last = kLatencyBuckets;
+        while (last > 0 && t.latency[k][last - 1] == 0) --last;
+        for (size_t b = 0; b < last; ++b) os << (b ? ", " : "") << t.latency[k][b];
+        os << "]}";
+    }
+    os << "\n  }\n}\n";
+}
+
+void writeExitReport() {
+    Registry& reg = registry();
+    std::string path;
+    ReportFormat format;
+    {
+        std::lock_guard<std::mutex> lock(reg.mutex);
+        path = reg.exitPath;
+        format = reg.exitFormat;
+    }
+    std::ofstream out(path);
+    if (!out) {
+        std::cerr << "Warning: Could not write instrumentation report to '" << path << "'." << std::endl;
+        return;
+    }
+    writeReport(out, format);
+}
+
+} // namespace
+
+ReportFormat parseReportFormat(const std::string& name) {
+    if (name == "text") return ReportFormat::Text;
+    if (name == "json") return ReportFormat::Json;
+    throw std::invalid_argument("Unknown instrumentation report format '" + name + "' (expected text or json)");
+}
+
+ThreadSlots& threadSlots() {
+    thread_local ThreadSlots* slots = nullptr;
+    if (!slots) {
+        auto owned = std::make_unique<ThreadSlots>();
+        slots = owned.get();
+        Registry& reg = registry();
+        std::lock_guard<std::mutex> lock(reg.mutex);
+        reg.slots.push_back(std::move(owned));
+    }
+    return *slots;
+}
+
+void recordTimer(Timer timer, uint64_t nanos) {
+    ThreadSlots::TimerSlot& slot = threadSlots().timers[static_cast<size_t>(timer)];
+    bump(slot.calls, 1);
+    bump(slot.totalNanos, nanos);
+    updateMax(slot.maxNanos, nanos);
+}
+
+void recordTradeLatency(InstrumentKind kind, uint64_t nanos) {
+    ThreadSlots& slots = threadSlots();
+    const size_t k = static_cast<size_t>(kind);
+    bump(slots.latency[k][latencyBucket(nanos)], 1);
+    bump(slots.latencyNanos[k], nanos);
+}
+
+void writeReport(std::ostream& os, ReportFormat format) {
+    const Totals totals = collect();
+    if (format == ReportFormat::Json) {
+        writeJson(os, totals);
+    } else {
+        writeText(os, totals);
+    }
+}
+
+void reset() {
+    Registry& reg = registry();
+    std::lock_guard<std::mutex> lock(reg.mutex);
+    for (const std::unique_ptr<ThreadSlots>& s : reg.slots) {
+        for (auto& c : s->counters) c.store(0, std::memory_order_relaxed);
+        for (auto& timer : s->timers) {
+            timer.calls.store(0, std::memory_order_relaxed);
+            timer.totalNanos.store(0, std::memory_order_relaxed);
+            timer.maxNanos.store(0, std::memory_order_relaxed);
+        }
+        for (auto& kind : s->latency) {
+            for (auto& bucket : kind) bucket.store(0, std::memory_order_relaxed);
+        }
+        for (auto& n : s->latencyNanos) n.store(0, std::memory_order_relaxed);
+    }
+}
+
+void writeReportAtExit(const std::string& path, ReportFormat format) {
+    Registry& reg = registry();
+    bool install = false;
+    {
+        std::lock_guard<std::mutex> lock(reg.mutex);
+        reg.exitPath = path;
+        reg.exitFormat = format;
+        install = !reg.exitHandlerInstalled;
+        reg.exitHandlerInstalled = true;
+    }
+    if (install) std::atexit(writeExitReport);
+}
+
+} // namespace instrumentation
@@ -0,0 +1,152 @@
+#ifndef INSTRUMENTATION_H
+#define INSTRUMENTATION_H
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+
+#include "Types.h"
+
+// Opt-in timers, counters and latency histograms for the pricing hot paths. Build with
+// -DPRICING_INSTRUMENTATION to enable them; otherwise the PRICING_* macros expand to nothing
+// (their arguments are not evaluated) and the report functions describe an empty, disabled run.
+//
+//   PRICING_SCOPED_TIMER(PriceTree);              // Inclusive wall time of the enclosing scope
+//   PRICING_COUNT(LatticeNodes, nodes);           // Adds to a counter
+//   PRICING_TRADE_LATENCY(trade.getKind());       // Latency histogram + trades-priced count per type
+//
+// Every thread records into its own slots, so the hot path takes no lock and shares no cache
+// line with other threads. Reports sum the slots of all threads, including exited ones.
+namespace instrumentation {
+
+enum class Counter {
+    LatticeNodes,        // Tree nodes evaluated by the lattice pricers, and finite-difference grid nodes
+    MarketCopies,        // Market copy-constructions and copy-assignments
+    CurveLookups,        // Market::getCurve / getVolCurve calls (base-market fallbacks included)
+    CurveInterpolations, // Rate/vol values interpolated off a curve
+    FileLoads,           // Market data, trade and snapshot files opened
+    Count
+};
+
+enum class Timer {
+    PricerPrice,
+    PriceTree,
+    PricePde,
+    ComputeDv01,
+    ComputeVega,
+    ComputeRisk,
+    ComputeScenarios,
+    MarketCopy,
+    LoadMarketFile,
+    LoadTradeFile,
+    LoadSnapshot,
+    Count
+};
+
+enum class ReportFormat { Text, Json };
+
+// "text" or "json"; throws std::invalid_argument otherwise.
+ReportFormat parseReportFormat(const std::string& name);
+
+constexpr size_t kCounterCount = static_cast<size_t>(Counter::Count);
+constexpr size_t kTimerCount = static_cast<size_t>(Timer::Count);
+constexpr size_t kKindCount = static_cast<size_t>(InstrumentKind::Other) + 1;
+constexpr size_t kLatencyBuckets = 40; // Bucket b holds latencies in [2^b, 2^(b+1)) ns
+
+// True when built with PRICING_INSTRUMENTATION.
+constexpr bool enabled() {
+#ifdef PRICING_INSTRUMENTATION
+    return true;
+#else
+    return false;
+#endif
+}
+
+// One thread's slots. Only the owning thread writes them (plain load + store, no locked
+// read-modify-write); the atomics only make concurrent reads from a report well defined.
+struct ThreadSlots {
+    struct TimerSlot {
+        std::atomic<uint64_t> calls{0};
+        std::atomic<uint64_t> totalNanos{0};
+        std::atomic<uint64_t> maxNanos{0};
+    };
+
+    std::atomic<uint64_t> counters[kCounterCount] = {};
+    TimerSlot timers[kTimerCount];
+    std::atomic<uint64_t> latency[kKindCount][kLatencyBuckets] = {};
+    std::atomic<uint64_t> latencyNanos[kKindCount] = {};
+};
+
+// The calling thread's slots, created and registered on first use.
+ThreadSlots& threadSlots();
+
+inline void bump(std::atomic<uint64_t>& slot, uint64_t n) {
+    slot.store(slot.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+}
+
+inline void count(Counter counter, uint64_t n = 1) {
+    bump(threadSlots().counters[static_cast<size_t>(counter)], n);
+}
+
+void recordTimer(Timer timer, uint64_t nanos);
+void recordTradeLatency(InstrumentKind kind, uint64_t nanos);
+
+class ScopedTimer {
+public:
+    explicit ScopedTimer(Timer timer_in) : timer(timer_in), start(std::chrono::steady_clock::now()) {}
+    ~ScopedTimer() {
+        recordTimer(timer, static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                               std::chrono::steady_clock::now() - start).count()));
+    }
+    ScopedTimer(const ScopedTimer&) = delete;
+    ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+private:
+    Timer timer;
+    std::chrono::steady_clock::time_point start;
+};
+
+class ScopedTradeLatency {
+public:
+    explicit ScopedTradeLatency(InstrumentKind kind_in) : kind(kind_in), start(std::chrono::steady_clock::now()) {}
+    ~ScopedTradeLatency() {
+        recordTradeLatency(kind, static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                     std::chrono::steady_clock::now() - start).count()));
+    }
+    ScopedTradeLatency(const ScopedTradeLatency&) = delete;
+    ScopedTradeLatency& operator=(const ScopedTradeLatency&) = delete;
+
+private:
+    InstrumentKind kind;
+    std::chrono::steady_clock::time_point start;
+};
+
+// Totals over all threads so far.
+void writeReport(std::ostream& os, ReportFormat format);
+
+// Zeroes every thread's slots (threads recording meanwhile may keep part of their updates).
+void reset();
+
+// Writes the report to 'path' when the process exits normally. Later calls replace the target.
+void writeReportAtExit(const std::string& path, ReportFormat format);
+
+} // namespace instrumentation
+
+#ifdef PRICING_INSTRUMENTATION
+#define PRICING_INSTR_CONCAT_(a, b) a##b
+#define PRICING_INSTR_CONCAT(a, b) PRICING_INSTR_CONCAT_(a, b)
+#define PRICING_SCOPED_TIMER(timer) \
+    ::instrumentation::ScopedTimer PRICING_INSTR_CONCAT(pricingTimer_, __LINE__)(::instrumentation::Timer::timer)
+#define PRICING_TRADE_LATENCY(kind) \
+    ::instrumentation::ScopedTradeLatency PRICING_INSTR_CONCAT(pricingLatency_, __LINE__)(kind)
+#define PRICING_COUNT(counter, n) ::instrumentation::count(::instrumentation::Counter::counter, (n))
+#else
+#define PRICING_SCOPED_TIMER(timer) static_cast<void>(0)
+#define PRICING_TRADE_LATENCY(kind) static_cast<void>(0)
+#define PRICING_COUNT(counter, n) static_cast<void>(0)
+#endif
+
+#endif // INSTRUMENTATION_H
@@ -0,0 +1,96 @@
+#include "MappedFile.h"
+
+#include <fstream>
+#include <utility>
+
+#if !defined(_WIN32) && !defined(_WIN64)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define MAPPED_FILE_USE_MMAP 1
+#endif
+
+MappedFile::~MappedFile() {
+    close();
+}
+
+MappedFile::MappedFile(MappedFile&& other) noexcept {
+    *this = std::move(other);
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept {
+    if (this != &other) {
+        close();
+        ptr = other.ptr;
+        length = other.length;
+        opened = other.opened;
+        mapped = other.mapped;
+        buffer = std::move(other.buffer);
+        if (!mapped && !buffer.empty()) {
+            ptr = buffer.data();
+        }
+        other.ptr = nullptr;
+        other.length = 0;
+        other.opened = false;
+        other.mapped = false;
+    }
+    return *this;
+}
+
+bool MappedFile::open(const std::string& path) {
+    close();
+#if defined(MAPPED_FILE_USE_MMAP)
+    const int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat st;
+    if (::fstat(fd, &st) != 0) {
+        ::close(fd);
+        return false;
+    }
+    length = static_cast<size_t>(st.st_size);
+    if (length > 0) {
+        void* p = ::mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (p == MAP_FAILED) {
+            ::close(fd);
+            length = 0;
+            return false;
+        }
+        ::madvise(p, length, MADV_SEQUENTIAL);
+        ptr = static_cast<const char*>(p);
+        mapped = true;
+    }
+    ::close(fd); // The mapping stays valid after the descriptor is closed
+#else
+    std::ifstream in(path, std::ios::binary | std::ios::ate);
+    if (!in.is_open()) {
+        return false;
+    }
+    const std::streamsize fileSize = in.tellg();
+    in.seekg(0, std::ios::beg);
+    buffer.resize(static_cast<size_t>(fileSize > 0 ? fileSize : 0));
+    if (!buffer.empty() && !in.read(buffer.data(), fileSize)) {
+        buffer.clear();
+        return false;
+    }
+    ptr = buffer.data();
+    length = buffer.size();
+#endif
+    opened = true;
+    return true;
+}
+
+void MappedFile::close() {
+#if defined(MAPPED_FILE_USE_MMAP)
+    if (mapped && ptr) {
+        ::munmap(const_cast<char*>(ptr), length);
+    }
+#endif
+    ptr = nullptr;
+    length = 0;
+    opened = false;
+    mapped = false;
+    buffer.clear();
+}
@@ -0,0 +1,38 @@
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstddef>
+
+// Read-only view of a whole file. On POSIX the file is memory-mapped (no copy, pages are
+// faulted in on demand); on other platforms it is read into an owned buffer.
+class MappedFile {
+public:
+    MappedFile() = default;
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    MappedFile(MappedFile&& other) noexcept;
+    MappedFile& operator=(MappedFile&& other) noexcept;
+
+    // Returns false if the file cannot be opened or mapped. An empty file opens with size() == 0.
+    bool open(const std::string& path);
+    void close();
+
+    bool isOpen() const { return opened; }
+    const char* data() const { return ptr; }
+    size_t size() const { return length; }
+    std::string_view view() const { return std::string_view(ptr, length); }
+
+private:
+    const char* ptr = nullptr;
+    size_t length = 0;
+    bool opened = false;
+    bool mapped = false;       // ptr came from mmap and must be unmapped
+    std::vector<char> buffer;  // Fallback storage when not mapped
+};
+
+#endif // MAPPED_FILE_H
@@ -5,6 +5,7 @@
 #include <sstream>   
 #include <stdexcept> 
 #include <iomanip>   
+#include <atomic>
 
 namespace imp {
     double linearInterpolate(double x0, double y0, double x1, double y1, double x) {
@@ -39,41 +40,42 @@ void RateCurve::addRate(const Date& tenor, double rate) {
         tenorDates.insert(it, tenor);
         rates.insert(rates.begin() + insert_pos, rate);
     }
+    compiled.build(tenorDates, rates);
 }
 
 double RateCurve::getRate(const Date& tenor) const {
-    if (tenorDates.empty()) {
-        std::cerr << "Warning: RateCurve '" << name << "' is empty. Returning 0.0 for getRate." << std::endl;
-        return 0.0; 
-    }
-    // Corrected comparisons:
-    if (tenor <= tenorDates.front()) { 
-        return rates.front();
-    }
-    if (!(tenor < tenorDates.back())) { // tenor >= tenorDates.back()
-        return rates.back();
-    }
-    auto it = std::lower_bound(tenorDates.begin(), tenorDates.end(), tenor);
-    if (it != tenorDates.end() && *it == tenor) {
-        return rates[std::distance(tenorDates.begin(), it)];
-    }
-    if (it == tenorDates.begin()) { 
-        return rates.front();
-    }
-    const Date& x1_date = *it;
-    const Date& x0_date = *(it - 1);
-    double y1 = rates[std::distance(tenorDates.begin(), it)];
-    double y0 = rates[std::distance(tenorDates.begin(), it - 1)];
-    double x0_serial = x0_date.getSerialDate();
-    double x1_serial = x1_date.getSerialDate();
-    double x_serial = tenor.getSerialDate();
-    return imp::linearInterpolate(x0_serial, y0, x1_serial, y1, x_serial);
+    // Callers check isEmpty() before pricing, so no diagnostics on this hot path.
+    PRICING_COUNT(CurveInterpolations, 1);
+    return compiled.valueAt(tenor.getSerialDate());
 }
 
 void RateCurve::shock(double shockValue) {
     for (double& rate : rates) {
         rate += shockValue;
     }
+    compiled.build(tenorDates, rates);
+}
+
+void RateCurve::shockPillar(size_t index, double shockValue) {
+    if (index >= rates.size()) {
+        throw std::out_of_range("RateCurve::shockPillar: pillar " + std::to_string(index) + " out of range for curve " + name);
+    }
+    rates[index] += shockValue;
+    compiled.build(tenorDates, rates);
+}
+
+void RateCurve::setPillars(std::vector<Date> tenors_in, std::vector<double> rates_in) {
+    if (tenors_in.size() != rates_in.size()) {
+        throw std::invalid_argument("RateCurve::setPillars: tenor and rate counts differ for curve " + name);
+    }
+    for (size_t i = 1; i < tenors_in.size(); ++i) {
+        if (!(tenors_in[i - 1] < tenors_in[i])) {
+            throw std::invalid_argument("RateCurve::setPillars: tenors not strictly ascending for curve " + name);
+        }
+    }
+    tenorDates = std::move(tenors_in);
+    rates = std::move(rates_in);
+    compiled.build(tenorDates, rates);
 }
 
 void RateCurve::display() const {
@@ -92,41 +94,41 @@ void VolCurve::addVol(const Date& tenor, double vol) {
         tenors.insert(it, tenor);
         vols.insert(vols.begin() + insert_pos, vol);
     }
+    compiled.build(tenors, vols);
 }
 
 double VolCurve::getVol(const Date& tenor) const {
-    if (tenors.empty()) {
-        std::cerr << "Warning: VolCurve '" << name << "' is empty. Returning 0.0 for getVol." << std::endl;
-        return 0.0; 
-    }
-    // Corrected comparisons:
-    if (tenor <= tenors.front()) {
-        return vols.front();
-    }
-    if (!(tenor < tenors.back())) { // tenor >= tenors.back()
-        return vols.back();
-    }
-    auto it = std::lower_bound(tenors.begin(), tenors.end(), tenor);
-    if (it != tenors.end() && *it == tenor) {
-        return vols[std::distance(tenors.begin(), it)];
-    }
-    if (it == tenors.begin()) {
-        return vols.front();
-    }
-    const Date& x1_date = *it;
-    const Date& x0_date = *(it - 1);
-    double y1 = vols[std::distance(tenors.begin(), it)];
-    double y0 = vols[std::distance(tenors.begin(), it - 1)];
-    double x0_serial = x0_date.getSerialDate();
-    double x1_serial = x1_date.getSerialDate();
-    double x_serial = tenor.getSerialDate();
-    return imp::linearInterpolate(x0_serial, y0, x1_serial, y1, x_serial);
+    PRICING_COUNT(CurveInterpolations, 1);
+    return compiled.valueAt(tenor.getSerialDate());
 }
 
 void VolCurve::shock(double shockValue) {
     for (double& vol_val : vols) { 
         vol_val += shockValue;
     }
+    compiled.build(tenors, vols);
+}
+
+void VolCurve::shockPillar(size_t index, double shockValue) {
+    if (index >= vols.size()) {
+        throw std::out_of_range("VolCurve::shockPillar: pillar " + std::to_string(index) + " out of range for vol curve " + name);
+    }
+    vols[index] += shockValue;
+    compiled.build(tenors, vols);
+}
+
+void VolCurve::setPillars(std::vector<Date> tenors_in, std::vector<double> vols_in) {
+    if (tenors_in.size() != vols_in.size()) {
+        throw std::invalid_argument("VolCurve::setPillars: tenor and vol counts differ for curve " + name);
+    }
+    for (size_t i = 1; i < tenors_in.size(); ++i) {
+        if (!(tenors_in[i - 1] < tenors_in[i])) {
+            throw std::invalid_argument("VolCurve::setPillars: tenors not strictly ascending for curve " + name);
+        }
+    }
+    tenors = std::move(tenors_in);
+    vols = std::move(vols_in);
+    compiled.build(tenors, vols);
 }
 
 void VolCurve::display() const {
@@ -136,118 +138,298 @@ void VolCurve::display() const {
     }
 }
 
-Market::Market() : asOf(Date()), name("defaultMarket") {}
-Market::Market(const Date& now, const std::string& marketName) : asOf(now), name(marketName) {}
+namespace {
+    // Entry 'id' of an ID-indexed table, growing the table if needed.
+    template <typename T>
+    T& tableSlot(std::vector<T>& table, MarketDataId id) {
+        if (id >= table.size()) {
+            table.resize(static_cast<size_t>(id) + 1);
+        }
+        return table[id];
+    }
 
-Market::Market(const Market& other) : asOf(other.asOf), name(other.name) {
-    curvesMap.clear();
-    for (const auto& pair : other.curvesMap) {
-        if (pair.second) { 
-            curvesMap[pair.first] = std::make_shared<RateCurve>(*pair.second);
+    template <typename T>
+    const T* findSlot(const std::vector<T>& table, MarketDataId id) {
+        return id < table.size() ? &table[id] : nullptr;
+    }
+
+    template <typename Curve>
+    std::vector<std::string> heldNames(const std::vector<std::shared_ptr<Curve>>& table) {
+        std::vector<std::string> names;
+        for (size_t id = 0; id < table.size(); ++id) {
+            if (table[id]) names.push_back(marketDataName(static_cast<MarketDataId>(id)));
         }
+        std::sort(names.begin(), names.end());
+        return names;
     }
-    volsMap.clear();
-    for (const auto& pair : other.volsMap) {
-        if (pair.second) { 
-            volsMap[pair.first] = std::make_shared<VolCurve>(*pair.second);
+
+    template <typename Curve>
+    void deepCopyCurves(const std::vector<std::shared_ptr<Curve>>& source, std::vector<std::shared_ptr<Curve>>& target) {
+        target.assign(source.size(), nullptr);
+        for (size_t id = 0; id < source.size(); ++id) {
+            if (source[id]) {
+                target[id] = std::make_shared<Curve>(*source[id]);
+            }
         }
     }
-    bondPricesMap = other.bondPricesMap;
-    stockPricesMap = other.stockPricesMap;
+}
+
+Market::Market() : asOf(Date()), name("defaultMarket") {}
+Market::Market(const Date& now, const std::string& marketName) : asOf(now), name(marketName) {}
+
+Market::Market(const Market& other) : asOf(other.asOf), name(other.name), baseMarket(other.baseMarket) {
+    PRICING_SCOPED_TIMER(MarketCopy);
+    PRICING_COUNT(MarketCopies, 1);
+    deepCopyCurves(other.curves, curves);
+    deepCopyCurves(other.vols, vols);
+    bondPrices = other.bondPrices;
+    stockPrices = other.stockPrices;
+    versions = other.versions;
 }
 
 Market& Market::operator=(const Market& other) {
     if (this == &other) {
         return *this;
     }
+    PRICING_SCOPED_TIMER(MarketCopy);
+    PRICING_COUNT(MarketCopies, 1);
     asOf = other.asOf;
     name = other.name;
-    curvesMap.clear();
-    for (const auto& pair : other.curvesMap) {
-        if (pair.second) {
-            curvesMap[pair.first] = std::make_shared<RateCurve>(*pair.second);
-        }
+    baseMarket = other.baseMarket;
+    deepCopyCurves(other.curves, curves);
+    deepCopyCurves(other.vols, vols);
+    bondPrices = other.bondPrices;
+    stockPrices = other.stockPrices;
+    versions = other.versions;
+    return *this;
+}
+
+Market Market::overlayOf(const Market& base) {
+    Market overlay(base.asOf, base.name);
+    overlay.baseMarket = &base;
+    return overlay;
+}
+
+void Market::shareContentsOf(const Market& source) {
+    if (this == &source) {
+        return;
+    }
+    asOf = source.asOf;
+    name = source.name;
+    baseMarket = nullptr;
+    curves.clear();
+    vols.clear();
+    bondPrices.clear();
+    stockPrices.clear();
+    for (auto& table : versions) table.clear();
+    shareEntriesOf(source);
+}
+
+void Market::shareEntriesOf(const Market& source) {
+    if (source.baseMarket) {
+        shareEntriesOf(*source.baseMarket);
+    }
+    for (size_t id = 0; id < source.curves.size(); ++id) {
+        if (source.curves[id]) tableSlot(curves, static_cast<MarketDataId>(id)) = source.curves[id];
+    }
+    for (size_t id = 0; id < source.vols.size(); ++id) {
+        if (source.vols[id]) tableSlot(vols, static_cast<MarketDataId>(id)) = source.vols[id];
+    }
+    for (size_t id = 0; id < source.bondPrices.size(); ++id) {
+        if (source.bondPrices[id].held) tableSlot(bondPrices, static_cast<MarketDataId>(id)) = source.bondPrices[id];
     }
-    volsMap.clear();
-    for (const auto& pair : other.volsMap) {
-        if (pair.second) {
-            volsMap[pair.first] = std::make_shared<VolCurve>(*pair.second);
+    for (size_t id = 0; id < source.stockPrices.size(); ++id) {
+        if (source.stockPrices[id].held) tableSlot(stockPrices, static_cast<MarketDataId>(id)) = source.stockPrices[id];
+    }
+    for (size_t type = 0; type < versions.size(); ++type) {
+        const std::vector<uint64_t>& stamps = source.versions[type];
+        for (size_t id = 0; id < stamps.size(); ++id) {
+            if (stamps[id] != 0) tableSlot(versions[type], static_cast<MarketDataId>(id)) = stamps[id];
         }
     }
-    bondPricesMap = other.bondPricesMap;
-    stockPricesMap = other.stockPricesMap;
-    return *this;
+}
+
+std::unordered_map<std::string, double> Market::pricesByName(const std::vector<PriceEntry>& prices) {
+    std::unordered_map<std::string, double> byName;
+    for (size_t id = 0; id < prices.size(); ++id) {
+        if (prices[id].held) byName[marketDataName(static_cast<MarketDataId>(id))] = prices[id].price;
+    }
+    return byName;
 }
 
 void Market::Print() const {
     std::cout << "Market Name: " << name << std::endl;
     std::cout << "As Of Date: " << asOf.toString() << std::endl;
-    for (const auto& pair : curvesMap) {
-        if (pair.second) pair.second->display();
+    for (const auto& curve : curves) {
+        if (curve) curve->display();
     }
-    for (const auto& pair : volsMap) {
-        if (pair.second) pair.second->display();
+    for (const auto& volCurve : vols) {
+        if (volCurve) volCurve->display();
     }
     std::cout << "Stock Prices:" << std::endl;
-    for (const auto& pair : stockPricesMap) {
-        std::cout << "  " << pair.first << ": " << pair.second << std::endl;
+    for (size_t id = 0; id < stockPrices.size(); ++id) {
+        if (stockPrices[id].held) {
+            std::cout << "  " << marketDataName(static_cast<MarketDataId>(id)) << ": " << stockPrices[id].price << std::endl;
+        }
     }
     std::cout << "Bond Prices:" << std::endl;
-    for (const auto& pair : bondPricesMap) {
-        std::cout << "  " << pair.first << ": " << pair.second << std::endl;
+    for (size_t id = 0; id < bondPrices.size(); ++id) {
+        if (bondPrices[id].held) {
+            std::cout << "  " << marketDataName(static_cast<MarketDataId>(id)) << ": " << bondPrices[id].price << std::endl;
+        }
+    }
+    if (baseMarket) {
+        std::cout << "(Overlay: entries not listed above are shared with base market '" << baseMarket->name << "')" << std::endl;
     }
 }
 
+std::vector<std::string> Market::getCurveNames() const {
+    return heldNames(curves);
+}
+
+std::vector<std::string> Market::getVolCurveNames() const {
+    return heldNames(vols);
+}
+
+uint64_t Market::getVersion(MarketDataType type, const std::string& entryName) const {
+    // A name never interned was never set in any market.
+    const MarketDataId id = findMarketDataId(entryName);
+    return id == kNoMarketDataId ? 0 : getVersion(type, id);
+}
+
+uint64_t Market::getVersion(MarketDataType type, MarketDataId entryId) const {
+    const uint64_t* stamp = findSlot(versions[static_cast<size_t>(type)], entryId);
+    if (stamp && *stamp != 0) {
+        return *stamp;
+    }
+    return baseMarket ? baseMarket->getVersion(type, entryId) : 0;
+}
+
+void Market::markChanged(MarketDataType type, const std::string& entryName) {
+    markChanged(type, internMarketDataName(entryName));
+}
+
+void Market::markChanged(MarketDataType type, MarketDataId entryId) {
+    static std::atomic<uint64_t> versionCounter{0};
+    tableSlot(versions[static_cast<size_t>(type)], entryId) = ++versionCounter;
+}
+
 void Market::addCurve(const std::string& curveName, std::shared_ptr<RateCurve> curve) {
-    curvesMap[curveName] = curve;
+    const MarketDataId id = internMarketDataName(curveName);
+    tableSlot(curves, id) = curve;
+    markChanged(MarketDataType::RateCurve, id);
 }
 void Market::addVolCurve(const std::string& volCurveName, std::shared_ptr<VolCurve> volCurve) {
-    volsMap[volCurveName] = volCurve;
+    const MarketDataId id = internMarketDataName(volCurveName);
+    tableSlot(vols, id) = volCurve;
+    markChanged(MarketDataType::VolCurve, id);
 }
 void Market::addBondPrice(const std::string& bondName, double price) {
-    bondPricesMap[bondName] = price;
+    const MarketDataId id = internMarketDataName(bondName);
+    tableSlot(bondPrices, id) = PriceEntry{price, true};
+    markChanged(MarketDataType::BondPrice, id);
 }
 void Market::addStockPrice(const std::string& stockName, double price) {
-    stockPricesMap[stockName] = price;
+    const MarketDataId id = internMarketDataName(stockName);
+    tableSlot(stockPrices, id) = PriceEntry{price, true};
+    markChanged(MarketDataType::StockPrice, id);
 }
 
 double Market::getStockPrice(const std::string& stockName) const {
-    auto it = stockPricesMap.find(stockName);
-    if (it != stockPricesMap.end()) {
-        return it->second;
+    const MarketDataId id = findMarketDataId(stockName);
+    if (id == kNoMarketDataId) { // Never interned, so held by no market
+        std::cerr << "Warning: Stock price for '" << stockName << "' not found in Market. Returning 0.0." << std::endl;
+        return 0.0;
+    }
+    return getStockPrice(id);
+}
+
+double Market::getStockPrice(MarketDataId stockId) const {
+    const PriceEntry* entry = findSlot(stockPrices, stockId);
+    if (entry && entry->held) {
+        return entry->price;
+    }
+    if (baseMarket) {
+        return baseMarket->getStockPrice(stockId);
     }
-    std::cerr << "Warning: Stock price for '" << stockName << "' not found in Market. Returning 0.0." << std::endl;
+    std::cerr << "Warning: Stock price for '" << marketDataName(stockId) << "' not found in Market. Returning 0.0." << std::endl;
     return 0.0; 
 }
 
 std::shared_ptr<const RateCurve> Market::getCurve(const std::string& curveName) const {
-    auto it = curvesMap.find(curveName);
-    if (it != curvesMap.end()) {
-        return it->second;
+    const MarketDataId id = findMarketDataId(curveName);
+    if (id == kNoMarketDataId) {
+        PRICING_COUNT(CurveLookups, 1);
+        return nullptr;
+    }
+    return getCurve(id);
+}
+std::shared_ptr<const RateCurve> Market::getCurve(MarketDataId curveId) const {
+    PRICING_COUNT(CurveLookups, 1);
+    const std::shared_ptr<RateCurve>* curve = findSlot(curves, curveId);
+    if (curve && *curve) {
+        return *curve;
+    }
+    if (baseMarket) {
+        return baseMarket->getCurve(curveId);
     }
     // Removed cerr for const getter, as it might be called to check existence.
     // Let caller handle nullptr.
     return nullptr;
 }
 std::shared_ptr<RateCurve> Market::getCurve(const std::string& curveName) {
-    auto it = curvesMap.find(curveName);
-    if (it != curvesMap.end()) {
-        return it->second;
+    PRICING_COUNT(CurveLookups, 1);
+    const MarketDataId id = findMarketDataId(curveName);
+    const std::shared_ptr<RateCurve>* held = findSlot(curves, id);
+    if (held && *held) {
+        markChanged(MarketDataType::RateCurve, id); // The caller may modify it
+        return *held;
+    }
+    if (baseMarket && id != kNoMarketDataId) { // Copy-on-write: take a private copy before handing out mutable access
+        if (std::shared_ptr<const RateCurve> shared = baseMarket->getCurve(id)) {
+            auto own = std::make_shared<RateCurve>(*shared);
+            tableSlot(curves, id) = own;
+            markChanged(MarketDataType::RateCurve, id);
+            return own;
+        }
     }
     std::cerr << "Warning: Rate curve '" << curveName << "' not found in Market (non-const get). Returning nullptr." << std::endl;
     return nullptr;
 }
 std::shared_ptr<const VolCurve> Market::getVolCurve(const std::string& volCurveName) const {
-    auto it = volsMap.find(volCurveName);
-    if (it != volsMap.end()) {
-        return it->second;
+    const MarketDataId id = findMarketDataId(volCurveName);
+    if (id == kNoMarketDataId) {
+        PRICING_COUNT(CurveLookups, 1);
+        return nullptr;
+    }
+    return getVolCurve(id);
+}
+std::shared_ptr<const VolCurve> Market::getVolCurve(MarketDataId volCurveId) const {
+    PRICING_COUNT(CurveLookups, 1);
+    const std::shared_ptr<VolCurve>* volCurve = findSlot(vols, volCurveId);
+    if (volCurve && *volCurve) {
+        return *volCurve;
+    }
+    if (baseMarket) {
+        return baseMarket->getVolCurve(volCurveId);
     }
     return nullptr;
 }
 std::shared_ptr<VolCurve> Market::getVolCurve(const std::string& volCurveName) {
-    auto it = volsMap.find(volCurveName);
-    if (it != volsMap.end()) {
-        return it->second;
+    PRICING_COUNT(CurveLookups, 1);
+    const MarketDataId id = findMarketDataId(volCurveName);
+    const std::shared_ptr<VolCurve>* held = findSlot(vols, id);
+    if (held && *held) {
+        markChanged(MarketDataType::VolCurve, id);
+        return *held;
+    }
+    if (baseMarket && id != kNoMarketDataId) { // Copy-on-write, as for rate curves
+        if (std::shared_ptr<const VolCurve> shared = baseMarket->getVolCurve(id)) {
+            auto own = std::make_shared<VolCurve>(*shared);
+            tableSlot(vols, id) = own;
+            markChanged(MarketDataType::VolCurve, id);
+            return own;
+        }
     }
     std::cerr << "Warning: Vol curve '" << volCurveName << "' not found in Market (non-const get). Returning nullptr." << std::endl;
     return nullptr;
@@ -284,6 +466,8 @@ double Market::parseRateValue(const std::string& rateStr) {
 bool Market::loadCurveDataFromFile(const std::string& filePath, 
                                  const std::string& curveNameInFileHint, 
                                  const std::string& marketCurveNameToStore) {
+    PRICING_SCOPED_TIMER(LoadMarketFile);
+    PRICING_COUNT(FileLoads, 1);
     std::ifstream file(filePath);
     if (!file.is_open()) {
         std::cerr << "Error: Could not open curve data file: " << filePath << std::endl;
@@ -365,6 +549,8 @@ bool Market::loadCurveDataFromFile(const std::string& filePath,
 }
 
 bool Market::loadVolDataFromFile(const std::string& filePath, [[maybe_unused]] const std::string& volCurveNameInFileHint, const std::string& marketVolCurveNameToStore) {
+    PRICING_SCOPED_TIMER(LoadMarketFile);
+    PRICING_COUNT(FileLoads, 1);
     std::ifstream file(filePath);
     if (!file.is_open()) {
         std::cerr << "Error: Could not open vol data file: " << filePath << std::endl;
@@ -439,6 +625,8 @@ bool Market::loadVolDataFromFile(const std::string& filePath, [[maybe_unused]] c
 }
 
 bool Market::loadStockPricesFromFile(const std::string& filePath) {
+    PRICING_SCOPED_TIMER(LoadMarketFile);
+    PRICING_COUNT(FileLoads, 1);
     std::ifstream file(filePath);
     if (!file.is_open()) {
         std::cerr << "Error: Could not open stock prices file: " << filePath << std::endl;
@@ -475,6 +663,8 @@ bool Market::loadStockPricesFromFile(const std::string& filePath) {
 }
 
 bool Market::loadBondPricesFromFile(const std::string& filePath) {
+    PRICING_SCOPED_TIMER(LoadMarketFile);
+    PRICING_COUNT(FileLoads, 1);
     std::ifstream file(filePath);
     if (!file.is_open()) {
         std::cerr << "Error: Could not open bond prices file: " << filePath << std::endl;
@@ -5,12 +5,18 @@
 #include <vector>
 #include <unordered_map>
 #include <string>
+#include <array>
 #include <memory> // Required for std::shared_ptr
+#include <cstdint>
+#include <cstddef>
 #include <algorithm> // Required for std::sort
 #include <fstream>   // Required for file operations in load methods
 #include <sstream>   // Required for parsing lines
 
 #include "Date.h"
+#include "CompiledCurve.h"
+#include "Instrumentation.h"
+#include "MarketDataId.h"
 
 // Forward declaration for imp::linearInterpolate if it's in a separate utility
 // Based on prompt, it was in a namespace `imp`.
@@ -25,8 +31,23 @@ public:
     RateCurve(const std::string& crvName) : name(crvName) {}
     
     void addRate(const Date& tenor, double rate); // tenor const&
-    double getRate(const Date& tenor) const;   // tenor const&
+    double getRate(const Date& tenor) const;   // tenor const&; 0.0 if the curve is empty
     void shock(double shockValue); // Parallel shock all rates
+    void shockPillar(size_t index, double shockValue); // Key-rate shock of one pillar; throws std::out_of_range
+    // Replaces all pillars at once (one compile instead of one per addRate).
+    // tenors must be strictly ascending and the same length as rates.
+    void setPillars(std::vector<Date> tenors, std::vector<double> rates);
+
+    // Batch lookups over serial dates (e.g. a whole cashflow schedule) via the compiled form.
+    void getRates(const long* serials, double* out, size_t n) const {
+        PRICING_COUNT(CurveInterpolations, n);
+        compiled.valuesAt(serials, out, n);
+    }
+    void getDiscountFactors(long asOfSerial, const long* serials, double* out, size_t n) const {
+        PRICING_COUNT(CurveInterpolations, n);
+        compiled.discountFactors(asOfSerial, serials, out, n);
+    }
+    const CompiledCurve& getCompiled() const { return compiled; }
     
     void display() const;
     bool isEmpty() const { return tenorDates.empty(); }
@@ -38,6 +59,7 @@ private:
     std::string name;
     std::vector<Date> tenorDates; // Should be kept sorted by Date for efficient interpolation
     std::vector<double> rates;
+    CompiledCurve compiled; // Rebuilt on every mutation; serves all lookups
 };
 
 class VolCurve {
@@ -46,8 +68,13 @@ public:
     VolCurve(const std::string& crvName) : name(crvName) {}
 
     void addVol(const Date& tenor, double vol); // tenor const&
-    double getVol(const Date& tenor) const;   // tenor const&
+    double getVol(const Date& tenor) const;   // tenor const&; 0.0 if the curve is empty
     void shock(double shockValue); // Parallel shock all vols
+    void shockPillar(size_t index, double shockValue); // One expiry bucket; throws std::out_of_range
+    void setPillars(std::vector<Date> tenors, std::vector<double> vols); // As RateCurve::setPillars
+
+    void getVols(const long* serials, double* out, size_t n) const { compiled.valuesAt(serials, out, n); }
+    const CompiledCurve& getCompiled() const { return compiled; }
 
     void display() const;
     bool isEmpty() const { return tenors.empty(); }
@@ -59,6 +86,28 @@ private:
     std::string name;
     std::vector<Date> tenors; // Should be kept sorted by Date
     std::vector<double> vols;
+    CompiledCurve compiled;
+};
+
+// Identifies one market data entry, e.g. for dependency tracking (see IncrementalValuation.h).
+enum class MarketDataType {
+    RateCurve,
+    VolCurve,
+    StockPrice,
+    BondPrice
+};
+
+struct MarketDataKey {
+    MarketDataType type;
+    std::string name;
+
+    bool operator==(const MarketDataKey& other) const { return type == other.type && name == other.name; }
+};
+
+struct MarketDataKeyHash {
+    size_t operator()(const MarketDataKey& key) const {
+        return std::hash<std::string>()(key.name) * 31 + static_cast<size_t>(key.type);
+    }
 };
 
 class Market {
@@ -73,6 +122,19 @@ public:
     Market& operator=(const Market& other); 
     ~Market() = default;
 
+    // Creates a copy-on-write overlay of 'base': lookups that miss in the overlay fall through
+    // to 'base', so nothing is copied up front. The first non-const getCurve/getVolCurve on the
+    // overlay copies just that curve, leaving the base untouched. Used for shocked markets in
+    // risk runs. 'base' must outlive the overlay (and any copies of it).
+    static Market overlayOf(const Market& base);
+    bool isOverlay() const { return baseMarket != nullptr; }
+
+    // Replaces this market's contents with those of 'source' (including, for an overlay, the
+    // entries it takes from its base), sharing the curve objects instead of copying them and
+    // keeping their version stamps. The result is standalone. Both markets then refer to the
+    // same curves, so neither may modify them afterwards; used to freeze MarketSnapshots.
+    void shareContentsOf(const Market& source);
+
     void Print() const;
     
     void addCurve(const std::string& curveName, std::shared_ptr<RateCurve> curve);
@@ -89,6 +151,29 @@ public:
     std::shared_ptr<const VolCurve> getVolCurve(const std::string& volCurveName) const;
     std::shared_ptr<VolCurve> getVolCurve(const std::string& volCurveName);
 
+    // Lookups by interned name (MarketDataId.h), for pricing paths: an index into this
+    // market's tables, no hashing. Same results as the by-name getters above.
+    double getStockPrice(MarketDataId stockId) const;
+    std::shared_ptr<const RateCurve> getCurve(MarketDataId curveId) const;
+    std::shared_ptr<const VolCurve> getVolCurve(MarketDataId volCurveId) const;
+
+    // Entries held directly by this market, names sorted (an overlay's base is not included).
+    std::vector<std::string> getCurveNames() const;
+    std::vector<std::string> getVolCurveNames() const;
+    std::unordered_map<std::string, double> getStockPrices() const { return pricesByName(stockPrices); } // A copy
+    std::unordered_map<std::string, double> getBondPrices() const { return pricesByName(bondPrices); }
+
+    // Version stamp of an entry: changes whenever the entry is added or replaced (add*, load*),
+    // or handed out for modification (non-const getCurve/getVolCurve). Stamps come from one
+    // process-wide counter, so they are unique across markets; copies keep the stamps of their
+    // source. 0 means the entry was never set (here or, for overlays, in the base).
+    uint64_t getVersion(MarketDataType type, const std::string& entryName) const;
+    uint64_t getVersion(const MarketDataKey& key) const { return getVersion(key.type, key.name); }
+    uint64_t getVersion(MarketDataType type, MarketDataId entryId) const;
+
+    // Call after changing a curve in place through a pointer obtained earlier.
+    void markChanged(MarketDataType type, const std::string& entryName);
+
     // Methods to load data from files - these will modify the market object
     bool loadCurveDataFromFile(const std::string& filePath, const std::string& curveNameInFile, const std::string& marketCurveName);
     bool loadVolDataFromFile(const std::string& filePath, const std::string& volCurveNameInFile, const std::string& marketVolCurveName);
@@ -96,12 +181,27 @@ public:
     bool loadBondPricesFromFile(const std::string& filePath);
 
 private:
-    std::unordered_map<std::string, std::shared_ptr<RateCurve>> curvesMap;
-    std::unordered_map<std::string, std::shared_ptr<VolCurve>> volsMap;
-    std::unordered_map<std::string, double> bondPricesMap;
-    std::unordered_map<std::string, double> stockPricesMap;
+    struct PriceEntry {
+        double price = 0.0;
+        bool held = false;
+    };
+
+    // All tables are indexed by MarketDataId and sized to the largest ID stored; a null curve
+    // or an entry not held means "not in this market".
+    std::vector<std::shared_ptr<RateCurve>> curves;
+    std::vector<std::shared_ptr<VolCurve>> vols;
+    std::vector<PriceEntry> bondPrices;
+    std::vector<PriceEntry> stockPrices;
+
+    // Non-null for overlays: market consulted for anything not held in the tables above.
+    const Market* baseMarket = nullptr;
+
+    std::array<std::vector<uint64_t>, 4> versions; // [MarketDataType][MarketDataId], 0 if never set; see getVersion
+
+    void markChanged(MarketDataType type, MarketDataId entryId);
+    void shareEntriesOf(const Market& source); // shareContentsOf: base entries first, then the source's own
+    static std::unordered_map<std::string, double> pricesByName(const std::vector<PriceEntry>& prices);
 
-    // Helper for parsing tenor strings if not using Date::dateAddTenor directly for this
     static Date parseTenorStrToDate(const Date& baseDate, const std::string& tenorStr); // Keep if used by loading
     static double parseRateValue(const std::string& rateStr); // Keep if used by loading
 
@@ -0,0 +1,54 @@
+#include "MarketDataId.h"
+
+#include <deque>
+#include <mutex>
+#include <shared_mutex>
+#include <unordered_map>
+
+namespace {
+
+struct NameRegistry {
+    std::shared_mutex mutex;
+    std::unordered_map<std::string, MarketDataId> ids;
+    std::deque<std::string> names; // names[id]; a deque so references survive growth
+};
+
+NameRegistry& registry() {
+    static NameRegistry instance;
+    return instance;
+}
+
+} // namespace
+
+MarketDataId internMarketDataName(const std::string& name) {
+    NameRegistry& r = registry();
+    {
+        std::shared_lock<std::shared_mutex> lock(r.mutex);
+        auto it = r.ids.find(name);
+        if (it != r.ids.end()) return it->second;
+    }
+    std::unique_lock<std::shared_mutex> lock(r.mutex);
+    auto inserted = r.ids.emplace(name, static_cast<MarketDataId>(r.names.size()));
+    if (inserted.second) r.names.push_back(name); // Not interned by another thread in between
+    return inserted.first->second;
+}
+
+MarketDataId findMarketDataId(const std::string& name) {
+    NameRegistry& r = registry();
+    std::shared_lock<std::shared_mutex> lock(r.mutex);
+    auto it = r.ids.find(name);
+    return it != r.ids.end() ? it->second : kNoMarketDataId;
+}
+
+const std::string& marketDataName(MarketDataId id) {
+    static const std::string none;
+    NameRegistry& r = registry();
+    std::shared_lock<std::shared_mutex> lock(r.mutex);
+    return id < r.names.size() ? r.names[id] : none;
+}
+
+size_t marketDataIdCount() {
+    NameRegistry& r = registry();
+    std::shared_lock<std::shared_mutex> lock(r.mutex);
+    return r.names.size();
+}
@@ -0,0 +1,30 @@
+#ifndef MARKET_DATA_ID_H
+#define MARKET_DATA_ID_H
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <string>
+
+// Dense integer identifiers for market data names (curves, vol curves, stocks, bonds), shared
+// by every Market and trade in the process. A name is interned once, when the trade or market
+// entry naming it is created; lookups by ID are then a vector index, with no string hashing or
+// allocation on the pricing path. IDs are never reused or released, and the same name always
+// has the same ID whatever its type.
+using MarketDataId = uint32_t;
+
+constexpr MarketDataId kNoMarketDataId = std::numeric_limits<MarketDataId>::max();
+
+// The ID of 'name', assigning the next free one if it was not seen before. Thread-safe.
+MarketDataId internMarketDataName(const std::string& name);
+
+// The ID of 'name' if it was interned, kNoMarketDataId otherwise (nothing is assigned).
+MarketDataId findMarketDataId(const std::string& name);
+
+// The name interned as 'id' (empty for kNoMarketDataId or an ID never assigned). The reference
+// stays valid for the life of the process.
+const std::string& marketDataName(MarketDataId id);
+
+size_t marketDataIdCount();
+
+#endif // MARKET_DATA_ID_H
@@ -0,0 +1,194 @@
+#include "MarketDataLoader.h"
+
+#include <algorithm>
+#include <cctype>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <unordered_map>
+#include <unordered_set>
+
+#include "IncrementalValuation.h" // IncrementalValuationService::dependenciesOf
+#include "Utils.h"
+
+namespace {
+
+const char* sourceTypeName(MarketDataType type) {
+    switch (type) {
+    case MarketDataType::RateCurve: return "rate curve";
+    case MarketDataType::VolCurve: return "vol curve";
+    case MarketDataType::StockPrice: return "stock prices";
+    case MarketDataType::BondPrice: return "bond prices";
+    }
+    return "market data";
+}
+
+bool isPriceTable(MarketDataType type) {
+    return type == MarketDataType::StockPrice || type == MarketDataType::BondPrice;
+}
+
+// Reads one source into 'scratch'.
+bool loadSource(const MarketDataSource& source, Market& scratch) {
+    switch (source.type) {
+    case MarketDataType::RateCurve: return scratch.loadCurveDataFromFile(source.path, source.name, source.name);
+    case MarketDataType::VolCurve: return scratch.loadVolDataFromFile(source.path, source.name, source.name);
+    case MarketDataType::StockPrice: return scratch.loadStockPricesFromFile(source.path);
+    case MarketDataType::BondPrice: return scratch.loadBondPricesFromFile(source.path);
+    }
+    return false;
+}
+
+} // namespace
+
+MarketDataCatalog MarketDataCatalog::defaultCatalog() {
+    MarketDataCatalog catalog;
+    catalog.add({MarketDataType::RateCurve, "USD-SOFR", "curve.txt"});
+    catalog.add({MarketDataType::RateCurve, "SGD-SORA", "sgd_curve.txt"});
+    catalog.add({MarketDataType::VolCurve, "VOL_CURVE_DEFAULT", "vol.txt"});
+    catalog.add({MarketDataType::VolCurve, "VOL_APPL", "vol_appl.txt"});
+    catalog.add({MarketDataType::StockPrice, "", "stockPrice.txt"});
+    catalog.add({MarketDataType::BondPrice, "", "bondPrice.txt"});
+    return catalog;
+}
+
+bool MarketDataCatalog::loadFromFile(const std::string& filePath) {
+    std::ifstream file(filePath);
+    if (!file.is_open()) {
+        std::cerr << "Error: Could not open market data catalog " << filePath << std::endl;
+        return false;
+    }
+    const size_t slash = filePath.find_last_of("/\\");
+    const std::string directory = (slash == std::string::npos) ? std::string() : filePath.substr(0, slash + 1);
+
+    std::string line;
+    std::vector<std::string> tokens;
+    size_t lineNumber = 0;
+    while (std::getline(file, line)) {
+        ++lineNumber;
+        splitString(tokens, line, ';');
+        if (tokens.empty() || tokens[0].empty() || tokens[0][0] == '#') continue;
+        std::string type = tokens[0];
+        std::transform(type.begin(), type.end(), type.begin(), [](unsigned char c) { return std::tolower(c); });
+        MarketDataSource source;
+        if (type == "rate") {
+            source.type = MarketDataType::RateCurve;
+        } else if (type == "vol") {
+            source.type = MarketDataType::VolCurve;
+        } else if (type == "stocks") {
+            source.type = MarketDataType::StockPrice;
+        } else if (type == "bonds") {
+            source.type = MarketDataType::BondPrice;
+        } else {
+            std::cerr << "Warning: Skipping catalog line " << lineNumber << " in " << filePath << ": unknown type '"
+                      << tokens[0] << "'." << std::endl;
+            continue;
+        }
+        if (tokens.size() < 3 || tokens[2].empty() || (!isPriceTable(source.type) && tokens[1].empty())) {
+            std::cerr << "Warning: Skipping catalog line " << lineNumber << " in " << filePath
+                      << ": expected type;name;path." << std::endl;
+            continue;
+        }
+        if (!isPriceTable(source.type)) source.name = tokens[1];
+        const bool absolute = tokens[2][0] == '/' || (tokens[2].size() > 1 && tokens[2][1] == ':');
+        source.path = absolute ? tokens[2] : directory + tokens[2];
+        add(source);
+    }
+    return true;
+}
+
+MarketDataLoadReport loadMarketDataFor(const std::vector<std::shared_ptr<Trade>>& portfolio,
+                                       const MarketDataCatalog& catalog, Market& market,
+                                       ThreadPool* pool, bool loadAll) {
+    std::unordered_set<MarketDataKey, MarketDataKeyHash> referenced;
+    bool needsPrices = false;
+    for (const auto& trade : portfolio) {
+        if (!trade) continue;
+        for (MarketDataKey& key : IncrementalValuationService::dependenciesOf(*trade)) {
+            if (isPriceTable(key.type)) {
+                needsPrices = true;
+            } else {
+                referenced.insert(std::move(key));
+            }
+        }
+    }
+
+    // Selection, keeping only the last source of each curve name.
+    const std::vector<MarketDataSource>& sources = catalog.sources();
+    std::unordered_map<MarketDataKey, size_t, MarketDataKeyHash> lastSource;
+    for (size_t i = 0; i < sources.size(); ++i) {
+        if (!isPriceTable(sources[i].type)) lastSource[MarketDataKey{sources[i].type, sources[i].name}] = i;
+    }
+    MarketDataLoadReport report;
+    std::vector<size_t> selected;
+    for (size_t i = 0; i < sources.size(); ++i) {
+        const MarketDataSource& source = sources[i];
+        bool wanted;
+        if (isPriceTable(source.type)) {
+            wanted = loadAll || needsPrices;
+        } else {
+            const MarketDataKey key{source.type, source.name};
+            wanted = lastSource[key] == i && (loadAll || referenced.count(key) > 0);
+        }
+        if (wanted) {
+            selected.push_back(i);
+        } else {
+            ++report.filesSkipped;
+        }
+    }
+
+    // provider[key]: catalog index of the source the market's entry came from.
+    std::mutex mergeMutex;
+    std::unordered_map<MarketDataKey, size_t, MarketDataKeyHash> provider;
+    auto takeEntry = [&](MarketDataType type, const std::string& name, size_t sourceIndex) {
+        auto inserted = provider.emplace(MarketDataKey{type, name}, sourceIndex);
+        if (!inserted.second && inserted.first->second > sourceIndex) return false;
+        inserted.first->second = sourceIndex;
+        return true;
+    };
+    auto loadRange = [&](size_t begin, size_t end, size_t) {
+        for (size_t s = begin; s < end; ++s) {
+            const size_t sourceIndex = selected[s];
+            const MarketDataSource& source = sources[sourceIndex];
+            Market scratch(market.asOf, market.name);
+            const bool ok = loadSource(source, scratch);
+
+            std::lock_guard<std::mutex> lock(mergeMutex);
+            if (!ok) {
+                ++report.filesFailed;
+                std::cerr << "Warning: Failed to load " << sourceTypeName(source.type)
+                          << (source.name.empty() ? "" : " '" + source.name + "'") << " from " << source.path << "."
+                          << std::endl;
+                continue;
+            }
+            ++report.filesLoaded;
+            for (const std::string& name : scratch.getCurveNames()) {
+                if (takeEntry(MarketDataType::RateCurve, name, sourceIndex)) market.addCurve(name, scratch.getCurve(name));
+            }
+            for (const std::string& name : scratch.getVolCurveNames()) {
+                if (takeEntry(MarketDataType::VolCurve, name, sourceIndex)) market.addVolCurve(name, scratch.getVolCurve(name));
+            }
+            for (const auto& price : scratch.getStockPrices()) {
+                if (takeEntry(MarketDataType::StockPrice, price.first, sourceIndex)) market.addStockPrice(price.first, price.second);
+            }
+            for (const auto& price : scratch.getBondPrices()) {
+                if (takeEntry(MarketDataType::BondPrice, price.first, sourceIndex)) market.addBondPrice(price.first, price.second);
+            }
+        }
+    };
+    if (pool) {
+        pool->parallelFor(selected.size(), 1, loadRange);
+    } else {
+        loadRange(0, selected.size(), 0);
+    }
+
+    const Market& loaded = market;
+    for (const MarketDataKey& key : referenced) {
+        const bool present = (key.type == MarketDataType::RateCurve) ? loaded.getCurve(key.name) != nullptr
+                                                                     : loaded.getVolCurve(key.name) != nullptr;
+        if (!present) report.unresolved.push_back(key);
+    }
+    std::sort(report.unresolved.begin(), report.unresolved.end(), [](const MarketDataKey& a, const MarketDataKey& b) {
+        return (a.type != b.type) ? a.type < b.type : a.name < b.name;
+    });
+    return report;
+}
@@ -0,0 +1,63 @@
+#ifndef MARKET_DATA_LOADER_H
+#define MARKET_DATA_LOADER_H
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "Market.h"
+#include "Trade.h"
+#include "ThreadPool.h"
+
+// Where one market data entry is loaded from. Rate and vol curves are one file per name, read
+// with Market::loadCurveDataFromFile/loadVolDataFromFile; StockPrice and BondPrice sources are
+// price tables (Market::loadStockPricesFromFile/loadBondPricesFromFile) for any number of
+// names, so their name is empty.
+struct MarketDataSource {
+    MarketDataType type = MarketDataType::RateCurve;
+    std::string name;
+    std::string path;
+};
+
+class MarketDataCatalog {
+public:
+    void add(const MarketDataSource& source) { entries.push_back(source); }
+    const std::vector<MarketDataSource>& sources() const { return entries; }
+
+    // The files main has always read: curve.txt (USD-SOFR), sgd_curve.txt (SGD-SORA),
+    // vol.txt (VOL_CURVE_DEFAULT), vol_appl.txt (VOL_APPL), stockPrice.txt and bondPrice.txt.
+    static MarketDataCatalog defaultCatalog();
+
+    // Appends the ';'-separated entries of a catalog file, one per line:
+    //   rate;USD-SOFR;curves/usd_sofr.txt
+    //   vol;VOL_APPL;vols/appl.txt
+    //   stocks;;stockPrice.txt
+    //   bonds;;bondPrice.txt
+    // Relative paths are taken from the catalog file's directory. Blank lines and '#' comments
+    // are skipped, malformed lines reported and skipped. Returns false if the file cannot be opened.
+    bool loadFromFile(const std::string& filePath);
+
+private:
+    std::vector<MarketDataSource> entries;
+};
+
+struct MarketDataLoadReport {
+    size_t filesLoaded = 0;
+    size_t filesFailed = 0;
+    size_t filesSkipped = 0;                // Catalog entries no trade references
+    std::vector<MarketDataKey> unresolved;  // Curves the portfolio references that no source provides
+};
+
+// Loads into 'market' the catalog entries the portfolio needs: the rate and vol curves its
+// trades name (IncrementalValuationService::dependenciesOf), and the price tables if any trade
+// has an underlying. With loadAll, every entry is loaded. Files are read concurrently on
+// 'pool' (an I/O pool may be larger than the core count), each into a private Market, and
+// merged into 'market' under a lock as soon as it is parsed. Failed files are reported with a
+// warning and counted. If several sources provide a name, the last one in the catalog wins,
+// whatever order the files finish in.
+MarketDataLoadReport loadMarketDataFor(const std::vector<std::shared_ptr<Trade>>& portfolio,
+                                       const MarketDataCatalog& catalog, Market& market,
+                                       ThreadPool* pool = nullptr, bool loadAll = false);
+
+#endif // MARKET_DATA_LOADER_H
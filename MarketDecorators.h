@@ -8,14 +8,25 @@
 #include <memory>  // For std::make_shared
 
 // Structure to define a market shock
-// For parallel shocks, tenor in 'shock' pair might be ignored or default Date() if not used.
 // shock_value is the amount to bump (e.g., 0.0001 for 1bp, 0.01 for 1% vol).
+// pillar_index selects a single pillar of the curve (key-rate / vega bucket shock); -1 shocks
+// every pillar (parallel shock).
 struct MarketShock {
     std::string market_id; // Name of the curve/vol surface to shock (e.g., "USD-SOFR", "VOL_CURVE_AAPL")
-    // Date tenor; // Specific tenor to shock - not used for parallel shock as per prompt
     double shock_value; // The actual bump amount (e.g., +0.0001 or -0.0001)
+    int pillar_index = -1; // Index into the curve's pillars, or -1 for a parallel shock
 };
 
+// Parallel or single-pillar bump of a RateCurve/VolCurve, as selected by shock.pillar_index.
+template <typename Curve>
+void applyShock(Curve& curve, const MarketShock& shock, double amount) {
+    if (shock.pillar_index >= 0) {
+        curve.shockPillar(static_cast<size_t>(shock.pillar_index), amount);
+    } else {
+        curve.shock(amount);
+    }
+}
+
 // Base class for Market Decorators (optional, but can be good practice if more decorators arise)
 // For this project, CurveDecorator and VolDecorator can directly use/modify Market objects.
 // The prompt's sample CurveDecorator directly holds two Market objects (up/down).
@@ -24,14 +35,16 @@ struct MarketShock {
 class CurveDecorator {
 public:
     // Constructor takes the original market and the shock details.
-    // It creates two new Market objects: one for bumped up, one for bumped down.
+    // It creates two copy-on-write overlays of it: one bumped up, one bumped down.
+    // Only the shocked curve is copied; everything else is shared with original_market,
+    // which must therefore outlive the decorator.
     CurveDecorator(const Market& original_market, const MarketShock& curve_shock_details) 
-        : marketUp(original_market), marketDown(original_market) {
+        : marketUp(Market::overlayOf(original_market)), marketDown(Market::overlayOf(original_market)) {
         
         // Apply upward shock
         std::shared_ptr<RateCurve> curveToShockUp = marketUp.getCurve(curve_shock_details.market_id);
         if (curveToShockUp) {
-            curveToShockUp->shock(curve_shock_details.shock_value); // Parallel shock
+            applyShock(*curveToShockUp, curve_shock_details, curve_shock_details.shock_value);
         } else {
             std::cerr << "Warning: CurveDecorator could not find curve '" << curve_shock_details.market_id << "' in marketUp to shock." << std::endl;
         }
@@ -39,7 +52,7 @@ public:
         // Apply downward shock
         std::shared_ptr<RateCurve> curveToShockDown = marketDown.getCurve(curve_shock_details.market_id);
         if (curveToShockDown) {
-            curveToShockDown->shock(-curve_shock_details.shock_value); // Parallel shock (opposite direction)
+            applyShock(*curveToShockDown, curve_shock_details, -curve_shock_details.shock_value); // Opposite direction
         } else {
             std::cerr << "Warning: CurveDecorator could not find curve '" << curve_shock_details.market_id << "' in marketDown to shock." << std::endl;
         }
@@ -49,20 +62,21 @@ public:
     const Market& getMarketDown() const { return marketDown; }
 
 private:
-    Market marketUp;   // A deep copy of the original market, with one curve bumped up
-    Market marketDown; // A deep copy of the original market, with one curve bumped down
+    Market marketUp;   // Overlay of the original market, with one curve bumped up
+    Market marketDown; // Overlay of the original market, with one curve bumped down
 };
 
 // Decorator for Volatility Curve shocks
 class VolDecorator {
 public:
+    // Same overlay scheme as CurveDecorator: only the shocked vol curve is copied.
     VolDecorator(const Market& original_market, const MarketShock& vol_shock_details)
-        : marketUp(original_market), marketDown(original_market) {
+        : marketUp(Market::overlayOf(original_market)), marketDown(Market::overlayOf(original_market)) {
 
         // Apply upward shock
         std::shared_ptr<VolCurve> volToShockUp = marketUp.getVolCurve(vol_shock_details.market_id);
         if (volToShockUp) {
-            volToShockUp->shock(vol_shock_details.shock_value);
+            applyShock(*volToShockUp, vol_shock_details, vol_shock_details.shock_value);
         } else {
             std::cerr << "Warning: VolDecorator could not find vol curve '" << vol_shock_details.market_id << "' in marketUp to shock." << std::endl;
         }
@@ -70,7 +84,7 @@ public:
         // Apply downward shock
         std::shared_ptr<VolCurve> volToShockDown = marketDown.getVolCurve(vol_shock_details.market_id);
         if (volToShockDown) {
-            volToShockDown->shock(-vol_shock_details.shock_value);
+            applyShock(*volToShockDown, vol_shock_details, -vol_shock_details.shock_value);
         } else {
             std::cerr << "Warning: VolDecorator could not find vol curve '" << vol_shock_details.market_id << "' in marketDown to shock." << std::endl;
         }
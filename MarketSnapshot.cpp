@@ -0,0 +1,112 @@
+#include "MarketSnapshot.h"
+
+#include <functional>
+#include <limits>
+#include <stdexcept>
+#include <thread>
+
+namespace {
+
+const Market& baseMarketOf(const MarketSnapshotPtr& base) {
+    if (!base) {
+        throw std::invalid_argument("MarketSnapshotBuilder: base snapshot is null.");
+    }
+    return base->market();
+}
+
+} // namespace
+
+MarketSnapshot::MarketSnapshot(const Market& source, uint64_t version) : sequence(version) {
+    contents.shareContentsOf(source);
+}
+
+MarketSnapshotBuilder::MarketSnapshotBuilder(const Date& asOf, const std::string& marketName)
+    : working(asOf, marketName) {}
+
+MarketSnapshotBuilder::MarketSnapshotBuilder(MarketSnapshotPtr base_in)
+    : base(std::move(base_in)), working(Market::overlayOf(baseMarketOf(base))) {}
+
+void MarketSnapshotBuilder::rebase(MarketSnapshotPtr published) {
+    base = std::move(published);
+    working = Market::overlayOf(base->market());
+}
+
+MarketSnapshotPublisher::MarketSnapshotPublisher(size_t readerSlots)
+    : slots(new ReaderSlot[readerSlots > 0 ? readerSlots : 1]), slotCount(readerSlots > 0 ? readerSlots : 1),
+      current(new MarketSnapshotPtr(new MarketSnapshot(Market(), 0))) {}
+
+MarketSnapshotPublisher::~MarketSnapshotPublisher() {
+    // No reader may be inside acquire() once the publisher is being destroyed.
+    delete current.load();
+    for (const auto& cell : retired) delete cell.first;
+}
+
+MarketSnapshotPtr MarketSnapshotPublisher::acquire() const {
+    // Announce the epoch before loading the pointer (both seq_cst): a publisher that retires a
+    // cell after our load then sees our slot, and one that retired it before our announcement
+    // has already swapped it out, so we cannot load it.
+    const uint64_t announced = epoch.load();
+    thread_local size_t hint = std::hash<std::thread::id>()(std::this_thread::get_id());
+    ReaderSlot* slot = nullptr;
+    for (size_t attempt = 0; !slot; ++attempt) {
+        ReaderSlot& candidate = slots[(hint + attempt) % slotCount];
+        uint64_t expected = 0;
+        if (candidate.epoch.compare_exchange_strong(expected, announced)) {
+            slot = &candidate;
+            hint += attempt;
+        } else if (attempt > 0 && attempt % slotCount == 0) {
+            std::this_thread::yield(); // Every slot busy
+        }
+    }
+    MarketSnapshotPtr snapshot = *current.load();
+    slot->epoch.store(0, std::memory_order_release);
+    return snapshot;
+}
+
+uint64_t MarketSnapshotPublisher::publish(MarketSnapshotBuilder& builder) {
+    std::lock_guard<std::mutex> lock(writerMutex);
+    return publishLocked(builder);
+}
+
+uint64_t MarketSnapshotPublisher::publishIfCurrent(MarketSnapshotBuilder& builder) {
+    std::lock_guard<std::mutex> lock(writerMutex);
+    if (builder.base != *current.load()) {
+        return 0;
+    }
+    return publishLocked(builder);
+}
+
+size_t MarketSnapshotPublisher::reclaim() {
+    std::lock_guard<std::mutex> lock(writerMutex);
+    return reclaimLocked();
+}
+
+uint64_t MarketSnapshotPublisher::publishLocked(MarketSnapshotBuilder& builder) {
+    const uint64_t version = lastVersion + 1;
+    MarketSnapshotPtr snapshot(new MarketSnapshot(builder.working, version));
+    const MarketSnapshotPtr* previous = current.exchange(new MarketSnapshotPtr(snapshot));
+    // Readers announcing this epoch or later loaded the new cell.
+    retired.emplace_back(previous, epoch.fetch_add(1) + 1);
+    lastVersion = version;
+    builder.rebase(std::move(snapshot));
+    reclaimLocked();
+    return version;
+}
+
+size_t MarketSnapshotPublisher::reclaimLocked() {
+    uint64_t oldestReader = std::numeric_limits<uint64_t>::max();
+    for (size_t i = 0; i < slotCount; ++i) {
+        const uint64_t e = slots[i].epoch.load();
+        if (e != 0 && e < oldestReader) oldestReader = e;
+    }
+    size_t kept = 0;
+    for (const auto& cell : retired) {
+        if (cell.second <= oldestReader) {
+            delete cell.first; // Drops the publisher's reference; readers may still hold the snapshot
+        } else {
+            retired[kept++] = cell;
+        }
+    }
+    retired.resize(kept);
+    return kept;
+}
@@ -0,0 +1,124 @@
+#ifndef MARKET_SNAPSHOT_H
+#define MARKET_SNAPSHOT_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "Date.h"
+#include "Market.h"
+
+class MarketSnapshot;
+using MarketSnapshotPtr = std::shared_ptr<const MarketSnapshot>;
+
+// An immutable, versioned Market as published by MarketSnapshotPublisher. Only the const
+// Market interface is reachable, so any number of threads may price against it. Curves that
+// did not change between two snapshots are the same objects in both, and keep their
+// Market::getVersion stamps, so IncrementalValuationService::refresh(snapshot->market())
+// reprices only the trades touched by an update.
+class MarketSnapshot {
+public:
+    const Market& market() const { return contents; }
+    uint64_t version() const { return sequence; } // 0 for a publisher's initial empty snapshot
+
+private:
+    friend class MarketSnapshotPublisher;
+
+    MarketSnapshot(const Market& source, uint64_t version); // Shares source's curves (Market::shareContentsOf)
+
+    Market contents;
+    uint64_t sequence;
+};
+
+// The next snapshot, built off to the side. market() is a private working Market: either
+// empty, or a copy-on-write overlay of a published snapshot (non-const getCurve/getVolCurve
+// copy the curve first, so published data is never modified). Load, add or bump anything on
+// it, then hand the builder to MarketSnapshotPublisher::publish.
+class MarketSnapshotBuilder {
+public:
+    MarketSnapshotBuilder(const Date& asOf, const std::string& marketName = "defaultMarket");
+    explicit MarketSnapshotBuilder(MarketSnapshotPtr base);
+
+    MarketSnapshotBuilder(const MarketSnapshotBuilder&) = delete;
+    MarketSnapshotBuilder& operator=(const MarketSnapshotBuilder&) = delete;
+
+    Market& market() { return working; }
+    const MarketSnapshotPtr& getBase() const { return base; } // Null for a builder started empty
+
+private:
+    friend class MarketSnapshotPublisher;
+
+    void rebase(MarketSnapshotPtr published); // After publish: an empty overlay of 'published'
+
+    MarketSnapshotPtr base; // Keeps the overlay's base alive
+    Market working;
+};
+
+// RCU-style publication of MarketSnapshots. acquire() is lock-free: the reader announces the
+// current epoch in a free reader slot, loads the published pointer, takes a reference to the
+// snapshot and clears its slot. publish() swaps in the new snapshot with one atomic exchange
+// and retires the old pointer; a retired pointer is freed once every reader that could still
+// be reading it has cleared its slot (checked on each publish and by reclaim()). Snapshots
+// are reference counted, so one stays alive for as long as any reader holds it, and is freed
+// when the last reader lets go of it.
+//
+//   MarketSnapshotPublisher publisher;
+//   MarketSnapshotBuilder next(valueDate, "Live");
+//   next.market().loadCurveDataFromFile("curve.txt", "USD-SOFR", "USD-SOFR");
+//   publisher.publish(next);                          // Loader thread
+//   MarketSnapshotPtr view = publisher.acquire();     // Pricing threads, no lock
+//   pricer.Price(view->market(), trade);
+//
+// Publishers are serialized by a mutex; readers never wait for them.
+class MarketSnapshotPublisher {
+public:
+    // readerSlots bounds the number of acquire() calls running at the same moment (further
+    // callers spin until a slot frees up); it is not a limit on reader threads.
+    explicit MarketSnapshotPublisher(size_t readerSlots = 64);
+    ~MarketSnapshotPublisher();
+
+    MarketSnapshotPublisher(const MarketSnapshotPublisher&) = delete;
+    MarketSnapshotPublisher& operator=(const MarketSnapshotPublisher&) = delete;
+
+    // The latest published snapshot (never null).
+    MarketSnapshotPtr acquire() const;
+
+    // Builder over the latest snapshot.
+    MarketSnapshotBuilder beginUpdate() const { return MarketSnapshotBuilder(acquire()); }
+
+    // Publishes the builder's market as the next version and returns that version. The builder
+    // is left as an empty overlay of the new snapshot, ready for the next update. Last writer
+    // wins: changes published by others since the builder's base was taken are replaced.
+    uint64_t publish(MarketSnapshotBuilder& builder);
+
+    // As publish, but only if the builder's base is still the latest snapshot; returns the new
+    // version, or 0 (the builder untouched) if another update was published in between.
+    uint64_t publishIfCurrent(MarketSnapshotBuilder& builder);
+
+    // Frees the retired pointers no reader can still hold; returns how many remain retired.
+    size_t reclaim();
+
+private:
+    struct alignas(64) ReaderSlot {
+        std::atomic<uint64_t> epoch{0}; // 0: free; otherwise the epoch its reader started in
+    };
+
+    uint64_t publishLocked(MarketSnapshotBuilder& builder);
+    size_t reclaimLocked();
+
+    std::unique_ptr<ReaderSlot[]> slots;
+    size_t slotCount;
+    std::atomic<const MarketSnapshotPtr*> current; // Heap cell owned by the publisher
+    std::atomic<uint64_t> epoch{1};
+
+    std::mutex writerMutex;
+    uint64_t lastVersion = 0;
+    std::vector<std::pair<const MarketSnapshotPtr*, uint64_t>> retired; // (cell, epoch it was retired in)
+};
+
+#endif // MARKET_SNAPSHOT_H
@@ -1,13 +1,52 @@
 #include "MathUtils.h"
 #include <stdexcept> // For std::invalid_argument
 #include <algorithm> // For std::max <<-- THIS IS THE FIX
+#include <limits>
 #include <cmath>     // For std::exp, std::log, std::sqrt, std::erf, M_SQRT1_2 (already there via MathUtils.h indirectly)
 
+#if defined(__AVX2__) && defined(__FMA__)
+#include <immintrin.h>
+#define MATHUTILS_HAVE_AVX2 1
+#endif
+
 // Cumulative Distribution Function for Standard Normal Distribution
 double normalCDF(double x) {
     return 0.5 * (1.0 + std::erf(x * M_SQRT1_2));
 }
 
+double inverseNormalCDF(double p) {
+    if (p <= 0.0) return -std::numeric_limits<double>::infinity();
+    if (p >= 1.0) return std::numeric_limits<double>::infinity();
+    static const double a[] = {-3.969683028665376e+01, 2.209460984245205e+02, -2.759285104469687e+02,
+                               1.383577518672690e+02, -3.066479806614716e+01, 2.506628277459239e+00};
+    static const double b[] = {-5.447609879822406e+01, 1.615858368580409e+02, -1.556989798598866e+02,
+                               6.680131188771972e+01, -1.328068155288572e+01};
+    static const double c[] = {-7.784894002430293e-03, -3.223964580411365e-01, -2.400758277161838e+00,
+                               -2.549732539343734e+00, 4.374664141464968e+00, 2.938163982698783e+00};
+    static const double d[] = {7.784695709041462e-03, 3.224671290700398e-01, 2.445134137142996e+00,
+                               3.754408661907416e+00};
+    const double pLow = 0.02425;
+    double x;
+    if (p < pLow) {
+        const double q = std::sqrt(-2.0 * std::log(p));
+        x = (((((c[0] * q + c[1]) * q + c[2]) * q + c[3]) * q + c[4]) * q + c[5]) /
+            ((((d[0] * q + d[1]) * q + d[2]) * q + d[3]) * q + 1.0);
+    } else if (p <= 1.0 - pLow) {
+        const double q = p - 0.5;
+        const double r = q * q;
+        x = (((((a[0] * r + a[1]) * r + a[2]) * r + a[3]) * r + a[4]) * r + a[5]) * q /
+            (((((b[0] * r + b[1]) * r + b[2]) * r + b[3]) * r + b[4]) * r + 1.0);
+    } else {
+        const double q = std::sqrt(-2.0 * std::log1p(-p));
+        x = -(((((c[0] * q + c[1]) * q + c[2]) * q + c[3]) * q + c[4]) * q + c[5]) /
+            ((((d[0] * q + d[1]) * q + d[2]) * q + d[3]) * q + 1.0);
+    }
+    // Halley step on normalCDF(x) - p, with the tail evaluated through erfc to keep precision.
+    const double e = 0.5 * std::erfc(-x * M_SQRT1_2) - p;
+    const double u = e * 2.50662827463100050242 * std::exp(0.5 * x * x);
+    return x - u / (1.0 + 0.5 * x * u);
+}
+
 // Black-Scholes formula for European call/put options
 double blackScholesPrice(OptionType optionType, 
                          double S, double K, 
@@ -57,3 +96,220 @@ double blackScholesPrice(OptionType optionType,
         return 0.0; 
     }
 }
+
+BlackScholesGreeks blackScholesGreeks(OptionType optionType,
+                                      double S, double K,
+                                      double T, double r,
+                                      double sigma) {
+    BlackScholesGreeks g;
+    if (optionType != Call && optionType != Put) {
+        return g; // Same convention as blackScholesPrice
+    }
+    if (T < 0) T = 0.0;
+    sigma = std::abs(sigma);
+    g.price = blackScholesPrice(optionType, S, K, T, r, sigma);
+
+    const double df = std::exp(-r * T);
+    if (K <= 1e-9 || S <= 1e-9 || T <= 1e-9 || sigma <= 1e-9) {
+        // Degenerate cases price at (discounted) intrinsic value; report that value's Greeks.
+        const double forwardIntrinsic = (optionType == Call) ? S - K * df : K * df - S;
+        if (forwardIntrinsic > 0.0) {
+            const double sign = (optionType == Call) ? 1.0 : -1.0;
+            g.delta = sign;
+            g.theta = -sign * r * K * df;
+            g.rho = sign * K * T * df;
+        }
+        return g;
+    }
+
+    const double sqrtT = std::sqrt(T);
+    const double d1 = (std::log(S / K) + (r + 0.5 * sigma * sigma) * T) / (sigma * sqrtT);
+    const double d2 = d1 - sigma * sqrtT;
+    const double pdf1 = std::exp(-0.5 * d1 * d1) / std::sqrt(2.0 * M_PI);
+    const double Kdf = K * df;
+
+    g.gamma = pdf1 / (S * sigma * sqrtT);
+    g.vega = S * pdf1 * sqrtT;
+    const double thetaDiffusion = -S * pdf1 * sigma / (2.0 * sqrtT);
+    if (optionType == Call) {
+        const double Nd2 = normalCDF(d2);
+        g.delta = normalCDF(d1);
+        g.theta = thetaDiffusion - r * Kdf * Nd2;
+        g.rho = T * Kdf * Nd2;
+    } else {
+        const double Nmd2 = normalCDF(-d2);
+        g.delta = -normalCDF(-d1);
+        g.theta = thetaDiffusion + r * Kdf * Nmd2;
+        g.rho = -T * Kdf * Nmd2;
+    }
+    return g;
+}
+
+namespace {
+    // Lanes the closed-form vector path handles; everything else goes through blackScholesGreeks.
+    inline bool isRegularLane(OptionType type, double S, double K, double T, double sigma) {
+        return (type == Call || type == Put) && S > 1e-9 && K > 1e-9 && T > 1e-9 && sigma > 1e-9;
+    }
+
+    inline void storeScalarLane(const BlackScholesBatchInput& in, const BlackScholesBatchOutput& out, size_t i) {
+        const BlackScholesGreeks g = blackScholesGreeks(in.type[i], in.S[i], in.K[i], in.T[i], in.r[i], in.sigma[i]);
+        out.price[i] = g.price;
+        if (out.delta) out.delta[i] = g.delta;
+        if (out.gamma) out.gamma[i] = g.gamma;
+        if (out.vega) out.vega[i] = g.vega;
+        if (out.theta) out.theta[i] = g.theta;
+        if (out.rho) out.rho[i] = g.rho;
+    }
+
+#if MATHUTILS_HAVE_AVX2
+    // exp(x): 2^n * exp(r) with |r| <= ln2/2 and a degree-13 Taylor polynomial for exp(r).
+    inline __m256d exp256(__m256d x) {
+        x = _mm256_min_pd(_mm256_max_pd(x, _mm256_set1_pd(-708.0)), _mm256_set1_pd(708.0));
+        const __m256d n = _mm256_round_pd(_mm256_mul_pd(x, _mm256_set1_pd(1.4426950408889634)),
+                                          _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+        __m256d r = _mm256_fnmadd_pd(n, _mm256_set1_pd(6.93147180369123816490e-01), x);
+        r = _mm256_fnmadd_pd(n, _mm256_set1_pd(1.90821492927058770002e-10), r);
+
+        static const double invFactorials[] = {
+            1.0 / 6227020800.0, 1.0 / 479001600.0, 1.0 / 39916800.0, 1.0 / 3628800.0,
+            1.0 / 362880.0, 1.0 / 40320.0, 1.0 / 5040.0, 1.0 / 720.0, 1.0 / 120.0,
+            1.0 / 24.0, 1.0 / 6.0, 0.5, 1.0, 1.0 };
+        __m256d p = _mm256_set1_pd(invFactorials[0]);
+        for (size_t k = 1; k < sizeof(invFactorials) / sizeof(invFactorials[0]); ++k) {
+            p = _mm256_fmadd_pd(p, r, _mm256_set1_pd(invFactorials[k]));
+        }
+
+        const __m256i biased = _mm256_add_epi64(_mm256_cvtepi32_epi64(_mm256_cvtpd_epi32(n)), _mm256_set1_epi64x(1023));
+        return _mm256_mul_pd(p, _mm256_castsi256_pd(_mm256_slli_epi64(biased, 52)));
+    }
+
+    // log(x) for positive normal x: x = 2^e * m with m in [sqrt(2)/2, sqrt(2)), and
+    // log(m) = 2 atanh(s), s = (m - 1) / (m + 1), summed to s^19.
+    inline __m256d log256(__m256d x) {
+        const __m256i bits = _mm256_castpd_si256(x);
+        const __m256d two52 = _mm256_set1_pd(4503599627370496.0);
+        __m256d e = _mm256_sub_pd(
+            _mm256_castsi256_pd(_mm256_or_si256(_mm256_srli_epi64(bits, 52), _mm256_castpd_si256(two52))), two52);
+        e = _mm256_sub_pd(e, _mm256_set1_pd(1023.0));
+        __m256d m = _mm256_castsi256_pd(_mm256_or_si256(
+            _mm256_and_si256(bits, _mm256_set1_epi64x(0x000FFFFFFFFFFFFFLL)), _mm256_set1_epi64x(0x3FF0000000000000LL)));
+        const __m256d large = _mm256_cmp_pd(m, _mm256_set1_pd(1.4142135623730951), _CMP_GT_OQ);
+        m = _mm256_blendv_pd(m, _mm256_mul_pd(m, _mm256_set1_pd(0.5)), large);
+        e = _mm256_blendv_pd(e, _mm256_add_pd(e, _mm256_set1_pd(1.0)), large);
+
+        const __m256d one = _mm256_set1_pd(1.0);
+        const __m256d s = _mm256_div_pd(_mm256_sub_pd(m, one), _mm256_add_pd(m, one));
+        const __m256d s2 = _mm256_mul_pd(s, s);
+        __m256d p = _mm256_set1_pd(1.0 / 19.0);
+        for (int k = 17; k >= 3; k -= 2) {
+            p = _mm256_fmadd_pd(p, s2, _mm256_set1_pd(1.0 / k));
+        }
+        p = _mm256_fmadd_pd(p, s2, one);
+        const __m256d logm = _mm256_mul_pd(_mm256_add_pd(s, s), p);
+        return _mm256_fmadd_pd(e, _mm256_set1_pd(0.693147180559945309417), logm);
+    }
+
+    // Lower tail N(-|x|) (Hart 1968, double-precision form) and the normal density at x.
+    inline __m256d normalTail256(__m256d x, __m256d& pdf) {
+        const __m256d ax = _mm256_andnot_pd(_mm256_set1_pd(-0.0), x);
+        const __m256d ex = exp256(_mm256_mul_pd(_mm256_set1_pd(-0.5), _mm256_mul_pd(ax, ax)));
+        pdf = _mm256_mul_pd(ex, _mm256_set1_pd(0.398942280401432677940));
+
+        static const double num[] = { 3.52624965998911e-02, 0.700383064443688, 6.37396220353165,
+                                      33.912866078383, 112.079291497871, 221.213596169931, 220.206867912376 };
+        static const double den[] = { 8.83883476483184e-02, 1.75566716318264, 16.064177579207, 86.7807322029461,
+                                      296.564248779674, 637.333633378831, 793.826512519948, 440.413735824752 };
+        __m256d pn = _mm256_set1_pd(num[0]);
+        for (size_t k = 1; k < sizeof(num) / sizeof(num[0]); ++k) pn = _mm256_fmadd_pd(pn, ax, _mm256_set1_pd(num[k]));
+        __m256d pd = _mm256_set1_pd(den[0]);
+        for (size_t k = 1; k < sizeof(den) / sizeof(den[0]); ++k) pd = _mm256_fmadd_pd(pd, ax, _mm256_set1_pd(den[k]));
+        const __m256d rational = _mm256_div_pd(_mm256_mul_pd(ex, pn), pd);
+
+        __m256d cf = _mm256_add_pd(ax, _mm256_set1_pd(0.65));
+        for (double k = 4.0; k >= 1.0; k -= 1.0) cf = _mm256_add_pd(ax, _mm256_div_pd(_mm256_set1_pd(k), cf));
+        const __m256d continued = _mm256_div_pd(ex, _mm256_mul_pd(cf, _mm256_set1_pd(2.506628274631)));
+
+        __m256d tail = _mm256_blendv_pd(rational, continued, _mm256_cmp_pd(ax, _mm256_set1_pd(7.07106781186547), _CMP_GE_OQ));
+        return _mm256_blendv_pd(tail, _mm256_setzero_pd(), _mm256_cmp_pd(ax, _mm256_set1_pd(37.0), _CMP_GT_OQ));
+    }
+
+    // Prices in.{...}[i, i + 4); lanes that are not isRegularLane must be patched by the caller.
+    inline void blackScholes4(const BlackScholesBatchInput& in, const BlackScholesBatchOutput& out, size_t i) {
+        const __m256d S = _mm256_loadu_pd(in.S + i);
+        const __m256d K = _mm256_loadu_pd(in.K + i);
+        const __m256d T = _mm256_loadu_pd(in.T + i);
+        const __m256d r = _mm256_loadu_pd(in.r + i);
+        const __m256d sigma = _mm256_loadu_pd(in.sigma + i);
+        const __m256d isPut = _mm256_castsi256_pd(_mm256_set_epi64x(
+            in.type[i + 3] == Put ? -1 : 0, in.type[i + 2] == Put ? -1 : 0,
+            in.type[i + 1] == Put ? -1 : 0, in.type[i] == Put ? -1 : 0));
+
+        const __m256d one = _mm256_set1_pd(1.0);
+        const __m256d zero = _mm256_setzero_pd();
+        const __m256d sqrtT = _mm256_sqrt_pd(T);
+        const __m256d sigmaSqrtT = _mm256_mul_pd(sigma, sqrtT);
+        const __m256d drift = _mm256_fmadd_pd(_mm256_set1_pd(0.5), _mm256_mul_pd(sigma, sigma), r);
+        const __m256d d1 = _mm256_div_pd(_mm256_fmadd_pd(drift, T, log256(_mm256_div_pd(S, K))), sigmaSqrtT);
+        const __m256d d2 = _mm256_sub_pd(d1, sigmaSqrtT);
+        const __m256d Kdf = _mm256_mul_pd(K, exp256(_mm256_sub_pd(zero, _mm256_mul_pd(r, T))));
+
+        __m256d pdf1, pdf2;
+        const __m256d tail1 = normalTail256(d1, pdf1);
+        const __m256d tail2 = normalTail256(d2, pdf2);
+        const __m256d d1Pos = _mm256_cmp_pd(d1, zero, _CMP_GT_OQ);
+        const __m256d d2Pos = _mm256_cmp_pd(d2, zero, _CMP_GT_OQ);
+        const __m256d Nd1 = _mm256_blendv_pd(tail1, _mm256_sub_pd(one, tail1), d1Pos);
+        const __m256d Nmd1 = _mm256_blendv_pd(_mm256_sub_pd(one, tail1), tail1, d1Pos);
+        const __m256d Nd2 = _mm256_blendv_pd(tail2, _mm256_sub_pd(one, tail2), d2Pos);
+        const __m256d Nmd2 = _mm256_blendv_pd(_mm256_sub_pd(one, tail2), tail2, d2Pos);
+
+        // Call and put share everything but the signed N() terms.
+        const __m256d callPrice = _mm256_fmsub_pd(S, Nd1, _mm256_mul_pd(Kdf, Nd2));
+        const __m256d putPrice = _mm256_fmsub_pd(Kdf, Nmd2, _mm256_mul_pd(S, Nmd1));
+        _mm256_storeu_pd(out.price + i, _mm256_blendv_pd(callPrice, putPrice, isPut));
+        if (out.delta) {
+            _mm256_storeu_pd(out.delta + i, _mm256_blendv_pd(Nd1, _mm256_sub_pd(zero, Nmd1), isPut));
+        }
+        if (out.gamma) {
+            _mm256_storeu_pd(out.gamma + i, _mm256_div_pd(pdf1, _mm256_mul_pd(S, sigmaSqrtT)));
+        }
+        if (out.vega) {
+            _mm256_storeu_pd(out.vega + i, _mm256_mul_pd(_mm256_mul_pd(S, pdf1), sqrtT));
+        }
+        if (out.theta) {
+            const __m256d diffusion = _mm256_div_pd(_mm256_mul_pd(_mm256_mul_pd(S, pdf1), sigma),
+                                                    _mm256_mul_pd(_mm256_set1_pd(-2.0), sqrtT));
+            const __m256d rKdf = _mm256_mul_pd(r, Kdf);
+            const __m256d callTheta = _mm256_fnmadd_pd(rKdf, Nd2, diffusion);
+            const __m256d putTheta = _mm256_fmadd_pd(rKdf, Nmd2, diffusion);
+            _mm256_storeu_pd(out.theta + i, _mm256_blendv_pd(callTheta, putTheta, isPut));
+        }
+        if (out.rho) {
+            const __m256d TKdf = _mm256_mul_pd(T, Kdf);
+            _mm256_storeu_pd(out.rho + i, _mm256_blendv_pd(_mm256_mul_pd(TKdf, Nd2),
+                                                           _mm256_sub_pd(zero, _mm256_mul_pd(TKdf, Nmd2)), isPut));
+        }
+        (void)pdf2;
+    }
+#endif
+}
+
+void blackScholesBatch(const BlackScholesBatchInput& in, const BlackScholesBatchOutput& out) {
+    if (!out.price) {
+        throw std::invalid_argument("blackScholesBatch requires a price output array.");
+    }
+    size_t i = 0;
+#if MATHUTILS_HAVE_AVX2
+    for (; i + 4 <= in.n; i += 4) {
+        blackScholes4(in, out, i);
+        for (size_t lane = i; lane < i + 4; ++lane) {
+            if (!isRegularLane(in.type[lane], in.S[lane], in.K[lane], in.T[lane], in.sigma[lane])) {
+                storeScalarLane(in, out, lane);
+            }
+        }
+    }
+#endif
+    for (; i < in.n; ++i) {
+        storeScalarLane(in, out, i);
+    }
+}
@@ -2,6 +2,7 @@
 #define MATH_UTILS_H
 
 #include <cmath> // For std::abs, std::exp, std::sqrt, std::log, std::erf, M_SQRT1_2
+#include <cstddef>
 #include "Types.h" // For OptionType
 
 // Define M_SQRT1_2 if not available (e.g. on MSVC before C++17 standard library fully supports it)
@@ -11,10 +12,59 @@
 
 double normalCDF(double x);
 
+// Inverse of normalCDF for p in (0, 1): Acklam's rational approximation refined by one Halley
+// step, accurate to about 1e-15. Returns -/+infinity at p <= 0 / p >= 1.
+double inverseNormalCDF(double p);
+
 double blackScholesPrice(OptionType optionType, 
                          double S, double K, 
                          double T, double r, 
                          double sigma);
 
+// Black-Scholes price and analytic Greeks for one Call/Put (other types give all zeros,
+// as in blackScholesPrice). Conventions: vega and rho per unit (1.0 = 100%) move,
+// theta is dV/dt per year of calendar time.
+struct BlackScholesGreeks {
+    double price = 0.0;
+    double delta = 0.0;
+    double gamma = 0.0;
+    double vega = 0.0;
+    double theta = 0.0;
+    double rho = 0.0;
+};
+
+BlackScholesGreeks blackScholesGreeks(OptionType optionType,
+                                      double S, double K,
+                                      double T, double r,
+                                      double sigma);
+
+// Structure-of-arrays inputs for blackScholesBatch; every array holds n entries.
+struct BlackScholesBatchInput {
+    const OptionType* type = nullptr;
+    const double* S = nullptr;
+    const double* K = nullptr;
+    const double* T = nullptr;
+    const double* r = nullptr;
+    const double* sigma = nullptr;
+    size_t n = 0;
+};
+
+// Output arrays for blackScholesBatch. price is required; any Greek left null is skipped.
+struct BlackScholesBatchOutput {
+    double* price = nullptr;
+    double* delta = nullptr;
+    double* gamma = nullptr;
+    double* vega = nullptr;
+    double* theta = nullptr;
+    double* rho = nullptr;
+};
+
+// Prices a whole book (or strike grid) of European options in one pass, filling the
+// requested Greeks alongside. Built with AVX2+FMA (e.g. -mavx2 -mfma or -march=native) it
+// runs four options per instruction using vectorized exp/log/normal-CDF approximations
+// accurate to ~1e-14; otherwise, and for degenerate inputs (T, sigma, S or K ~ 0), it uses
+// the scalar blackScholesGreeks.
+void blackScholesBatch(const BlackScholesBatchInput& in, const BlackScholesBatchOutput& out);
+
 #endif // MATH_UTILS_H
 //Updated
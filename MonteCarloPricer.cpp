@@ -0,0 +1,363 @@
+#include "MonteCarloPricer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+#include <vector>
+
+#include "Market.h"
+#include "MathUtils.h"
+#include "Payoff.h"
+#include "RandomStreams.h"
+#include "ThreadPool.h"
+#include "TreeProduct.h"
+
+namespace {
+
+constexpr size_t kBlockPaths = 64;       // Paths simulated side by side
+constexpr uint64_t kBatchesPerRound = 8; // Fixed, so early stopping does not depend on the thread count
+
+// Counter layout: {sample low, sample high, word pair, stream}.
+constexpr uint32_t kPathStream = 0;
+constexpr uint32_t kShiftStream = 1;
+
+struct PathModel {
+    double S0 = 0.0;
+    double r = 0.0;
+    double sigma = 0.0;
+    double T = 0.0;
+    int steps = 1;
+    OptionType controlType = None; // Call, Put or None
+    double controlStrike = 0.0;
+};
+
+// Mean and centred sums of one batch (Y = payoff, X = control), mergeable in any fixed order.
+struct BatchStats {
+    double n = 0.0;
+    double meanY = 0.0, meanX = 0.0;
+    double cyy = 0.0, cxx = 0.0, cxy = 0.0;
+
+    void merge(const BatchStats& o) {
+        if (o.n == 0.0) return;
+        const double total = n + o.n;
+        const double dy = o.meanY - meanY;
+        const double dx = o.meanX - meanX;
+        const double w = n * o.n / total;
+        cyy += o.cyy + dy * dy * w;
+        cxx += o.cxx + dx * dx * w;
+        cxy += o.cxy + dy * dx * w;
+        meanY += dy * o.n / total;
+        meanX += dx * o.n / total;
+        n = total;
+    }
+};
+
+void readModel(const Market& mkt, MarketDataId underlying, MarketDataId rateCurve, MarketDataId volCurve,
+               const Date& expiry, PathModel& model) {
+    model.S0 = mkt.getStockPrice(underlying);
+    if (model.S0 < 0) {
+        throw std::runtime_error("Initial stock price cannot be negative.");
+    }
+    const double T = expiry - mkt.asOf;
+    if (T < -1e-9) {
+        throw std::runtime_error("Option already expired in MonteCarloPricer.");
+    }
+    model.T = std::max(0.0, T);
+    std::shared_ptr<const RateCurve> rCurve = mkt.getCurve(rateCurve);
+    std::shared_ptr<const VolCurve> vCurve = mkt.getVolCurve(volCurve);
+    if (!rCurve || rCurve->isEmpty()) {
+        throw std::runtime_error("Rate curve '" + marketDataName(rateCurve) + "' not found or empty for Monte Carlo setup.");
+    }
+    if (!vCurve || vCurve->isEmpty()) {
+        throw std::runtime_error("Volatility curve '" + marketDataName(volCurve) + "' not found or empty for Monte Carlo setup.");
+    }
+    model.r = rCurve->getRate(expiry);
+    model.sigma = std::abs(vCurve->getVol(expiry));
+}
+
+// Per-thread scratch for simulateBatch and the block payoffs. Buffers only grow, so after
+// warm-up a batch performs no allocation (as LatticeWorkspace and the FD GridWorkspace).
+struct PathWorkspace {
+    std::vector<double> z, w, spots; // Step-major blocks of kBlockPaths paths
+    std::vector<uint32_t> shift;     // Sobol' digital shift per dimension
+    std::vector<double> longPath;    // PathPayoff's copy of one path beyond 256 steps
+    std::vector<double> y, x;        // Per-sample payoff and control of the batch being run
+
+    static PathWorkspace& forThisThread() {
+        static thread_local PathWorkspace ws;
+        return ws;
+    }
+};
+
+// Simulates one batch: fills y[s] (and x[s] for the control) for its samples s, antithetic
+// pairs averaged. terminalOnly skips the spots of the monitoring dates before expiry.
+template <typename BlockPayoff>
+void simulateBatch(const PathModel& model, const MonteCarloSettings& settings, const BrownianBridge& bridge,
+                   uint64_t batch, const BlockPayoff& payoffBlock, double* y, double* x) {
+    const int steps = model.steps;
+    const size_t stride = kBlockPaths;
+    PathWorkspace& ws = PathWorkspace::forThisThread();
+    ws.z.resize(static_cast<size_t>(steps) * stride);
+    ws.w.resize(ws.z.size());
+    ws.spots.resize(ws.z.size());
+    double* z = ws.z.data();
+    double* w = ws.w.data();
+    double* spots = ws.spots.data();
+    double payoffs[kBlockPaths], mirrored[kBlockPaths];
+
+    const Philox4x32 philox(settings.seed);
+    const bool sobol = settings.sampler == MonteCarloSampler::Sobol;
+    const int sobolDims = sobol ? std::min(steps, SobolSequence::kMaxDimensions) : 0;
+    SobolSequence sequence(std::max(sobolDims, 1));
+    ws.shift.resize(static_cast<size_t>(sobolDims));
+    uint32_t* shift = ws.shift.data();
+    for (int d = 0; d < sobolDims; ++d) {
+        shift[d] = philox({static_cast<uint32_t>(batch), static_cast<uint32_t>(batch >> 32),
+                           static_cast<uint32_t>(d), kShiftStream})[0];
+    }
+
+    const double drift = model.r - 0.5 * model.sigma * model.sigma;
+    const double logS0 = std::log(model.S0);
+    const double dt = model.T / steps;
+    const int firstSpot = payoffBlock.terminalOnly ? steps - 1 : 0;
+
+    const uint64_t batchStart = batch * settings.pathsPerBatch;
+    for (uint64_t blockStart = 0; blockStart < settings.pathsPerBatch; blockStart += kBlockPaths) {
+        const size_t width = static_cast<size_t>(std::min<uint64_t>(kBlockPaths, settings.pathsPerBatch - blockStart));
+
+        // Normals in bridge order: Sobol' dimensions first, Philox for any beyond them.
+        for (size_t p = 0; p < width; ++p) {
+            if (sobolDims > 0) {
+                const uint32_t* point = (p == 0) ? sequence.seek(blockStart) : sequence.next();
+                for (int d = 0; d < sobolDims; ++d) {
+                    z[static_cast<size_t>(d) * stride + p] = inverseNormalCDF(((point[d] ^ shift[d]) + 0.5) * 0x1.0p-32);
+                }
+            }
+            const uint64_t sample = batchStart + blockStart + p;
+            for (int d = sobolDims; d < steps; d += 2) {
+                const Philox4x32::Counter bits = philox({static_cast<uint32_t>(sample), static_cast<uint32_t>(sample >> 32),
+                                                         static_cast<uint32_t>(d / 2), kPathStream});
+                z[static_cast<size_t>(d) * stride + p] = inverseNormalCDF(Philox4x32::toUniform(bits[0], bits[1]));
+                if (d + 1 < steps) {
+                    z[static_cast<size_t>(d + 1) * stride + p] = inverseNormalCDF(Philox4x32::toUniform(bits[2], bits[3]));
+                }
+            }
+        }
+        bridge.build(z, w, width, stride);
+
+        // ln S(t_i) = ln S0 + (r - sigma^2 / 2) t_i + sigma W(t_i); the mirror path uses -W.
+        for (int mirror = 0; mirror < (settings.antithetic ? 2 : 1); ++mirror) {
+            const double sign = mirror ? -model.sigma : model.sigma;
+            for (int i = firstSpot; i < steps; ++i) {
+                const double mean = logS0 + drift * dt * (i + 1);
+                const double* wi = w + static_cast<size_t>(i) * stride;
+                double* si = spots + static_cast<size_t>(i) * stride;
+                for (size_t p = 0; p < width; ++p) si[p] = std::exp(mean + sign * wi[p]);
+            }
+            payoffBlock(spots, width, stride, mirror ? mirrored : payoffs);
+            const double* terminal = spots + static_cast<size_t>(steps - 1) * stride;
+            for (size_t p = 0; p < width; ++p) {
+                const double control = (model.controlType == None) ? 0.0
+                                       : PAYOFF::VanillaOption(model.controlType, model.controlStrike, terminal[p]);
+                const size_t s = static_cast<size_t>(blockStart) + p;
+                if (mirror == 0) {
+                    y[s] = payoffs[p];
+                    x[s] = control;
+                } else {
+                    y[s] = 0.5 * (y[s] + mirrored[p]);
+                    x[s] = 0.5 * (x[s] + control);
+                }
+            }
+        }
+    }
+}
+
+BatchStats batchStats(const double* y, const double* x, size_t n) {
+    BatchStats stats;
+    stats.n = static_cast<double>(n);
+    for (size_t s = 0; s < n; ++s) {
+        stats.meanY += y[s];
+        stats.meanX += x[s];
+    }
+    stats.meanY /= stats.n;
+    stats.meanX /= stats.n;
+    for (size_t s = 0; s < n; ++s) {
+        const double dy = y[s] - stats.meanY;
+        const double dx = x[s] - stats.meanX;
+        stats.cyy += dy * dy;
+        stats.cxx += dx * dx;
+        stats.cxy += dy * dx;
+    }
+    return stats;
+}
+
+// Undiscounted estimate and standard error over batches[0..count).
+void combine(const std::vector<BatchStats>& batches, size_t count, bool replicates, bool useControl,
+             double controlMean, double& estimate, double& standardError) {
+    BatchStats pooled;
+    for (size_t b = 0; b < count; ++b) pooled.merge(batches[b]);
+    const double beta = (useControl && pooled.cxx > 0.0) ? pooled.cxy / pooled.cxx : 0.0;
+    estimate = pooled.meanY - beta * (pooled.meanX - controlMean);
+    if (!replicates) {
+        // i.i.d. samples: residual variance of Y - beta X.
+        const double residual = std::max(0.0, pooled.cyy - beta * pooled.cxy);
+        standardError = (pooled.n > 1.0) ? std::sqrt(residual / (pooled.n - 1.0) / pooled.n) : 0.0;
+        return;
+    }
+    // Randomized QMC: the batch estimates are the i.i.d. replicates.
+    if (count < 2) {
+        standardError = std::numeric_limits<double>::infinity();
+        return;
+    }
+    double sumSq = 0.0;
+    for (size_t b = 0; b < count; ++b) {
+        const double theta = batches[b].meanY - beta * (batches[b].meanX - controlMean);
+        sumSq += (theta - estimate) * (theta - estimate);
+    }
+    standardError = std::sqrt(sumSq / (count - 1.0) / count);
+}
+
+template <typename BlockPayoff>
+MonteCarloResult simulate(const PathModel& model, const MonteCarloSettings& settings, ThreadPool* pool,
+                          const BlockPayoff& payoffBlock) {
+    if (settings.pathsPerBatch == 0) {
+        throw std::invalid_argument("MonteCarloPricer: pathsPerBatch must be positive.");
+    }
+    const double discount = std::exp(-model.r * model.T);
+    const bool useControl = settings.controlVariate && model.controlType != None;
+    const double controlMean = useControl
+        ? blackScholesPrice(model.controlType, model.S0, model.controlStrike, model.T, model.r, model.sigma) / discount
+        : 0.0;
+    const bool replicates = settings.sampler == MonteCarloSampler::Sobol;
+    const uint64_t minBatches = replicates ? 2 : 1;
+    const uint64_t totalBatches =
+        std::max(minBatches, (settings.maxPaths + settings.pathsPerBatch - 1) / settings.pathsPerBatch);
+    const BrownianBridge bridge(model.steps, model.T);
+
+    std::vector<BatchStats> stats;
+    MonteCarloResult result;
+    double estimate = 0.0, standardError = 0.0;
+    for (uint64_t done = 0; done < totalBatches;) {
+        const uint64_t round = std::min(kBatchesPerRound, totalBatches - done);
+        stats.resize(static_cast<size_t>(done + round));
+        auto runBatches = [&](size_t begin, size_t end, size_t) {
+            PathWorkspace& ws = PathWorkspace::forThisThread();
+            const size_t samples = static_cast<size_t>(settings.pathsPerBatch);
+            ws.y.resize(samples);
+            ws.x.resize(samples);
+            for (size_t k = begin; k < end; ++k) {
+                const uint64_t batch = done + k;
+                simulateBatch(model, settings, bridge, batch, payoffBlock, ws.y.data(), ws.x.data());
+                stats[static_cast<size_t>(batch)] = batchStats(ws.y.data(), ws.x.data(), samples);
+            }
+        };
+        if (pool) {
+            pool->parallelFor(static_cast<size_t>(round), 1, runBatches);
+        } else {
+            runBatches(0, static_cast<size_t>(round), 0);
+        }
+        done += round;
+
+        combine(stats, static_cast<size_t>(done), replicates, useControl, controlMean, estimate, standardError);
+        result.batches = done;
+        result.samples = done * settings.pathsPerBatch;
+        if (settings.targetStdError > 0.0 && discount * standardError <= settings.targetStdError && done >= minBatches) {
+            result.targetReached = true;
+            break;
+        }
+    }
+    result.price = discount * estimate;
+    result.standardError = discount * standardError;
+    return result;
+}
+
+// Block payoffs for simulate: out[p] for the width paths of a step-major spot block.
+struct TerminalPayoff {
+    const TreeProduct& product;
+    static constexpr bool terminalOnly = true;
+    void operator()(const double* spots, size_t width, size_t, double* out) const {
+        for (size_t p = 0; p < width; ++p) out[p] = product.Payoff(spots[p]);
+    }
+};
+
+struct PathPayoff {
+    const PathContract& contract;
+    int steps;
+    static constexpr bool terminalOnly = false;
+    void operator()(const double* spots, size_t width, size_t stride, double* out) const {
+        double path[256];
+        double* buffer = path;
+        if (steps > 256) {
+            std::vector<double>& longPath = PathWorkspace::forThisThread().longPath;
+            longPath.resize(static_cast<size_t>(steps));
+            buffer = longPath.data();
+        }
+        for (size_t p = 0; p < width; ++p) {
+            for (int i = 0; i < steps; ++i) buffer[i] = spots[static_cast<size_t>(i) * stride + p];
+            out[p] = contract.payoff(buffer, steps);
+        }
+    }
+};
+
+// The vanilla on S_T that serves as control for a product of this type, or None.
+OptionType controlTypeFor(OptionType type) {
+    switch (type) {
+    case Call:
+    case BinaryCall: return Call;
+    case Put:
+    case BinaryPut: return Put;
+    default: return None;
+    }
+}
+
+} // namespace
+
+MonteCarloPricer::MonteCarloPricer(const MonteCarloSettings& settings_in, ThreadPool* pool_in)
+    : settings(settings_in), pool(pool_in) {}
+
+double MonteCarloPricer::PriceTree(const Market& mkt, const TreeProduct& product) const {
+    return PriceWithError(mkt, product).price;
+}
+
+MonteCarloResult MonteCarloPricer::PriceWithError(const Market& mkt, const TreeProduct& product) const {
+    PathModel model;
+    readModel(mkt, product.getUnderlyingId(), product.getRateCurveId(), product.getVolCurveId(),
+              product.GetExpiry(), model);
+    if (product.ValueAtNode(model.S0, 0.0, -std::numeric_limits<double>::infinity()) >
+        -std::numeric_limits<double>::infinity()) {
+        throw std::invalid_argument("MonteCarloPricer does not price early exercise (" + product.getType() + ").");
+    }
+    MonteCarloResult result;
+    if (model.T <= 1e-9) {
+        result.price = product.Payoff(model.S0);
+        return result;
+    }
+    model.steps = 1; // Payoff(S_T) only needs the terminal spot
+    if (product.getStrike() > 0.0) {
+        model.controlType = controlTypeFor(product.getOptionType());
+        model.controlStrike = product.getStrike();
+    }
+    return simulate(model, settings, pool, TerminalPayoff{product});
+}
+
+MonteCarloResult MonteCarloPricer::PricePath(const Market& mkt, const PathContract& contract) const {
+    if (!contract.payoff || contract.monitoringDates < 1) {
+        throw std::invalid_argument("MonteCarloPricer::PricePath: need a payoff and at least one monitoring date.");
+    }
+    PathModel model;
+    readModel(mkt, internMarketDataName(contract.underlying), internMarketDataName(contract.rateCurve),
+              internMarketDataName(contract.volCurve), contract.expiry, model);
+    model.steps = contract.monitoringDates;
+    if (contract.controlType == Call || contract.controlType == Put) {
+        model.controlType = contract.controlType;
+        model.controlStrike = contract.controlStrike;
+    }
+    MonteCarloResult result;
+    if (model.T <= 1e-9) {
+        const std::vector<double> flat(static_cast<size_t>(model.steps), model.S0);
+        result.price = contract.payoff(flat.data(), model.steps);
+        return result;
+    }
+    return simulate(model, settings, pool, PathPayoff{contract, model.steps});
+}
@@ -0,0 +1,89 @@
+#ifndef MONTE_CARLO_PRICER_H
+#define MONTE_CARLO_PRICER_H
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+
+#include "Date.h"
+#include "Pricer.h"
+#include "Types.h"
+
+class Market;
+class ThreadPool;
+class TreeProduct;
+
+enum class MonteCarloSampler {
+    Pseudo, // Philox4x32 counter-based streams
+    Sobol   // Sobol' points with a Brownian bridge, randomized by a digital shift per batch
+};
+
+struct MonteCarloSettings {
+    MonteCarloSampler sampler = MonteCarloSampler::Sobol;
+    uint64_t seed = 20240601;
+    uint64_t pathsPerBatch = 4096; // Samples per batch (a power of two suits Sobol')
+    uint64_t maxPaths = 1 << 20;   // Sample budget, rounded up to whole batches
+    double targetStdError = 0.0;   // Stop once the standard error is at or below this (0: run maxPaths)
+    bool antithetic = true;        // Each sample averages a path and its mirror (-z)
+    bool controlVariate = true;    // Vanilla call/put on S_T, priced by blackScholesPrice
+};
+
+struct MonteCarloResult {
+    double price = 0.0;
+    double standardError = 0.0;
+    uint64_t samples = 0;   // Antithetic pairs count once
+    uint64_t batches = 0;
+    bool targetReached = false;
+};
+
+// A path-dependent payoff on one underlying: 'spots' holds S(t_1)..S(t_n) at the equally spaced
+// monitoring times t_i = i T / n (spots[n - 1] is S_T). The payoff is paid at expiry.
+struct PathContract {
+    std::string underlying;
+    std::string rateCurve;
+    std::string volCurve;
+    Date expiry;
+    int monitoringDates = 1;
+    std::function<double(const double* spots, int n)> payoff;
+    // Control variate: the vanilla (Call or Put) of this strike on S_T; None disables it.
+    OptionType controlType = None;
+    double controlStrike = 0.0;
+};
+
+// Monte Carlo under Black-Scholes dynamics (r and sigma read at expiry, as the trees do), as a
+// Pricer for European-exercise tree products and as an engine for PathContract payoffs.
+//
+// Work is split into batches of pathsPerBatch samples. A batch's random numbers depend only on
+// (seed, batch index, sample index), and batches are combined in index order after each round
+// of a fixed number of batches, so a result is reproducible whatever the thread count. Sobol'
+// batches are independently shifted replicates of the same points (randomized QMC), and the
+// standard error comes from the spread of the batch estimates; pseudo-random batches use the
+// sample variance. Within a batch, paths are simulated in blocks laid out step-major, so each
+// time step is one loop over the block's paths. Batches run on the pool if one is given
+// (inline when called from a pool task); the pricer is stateless and may be shared.
+//
+// Early exercise is not supported: Price throws for products whose ValueAtNode takes the
+// exercise value (AmericanOption).
+class MonteCarloPricer : public Pricer {
+public:
+    explicit MonteCarloPricer(const MonteCarloSettings& settings = MonteCarloSettings(), ThreadPool* pool = nullptr);
+
+    std::unique_ptr<Pricer> Clone() const override { return std::make_unique<MonteCarloPricer>(*this); }
+
+    const MonteCarloSettings& getSettings() const { return settings; }
+
+    // Price and standard error of a European-exercise product's Payoff(S_T).
+    MonteCarloResult PriceWithError(const Market& mkt, const TreeProduct& product) const;
+
+    MonteCarloResult PricePath(const Market& mkt, const PathContract& contract) const;
+
+protected:
+    double PriceTree(const Market& mkt, const TreeProduct& product) const override;
+
+private:
+    MonteCarloSettings settings;
+    ThreadPool* pool; // Not owned; may be null
+};
+
+#endif // MONTE_CARLO_PRICER_H
@@ -0,0 +1,65 @@
+#include "PortfolioEngine.h"
+
+#include <exception>
+
+PortfolioEngine::PortfolioEngine(const Pricer& pricer, const RiskEngine& riskEngine_in, size_t numThreads)
+    : riskEngine(riskEngine_in), pool(numThreads), sharedPricer(pricer.Clone()) {}
+
+namespace {
+    // Small chunks: a single option tree costs far more than a bond, so fine-grained
+    // tasks give the stealers something to take.
+    constexpr size_t kGrainSize = 16;
+}
+
+void PortfolioEngine::priceChunk(const std::vector<std::shared_ptr<Trade>>& portfolio, size_t begin, size_t end,
+                                 const Market& market, const Pricer& workerPricer,
+                                 std::vector<TradeResult>& results) const {
+    const Trade* chunkTrades[kGrainSize] = {};
+    size_t chunkIndex[kGrainSize] = {};
+    double chunkPvs[kGrainSize] = {};
+    std::string chunkErrors[kGrainSize];
+    size_t n = 0;
+    for (size_t i = begin; i < end; ++i) {
+        const std::shared_ptr<Trade>& trade = portfolio[i];
+        if (!trade) continue;
+        results[i].hasTrade = true;
+        results[i].instrument = trade->getUnderlyingName();
+        results[i].type = trade->getType();
+        chunkTrades[n] = trade.get();
+        chunkIndex[n] = i;
+        ++n;
+    }
+    workerPricer.PriceBatch(market, chunkTrades, n, chunkPvs, chunkErrors);
+    for (size_t k = 0; k < n; ++k) {
+        TradeResult& result = results[chunkIndex[k]];
+        result.pvOk = chunkErrors[k].empty();
+        if (result.pvOk) {
+            result.pv = chunkPvs[k];
+        } else {
+            result.pvError = std::move(chunkErrors[k]);
+        }
+    }
+}
+
+std::vector<TradeResult> PortfolioEngine::run(const std::vector<std::shared_ptr<Trade>>& portfolio,
+                                              const Market& market) {
+    std::vector<TradeResult> results(portfolio.size());
+    pool.parallelFor(portfolio.size(), kGrainSize,
+        [&](size_t begin, size_t end, size_t) {
+            priceChunk(portfolio, begin, end, market, *sharedPricer, results);
+        });
+
+    // Risk is batched by curve, so each shocked market is built once for the whole book.
+    PortfolioRisk risk = riskEngine.computeRisk(portfolio, market, *sharedPricer,
+                                               {RiskType::DV01, RiskType::Vega}, &pool);
+    for (size_t i = 0; i < results.size(); ++i) {
+        if (!results[i].hasTrade) continue;
+        results[i].dv01Ok = risk.dv01Errors[i].empty();
+        results[i].dv01 = std::move(risk.dv01[i]);
+        results[i].dv01Error = std::move(risk.dv01Errors[i]);
+        results[i].vegaOk = risk.vegaErrors[i].empty();
+        results[i].vega = std::move(risk.vega[i]);
+        results[i].vegaError = std::move(risk.vegaErrors[i]);
+    }
+    return results;
+}
@@ -0,0 +1,64 @@
+#ifndef PORTFOLIO_ENGINE_H
+#define PORTFOLIO_ENGINE_H
+
+#include "Market.h"
+#include "Trade.h"
+#include "Pricer.h"
+#include "RiskEngine.h"
+#include "ThreadPool.h"
+
+#include <string>
+#include <vector>
+#include <map>
+#include <memory>
+
+// PV and risk for one trade, as produced by PortfolioEngine::run.
+// Each measure carries its own error message so that one failing calculation
+// does not hide the others (mirrors the per-measure try/catch of the serial loop).
+struct TradeResult {
+    bool hasTrade = false; // false for null entries in the portfolio
+    std::string instrument;
+    std::string type;
+
+    bool pvOk = false;
+    double pv = 0.0;
+    std::string pvError;
+
+    bool dv01Ok = false;
+    std::map<std::string, double> dv01;
+    std::string dv01Error;
+
+    bool vegaOk = false;
+    std::map<std::string, double> vega;
+    std::string vegaError;
+};
+
+// Values a portfolio (PV, DV01, Vega) on a work-stealing thread pool.
+// PVs are priced trade by trade; DV01/Vega go through RiskEngine::computeRisk on the same pool.
+// Results are returned in the original trade order, so output written from them is
+// identical regardless of the number of threads.
+class PortfolioEngine {
+public:
+    // numThreads == 0 uses all hardware threads.
+    PortfolioEngine(const Pricer& pricer, const RiskEngine& riskEngine, size_t numThreads = 0);
+
+    std::vector<TradeResult> run(const std::vector<std::shared_ptr<Trade>>& portfolio,
+                                 const Market& market);
+
+    size_t threadCount() const { return pool.size(); }
+
+    // The engine's worker pool, for other parallel stages of a run (e.g. trade loading).
+    ThreadPool& threadPool() { return pool; }
+
+private:
+    // Prices portfolio[begin, end) (at most one pool chunk) through Pricer::PriceBatch.
+    void priceChunk(const std::vector<std::shared_ptr<Trade>>& portfolio, size_t begin, size_t end,
+                    const Market& market, const Pricer& workerPricer,
+                    std::vector<TradeResult>& results) const;
+
+    const RiskEngine& riskEngine;
+    ThreadPool pool;
+    std::unique_ptr<Pricer> sharedPricer; // Stateless, so one copy serves every worker
+};
+
+#endif // PORTFOLIO_ENGINE_H
@@ -6,36 +6,133 @@
 #include "Swap.h"        
 #include "EuropeanTrade.h" 
 #include "AmericanTrade.h" 
+#include "BinomialLattice.h"
+#include "Payoff.h"
+#include "Instrumentation.h"
 
 #include <vector>
 #include <cmath>     
 #include <algorithm> 
 #include <stdexcept> 
 #include <iostream>  
+#include <chrono>
+#include <limits>
+#include <tuple>
 
 double Pricer::Price(const Market& mkt, const std::shared_ptr<Trade>& trade) const {
     if (!trade) {
         throw std::invalid_argument("Trade pointer is null in Pricer::Price");
     }
+    return Price(mkt, *trade);
+}
+
+double Pricer::Price(const Market& mkt, const Trade& trade) const {
+    PRICING_SCOPED_TIMER(PricerPrice);
+    PRICING_TRADE_LATENCY(trade.getKind());
+    switch (trade.getKind()) {
+    case InstrumentKind::Bond:
+        return static_cast<const Bond&>(trade).Pv(mkt);
+    case InstrumentKind::Swap:
+        return static_cast<const Swap&>(trade).Pv(mkt);
+    case InstrumentKind::EuropeanOption:
+    case InstrumentKind::AmericanOption:
+        return this->PriceTree(mkt, static_cast<const TreeProduct&>(trade));
+    case InstrumentKind::Other:
+        break;
+    }
 
-    if (auto bond = std::dynamic_pointer_cast<const Bond>(trade)) {
+    // Untagged trade types: fall back to RTTI.
+    if (auto bond = dynamic_cast<const Bond*>(&trade)) {
         return bond->Pv(mkt); 
     }
-    if (auto swap = std::dynamic_pointer_cast<const Swap>(trade)) {
+    if (auto swap = dynamic_cast<const Swap*>(&trade)) {
         return swap->Pv(mkt); 
     }
-    if (auto treeProduct = std::dynamic_pointer_cast<const TreeProduct>(trade)) {
+    if (auto treeProduct = dynamic_cast<const TreeProduct*>(&trade)) {
         return this->PriceTree(mkt, *treeProduct);
     }
     
     std::cerr << "Warning: Pricer::Price could not determine specific pricing method for trade type: " 
-              << trade->getType() << ". Attempting generic Trade::Pv." << std::endl;
-    return trade->Pv(mkt); 
+              << trade.getType() << ". Attempting generic Trade::Pv." << std::endl;
+    return trade.Pv(mkt); 
+}
+
+namespace {
+
+// Prices trades[i] for each i in indices[0..count) with priceOne, under PriceBatch's error contract.
+template <typename PriceOne>
+void priceEach(const Trade* const* trades, const size_t* indices, size_t count, double* pvs, std::string* errors,
+               PriceOne&& priceOne) {
+    for (size_t k = 0; k < count; ++k) {
+        const size_t i = indices[k];
+        if (!errors) {
+            pvs[i] = priceOne(*trades[i]);
+            continue;
+        }
+        try {
+            pvs[i] = priceOne(*trades[i]);
+        } catch (const std::exception& e) {
+            pvs[i] = std::numeric_limits<double>::quiet_NaN();
+            errors[i] = e.what();
+        }
+    }
+}
+
+} // namespace
+
+void Pricer::PriceBatch(const Market& mkt, const Trade* const* trades, size_t count, double* pvs,
+                        std::string* errors) const {
+    // Partition by kind once; index buffers are reused across calls on the same thread.
+    static thread_local std::vector<size_t> bonds, swaps, treeProducts, others;
+    bonds.clear();
+    swaps.clear();
+    treeProducts.clear();
+    others.clear();
+    for (size_t i = 0; i < count; ++i) {
+        if (!trades[i]) {
+            if (!errors) throw std::invalid_argument("Trade pointer is null in Pricer::PriceBatch");
+            pvs[i] = std::numeric_limits<double>::quiet_NaN();
+            errors[i] = "Trade pointer is null in Pricer::PriceBatch";
+            continue;
+        }
+        switch (trades[i]->getKind()) {
+        case InstrumentKind::Bond: bonds.push_back(i); break;
+        case InstrumentKind::Swap: swaps.push_back(i); break;
+        case InstrumentKind::EuropeanOption:
+        case InstrumentKind::AmericanOption: treeProducts.push_back(i); break;
+        case InstrumentKind::Other: others.push_back(i); break;
+        }
+    }
+
+    priceEach(trades, bonds.data(), bonds.size(), pvs, errors, [&](const Trade& t) {
+        PRICING_TRADE_LATENCY(InstrumentKind::Bond);
+        return static_cast<const Bond&>(t).Pv(mkt);
+    });
+    priceEach(trades, swaps.data(), swaps.size(), pvs, errors, [&](const Trade& t) {
+        PRICING_TRADE_LATENCY(InstrumentKind::Swap);
+        return static_cast<const Swap&>(t).Pv(mkt);
+    });
+    PriceTreeBatch(mkt, trades, treeProducts.data(), treeProducts.size(), pvs, errors);
+    priceEach(trades, others.data(), others.size(), pvs, errors,
+              [&](const Trade& t) { return this->Price(mkt, t); }); // Price records its own latency
+}
+
+void Pricer::PriceTreeBatch(const Market& mkt, const Trade* const* trades, const size_t* indices, size_t count,
+                            double* pvs, std::string* errors) const {
+    priceEach(trades, indices, count, pvs, errors, [&](const Trade& t) {
+        PRICING_TRADE_LATENCY(t.getKind());
+        return this->PriceTree(mkt, static_cast<const TreeProduct&>(t));
+    });
 }
 
-void CRRBinomialTreePricer::SetupTreeParams(const Market& mkt, const TreeProduct& product) const {
+namespace {
+
+// CRR tree (u = exp(sigma sqrt(dt)), d = 1/u); also the base of the LR and BBSR trees.
+TreeParams crrTreeParams(const Market& mkt, const TreeInputs& inputs, int nSteps) {
+    TreeParams params;
+    params.N = nSteps;
     Date valuationDate = mkt.asOf;
-    Date expiryDate = product.GetExpiry();
+    const Date& expiryDate = inputs.expiry;
     double T = (expiryDate - valuationDate); 
 
     if (T < -1e-9) { 
@@ -43,82 +140,324 @@ void CRRBinomialTreePricer::SetupTreeParams(const Market& mkt, const TreeProduct
     }
     T = std::max(0.0, T); // Clamp T to be non-negative
 
-    this->deltaT = (this->N == 0) ? 0 : T / this->N; 
+    params.deltaT = (params.N == 0) ? 0 : T / params.N; 
 
-    std::shared_ptr<const RateCurve> rCurve = mkt.getCurve(product.getRateCurveName());
-    std::shared_ptr<const VolCurve> vCurve = mkt.getVolCurve(product.getVolCurveName());
+    std::shared_ptr<const RateCurve> rCurve = mkt.getCurve(inputs.rateCurveId);
+    std::shared_ptr<const VolCurve> vCurve = mkt.getVolCurve(inputs.volCurveId);
 
     if (!rCurve || rCurve->isEmpty()) {
-        throw std::runtime_error("Rate curve '" + product.getRateCurveName() + "' not found or empty for tree setup.");
+        throw std::runtime_error("Rate curve '" + marketDataName(inputs.rateCurveId) + "' not found or empty for tree setup.");
     }
     if (!vCurve || vCurve->isEmpty()) {
-        throw std::runtime_error("Volatility curve '" + product.getVolCurveName() + "' not found or empty for tree setup.");
+        throw std::runtime_error("Volatility curve '" + marketDataName(inputs.volCurveId) + "' not found or empty for tree setup.");
     }
 
     double r = rCurve->getRate(expiryDate);    
     double sigma = vCurve->getVol(expiryDate); 
+    params.rate = r;
+    params.vol = sigma;
 
-    if (this->deltaT > 1e-9) { // Avoid division by zero or issues if T=0 (N might be >0)
-        this->u = std::exp(sigma * std::sqrt(deltaT));
-        this->d = 1.0 / u;
-        double a = std::exp(r * deltaT); 
-        this->p_up = (a - d) / (u - d);
-        if (this->u == this->d) { // Avoid division by zero if u=d (e.g. sigma=0)
-             this->p_up = (a >=d) ? 1.0 : 0.0; // if a=d, then p_up can be anything, conventionally 0.5 or based on limit.
+    if (params.deltaT > 1e-9) { // Avoid division by zero or issues if T=0 (N might be >0)
+        params.u = std::exp(sigma * std::sqrt(params.deltaT));
+        params.d = 1.0 / params.u;
+        double a = std::exp(r * params.deltaT); 
+        params.p_up = (a - params.d) / (params.u - params.d);
+        if (params.u == params.d) { // Avoid division by zero if u=d (e.g. sigma=0)
+             params.p_up = (a >=params.d) ? 1.0 : 0.0; // if a=d, then p_up can be anything, conventionally 0.5 or based on limit.
                                             // if sigma is 0, u=d=1. a = exp(r*dT). p_up = (exp(r*dT)-1)/0. This needs care.
                                             // If sigma=0, tree is deterministic S0*exp(rT). Price is discounted payoff.
              if (std::abs(sigma) < 1e-9) { // If sigma is effectively zero
-                 this->p_up = (a >= 1.0) ? 1.0 : 0.0; // Simplified: if rate positive, goes up; else down/neutral. Better: use deterministic pricing.
+                 params.p_up = (a >= 1.0) ? 1.0 : 0.0; // Simplified: if rate positive, goes up; else down/neutral. Better: use deterministic pricing.
              } else {
                   throw std::runtime_error("CRR Tree: u and d are equal but sigma is not zero. Check parameters.");
              }
         }
-        this->p_down = 1.0 - p_up;
-        this->df_step = std::exp(-r * deltaT);
+        params.p_down = 1.0 - params.p_up;
+        params.df_step = std::exp(-r * params.deltaT);
 
-        if (p_up < -1e-6 || p_up > 1.0 + 1e-6) { // Allow small tolerance for floating point errors
-            std::cerr << "Warning: CRR risk-neutral probability p_up (" << p_up << ") is out of [0,1] range significantly. Clamping. Check parameters (r=" << r << ", sigma=" << sigma << ", dT=" << deltaT << ", u=" << u << ", d=" << d << ", a=" << a << ")." << std::endl;
-            this->p_up = std::max(0.0, std::min(1.0, this->p_up));
-            this->p_down = 1.0 - this->p_up;
+        if (params.p_up < -1e-6 || params.p_up > 1.0 + 1e-6) { // Allow small tolerance for floating point errors
+            std::cerr << "Warning: CRR risk-neutral probability p_up (" << params.p_up << ") is out of [0,1] range significantly. Clamping. Check parameters (r=" << r << ", sigma=" << sigma << ", dT=" << params.deltaT << ", u=" << params.u << ", d=" << params.d << ", a=" << a << ")." << std::endl;
+            params.p_up = std::max(0.0, std::min(1.0, params.p_up));
+            params.p_down = 1.0 - params.p_up;
         }
     } else { // T=0 or N=0
-        this->u = 1.0;
-        this->d = 1.0;
-        this->p_up = 0.5; // Arbitrary, won't be used if N=0 or T=0
-        this->p_down = 0.5;
-        this->df_step = 1.0;
+        params.u = 1.0;
+        params.d = 1.0;
+        params.p_up = 0.5; // Arbitrary, won't be used if N=0 or T=0
+        params.p_down = 0.5;
+        params.df_step = 1.0;
+    }
+    return params;
+}
+
+// Built-in options go to their specialized kernel; anything else keeps the product for callbacks.
+TreeInputs treeInputsFor(const TreeProduct& product) {
+    TreeInputs inputs;
+    inputs.expiry = product.GetExpiry();
+    inputs.underlyingId = product.getUnderlyingId();
+    inputs.rateCurveId = product.getRateCurveId();
+    inputs.volCurveId = product.getVolCurveId();
+    if (!latticeOptionFor(product, inputs.option)) {
+        inputs.option.type = product.getOptionType();
+        inputs.option.strike = product.getStrike();
+        inputs.product = &product;
+    }
+    return inputs;
+}
+
+// Peizer-Pratt method-2 inversion: the binomial probability matching a normal N(z) on n steps.
+double peizerPrattInversion(double z, int n) {
+    const double q = z / (n + 1.0 / 3.0 + 0.1 / (n + 1.0));
+    const double root = std::sqrt(0.25 - 0.25 * std::exp(-q * q * (n + 1.0 / 6.0)));
+    return (z >= 0.0) ? 0.5 + root : 0.5 - root;
+}
+
+} // namespace
+
+TreeParams CRRBinomialTreePricer::SetupTreeParams(const Market& mkt, const TreeInputs& inputs, double, int nSteps) const {
+    return crrTreeParams(mkt, inputs, nSteps);
+}
+
+TreeParams LeisenReimerTreePricer::SetupTreeParams(const Market& mkt, const TreeInputs& inputs, double S0, int nSteps) const {
+    TreeParams params = crrTreeParams(mkt, inputs, nSteps); // Validates and reads r, sigma
+    const double K = inputs.option.strike;
+    if (params.deltaT <= 1e-9 || S0 <= 1e-9 || K <= 1e-9 || params.vol <= 1e-9) {
+        return params;
+    }
+    const double T = params.deltaT * params.N;
+    const double sigmaSqrtT = params.vol * std::sqrt(T);
+    const double d1 = (std::log(S0 / K) + (params.rate + 0.5 * params.vol * params.vol) * T) / sigmaSqrtT;
+    const double d2 = d1 - sigmaSqrtT;
+    const double p = peizerPrattInversion(d2, params.N);
+    const double pBar = peizerPrattInversion(d1, params.N);
+    if (p <= 0.0 || p >= 1.0) {
+        return params; // Deep in/out of the money beyond double precision: keep CRR
+    }
+    const double a = std::exp(params.rate * params.deltaT);
+    params.u = a * pBar / p;
+    params.d = (a - p * params.u) / (1.0 - p);
+    params.p_up = p;
+    params.p_down = 1.0 - p;
+    return params;
+}
+
+TreeParams BBSRTreePricer::SetupTreeParams(const Market& mkt, const TreeInputs& inputs, double, int nSteps) const {
+    return crrTreeParams(mkt, inputs, nSteps);
+}
+
+double BBSRTreePricer::RunTree(const Market& mkt, const TreeInputs& inputs, int nSteps, TreeGreeks* greeks) const {
+    const double full = RunSingleTree(mkt, inputs, nSteps, greeks, true);
+    const double half = RunSingleTree(mkt, inputs, nSteps / 2, nullptr, true);
+    const double price = 2.0 * full - half;
+    if (greeks) greeks->pv = price;
+    return price;
+}
+
+double BinomialTreePricer::PriceTree(const Market& mkt, const TreeProduct& product) const {
+    return Solve(mkt, treeInputsFor(product), nullptr);
+}
+
+TreeGreeks BinomialTreePricer::PriceTreeWithGreeks(const Market& mkt, const TreeProduct& product) const {
+    TreeGreeks greeks;
+    greeks.pv = Solve(mkt, treeInputsFor(product), &greeks);
+    return greeks;
+}
+
+double BinomialTreePricer::PriceWithSteps(const Market& mkt, const TreeProduct& product, int nSteps) const {
+    return RunTree(mkt, treeInputsFor(product), EffectiveSteps(nSteps), nullptr);
+}
+
+double BinomialTreePricer::PriceOption(const Market& mkt, const TreeInputs& inputs) const {
+    return Solve(mkt, inputs, nullptr);
+}
+
+double BinomialTreePricer::Solve(const Market& mkt, const TreeInputs& inputs, TreeGreeks* greeks) const {
+    int n = EffectiveSteps(this->N);
+    double price = RunTree(mkt, inputs, n, greeks);
+    if (tolerance <= 0.0) {
+        return price;
+    }
+    while (true) {
+        const int next = EffectiveSteps(2 * n);
+        if (next <= n || next > maxToleranceSteps) break;
+        const double refined = RunTree(mkt, inputs, next, greeks);
+        const bool converged = std::abs(refined - price) < tolerance;
+        price = refined;
+        n = next;
+        if (converged) break;
     }
+    return price;
+}
+
+double BinomialTreePricer::RunTree(const Market& mkt, const TreeInputs& inputs, int nSteps, TreeGreeks* greeks) const {
+    return RunSingleTree(mkt, inputs, nSteps, greeks, false);
 }
 
-double CRRBinomialTreePricer::PriceTree(const Market& mkt, const TreeProduct& product) const {
-    double S0 = mkt.getStockPrice(product.getUnderlyingName());
+double BinomialTreePricer::RunSingleTree(const Market& mkt, const TreeInputs& inputs, int nSteps, TreeGreeks* greeks,
+                                         bool closedFormLastStep) const {
+    PRICING_SCOPED_TIMER(PriceTree);
+    double S0 = mkt.getStockPrice(inputs.underlyingId);
     if (S0 < 0) {
         throw std::runtime_error("Initial stock price cannot be negative.");
     }
 
-    SetupTreeParams(mkt, product); // Sets mutable members u, d, p_up, p_down, deltaT, df_step
+    const TreeParams params = SetupTreeParams(mkt, inputs, S0, nSteps); // Per call: nothing is stored on the pricer
 
-    if (this->N == 0 || this->deltaT <= 1e-9) { // If N is 0 or time step is zero (option on expiry)
-        return product.Payoff(S0);
+    if (params.N == 0 || params.deltaT <= 1e-9) { // If N is 0 or time step is zero (option on expiry)
+        // Greeks (if requested) stay at zero
+        return inputs.product ? inputs.product->Payoff(S0)
+                              : PAYOFF::VanillaOption(inputs.option.type, inputs.option.strike, S0);
+    }
+
+    LastStepClosedForm lastStep;
+    const LastStepClosedForm* lastStepPtr = nullptr;
+    if (closedFormLastStep && (inputs.option.type == Call || inputs.option.type == Put)) {
+        lastStep.type = inputs.option.type;
+        lastStep.strike = inputs.option.strike;
+        lastStepPtr = &lastStep;
+    }
+    // Spot grid by recurrence and a per-thread workspace: no pow calls, no allocation after warm-up.
+    // Built-in vanillas and binaries run on their specialized kernel, anything else via callbacks.
+    LatticeWorkspace& ws = LatticeWorkspace::forThisThread();
+    if (!inputs.product) {
+        return priceOptionOnLattice(params, S0, inputs.option, ws, greeks, lastStepPtr);
+    }
+    return priceOnLattice(params, S0, *inputs.product, ws, greeks, lastStepPtr);
+}
+
+namespace {
+
+// Lanes per strip; larger groups are split so the strip layer stays cache-sized.
+constexpr size_t kMaxStripLanes = 64;
+
+// Tree products priced on one strip share underlying, expiry and curves.
+struct StripKey {
+    MarketDataId underlying = kNoMarketDataId;
+    long expiry = 0;
+    MarketDataId rateCurve = kNoMarketDataId;
+    MarketDataId volCurve = kNoMarketDataId;
+    size_t index = 0; // Into the batch's trades
+
+    bool sameTree(const StripKey& o) const {
+        return underlying == o.underlying && expiry == o.expiry && rateCurve == o.rateCurve && volCurve == o.volCurve;
+    }
+    bool operator<(const StripKey& o) const {
+        return std::tie(underlying, expiry, rateCurve, volCurve, index) <
+               std::tie(o.underlying, o.expiry, o.rateCurve, o.volCurve, o.index);
     }
+};
 
-    std::vector<double> V(N + 1); // Option values at current time step, going backwards
+} // namespace
 
-    // Initialize values at expiry (time N)
-    for (int j = 0; j <= N; ++j) { // j is number of up steps
-        double S_expiry_node = S0 * std::pow(this->u, j) * std::pow(this->d, N - j);
-        V[j] = product.Payoff(S_expiry_node);
+void BinomialTreePricer::PriceTreeBatch(const Market& mkt, const Trade* const* trades, const size_t* indices, size_t count,
+                                        double* pvs, std::string* errors) const {
+    if (!stripPricing || tolerance > 0.0 || !SharesTreeAcrossStrikes() || count < 2) {
+        Pricer::PriceTreeBatch(mkt, trades, indices, count, pvs, errors);
+        return;
     }
+    auto productAt = [&](size_t i) -> const TreeProduct& { return static_cast<const TreeProduct&>(*trades[i]); };
 
-    // Backward induction
-    for (int i = N - 1; i >= 0; --i) { // Time step i
-        for (int j = 0; j <= i; ++j) { // Node j at time step i (j up steps)
-            double S_node = S0 * std::pow(this->u, j) * std::pow(this->d, i - j);
-            double continuation_value = (this->p_up * V[j + 1] + this->p_down * V[j]) * this->df_step;
-            V[j] = product.ValueAtNode(S_node, i * this->deltaT, continuation_value);
+    // Group built-in calls and puts by tree; anything else (binaries, derived products, lone
+    // trades) is priced on its own.
+    static thread_local std::vector<StripKey> keys;
+    static thread_local std::vector<size_t> singles;
+    static thread_local std::vector<StripLane> lanes;
+    static thread_local std::vector<double> lanePvs;
+    keys.clear();
+    singles.clear();
+    for (size_t k = 0; k < count; ++k) {
+        const TreeProduct& product = productAt(indices[k]);
+        LatticeOption option;
+        if (!latticeOptionFor(product, option) || (option.type != Call && option.type != Put)) {
+            singles.push_back(indices[k]);
+            continue;
         }
+        keys.push_back(StripKey{product.getUnderlyingId(), product.GetExpiry().getSerialDate(),
+                                product.getRateCurveId(), product.getVolCurveId(), indices[k]});
     }
-    return V[0]; // Value at t=0, node 0 (0 up steps)
+    std::sort(keys.begin(), keys.end());
+
+    const int nSteps = EffectiveSteps(this->N);
+    for (size_t begin = 0; begin < keys.size();) {
+        size_t end = begin + 1;
+        while (end < keys.size() && end - begin < kMaxStripLanes && keys[end].sameTree(keys[begin])) ++end;
+        const size_t n = end - begin;
+        if (n == 1) {
+            singles.push_back(keys[begin].index);
+            begin = end;
+            continue;
+        }
+        lanes.clear();
+        for (size_t k = begin; k < end; ++k) {
+            LatticeOption option;
+            latticeOptionFor(productAt(keys[k].index), option);
+            lanes.push_back(StripLane{option.type, option.strike, option.exercise == ExerciseStyle::American});
+        }
+        lanePvs.resize(n);
+        try {
+#ifdef PRICING_INSTRUMENTATION
+            const auto start = std::chrono::steady_clock::now();
+#endif
+            RunStrip(mkt, treeInputsFor(productAt(keys[begin].index)), lanes.data(), n, nSteps, lanePvs.data());
+#ifdef PRICING_INSTRUMENTATION
+            // Each lane is charged an equal share of the strip.
+            const uint64_t nanos = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now() - start).count());
+            for (size_t k = begin; k < end; ++k) {
+                instrumentation::recordTradeLatency(productAt(keys[k].index).getKind(), nanos / n);
+            }
+#endif
+            for (size_t k = 0; k < n; ++k) pvs[keys[begin + k].index] = lanePvs[k];
+        } catch (const std::exception&) {
+            // Shared inputs failed (e.g. a missing curve): price the group one by one so each
+            // trade gets its own error, or the first exception propagates.
+            for (size_t k = begin; k < end; ++k) singles.push_back(keys[k].index);
+        }
+        begin = end;
+    }
+    Pricer::PriceTreeBatch(mkt, trades, singles.data(), singles.size(), pvs, errors);
 }
 
-//Updated
+void BinomialTreePricer::RunStrip(const Market& mkt, const TreeInputs& reference, const StripLane* lanes, size_t count,
+                                  int nSteps, double* pvs) const {
+    RunSingleStrip(mkt, reference, lanes, count, nSteps, pvs, false);
+}
+
+void BinomialTreePricer::RunSingleStrip(const Market& mkt, const TreeInputs& reference, const StripLane* lanes,
+                                        size_t count, int nSteps, double* pvs, bool closedFormLastStep) const {
+    PRICING_SCOPED_TIMER(PriceTree);
+    const double S0 = mkt.getStockPrice(reference.underlyingId);
+    if (S0 < 0) {
+        throw std::runtime_error("Initial stock price cannot be negative.");
+    }
+    const TreeParams params = SetupTreeParams(mkt, reference, S0, nSteps);
+    if (params.N == 0 || params.deltaT <= 1e-9) { // Option on expiry, as RunSingleTree
+        for (size_t k = 0; k < count; ++k) pvs[k] = PAYOFF::VanillaOption(lanes[k].type, lanes[k].strike, S0);
+        return;
+    }
+    priceStripOnLattice(params, S0, lanes, count, LatticeWorkspace::forThisThread(), pvs, closedFormLastStep);
+}
+
+void BBSRTreePricer::RunStrip(const Market& mkt, const TreeInputs& reference, const StripLane* lanes, size_t count,
+                              int nSteps, double* pvs) const {
+    static thread_local std::vector<double> half;
+    half.resize(count);
+    RunSingleStrip(mkt, reference, lanes, count, nSteps, pvs, true);
+    RunSingleStrip(mkt, reference, lanes, count, nSteps / 2, half.data(), true);
+    for (size_t k = 0; k < count; ++k) pvs[k] = 2.0 * pvs[k] - half[k];
+}
+
+TreeModel parseTreeModel(const std::string& name) {
+    if (name == "crr") return TreeModel::CRR;
+    if (name == "lr") return TreeModel::LeisenReimer;
+    if (name == "bbsr") return TreeModel::BBSR;
+    throw std::invalid_argument("Unknown tree model '" + name + "' (expected crr, lr or bbsr)");
+}
+
+std::unique_ptr<BinomialTreePricer> makeTreePricer(TreeModel model, int nSteps) {
+    switch (model) {
+    case TreeModel::LeisenReimer: return std::make_unique<LeisenReimerTreePricer>(nSteps);
+    case TreeModel::BBSR: return std::make_unique<BBSRTreePricer>(nSteps);
+    default: return std::make_unique<CRRBinomialTreePricer>(nSteps);
+    }
+}
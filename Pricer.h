@@ -6,6 +6,10 @@
 #include <memory>
 #include <string>
 
+#include "BinomialLattice.h" // TreeGreeks
+#include "Date.h"
+#include "MarketDataId.h"
+
 // Forward declarations
 class Market;
 class Trade;
@@ -18,45 +22,176 @@ public:
     virtual ~Pricer() = default;
     virtual double Price(const Market& mkt, const std::shared_ptr<Trade>& trade) const;
 
+    // Same as above without touching the shared_ptr refcount. Dispatches on Trade::getKind()
+    // and only falls back to dynamic_cast for InstrumentKind::Other.
+    virtual double Price(const Market& mkt, const Trade& trade) const;
+
+    // Prices trades[0..count) into pvs[0..count). The batch is partitioned by instrument kind
+    // once, then each homogeneous group is priced in its own loop with no per-trade dispatch.
+    // If errors is non-null, a failing trade gets pvs[i] = NaN and its message in errors[i]
+    // (other trades are still priced); otherwise the first exception propagates.
+    void PriceBatch(const Market& mkt, const Trade* const* trades, size_t count, double* pvs,
+                    std::string* errors = nullptr) const;
+
+    // Returns an independent copy of this pricer. The built-in pricers keep no per-call state,
+    // so one instance may be shared by any number of threads (PortfolioEngine and RiskEngine
+    // do); pricers derived outside this file must keep Price thread-safe to be used that way.
+    virtual std::unique_ptr<Pricer> Clone() const = 0;
+
 protected:
     // PriceTree is the core method for options, to be implemented by derived tree pricers.
     // It's marked const because the pricer itself (its configuration like N_steps) doesn't change per call,
     // but it will need to calculate tree parameters (u,d,p,etc.) based on mkt and product.
     // These calculations will happen inside PriceTree or a helper it calls.
     virtual double PriceTree(const Market& mkt, const TreeProduct& product) const = 0;
+
+    // Prices the tree products trades[indices[0..count)] for PriceBatch, with the same error
+    // contract. The default calls PriceTree on each; BinomialTreePricer can price strips.
+    virtual void PriceTreeBatch(const Market& mkt, const Trade* const* trades, const size_t* indices, size_t count,
+                                double* pvs, std::string* errors) const;
+};
+
+// What one tree pricing works from: the expiry and market data a tree is built on, and the
+// option priced on it. Without product, 'option' runs on its specialized lattice kernel (a
+// built-in option, or a TradeStore row); with one, the product's callbacks are used and
+// option only carries its type and strike.
+struct TreeInputs {
+    Date expiry;
+    MarketDataId underlyingId = kNoMarketDataId;
+    MarketDataId rateCurveId = kNoMarketDataId;
+    MarketDataId volCurveId = kNoMarketDataId;
+    LatticeOption option;
+    const TreeProduct* product = nullptr;
 };
 
 class BinomialTreePricer : public Pricer {
 public:
     BinomialTreePricer(int nSteps) : N(nSteps) {}
 
+    int getSteps() const { return N; }
+
+    // Tolerance mode: with absTolerance > 0, PriceTree starts at N steps and doubles the step
+    // count until two successive prices differ by less than absTolerance, or the next count
+    // would exceed maxSteps. Configure before pricing; the setting is not changed by pricing.
+    void setTolerance(double absTolerance, int maxSteps = 4096) {
+        tolerance = absTolerance;
+        maxToleranceSteps = maxSteps;
+    }
+    double getTolerance() const { return tolerance; }
+
+    // Strip mode: in PriceBatch, European and American calls and puts sharing underlying, expiry,
+    // rate curve and vol curve are priced on one lattice, one lane per strike, instead of a tree
+    // each (see priceStripOnLattice). Prices are unchanged. Ignored in tolerance mode and by
+    // models whose tree depends on the strike (Leisen-Reimer).
+    void setStripPricing(bool enabled) { stripPricing = enabled; }
+    bool getStripPricing() const { return stripPricing; }
+
+    // Main pricing method for tree products (fixed N, or the tolerance mode above)
+    double PriceTree(const Market& mkt, const TreeProduct& product) const override;
+
+    // Same tree as PriceTree, also returning delta, gamma and theta taken from the
+    // early lattice levels of the same backward induction (no extra tree builds).
+    TreeGreeks PriceTreeWithGreeks(const Market& mkt, const TreeProduct& product) const;
+
+    // One price at an explicit step count, ignoring the tolerance setting.
+    double PriceWithSteps(const Market& mkt, const TreeProduct& product, int nSteps) const;
+
+    // PriceTree for an option given by its terms rather than a TreeProduct (e.g. a TradeStore
+    // row): same tree, step count and tolerance mode as PriceTree on the matching option.
+    double PriceOption(const Market& mkt, const TreeInputs& inputs) const;
+
 protected:
-    // These members will be populated by a specific model's setup logic (e.g., CRR's ModelSetup)
-    // They are effectively 'cached' or 'configured' per product pricing call within PriceTree.
-    // Making them mutable allows PriceTree (which is const) to modify them via a helper method.
-    mutable int N; // Number of time steps
-    mutable double deltaT; // Time step duration
-    mutable double u;      // Up factor
-    mutable double d;      // Down factor
-    mutable double p_up;   // Risk-neutral probability of up move
-    mutable double p_down; // Risk-neutral probability of down move
-    mutable double df_step; // Discount factor per step
-
-    // Pure virtual method for specific model (CRR, JRR) to set up these parameters
-    virtual void SetupTreeParams(const Market& mkt, const TreeProduct& product) const = 0;
+    int N; // Number of time steps; fixed at construction
+    double tolerance = 0.0;
+    int maxToleranceSteps = 4096;
+    bool stripPricing = false;
+
+    void PriceTreeBatch(const Market& mkt, const Trade* const* trades, const size_t* indices, size_t count,
+                        double* pvs, std::string* errors) const override;
+
+    // Model-specific (CRR, JRR) tree of nSteps steps for one pricing call; S0 is the spot the
+    // caller read. The parameters are returned by value rather than stored on the pricer, so
+    // concurrent calls do not interfere.
+    virtual TreeParams SetupTreeParams(const Market& mkt, const TreeInputs& inputs, double S0, int nSteps) const = 0;
+
+    // Step count the model actually uses for a requested one (e.g. Leisen-Reimer needs odd N).
+    virtual int EffectiveSteps(int nSteps) const { return nSteps; }
+
+    // Price on an nSteps tree; greeks may be null. The default prices the one tree from
+    // SetupTreeParams; extrapolating pricers combine several.
+    virtual double RunTree(const Market& mkt, const TreeInputs& inputs, int nSteps, TreeGreeks* greeks) const;
+
+    // One backward induction on the SetupTreeParams tree. With closedFormLastStep, the final
+    // step uses Black-Scholes values for Call/Put products (binomial Black-Scholes).
+    double RunSingleTree(const Market& mkt, const TreeInputs& inputs, int nSteps, TreeGreeks* greeks,
+                         bool closedFormLastStep) const;
+
+    // False when SetupTreeParams depends on the product beyond its underlying, expiry and curves.
+    virtual bool SharesTreeAcrossStrikes() const { return true; }
+
+    // Strip counterparts of RunTree/RunSingleTree: prices lanes[0..count), all on the tree
+    // SetupTreeParams builds for 'reference', into pvs.
+    virtual void RunStrip(const Market& mkt, const TreeInputs& reference, const StripLane* lanes, size_t count,
+                          int nSteps, double* pvs) const;
+    void RunSingleStrip(const Market& mkt, const TreeInputs& reference, const StripLane* lanes, size_t count,
+                        int nSteps, double* pvs, bool closedFormLastStep) const;
+
+private:
+    // N steps, or the tolerance-mode search; greeks may be null.
+    double Solve(const Market& mkt, const TreeInputs& inputs, TreeGreeks* greeks) const;
 };
 
 class CRRBinomialTreePricer : public BinomialTreePricer {
 public:
     CRRBinomialTreePricer(int nSteps) : BinomialTreePricer(nSteps) {}
 
-    // Main pricing method for tree products using CRR model
-    double PriceTree(const Market& mkt, const TreeProduct& product) const override;
+    std::unique_ptr<Pricer> Clone() const override { return std::make_unique<CRRBinomialTreePricer>(*this); }
+
+protected:
+    // CRR-specific u, d, p, etc.
+    TreeParams SetupTreeParams(const Market& mkt, const TreeInputs& inputs, double S0, int nSteps) const override;
+};
+
+// Leisen-Reimer tree: u, d and p come from Peizer-Pratt inversions of d1/d2 so that the
+// strike sits on the centre of the terminal layer. Converges smoothly at O(1/N^2) instead
+// of CRR's oscillating O(1/N). Uses odd step counts (an even N is rounded up); products
+// without a strike, or a zero spot or vol, fall back to the CRR tree.
+class LeisenReimerTreePricer : public BinomialTreePricer {
+public:
+    LeisenReimerTreePricer(int nSteps) : BinomialTreePricer(nSteps) {}
+
+    std::unique_ptr<Pricer> Clone() const override { return std::make_unique<LeisenReimerTreePricer>(*this); }
 
 protected:
-    // CRR-specific implementation to set u, d, p, etc.
-    void SetupTreeParams(const Market& mkt, const TreeProduct& product) const override;
+    TreeParams SetupTreeParams(const Market& mkt, const TreeInputs& inputs, double S0, int nSteps) const override;
+    int EffectiveSteps(int nSteps) const override { return (nSteps % 2 == 0) ? nSteps + 1 : nSteps; }
+    bool SharesTreeAcrossStrikes() const override { return false; }
 };
 
+// Binomial Black-Scholes with Richardson extrapolation (Broadie-Detemple): a CRR tree whose last
+// step is replaced by Black-Scholes values, priced at N and N/2 and combined as 2 P(N) - P(N/2).
+// The smoothing removes CRR's odd/even oscillation so the extrapolation is effective. Uses even
+// step counts (an odd N is rounded up); Greeks come from the N-step tree.
+class BBSRTreePricer : public BinomialTreePricer {
+public:
+    BBSRTreePricer(int nSteps) : BinomialTreePricer(nSteps) {}
+
+    std::unique_ptr<Pricer> Clone() const override { return std::make_unique<BBSRTreePricer>(*this); }
+
+protected:
+    TreeParams SetupTreeParams(const Market& mkt, const TreeInputs& inputs, double S0, int nSteps) const override;
+    int EffectiveSteps(int nSteps) const override { return (nSteps < 2) ? 2 : nSteps + (nSteps % 2); }
+    double RunTree(const Market& mkt, const TreeInputs& inputs, int nSteps, TreeGreeks* greeks) const override;
+    void RunStrip(const Market& mkt, const TreeInputs& reference, const StripLane* lanes, size_t count,
+                  int nSteps, double* pvs) const override;
+};
+
+enum class TreeModel { CRR, LeisenReimer, BBSR };
+
+// "crr", "lr" or "bbsr"; throws std::invalid_argument otherwise.
+TreeModel parseTreeModel(const std::string& name);
+
+std::unique_ptr<BinomialTreePricer> makeTreePricer(TreeModel model, int nSteps);
+
 #endif // PRICER_H
 //Updated
@@ -0,0 +1,168 @@
+#include "RandomStreams.h"
+
+#include <cmath>
+#include <stdexcept>
+#include <string>
+
+namespace {
+
+// Joe-Kuo (new-joe-kuo-6.21201) primitive polynomials and initial direction numbers for
+// dimensions 2..21; dimension 1 is the van der Corput sequence.
+struct SobolPolynomial {
+    int degree;
+    uint32_t coefficients; // Interior coefficients a_1..a_{s-1}, a_1 the most significant bit
+    uint32_t m[7];
+};
+
+const SobolPolynomial kSobolPolynomials[SobolSequence::kMaxDimensions - 1] = {
+    {1, 0, {1}},
+    {2, 1, {1, 3}},
+    {3, 1, {1, 3, 1}},
+    {3, 2, {1, 1, 1}},
+    {4, 1, {1, 1, 3, 3}},
+    {4, 4, {1, 3, 5, 13}},
+    {5, 2, {1, 1, 5, 5, 17}},
+    {5, 4, {1, 1, 5, 5, 5}},
+    {5, 7, {1, 1, 7, 11, 19}},
+    {5, 11, {1, 1, 5, 1, 1}},
+    {5, 13, {1, 1, 1, 3, 11}},
+    {5, 14, {1, 3, 5, 5, 31}},
+    {6, 1, {1, 3, 3, 9, 7, 49}},
+    {6, 13, {1, 1, 1, 15, 21, 21}},
+    {6, 16, {1, 3, 1, 13, 27, 49}},
+    {6, 19, {1, 1, 1, 15, 7, 5}},
+    {6, 22, {1, 3, 1, 15, 13, 25}},
+    {6, 25, {1, 1, 5, 5, 19, 61}},
+    {7, 1, {1, 3, 7, 11, 23, 15, 103}},
+    {7, 4, {1, 3, 7, 13, 13, 15, 69}},
+};
+
+constexpr int kSobolBits = 32;
+
+inline void mulhilo(uint32_t a, uint32_t b, uint32_t& hi, uint32_t& lo) {
+    const uint64_t product = static_cast<uint64_t>(a) * b;
+    hi = static_cast<uint32_t>(product >> 32);
+    lo = static_cast<uint32_t>(product);
+}
+
+} // namespace
+
+Philox4x32::Counter Philox4x32::operator()(Counter c) const {
+    uint32_t k0 = key[0], k1 = key[1];
+    for (int round = 0; round < 10; ++round) {
+        uint32_t hi0, lo0, hi1, lo1;
+        mulhilo(0xD2511F53u, c[0], hi0, lo0);
+        mulhilo(0xCD9E8D57u, c[2], hi1, lo1);
+        c = {hi1 ^ c[1] ^ k0, lo1, hi0 ^ c[3] ^ k1, lo0};
+        k0 += 0x9E3779B9u;
+        k1 += 0xBB67AE85u;
+    }
+    return c;
+}
+
+SobolSequence::SobolSequence(int dimensions)
+    : dims(dimensions), directions(static_cast<size_t>(kSobolBits) * dimensions), state(dimensions, 0) {
+    if (dimensions < 1 || dimensions > kMaxDimensions) {
+        throw std::invalid_argument("SobolSequence: dimensions must be in [1, " + std::to_string(kMaxDimensions) + "].");
+    }
+    auto v = [&](int bit, int d) -> uint32_t& { return directions[static_cast<size_t>(bit) * dims + d]; };
+    for (int bit = 0; bit < kSobolBits; ++bit) {
+        v(bit, 0) = 1u << (kSobolBits - 1 - bit);
+    }
+    for (int d = 1; d < dims; ++d) {
+        const SobolPolynomial& poly = kSobolPolynomials[d - 1];
+        const int s = poly.degree;
+        for (int bit = 0; bit < kSobolBits; ++bit) {
+            if (bit < s) {
+                v(bit, d) = poly.m[bit] << (kSobolBits - 1 - bit);
+                continue;
+            }
+            uint32_t value = v(bit - s, d) ^ (v(bit - s, d) >> s);
+            for (int k = 1; k < s; ++k) {
+                if ((poly.coefficients >> (s - 1 - k)) & 1u) value ^= v(bit - k, d);
+            }
+            v(bit, d) = value;
+        }
+    }
+}
+
+const uint32_t* SobolSequence::seek(uint64_t i) {
+    index = i;
+    const uint64_t gray = i ^ (i >> 1);
+    for (int d = 0; d < dims; ++d) {
+        uint32_t x = 0;
+        for (int bit = 0; bit < kSobolBits; ++bit) {
+            if ((gray >> bit) & 1u) x ^= directions[static_cast<size_t>(bit) * dims + d];
+        }
+        state[d] = x;
+    }
+    return state.data();
+}
+
+const uint32_t* SobolSequence::next() {
+    // Gray code: point i + 1 differs from point i in the direction of i's lowest zero bit.
+    int bit = 0;
+    while ((index >> bit) & 1u) ++bit;
+    ++index;
+    if (bit >= kSobolBits) {
+        throw std::out_of_range("SobolSequence: more than 2^32 points requested.");
+    }
+    const uint32_t* v = &directions[static_cast<size_t>(bit) * dims];
+    for (int d = 0; d < dims; ++d) state[d] ^= v[d];
+    return state.data();
+}
+
+BrownianBridge::BrownianBridge(int steps_in, double maturity)
+    : n(steps_in), bridgeIndex(steps_in), leftIndex(steps_in), rightIndex(steps_in),
+      leftWeight(steps_in), rightWeight(steps_in), stdDev(steps_in) {
+    if (n < 1 || !(maturity > 0.0)) {
+        throw std::invalid_argument("BrownianBridge: need at least one step and a positive maturity.");
+    }
+    auto time = [&](int i) { return maturity * (i + 1) / n; }; // t_{i+1}, i = 0..n-1
+    // map[i] != 0 once W(t_{i+1}) has been placed.
+    std::vector<int> map(n, 0);
+    map[n - 1] = 1;
+    bridgeIndex[0] = n - 1;
+    stdDev[0] = std::sqrt(maturity);
+    int j = 0;
+    for (int i = 1; i < n; ++i) {
+        while (map[j]) ++j;
+        int k = j;
+        while (!map[k]) ++k;
+        // Nodes j..k-1 are free, k is placed: fill their midpoint from j-1 (or 0) and k.
+        const int l = j + ((k - 1 - j) >> 1);
+        map[l] = i;
+        bridgeIndex[i] = l;
+        leftIndex[i] = j;
+        rightIndex[i] = k;
+        const double tLeft = (j == 0) ? 0.0 : time(j - 1);
+        leftWeight[i] = (time(k) - time(l)) / (time(k) - tLeft);
+        rightWeight[i] = (time(l) - tLeft) / (time(k) - tLeft);
+        stdDev[i] = std::sqrt((time(l) - tLeft) * (time(k) - time(l)) / (time(k) - tLeft));
+        j = k + 1;
+        if (j >= n) j = 0;
+    }
+}
+
+void BrownianBridge::build(const double* z, double* w, size_t width, size_t stride) const {
+    {
+        double* out = w + static_cast<size_t>(n - 1) * stride;
+        const double sd = stdDev[0];
+        for (size_t p = 0; p < width; ++p) out[p] = sd * z[p];
+    }
+    for (int i = 1; i < n; ++i) {
+        const int j = leftIndex[i];
+        const double* right = w + static_cast<size_t>(rightIndex[i]) * stride;
+        const double* zi = z + static_cast<size_t>(i) * stride;
+        double* out = w + static_cast<size_t>(bridgeIndex[i]) * stride;
+        const double rw = rightWeight[i];
+        const double sd = stdDev[i];
+        if (j == 0) {
+            for (size_t p = 0; p < width; ++p) out[p] = rw * right[p] + sd * zi[p];
+        } else {
+            const double* left = w + static_cast<size_t>(j - 1) * stride;
+            const double lw = leftWeight[i];
+            for (size_t p = 0; p < width; ++p) out[p] = lw * left[p] + rw * right[p] + sd * zi[p];
+        }
+    }
+}
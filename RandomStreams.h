@@ -0,0 +1,75 @@
+#ifndef RANDOM_STREAMS_H
+#define RANDOM_STREAMS_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Random number sources for the Monte Carlo engine. All of them are addressable: the value
+// for a given (stream, index) is a pure function of the inputs, so results do not depend on
+// how work is split across threads or in which order it runs.
+
+// Philox4x32-10 counter-based generator (Salmon et al., "Parallel random numbers: as easy as
+// 1, 2, 3"): a keyed bijection of a 128-bit counter, 4 x 32 random bits per call.
+class Philox4x32 {
+public:
+    using Counter = std::array<uint32_t, 4>;
+
+    explicit Philox4x32(uint64_t seed)
+        : key{static_cast<uint32_t>(seed), static_cast<uint32_t>(seed >> 32)} {}
+
+    Counter operator()(Counter counter) const;
+
+    // Uniform in (0, 1) with 53 random bits from two 32-bit words; never 0 or 1.
+    static double toUniform(uint32_t hi, uint32_t lo) {
+        return ((static_cast<uint64_t>(hi >> 5) << 26 | (lo >> 6)) + 0.5) * 0x1.0p-53;
+    }
+
+private:
+    std::array<uint32_t, 2> key;
+};
+
+// Sobol' sequence in up to kMaxDimensions dimensions (Joe-Kuo direction numbers, 32 bits).
+// point(i) fills the i-th point directly; next() steps to the following point in Gray-code
+// order, which visits the same set of points for any power-of-two prefix.
+class SobolSequence {
+public:
+    static constexpr int kMaxDimensions = 21;
+
+    explicit SobolSequence(int dimensions);
+
+    int dimensions() const { return dims; }
+
+    // Positions the sequence at point index and returns it (32-bit integers per dimension).
+    const uint32_t* seek(uint64_t index);
+    // Advances to the next point in Gray-code order and returns it.
+    const uint32_t* next();
+
+private:
+    int dims;
+    uint64_t index = 0;
+    std::vector<uint32_t> directions; // directions[bit * dims + d]
+    std::vector<uint32_t> state;
+};
+
+// Brownian-bridge construction of W(t_1..t_n) on equally spaced times t_i = i T / n: the first
+// normal sets W(T), the next ones the midpoints in order of decreasing variance. Paired with
+// Sobol', the leading (best distributed) dimensions carry most of the path's variance.
+class BrownianBridge {
+public:
+    BrownianBridge(int steps, double maturity);
+
+    int steps() const { return n; }
+
+    // Maps z[i * stride + p] (normals in bridge order) to w[i * stride + p] = W(t_{i+1}) for the
+    // 'width' paths p < width laid out side by side; the path loop is the inner one.
+    void build(const double* z, double* w, size_t width, size_t stride) const;
+
+private:
+    int n;
+    std::vector<int> bridgeIndex, leftIndex, rightIndex;
+    std::vector<double> leftWeight, rightWeight, stdDev;
+};
+
+#endif // RANDOM_STREAMS_H
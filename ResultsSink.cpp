@@ -0,0 +1,387 @@
+#include "ResultsSink.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+#include <utility>
+
+#include "MappedFile.h"
+
+ResultsFormat parseResultsFormat(const std::string& name) {
+    if (name == "text") return ResultsFormat::Text;
+    if (name == "binary") return ResultsFormat::Binary;
+    throw std::invalid_argument("Unknown results format '" + name + "' (expected text or binary)");
+}
+
+// --- AsyncFileWriter ---
+
+AsyncFileWriter::~AsyncFileWriter() {
+    try {
+        close();
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+    }
+}
+
+bool AsyncFileWriter::open(const std::string& path, size_t bufferSize, size_t maxPendingBuffers) {
+    close();
+    file.open(path, std::ios::binary | std::ios::trunc);
+    if (!file.is_open()) return false;
+    filePath = path;
+    bufferBytes = std::max<size_t>(bufferSize, 4096);
+    maxPending = std::max<size_t>(maxPendingBuffers, 1);
+    buffer.clear();
+    buffer.reserve(bufferBytes);
+    closing = false;
+    failed = false;
+    writerThread = std::thread(&AsyncFileWriter::writerLoop, this);
+    return true;
+}
+
+void AsyncFileWriter::append(const char* data, size_t n) {
+    buffer.append(data, n);
+    if (buffer.size() >= bufferBytes) handOff();
+}
+
+void AsyncFileWriter::handOff() {
+    if (buffer.empty()) return;
+    std::string full;
+    full.reserve(bufferBytes);
+    full.swap(buffer);
+    std::unique_lock<std::mutex> lock(mutex);
+    queueChanged.wait(lock, [this] { return pending.size() < maxPending; });
+    pending.push_back(std::move(full));
+    queueChanged.notify_all();
+}
+
+void AsyncFileWriter::writerLoop() {
+    for (;;) {
+        std::string chunk;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            queueChanged.wait(lock, [this] { return closing || !pending.empty(); });
+            if (pending.empty()) return; // closing, and everything is written
+            chunk = std::move(pending.front());
+            pending.pop_front();
+            queueChanged.notify_all();
+        }
+        if (!failed) {
+            file.write(chunk.data(), static_cast<std::streamsize>(chunk.size()));
+            if (!file) failed = true; // Only this thread touches 'failed' until join
+        }
+    }
+}
+
+void AsyncFileWriter::close() {
+    if (!writerThread.joinable()) return;
+    handOff();
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        closing = true;
+    }
+    queueChanged.notify_all();
+    writerThread.join();
+    file.close();
+    if (failed || file.fail()) {
+        throw std::runtime_error("Failed writing results to '" + filePath + "'");
+    }
+}
+
+// --- TextResultsSink ---
+
+bool TextResultsSink::open(const std::string& filePath, size_t bufferBytes) {
+    if (!writer.open(filePath, bufferBytes)) return false;
+    writer.append("Instrument;Type;PV;DV01_Curve;DV01_Value;Vega_Curve;Vega_Value\n");
+    return true;
+}
+
+void TextResultsSink::appendFixed(double value) {
+    // Same digits as an ostream with std::fixed << std::setprecision(6).
+    char buf[64];
+    const int n = std::snprintf(buf, sizeof(buf), "%.6f", value);
+    if (n < static_cast<int>(sizeof(buf))) {
+        line.append(buf, static_cast<size_t>(n));
+        return;
+    }
+    std::string big(static_cast<size_t>(n) + 1, '\0');
+    std::snprintf(&big[0], big.size(), "%.6f", value);
+    line.append(big.data(), static_cast<size_t>(n));
+}
+
+void TextResultsSink::writeTradeResult(const TradeResult& result) {
+    line.clear();
+    line += result.instrument;
+    line += ';';
+    line += result.type;
+    line += ';';
+    if (result.pvOk) {
+        appendFixed(result.pv);
+        line += ';';
+    } else {
+        line += "ErrorPricing;";
+    }
+    if (result.dv01Ok) {
+        if (!result.dv01.empty()) {
+            for (const auto& dv : result.dv01) {
+                line += dv.first;
+                line += ';';
+                appendFixed(dv.second);
+                line += ';';
+            }
+        } else {
+            line += "N/A;0.0;";
+        }
+    } else {
+        line += "ErrorDV01;0.0;";
+    }
+    if (result.vegaOk) {
+        if (!result.vega.empty()) {
+            for (const auto& v : result.vega) {
+                line += v.first;
+                line += ';';
+                appendFixed(v.second);
+            }
+        } else {
+            line += "N/A;0.0";
+        }
+    } else {
+        line += "ErrorVega;0.0";
+    }
+    line += '\n';
+    writer.append(line);
+}
+
+void TextResultsSink::writeNotes(const std::string& text) {
+    writer.append(text);
+}
+
+// --- BinaryResultsSink ---
+
+namespace {
+
+const char kResultsMagic[8] = {'P', 'R', 'C', 'R', 'E', 'S', '\0', '\0'};
+const uint32_t kByteOrderMark = 0x01020304u;
+const uint32_t kTradeBlock = 1;
+const uint32_t kNotesBlock = 2;
+
+template <typename T>
+void appendPod(std::string& out, const T& value) {
+    out.append(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+template <typename T>
+void appendColumn(std::string& out, const std::vector<T>& column) {
+    if (!column.empty()) out.append(reinterpret_cast<const char*>(column.data()), column.size() * sizeof(T));
+}
+
+void appendStrings(std::string& out, const std::vector<std::string>& column) {
+    for (const std::string& s : column) appendPod(out, static_cast<uint32_t>(s.size()));
+    for (const std::string& s : column) out += s;
+}
+
+void appendBlockHeader(std::string& out, uint32_t type, uint32_t rows, uint64_t payloadBytes) {
+    appendPod(out, type);
+    appendPod(out, rows);
+    appendPod(out, payloadBytes);
+}
+
+// Bounds-checked cursor over a mapped results file.
+class Cursor {
+public:
+    Cursor(const char* begin, const char* end) : pos(begin), end(end) {}
+
+    bool atEnd() const { return pos == end; }
+
+    const char* take(size_t n) {
+        if (remaining() < n) throw truncated();
+        const char* p = pos;
+        pos += n;
+        return p;
+    }
+
+    template <typename T>
+    T pod() {
+        T value;
+        std::memcpy(&value, take(sizeof(T)), sizeof(T));
+        return value;
+    }
+
+    // Counts come from the file, so they are checked against the bytes left before anything
+    // is allocated: a corrupt header fails as truncated instead of requesting a huge buffer.
+    template <typename T>
+    std::vector<T> column(size_t n) {
+        if (n > remaining() / sizeof(T)) throw truncated();
+        std::vector<T> values(n);
+        if (n) std::memcpy(values.data(), take(n * sizeof(T)), n * sizeof(T));
+        return values;
+    }
+
+    std::vector<std::string> strings(size_t n) {
+        const std::vector<uint32_t> lengths = column<uint32_t>(n);
+        uint64_t totalBytes = 0;
+        for (uint32_t length : lengths) totalBytes += length;
+        if (totalBytes > remaining()) throw truncated();
+        std::vector<std::string> values(n);
+        for (size_t i = 0; i < n; ++i) values[i].assign(take(lengths[i]), lengths[i]);
+        return values;
+    }
+
+private:
+    size_t remaining() const { return static_cast<size_t>(end - pos); }
+    static std::runtime_error truncated() { return std::runtime_error("Truncated results file"); }
+
+    const char* pos;
+    const char* end;
+};
+
+} // namespace
+
+bool BinaryResultsSink::open(const std::string& filePath, size_t bufferBytes, size_t blockRows) {
+    if (!writer.open(filePath, bufferBytes)) return false;
+    rowsPerBlock = std::max<size_t>(blockRows, 1);
+    std::string header(kResultsMagic, sizeof(kResultsMagic));
+    appendPod(header, kVersion);
+    appendPod(header, kByteOrderMark);
+    writer.append(header);
+    return true;
+}
+
+void BinaryResultsSink::writeTradeResult(const TradeResult& result) {
+    flags.push_back(static_cast<uint8_t>((result.pvOk ? 1 : 0) | (result.dv01Ok ? 2 : 0) | (result.vegaOk ? 4 : 0)));
+    pvs.push_back(result.pvOk ? result.pv : 0.0);
+    instruments.push_back(result.instrument);
+    types.push_back(result.type);
+    dv01Counts.push_back(static_cast<uint32_t>(result.dv01Ok ? result.dv01.size() : 0));
+    if (result.dv01Ok) {
+        for (const auto& dv : result.dv01) {
+            dv01Curves.push_back(dv.first);
+            dv01Values.push_back(dv.second);
+        }
+    }
+    vegaCounts.push_back(static_cast<uint32_t>(result.vegaOk ? result.vega.size() : 0));
+    if (result.vegaOk) {
+        for (const auto& v : result.vega) {
+            vegaCurves.push_back(v.first);
+            vegaValues.push_back(v.second);
+        }
+    }
+    if (flags.size() >= rowsPerBlock) flushBlock();
+}
+
+void BinaryResultsSink::flushBlock() {
+    if (flags.empty()) return;
+    std::string payload;
+    appendColumn(payload, flags);
+    appendColumn(payload, pvs);
+    appendColumn(payload, dv01Counts);
+    appendColumn(payload, vegaCounts);
+    appendStrings(payload, instruments);
+    appendStrings(payload, types);
+    appendStrings(payload, dv01Curves);
+    appendColumn(payload, dv01Values);
+    appendStrings(payload, vegaCurves);
+    appendColumn(payload, vegaValues);
+
+    std::string block;
+    appendBlockHeader(block, kTradeBlock, static_cast<uint32_t>(flags.size()), payload.size());
+    writer.append(block);
+    writer.append(payload);
+
+    flags.clear();
+    pvs.clear();
+    dv01Counts.clear();
+    vegaCounts.clear();
+    instruments.clear();
+    types.clear();
+    dv01Curves.clear();
+    dv01Values.clear();
+    vegaCurves.clear();
+    vegaValues.clear();
+}
+
+void BinaryResultsSink::writeNotes(const std::string& text) {
+    flushBlock(); // Keep notes after the results that preceded them
+    std::string block;
+    appendBlockHeader(block, kNotesBlock, 0, text.size());
+    writer.append(block);
+    writer.append(text);
+}
+
+void BinaryResultsSink::close() {
+    if (writer.isOpen()) flushBlock();
+    writer.close();
+}
+
+std::unique_ptr<ResultsSink> makeResultsSink(ResultsFormat format, const std::string& filePath, size_t bufferBytes) {
+    if (format == ResultsFormat::Binary) {
+        auto sink = std::make_unique<BinaryResultsSink>();
+        if (!sink->open(filePath, bufferBytes)) return nullptr;
+        return sink;
+    }
+    auto sink = std::make_unique<TextResultsSink>();
+    if (!sink->open(filePath, bufferBytes)) return nullptr;
+    return sink;
+}
+
+void readBinaryResults(const std::string& filePath, std::vector<TradeResult>& results, std::string* notes) {
+    MappedFile file;
+    if (!file.open(filePath)) {
+        throw std::runtime_error("Could not open results file '" + filePath + "'");
+    }
+    Cursor in(file.data(), file.data() + file.size());
+    if (std::memcmp(in.take(sizeof(kResultsMagic)), kResultsMagic, sizeof(kResultsMagic)) != 0) {
+        throw std::runtime_error("'" + filePath + "' is not a binary results file");
+    }
+    const uint32_t version = in.pod<uint32_t>();
+    if (version != BinaryResultsSink::kVersion) {
+        throw std::runtime_error("Unsupported results file version " + std::to_string(version));
+    }
+    if (in.pod<uint32_t>() != kByteOrderMark) {
+        throw std::runtime_error("Results file was written with a different byte order");
+    }
+
+    while (!in.atEnd()) {
+        const uint32_t type = in.pod<uint32_t>();
+        const uint32_t rows = in.pod<uint32_t>();
+        const uint64_t payloadBytes = in.pod<uint64_t>();
+        const char* payload = in.take(static_cast<size_t>(payloadBytes));
+        Cursor block(payload, payload + payloadBytes);
+
+        if (type == kNotesBlock) {
+            if (notes) notes->append(payload, static_cast<size_t>(payloadBytes));
+            continue;
+        }
+        if (type != kTradeBlock) continue; // Unknown block types are skipped
+
+        const std::vector<uint8_t> flags = block.column<uint8_t>(rows);
+        const std::vector<double> pvs = block.column<double>(rows);
+        const std::vector<uint32_t> dv01Counts = block.column<uint32_t>(rows);
+        const std::vector<uint32_t> vegaCounts = block.column<uint32_t>(rows);
+        const std::vector<std::string> instruments = block.strings(rows);
+        const std::vector<std::string> types = block.strings(rows);
+        size_t dv01Total = 0, vegaTotal = 0;
+        for (uint32_t c : dv01Counts) dv01Total += c;
+        for (uint32_t c : vegaCounts) vegaTotal += c;
+        const std::vector<std::string> dv01Curves = block.strings(dv01Total);
+        const std::vector<double> dv01Values = block.column<double>(dv01Total);
+        const std::vector<std::string> vegaCurves = block.strings(vegaTotal);
+        const std::vector<double> vegaValues = block.column<double>(vegaTotal);
+
+        size_t dv01Next = 0, vegaNext = 0;
+        for (size_t i = 0; i < rows; ++i) {
+            TradeResult r;
+            r.hasTrade = true;
+            r.instrument = instruments[i];
+            r.type = types[i];
+            r.pvOk = (flags[i] & 1) != 0;
+            r.pv = pvs[i];
+            r.dv01Ok = (flags[i] & 2) != 0;
+            for (uint32_t k = 0; k < dv01Counts[i]; ++k, ++dv01Next) r.dv01[dv01Curves[dv01Next]] = dv01Values[dv01Next];
+            r.vegaOk = (flags[i] & 4) != 0;
+            for (uint32_t k = 0; k < vegaCounts[i]; ++k, ++vegaNext) r.vega[vegaCurves[vegaNext]] = vegaValues[vegaNext];
+            results.push_back(std::move(r));
+        }
+    }
+}
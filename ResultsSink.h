@@ -0,0 +1,136 @@
+#ifndef RESULTS_SINK_H
+#define RESULTS_SINK_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "PortfolioEngine.h" // TradeResult
+
+enum class ResultsFormat {
+    Text,  // Instrument;Type;PV;DV01_Curve;DV01_Value;Vega_Curve;Vega_Value (results.txt)
+    Binary // Columnar blocks, see BinaryResultsSink
+};
+
+// "text" or "binary"; throws std::invalid_argument otherwise.
+ResultsFormat parseResultsFormat(const std::string& name);
+
+// Appends bytes to a file from a background thread. Producers fill a large in-memory buffer;
+// full buffers are handed to the writer thread, so formatting never waits on the disk unless
+// maxPendingBuffers buffers are already queued.
+class AsyncFileWriter {
+public:
+    AsyncFileWriter() = default;
+    ~AsyncFileWriter(); // Closes, swallowing (but reporting) write errors
+
+    AsyncFileWriter(const AsyncFileWriter&) = delete;
+    AsyncFileWriter& operator=(const AsyncFileWriter&) = delete;
+
+    // Returns false if the file cannot be opened (same contract as the load* functions).
+    bool open(const std::string& filePath, size_t bufferBytes = 4 << 20, size_t maxPendingBuffers = 4);
+    bool isOpen() const { return writerThread.joinable(); }
+
+    void append(const char* data, size_t n);
+    void append(const std::string& s) { append(s.data(), s.size()); }
+
+    // Flushes everything and joins the writer. Throws std::runtime_error if any write failed.
+    void close();
+
+private:
+    void handOff(); // Queues the current buffer, waiting while the queue is full
+    void writerLoop();
+
+    std::ofstream file;
+    std::string filePath;
+    std::string buffer;
+    size_t bufferBytes = 0;
+    size_t maxPending = 0;
+
+    std::mutex mutex;
+    std::condition_variable queueChanged;
+    std::deque<std::string> pending;
+    bool closing = false;
+    bool failed = false;
+    std::thread writerThread;
+};
+
+// Destination for the per-trade results of a run, plus free-form notes (the comparison
+// section of results.txt). Results must be written in portfolio order.
+class ResultsSink {
+public:
+    virtual ~ResultsSink() = default;
+
+    virtual void writeTradeResult(const TradeResult& result) = 0;
+    virtual void writeNotes(const std::string& text) = 0;
+
+    // Flushes and closes the file. Throws std::runtime_error on I/O failure.
+    virtual void close() = 0;
+};
+
+// The original results.txt layout, byte for byte: fixed notation with 6 decimals.
+class TextResultsSink : public ResultsSink {
+public:
+    bool open(const std::string& filePath, size_t bufferBytes = 4 << 20);
+
+    void writeTradeResult(const TradeResult& result) override;
+    void writeNotes(const std::string& text) override;
+    void close() override { writer.close(); }
+
+private:
+    void appendFixed(double value);
+
+    AsyncFileWriter writer;
+    std::string line;
+};
+
+// Compact columnar layout (native byte order, checked by readBinaryResults):
+//   file header  magic "PRCRES\0\0", uint32 version, uint32 byte-order mark 0x01020304
+//   blocks       uint32 block type, uint32 row count, uint64 payload bytes, payload
+//   trade block  (type 1, up to rowsPerBlock results) columns in this order:
+//                  uint8  flags[n]      bit 0 pvOk, bit 1 dv01Ok, bit 2 vegaOk
+//                  double pv[n]
+//                  uint32 dv01Count[n], uint32 vegaCount[n]
+//                  strings instrument[n], type[n]        (uint32 lengths, then the chars)
+//                  strings dv01Curve[m], double dv01[m]  (m = sum of dv01Count)
+//                  strings vegaCurve[k], double vega[k]  (k = sum of vegaCount)
+//   notes block  (type 2, row count 0) UTF-8 text
+// Error messages are not stored; failed measures are flagged as in the text format.
+class BinaryResultsSink : public ResultsSink {
+public:
+    static constexpr uint32_t kVersion = 1;
+
+    bool open(const std::string& filePath, size_t bufferBytes = 4 << 20, size_t rowsPerBlock = 4096);
+
+    void writeTradeResult(const TradeResult& result) override;
+    void writeNotes(const std::string& text) override;
+    void close() override;
+
+private:
+    void flushBlock();
+
+    AsyncFileWriter writer;
+    size_t rowsPerBlock = 4096;
+
+    std::vector<uint8_t> flags;
+    std::vector<double> pvs;
+    std::vector<uint32_t> dv01Counts, vegaCounts;
+    std::vector<std::string> instruments, types, dv01Curves, vegaCurves;
+    std::vector<double> dv01Values, vegaValues;
+};
+
+// Opens a sink of the given format. Returns nullptr if the file cannot be opened.
+std::unique_ptr<ResultsSink> makeResultsSink(ResultsFormat format, const std::string& filePath,
+                                             size_t bufferBytes = 4 << 20);
+
+// Reads a BinaryResultsSink file back (results in file order; error strings are empty).
+// Throws std::runtime_error if the file is missing, truncated or of another version.
+void readBinaryResults(const std::string& filePath, std::vector<TradeResult>& results, std::string* notes = nullptr);
+
+#endif // RESULTS_SINK_H
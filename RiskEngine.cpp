@@ -3,36 +3,337 @@
 #include "Market.h"           
 #include "Pricer.h"           
 #include "MarketDecorators.h" 
+#include "Bond.h"
+#include "Swap.h"
+#include "TreeProduct.h"
+#include "AdjointPricer.h"
+#include "Instrumentation.h"
 
+#include <algorithm>
 #include <iostream> 
+#include <exception>
+#include <stdexcept>
+#include <cstdint>
+
+namespace {
+    bool isNoCurve(MarketDataId curveId) {
+        static const MarketDataId empty = internMarketDataName("");
+        static const MarketDataId none = internMarketDataName("NONE");
+        static const MarketDataId na = internMarketDataName("na");
+        return curveId == kNoMarketDataId || curveId == empty || curveId == none || curveId == na;
+    }
+
+    // One shocked up/down market pair and the trades repriced against it.
+    template <typename Decorator>
+    struct ShockGroup {
+        std::string curveName;
+        std::unique_ptr<Decorator> shockedMarkets;
+        std::vector<size_t> tradeIndices;
+    };
+
+    struct RepriceTask {
+        const std::string* curveName;
+        const Market* marketUp;
+        const Market* marketDown;
+        size_t tradeIndex;
+    };
+
+    // Groups trades by the curve in curvePerTrade (kNoMarketDataId = no sensitivity), builds one
+    // Decorator per curve and reprices each trade against its group's up/down markets.
+    template <typename Decorator>
+    void bumpAndRepriceGrouped(const std::vector<std::shared_ptr<Trade>>& portfolio,
+                               const Market& originalMarket,
+                               const std::vector<MarketDataId>& curvePerTrade,
+                               double shockSize,
+                               const Pricer& pricer,
+                               ThreadPool* pool,
+                               std::vector<std::map<std::string, double>>& results,
+                               std::vector<std::string>& errors) {
+        std::vector<ShockGroup<Decorator>> groups;
+        std::vector<size_t> groupIndexByCurve; // By MarketDataId; SIZE_MAX: no group yet
+        for (size_t i = 0; i < curvePerTrade.size(); ++i) {
+            const MarketDataId curveId = curvePerTrade[i];
+            if (curveId == kNoMarketDataId) continue;
+            if (curveId >= groupIndexByCurve.size()) groupIndexByCurve.resize(static_cast<size_t>(curveId) + 1, SIZE_MAX);
+            if (groupIndexByCurve[curveId] == SIZE_MAX) {
+                groupIndexByCurve[curveId] = groups.size();
+                groups.push_back(ShockGroup<Decorator>{marketDataName(curveId), nullptr, {}});
+            }
+            groups[groupIndexByCurve[curveId]].tradeIndices.push_back(i);
+        }
+
+        std::vector<RepriceTask> tasks;
+        tasks.reserve(curvePerTrade.size());
+        for (auto& group : groups) {
+            MarketShock shockDetails;
+            shockDetails.market_id = group.curveName;
+            shockDetails.shock_value = shockSize;
+            group.shockedMarkets = std::make_unique<Decorator>(originalMarket, shockDetails);
+            for (size_t tradeIndex : group.tradeIndices) {
+                tasks.push_back(RepriceTask{&group.curveName, &group.shockedMarkets->getMarketUp(),
+                                            &group.shockedMarkets->getMarketDown(), tradeIndex});
+            }
+        }
+
+        auto runTasks = [&](size_t begin, size_t end, size_t) {
+            for (size_t t = begin; t < end; ++t) {
+                const RepriceTask& task = tasks[t];
+                try {
+                    const Trade& trade = *portfolio[task.tradeIndex];
+                    double pv_up = pricer.Price(*task.marketUp, trade);
+                    double pv_down = pricer.Price(*task.marketDown, trade);
+                    results[task.tradeIndex][*task.curveName] = (pv_up - pv_down) / 2.0;
+                } catch (const std::exception& e) {
+                    errors[task.tradeIndex] = e.what();
+                }
+            }
+        };
+        if (pool) {
+            pool->parallelFor(tasks.size(), 16, runTasks);
+        } else {
+            runTasks(0, tasks.size(), 0);
+        }
+    }
+
+    // Serial dates at which valuing 'trade' reads its rate curve (volCurve == false) or vol
+    // curve, mirroring Bond::Pv, Swap::Pv and the tree/closed-form option pricers. Returns
+    // false if the trade type is not known, in which case every pillar is assumed to matter.
+    bool curveLookupSerials(const Trade& trade, long asOfSerial, bool volCurve, std::vector<long>& out) {
+        out.clear();
+        switch (trade.getKind()) {
+        case InstrumentKind::Bond: {
+            if (volCurve) return true;
+            const Bond& bond = static_cast<const Bond&>(trade);
+            if (asOfSerial >= bond.getMaturityDate().getSerialDate()) return true;
+            for (long serial : bond.getCashflowSerials()) {
+                if (serial > asOfSerial) out.push_back(serial);
+            }
+            return true;
+        }
+        case InstrumentKind::Swap: {
+            if (volCurve) return true;
+            const Swap& swap = static_cast<const Swap&>(trade);
+            const long maturity = swap.getMaturityDate().getSerialDate();
+            if (asOfSerial >= maturity) return true;
+            for (const Date& paymentDate : swap.getFixedLegSchedule()) {
+                if (paymentDate.getSerialDate() > asOfSerial) out.push_back(paymentDate.getSerialDate());
+            }
+            out.push_back(maturity);
+            return true;
+        }
+        case InstrumentKind::EuropeanOption:
+        case InstrumentKind::AmericanOption: {
+            // Both the closed form and the trees read r and sigma at expiry only.
+            const long expiry = static_cast<const TreeProduct&>(trade).GetExpiry().getSerialDate();
+            if (expiry > asOfSerial) out.push_back(expiry);
+            return true;
+        }
+        case InstrumentKind::Other:
+            break;
+        }
+        return false;
+    }
+
+    // Pillars whose value enters a linearly interpolated (flat extrapolated) lookup at any of
+    // 'lookups': pillar b only influences dates in (pillar[b-1], pillar[b+1]).
+    std::vector<size_t> touchedPillars(const std::vector<long>& pillarSerials, const std::vector<long>& lookups) {
+        std::vector<size_t> touched;
+        if (pillarSerials.empty()) return touched;
+        const size_t last = pillarSerials.size() - 1;
+        for (long x : lookups) {
+            if (x <= pillarSerials.front()) {
+                touched.push_back(0);
+            } else if (x >= pillarSerials.back()) {
+                touched.push_back(last);
+            } else {
+                const size_t i = static_cast<size_t>(
+                    std::upper_bound(pillarSerials.begin(), pillarSerials.end(), x) - pillarSerials.begin()) - 1;
+                touched.push_back(i);
+                if (x != pillarSerials[i]) touched.push_back(i + 1);
+            }
+        }
+        std::sort(touched.begin(), touched.end());
+        touched.erase(std::unique(touched.begin(), touched.end()), touched.end());
+        return touched;
+    }
+
+    struct BucketTask {
+        const Market* marketUp;
+        const Market* marketDown;
+        size_t tradeIndex;
+        double* slot;
+    };
+
+    // Shared body of computeKeyRateDv01/computeBucketedVega. 'curvePerTrade' holds the curve
+    // each trade depends on; only trades on risk.curveName are bucketed.
+    template <typename Decorator>
+    void bucketedBumpAndReprice(const std::vector<std::shared_ptr<Trade>>& portfolio,
+                                const Market& originalMarket,
+                                const std::vector<long>& pillarSerials,
+                                const std::vector<MarketDataId>& curvePerTrade,
+                                bool volCurve,
+                                double shockSize,
+                                const Pricer& pricer,
+                                ThreadPool* pool,
+                                BucketedRisk& risk) {
+        const size_t pillarCount = pillarSerials.size();
+        const long asOfSerial = originalMarket.asOf.getSerialDate();
+        const MarketDataId curveId = internMarketDataName(risk.curveName);
+        std::vector<std::vector<size_t>> tradesPerBucket(pillarCount);
+        std::vector<long> lookups;
+        for (size_t i = 0; i < portfolio.size(); ++i) {
+            if (!portfolio[i] || curvePerTrade[i] != curveId) continue;
+            std::vector<size_t> touched;
+            if (curveLookupSerials(*portfolio[i], asOfSerial, volCurve, lookups)) {
+                touched = touchedPillars(pillarSerials, lookups);
+            } else {
+                touched.resize(pillarCount);
+                for (size_t b = 0; b < pillarCount; ++b) touched[b] = b;
+            }
+            for (size_t b : touched) {
+                tradesPerBucket[b].push_back(i);
+                risk.buckets[i].emplace_back(b, 0.0);
+            }
+        }
+
+        // One shocked up/down pair per bucket; slots are stable since buckets[i] is complete.
+        std::vector<std::unique_ptr<Decorator>> shockedMarkets(pillarCount);
+        std::vector<size_t> nextSlot(portfolio.size(), 0);
+        std::vector<BucketTask> tasks;
+        for (size_t b = 0; b < pillarCount; ++b) {
+            if (tradesPerBucket[b].empty()) continue;
+            MarketShock shockDetails;
+            shockDetails.market_id = risk.curveName;
+            shockDetails.shock_value = shockSize;
+            shockDetails.pillar_index = static_cast<int>(b);
+            shockedMarkets[b] = std::make_unique<Decorator>(originalMarket, shockDetails);
+            for (size_t tradeIndex : tradesPerBucket[b]) {
+                double* slot = &risk.buckets[tradeIndex][nextSlot[tradeIndex]++].second;
+                tasks.push_back(BucketTask{&shockedMarkets[b]->getMarketUp(), &shockedMarkets[b]->getMarketDown(),
+                                           tradeIndex, slot});
+            }
+        }
+        risk.repricedTrades = tasks.size();
+
+        std::vector<std::string> taskErrors(tasks.size());
+        auto runTasks = [&](size_t begin, size_t end, size_t) {
+            for (size_t t = begin; t < end; ++t) {
+                const BucketTask& task = tasks[t];
+                try {
+                    const Trade& trade = *portfolio[task.tradeIndex];
+                    double pv_up = pricer.Price(*task.marketUp, trade);
+                    double pv_down = pricer.Price(*task.marketDown, trade);
+                    *task.slot = (pv_up - pv_down) / 2.0;
+                } catch (const std::exception& e) {
+                    taskErrors[t] = e.what();
+                }
+            }
+        };
+        if (pool) {
+            pool->parallelFor(tasks.size(), 16, runTasks);
+        } else {
+            runTasks(0, tasks.size(), 0);
+        }
+        for (size_t t = 0; t < tasks.size(); ++t) {
+            if (!taskErrors[t].empty() && risk.errors[tasks[t].tradeIndex].empty()) {
+                risk.errors[tasks[t].tradeIndex] = taskErrors[t];
+            }
+        }
+    }
+
+    // Sum of a gradient's pillar entries times the shock size: the adjoint counterpart of a
+    // central-difference parallel bump.
+    double parallelSensitivity(const std::vector<double>& pillarAdjoints, double shockSize) {
+        double sum = 0.0;
+        for (double a : pillarAdjoints) sum += a;
+        return sum * shockSize;
+    }
+
+    // Adjoint path of the bucketed risks: trades on risk.curveName that supportsAdjoint() get
+    // their buckets from one adjointPv each and are removed from curvePerTrade, leaving the
+    // rest to bucketedBumpAndReprice.
+    void adjointBuckets(const std::vector<std::shared_ptr<Trade>>& portfolio,
+                        const Market& originalMarket,
+                        const std::vector<long>& pillarSerials,
+                        std::vector<MarketDataId>& curvePerTrade,
+                        bool volCurve,
+                        double shockSize,
+                        ThreadPool* pool,
+                        BucketedRisk& risk) {
+        const MarketDataId curveId = internMarketDataName(risk.curveName);
+        std::vector<size_t> indices;
+        for (size_t i = 0; i < portfolio.size(); ++i) {
+            if (portfolio[i] && curvePerTrade[i] == curveId && supportsAdjoint(*portfolio[i])) {
+                indices.push_back(i);
+                curvePerTrade[i] = kNoMarketDataId;
+            }
+        }
+        const long asOfSerial = originalMarket.asOf.getSerialDate();
+        auto run = [&](size_t begin, size_t end, size_t) {
+            std::vector<long> lookups;
+            for (size_t k = begin; k < end; ++k) {
+                const size_t i = indices[k];
+                try {
+                    const PvGradient g = adjointPv(*portfolio[i], originalMarket);
+                    const std::vector<double>& adjoints = volCurve ? g.volAdjoints : g.rateAdjoints;
+                    curveLookupSerials(*portfolio[i], asOfSerial, volCurve, lookups);
+                    for (size_t b : touchedPillars(pillarSerials, lookups)) {
+                        risk.buckets[i].emplace_back(b, (b < adjoints.size()) ? adjoints[b] * shockSize : 0.0);
+                    }
+                } catch (const std::exception& e) {
+                    risk.errors[i] = e.what();
+                }
+            }
+        };
+        if (pool) {
+            pool->parallelFor(indices.size(), 64, run);
+        } else {
+            run(0, indices.size(), 0);
+        }
+    }
+}
+
+SensitivityMethod parseSensitivityMethod(const std::string& name) {
+    if (name == "bump") return SensitivityMethod::BumpAndReprice;
+    if (name == "adjoint") return SensitivityMethod::Adjoint;
+    throw std::invalid_argument("Unknown sensitivity method '" + name + "' (expected bump or adjoint)");
+}
 
 RiskEngine::RiskEngine(double default_curve_shock_abs,
-                       double default_vol_shock_abs)
+                       double default_vol_shock_abs,
+                       SensitivityMethod method)
     : defaultCurveShockAmount(default_curve_shock_abs),
-      defaultVolShockAmount(default_vol_shock_abs) {}
+      defaultVolShockAmount(default_vol_shock_abs),
+      sensitivityMethod(method) {}
 
 std::map<std::string, double> RiskEngine::computeDv01(
     const std::shared_ptr<Trade>& trade,
     const Market& originalMarket,
     const Pricer& pricer) const {
-    
+    PRICING_SCOPED_TIMER(ComputeDv01);
     std::map<std::string, double> dv01_results;
     if (!trade) {
         std::cerr << "Error: Null trade provided to computeDv01." << std::endl;
         return dv01_results;
     }
 
-    std::string rateCurveName = trade->getRateCurveName();
-    if (rateCurveName.empty() || rateCurveName == "NONE" || rateCurveName == "na") {
+    const MarketDataId rateCurveId = trade->getRateCurveId();
+    if (isNoCurve(rateCurveId)) {
         return dv01_results; 
     }
 
-    if (!originalMarket.getCurve(rateCurveName)) {
+    const std::string& rateCurveName = marketDataName(rateCurveId);
+    if (!originalMarket.getCurve(rateCurveId)) {
         std::cerr << "Warning: Rate curve '" << rateCurveName << "' for DV01 not found in the original market for trade " 
                   << trade->getUnderlyingName() << " (" << trade->getType() << "). Skipping DV01." << std::endl;
         return dv01_results;
     }
 
+    if (sensitivityMethod == SensitivityMethod::Adjoint && supportsAdjoint(*trade)) {
+        dv01_results[rateCurveName] = parallelSensitivity(adjointPv(*trade, originalMarket).rateAdjoints, defaultCurveShockAmount);
+        return dv01_results;
+    }
+
     MarketShock shockDetails;
     shockDetails.market_id = rateCurveName;
     shockDetails.shock_value = defaultCurveShockAmount; 
@@ -54,24 +355,30 @@ std::map<std::string, double> RiskEngine::computeVega(
     const std::shared_ptr<Trade>& trade,
     const Market& originalMarket,
     const Pricer& pricer) const {
-
+    PRICING_SCOPED_TIMER(ComputeVega);
     std::map<std::string, double> vega_results;
     if (!trade) {
         std::cerr << "Error: Null trade provided to computeVega." << std::endl;
         return vega_results;
     }
 
-    std::string volCurveName = trade->getVolCurveName();
-    if (volCurveName.empty() || volCurveName == "NONE" || volCurveName == "na") {
+    const MarketDataId volCurveId = trade->getVolCurveId();
+    if (isNoCurve(volCurveId)) {
         return vega_results; 
     }
 
-    if (!originalMarket.getVolCurve(volCurveName)) {
+    const std::string& volCurveName = marketDataName(volCurveId);
+    if (!originalMarket.getVolCurve(volCurveId)) {
         std::cerr << "Warning: Volatility curve '" << volCurveName << "' for Vega not found in the original market for trade " 
                   << trade->getUnderlyingName() << " (" << trade->getType() << "). Skipping Vega." << std::endl;
         return vega_results;
     }
 
+    if (sensitivityMethod == SensitivityMethod::Adjoint && supportsAdjoint(*trade)) {
+        vega_results[volCurveName] = parallelSensitivity(adjointPv(*trade, originalMarket).volAdjoints, defaultVolShockAmount);
+        return vega_results;
+    }
+
     MarketShock shockDetails;
     shockDetails.market_id = volCurveName;
     shockDetails.shock_value = defaultVolShockAmount; 
@@ -88,3 +395,152 @@ std::map<std::string, double> RiskEngine::computeVega(
 
     return vega_results;
 }
+
+PortfolioRisk RiskEngine::computeRisk(const std::vector<std::shared_ptr<Trade>>& portfolio,
+                                      const Market& originalMarket,
+                                      const Pricer& pricer,
+                                      const std::vector<RiskType>& riskTypes,
+                                      ThreadPool* pool) const {
+    PRICING_SCOPED_TIMER(ComputeRisk);
+    PortfolioRisk risk;
+    risk.dv01.resize(portfolio.size());
+    risk.dv01Errors.resize(portfolio.size());
+    risk.vega.resize(portfolio.size());
+    risk.vegaErrors.resize(portfolio.size());
+
+
+    // Adjoint mode: one gradient per supported trade serves both DV01 and Vega.
+    std::vector<PvGradient> gradients;
+    std::vector<char> gradientDone;
+    if (sensitivityMethod == SensitivityMethod::Adjoint) {
+        gradients.resize(portfolio.size());
+        gradientDone.assign(portfolio.size(), 0);
+    }
+
+    for (RiskType riskType : riskTypes) {
+        std::vector<MarketDataId> curvePerTrade(portfolio.size(), kNoMarketDataId);
+        for (size_t i = 0; i < portfolio.size(); ++i) {
+            const std::shared_ptr<Trade>& trade = portfolio[i];
+            if (!trade) continue;
+            if (riskType == RiskType::DV01) {
+                const MarketDataId rateCurveId = trade->getRateCurveId();
+                if (isNoCurve(rateCurveId)) continue;
+                if (!originalMarket.getCurve(rateCurveId)) {
+                    std::cerr << "Warning: Rate curve '" << marketDataName(rateCurveId) << "' for DV01 not found in the original market for trade " 
+                              << trade->getUnderlyingName() << " (" << trade->getType() << "). Skipping DV01." << std::endl;
+                    continue;
+                }
+                curvePerTrade[i] = rateCurveId;
+            } else {
+                const MarketDataId volCurveId = trade->getVolCurveId();
+                if (isNoCurve(volCurveId)) continue;
+                if (!originalMarket.getVolCurve(volCurveId)) {
+                    std::cerr << "Warning: Volatility curve '" << marketDataName(volCurveId) << "' for Vega not found in the original market for trade " 
+                              << trade->getUnderlyingName() << " (" << trade->getType() << "). Skipping Vega." << std::endl;
+                    continue;
+                }
+                curvePerTrade[i] = volCurveId;
+            }
+        }
+
+        if (sensitivityMethod == SensitivityMethod::Adjoint) {
+            std::vector<size_t> indices;
+            for (size_t i = 0; i < portfolio.size(); ++i) {
+                if (curvePerTrade[i] != kNoMarketDataId && supportsAdjoint(*portfolio[i])) indices.push_back(i);
+            }
+            std::vector<std::map<std::string, double>>& results = (riskType == RiskType::DV01) ? risk.dv01 : risk.vega;
+            std::vector<std::string>& errors = (riskType == RiskType::DV01) ? risk.dv01Errors : risk.vegaErrors;
+            auto run = [&](size_t begin, size_t end, size_t) {
+                for (size_t k = begin; k < end; ++k) {
+                    const size_t i = indices[k];
+                    try {
+                        if (!gradientDone[i]) {
+                            gradients[i] = adjointPv(*portfolio[i], originalMarket);
+                            gradientDone[i] = 1;
+                        }
+                        results[i][marketDataName(curvePerTrade[i])] = (riskType == RiskType::DV01)
+                            ? parallelSensitivity(gradients[i].rateAdjoints, defaultCurveShockAmount)
+                            : parallelSensitivity(gradients[i].volAdjoints, defaultVolShockAmount);
+                    } catch (const std::exception& e) {
+                        errors[i] = e.what();
+                    }
+                }
+            };
+            if (pool) {
+                pool->parallelFor(indices.size(), 64, run);
+            } else {
+                run(0, indices.size(), 0);
+            }
+            for (size_t i : indices) curvePerTrade[i] = kNoMarketDataId; // Done; the rest are bumped below
+        }
+
+        if (riskType == RiskType::DV01) {
+            bumpAndRepriceGrouped<CurveDecorator>(portfolio, originalMarket, curvePerTrade, defaultCurveShockAmount,
+                                                  pricer, pool, risk.dv01, risk.dv01Errors);
+        } else {
+            bumpAndRepriceGrouped<VolDecorator>(portfolio, originalMarket, curvePerTrade, defaultVolShockAmount,
+                                                pricer, pool, risk.vega, risk.vegaErrors);
+        }
+    }
+    return risk;
+}
+
+BucketedRisk RiskEngine::computeKeyRateDv01(const std::vector<std::shared_ptr<Trade>>& portfolio,
+                                            const Market& originalMarket,
+                                            const std::string& curveName,
+                                            const Pricer& pricer,
+                                            ThreadPool* pool) const {
+    BucketedRisk risk;
+    risk.curveName = curveName;
+    risk.buckets.resize(portfolio.size());
+    risk.errors.resize(portfolio.size());
+
+    std::shared_ptr<const RateCurve> curve = originalMarket.getCurve(curveName);
+    if (!curve || curve->isEmpty()) {
+        std::cerr << "Warning: Rate curve '" << curveName << "' for key-rate DV01 not found or empty in the original market. Skipping." << std::endl;
+        return risk;
+    }
+    risk.pillars = curve->getTenorDates();
+
+    std::vector<MarketDataId> curvePerTrade(portfolio.size(), kNoMarketDataId);
+    for (size_t i = 0; i < portfolio.size(); ++i) {
+        if (portfolio[i]) curvePerTrade[i] = portfolio[i]->getRateCurveId();
+    }
+    if (sensitivityMethod == SensitivityMethod::Adjoint) {
+        adjointBuckets(portfolio, originalMarket, curve->getCompiled().getSerials(), curvePerTrade, false,
+                       defaultCurveShockAmount, pool, risk);
+    }
+    bucketedBumpAndReprice<CurveDecorator>(portfolio, originalMarket, curve->getCompiled().getSerials(), curvePerTrade,
+                                           false, defaultCurveShockAmount, pricer, pool, risk);
+    return risk;
+}
+
+BucketedRisk RiskEngine::computeBucketedVega(const std::vector<std::shared_ptr<Trade>>& portfolio,
+                                             const Market& originalMarket,
+                                             const std::string& volCurveName,
+                                             const Pricer& pricer,
+                                             ThreadPool* pool) const {
+    BucketedRisk risk;
+    risk.curveName = volCurveName;
+    risk.buckets.resize(portfolio.size());
+    risk.errors.resize(portfolio.size());
+
+    std::shared_ptr<const VolCurve> curve = originalMarket.getVolCurve(volCurveName);
+    if (!curve || curve->isEmpty()) {
+        std::cerr << "Warning: Volatility curve '" << volCurveName << "' for bucketed Vega not found or empty in the original market. Skipping." << std::endl;
+        return risk;
+    }
+    risk.pillars = curve->getTenors();
+
+    std::vector<MarketDataId> curvePerTrade(portfolio.size(), kNoMarketDataId);
+    for (size_t i = 0; i < portfolio.size(); ++i) {
+        if (portfolio[i]) curvePerTrade[i] = portfolio[i]->getVolCurveId();
+    }
+    if (sensitivityMethod == SensitivityMethod::Adjoint) {
+        adjointBuckets(portfolio, originalMarket, curve->getCompiled().getSerials(), curvePerTrade, true,
+                       defaultVolShockAmount, pool, risk);
+    }
+    bucketedBumpAndReprice<VolDecorator>(portfolio, originalMarket, curve->getCompiled().getSerials(), curvePerTrade,
+                                         true, defaultVolShockAmount, pricer, pool, risk);
+    return risk;
+}
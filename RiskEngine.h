@@ -5,21 +5,65 @@
 #include "Trade.h"
 #include "Pricer.h"
 #include "MarketDecorators.h" // For MarketShock, CurveDecorator, VolDecorator
+#include "ThreadPool.h"
 
 #include <string>
 #include <vector>
 #include <map>
 #include <memory> // For std::shared_ptr
+#include <utility>
 // For std::future, std::async (if implementing async computation later)
 // #include <future> 
 
+enum class RiskType {
+    DV01,
+    Vega
+};
+
+// How RiskEngine obtains sensitivities.
+enum class SensitivityMethod {
+    BumpAndReprice, // Central finite differences: shocked up/down markets, two repricings per factor
+    Adjoint         // adjointPv (AdjointPricer.h) for Bond/Swap/EuropeanOption, bumping the rest
+};
+
+// "bump" or "adjoint"; throws std::invalid_argument otherwise.
+SensitivityMethod parseSensitivityMethod(const std::string& name);
+
+// Per-trade output of RiskEngine::computeRisk, indexed like the input portfolio.
+// A non-empty error string means that measure failed for that trade (its map is then empty).
+struct PortfolioRisk {
+    std::vector<std::map<std::string, double>> dv01;
+    std::vector<std::string> dv01Errors;
+    std::vector<std::map<std::string, double>> vega;
+    std::vector<std::string> vegaErrors;
+};
+
+// Per-pillar (key-rate DV01 or vega bucket) sensitivities of a portfolio to one curve.
+// Bucket b is pillar b of the curve; each trade only holds the buckets it is exposed to.
+struct BucketedRisk {
+    std::string curveName;
+    std::vector<Date> pillars;
+    // Per trade (indexed like the portfolio): (bucket index, sensitivity), bucket ascending.
+    std::vector<std::vector<std::pair<size_t, double>>> buckets;
+    std::vector<std::string> errors; // Non-empty: some bucket failed for that trade
+    size_t repricedTrades = 0;       // Up/down repricing pairs performed, summed over buckets
+};
+
 class RiskEngine {
 public:
     // Constructor: takes default shock sizes for different risk types.
     // curve_shock_abs: absolute shock for IR curves (e.g., 0.0001 for 1bp)
     // vol_shock_abs: absolute shock for Vol curves (e.g., 0.01 for 1%)
+    // method: see SensitivityMethod. With Adjoint, each supported trade gets all its DV01/Vega
+    // numbers from one adjointPv pass, scaled to the same shock sizes (DV01 = shock x the sum
+    // of the pillar adjoints, which is what a parallel bump moves). These are sensitivities of
+    // Trade::Pv, i.e. Black-Scholes for European options even when 'pricer' is a tree, and
+    // differ from the central differences by O(shock^3) terms only.
     RiskEngine(double default_curve_shock_abs = 0.0001, 
-               double default_vol_shock_abs = 0.01);
+               double default_vol_shock_abs = 0.01,
+               SensitivityMethod method = SensitivityMethod::BumpAndReprice);
+
+    SensitivityMethod getSensitivityMethod() const { return sensitivityMethod; }
 
     // Computes DV01 for a given trade.
     // DV01 is sensitivity to a 1bp parallel shift in the relevant interest rate curve.
@@ -35,14 +79,41 @@ public:
                                               const Market& originalMarket,
                                               const Pricer& pricer) const;
 
-    // The prompt's sample RiskEngine had a more generic computeRisk function.
-    // void computeRisk(std::string riskType, std::shared_ptr<Trade> trade, bool singleThread);
-    // For now, specific functions like computeDv01 and computeVega are clearer.
-    // Multi-threading can be added as an enhancement to these functions later.
+    // Batched DV01/Vega for a whole portfolio.
+    // Trades are grouped by getRateCurveName()/getVolCurveName() and each shocked up/down
+    // market is built once per curve, then every dependent trade is repriced against it,
+    // so the number of market builds is O(curves) rather than O(trades).
+    // Results match computeDv01/computeVega trade by trade. If 'pool' is given, the repricings
+    // are spread over it; all workers share 'pricer', so its Price must be thread-safe (the
+    // built-in pricers are: they keep no per-call state).
+    PortfolioRisk computeRisk(const std::vector<std::shared_ptr<Trade>>& portfolio,
+                              const Market& originalMarket,
+                              const Pricer& pricer,
+                              const std::vector<RiskType>& riskTypes,
+                              ThreadPool* pool = nullptr) const;
+
+    // Key-rate DV01: each pillar of 'curveName' is bumped by the default curve shock on its
+    // own (central difference, like computeDv01). A bucket only reprices the trades whose
+    // curve lookups (cashflow, payment or expiry dates) fall within that pillar's linear
+    // interpolation support, so the cost is proportional to the affected trades, not to
+    // pillars x portfolio. Trades on other curves get no buckets.
+    BucketedRisk computeKeyRateDv01(const std::vector<std::shared_ptr<Trade>>& portfolio,
+                                    const Market& originalMarket,
+                                    const std::string& curveName,
+                                    const Pricer& pricer,
+                                    ThreadPool* pool = nullptr) const;
+
+    // Vega per expiry bucket of 'volCurveName', by the same scheme with the default vol shock.
+    BucketedRisk computeBucketedVega(const std::vector<std::shared_ptr<Trade>>& portfolio,
+                                     const Market& originalMarket,
+                                     const std::string& volCurveName,
+                                     const Pricer& pricer,
+                                     ThreadPool* pool = nullptr) const;
 
 private:
     double defaultCurveShockAmount; // e.g., 0.0001 for 1bp
     double defaultVolShockAmount;   // e.g., 0.01 for 1%
+    SensitivityMethod sensitivityMethod;
 
     // The prompt's sample RiskEngine stored decorator objects.
     // An alternative is to create decorators on-the-fly within compute methods.
@@ -0,0 +1,365 @@
+#include "ScenarioEngine.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <limits>
+#include <set>
+#include <stdexcept>
+#include <unordered_map>
+#include <utility>
+
+#include "Instrumentation.h"
+#include "MathUtils.h"
+#include "RandomStreams.h"
+#include "Utils.h"
+
+namespace {
+
+const char* moveTypeName(MarketDataType type) {
+    switch (type) {
+    case MarketDataType::RateCurve: return "rate curve";
+    case MarketDataType::VolCurve: return "vol curve";
+    case MarketDataType::StockPrice: return "stock price";
+    case MarketDataType::BondPrice: return "bond price";
+    }
+    return "market data";
+}
+
+// Pillars of the entry a move targets: the curve's pillar count, 1 for a stock price, or -1
+// if 'base' does not hold it (bond prices are never scenario factors).
+long factorPillars(const Market& base, const ScenarioMove& move) {
+    switch (move.type) {
+    case MarketDataType::RateCurve: {
+        std::shared_ptr<const RateCurve> curve = base.getCurve(move.name);
+        return curve ? static_cast<long>(curve->getRates().size()) : -1;
+    }
+    case MarketDataType::VolCurve: {
+        std::shared_ptr<const VolCurve> curve = base.getVolCurve(move.name);
+        return curve ? static_cast<long>(curve->getVols().size()) : -1;
+    }
+    case MarketDataType::StockPrice:
+        return base.getVersion(MarketDataType::StockPrice, move.name) != 0 ? 1 : -1;
+    case MarketDataType::BondPrice:
+        break;
+    }
+    return -1;
+}
+
+// Applies the moves of one curve to a copy of its values.
+void shiftPillars(std::vector<double>& values, const ScenarioMove* const* moves, size_t count,
+                  const MarketScenario& scenario) {
+    for (size_t m = 0; m < count; ++m) {
+        const ScenarioMove& move = *moves[m];
+        if (move.pillar < 0) {
+            for (double& v : values) v += move.shift;
+        } else if (static_cast<size_t>(move.pillar) < values.size()) {
+            values[static_cast<size_t>(move.pillar)] += move.shift;
+        } else {
+            throw std::out_of_range("applyScenario: pillar " + std::to_string(move.pillar) + " out of range for " +
+                                    moveTypeName(move.type) + " '" + move.name + "' in scenario '" + scenario.id + "'.");
+        }
+    }
+}
+
+// Draws a standard normal for (scenario, factor) from a Philox stream.
+double scenarioNormal(const Philox4x32& philox, uint64_t scenario, uint64_t factor) {
+    const Philox4x32::Counter bits = philox({static_cast<uint32_t>(scenario), static_cast<uint32_t>(scenario >> 32),
+                                             static_cast<uint32_t>(factor), static_cast<uint32_t>(factor >> 32)});
+    return inverseNormalCDF(Philox4x32::toUniform(bits[0], bits[1]));
+}
+
+struct ScenarioFailure {
+    size_t trade;
+    size_t scenario;
+    std::string message;
+};
+
+} // namespace
+
+bool loadScenarioFile(const std::string& filePath, ScenarioSet& scenarios) {
+    std::ifstream file(filePath);
+    if (!file.is_open()) {
+        std::cerr << "Error: Could not open scenario file " << filePath << std::endl;
+        return false;
+    }
+    std::unordered_map<std::string, size_t> scenarioIndex;
+    for (size_t i = 0; i < scenarios.scenarios.size(); ++i) scenarioIndex.emplace(scenarios.scenarios[i].id, i);
+
+    std::string line;
+    std::vector<std::string> tokens;
+    size_t lineNumber = 0;
+    while (std::getline(file, line)) {
+        ++lineNumber;
+        splitString(tokens, line, ';');
+        if (tokens.empty() || tokens[0].empty() || tokens[0][0] == '#') continue;
+        std::string first = tokens[0];
+        std::transform(first.begin(), first.end(), first.begin(), [](unsigned char c) { return std::tolower(c); });
+        if (first == "scenario") continue; // Header
+        if (tokens.size() < 5) {
+            std::cerr << "Warning: Skipping scenario line " << lineNumber << " in " << filePath
+                      << ": expected scenario;type;name;pillar;shift." << std::endl;
+            continue;
+        }
+        try {
+            ScenarioMove move;
+            std::string type = tokens[1];
+            std::transform(type.begin(), type.end(), type.begin(), [](unsigned char c) { return std::tolower(c); });
+            if (type == "rate") {
+                move.type = MarketDataType::RateCurve;
+            } else if (type == "vol") {
+                move.type = MarketDataType::VolCurve;
+            } else if (type == "stock") {
+                move.type = MarketDataType::StockPrice;
+            } else {
+                throw std::invalid_argument("unknown type '" + tokens[1] + "'");
+            }
+            move.name = tokens[2];
+            if (move.name.empty()) throw std::invalid_argument("empty name");
+            std::string pillar = tokens[3];
+            std::transform(pillar.begin(), pillar.end(), pillar.begin(), [](unsigned char c) { return std::tolower(c); });
+            move.pillar = (pillar == "all" || pillar.empty() || move.type == MarketDataType::StockPrice)
+                              ? -1 : std::stoi(pillar);
+            if (move.pillar < -1) throw std::invalid_argument("negative pillar");
+            move.shift = std::stod(tokens[4]);
+
+            auto found = scenarioIndex.find(tokens[0]);
+            if (found == scenarioIndex.end()) {
+                found = scenarioIndex.emplace(tokens[0], scenarios.scenarios.size()).first;
+                scenarios.scenarios.push_back(MarketScenario{tokens[0], {}});
+            }
+            scenarios.scenarios[found->second].moves.push_back(std::move(move));
+        } catch (const std::exception& e) {
+            std::cerr << "Warning: Skipping scenario line " << lineNumber << " in " << filePath << ": " << e.what()
+                      << std::endl;
+        }
+    }
+    return true;
+}
+
+ScenarioSet generateScenarios(const Market& base, size_t count, uint64_t seed,
+                              double rateStdDev, double volStdDev, double stockStdDev) {
+    std::vector<std::pair<MarketDataType, std::string>> factors;
+    for (const std::string& name : base.getCurveNames()) factors.emplace_back(MarketDataType::RateCurve, name);
+    for (const std::string& name : base.getVolCurveNames()) factors.emplace_back(MarketDataType::VolCurve, name);
+    std::vector<std::string> stocks;
+    for (const auto& entry : base.getStockPrices()) stocks.push_back(entry.first);
+    std::sort(stocks.begin(), stocks.end());
+    for (const std::string& name : stocks) factors.emplace_back(MarketDataType::StockPrice, name);
+
+    const Philox4x32 philox(seed);
+    ScenarioSet set;
+    set.scenarios.resize(count);
+    for (size_t s = 0; s < count; ++s) {
+        MarketScenario& scenario = set.scenarios[s];
+        scenario.id = "S" + std::to_string(s + 1);
+        scenario.moves.reserve(factors.size());
+        for (size_t f = 0; f < factors.size(); ++f) {
+            const double stdDev = (factors[f].first == MarketDataType::RateCurve) ? rateStdDev
+                                : (factors[f].first == MarketDataType::VolCurve) ? volStdDev : stockStdDev;
+            scenario.moves.push_back(ScenarioMove{factors[f].first, factors[f].second, -1,
+                                                  stdDev * scenarioNormal(philox, s, f)});
+        }
+    }
+    return set;
+}
+
+Market applyScenario(const Market& base, const MarketScenario& scenario) {
+    Market overlay = Market::overlayOf(base);
+
+    // Group the moves by entry (stable, so repeated moves on one pillar apply in file order).
+    std::vector<const ScenarioMove*> moves;
+    moves.reserve(scenario.moves.size());
+    for (const ScenarioMove& move : scenario.moves) moves.push_back(&move);
+    std::stable_sort(moves.begin(), moves.end(), [](const ScenarioMove* a, const ScenarioMove* b) {
+        return (a->type != b->type) ? a->type < b->type : a->name < b->name;
+    });
+
+    for (size_t begin = 0; begin < moves.size();) {
+        size_t end = begin + 1;
+        while (end < moves.size() && moves[end]->type == moves[begin]->type && moves[end]->name == moves[begin]->name) ++end;
+        const ScenarioMove& first = *moves[begin];
+        switch (first.type) {
+        case MarketDataType::RateCurve:
+            if (std::shared_ptr<const RateCurve> curve = base.getCurve(first.name)) {
+                std::vector<double> rates = curve->getRates();
+                shiftPillars(rates, &moves[begin], end - begin, scenario);
+                auto shocked = std::make_shared<RateCurve>(curve->getName());
+                shocked->setPillars(curve->getTenorDates(), std::move(rates));
+                overlay.addCurve(first.name, std::move(shocked));
+            }
+            break;
+        case MarketDataType::VolCurve:
+            if (std::shared_ptr<const VolCurve> curve = base.getVolCurve(first.name)) {
+                std::vector<double> vols = curve->getVols();
+                shiftPillars(vols, &moves[begin], end - begin, scenario);
+                auto shocked = std::make_shared<VolCurve>(curve->getName());
+                shocked->setPillars(curve->getTenors(), std::move(vols));
+                overlay.addVolCurve(first.name, std::move(shocked));
+            }
+            break;
+        case MarketDataType::StockPrice:
+            if (base.getVersion(MarketDataType::StockPrice, first.name) != 0) {
+                double price = base.getStockPrice(first.name);
+                for (size_t m = begin; m < end; ++m) price *= 1.0 + moves[m]->shift;
+                overlay.addStockPrice(first.name, price);
+            }
+            break;
+        case MarketDataType::BondPrice:
+            break;
+        }
+        begin = end;
+    }
+    return overlay;
+}
+
+VaRResult computeVaR(const std::vector<double>& pnl, double confidence) {
+    if (pnl.empty()) {
+        throw std::invalid_argument("computeVaR: empty P&L sample.");
+    }
+    if (!(confidence > 0.0 && confidence < 1.0)) {
+        throw std::invalid_argument("computeVaR: confidence must be in (0, 1).");
+    }
+    const size_t n = pnl.size();
+    // The epsilon keeps e.g. (1 - 0.99) * 100 from rounding up to 2.
+    size_t k = static_cast<size_t>(std::ceil((1.0 - confidence) * static_cast<double>(n) - 1e-9));
+    k = std::min(std::max<size_t>(k, 1), n);
+
+    std::vector<double> sorted(pnl);
+    std::nth_element(sorted.begin(), sorted.begin() + static_cast<std::ptrdiff_t>(k - 1), sorted.end());
+    std::sort(sorted.begin(), sorted.begin() + static_cast<std::ptrdiff_t>(k));
+    double tail = 0.0;
+    for (size_t i = 0; i < k; ++i) tail += sorted[i];
+
+    VaRResult result;
+    result.confidence = confidence;
+    result.valueAtRisk = -sorted[k - 1];
+    result.expectedShortfall = -tail / static_cast<double>(k);
+    result.tailScenarios = k;
+    return result;
+}
+
+ScenarioEngine::ScenarioEngine(const Pricer& pricer_in, ThreadPool* pool_in, const ScenarioRunSettings& settings_in)
+    : pricer(pricer_in), pool(pool_in), settings(settings_in) {
+    if (settings.scenarioBlock == 0 || settings.tradeBlock == 0) {
+        throw std::invalid_argument("ScenarioEngine: block sizes must be positive.");
+    }
+}
+
+ScenarioPnl ScenarioEngine::run(const std::vector<std::shared_ptr<Trade>>& portfolio, const Market& base,
+                                const ScenarioSet& scenarios) const {
+    PRICING_SCOPED_TIMER(ComputeScenarios);
+    const size_t tradeCount = portfolio.size();
+    const size_t scenarioCount = scenarios.size();
+    const double nan = std::numeric_limits<double>::quiet_NaN();
+
+    // Up-front checks, so bad input is reported once rather than per scenario and worker.
+    std::set<std::pair<MarketDataType, std::string>> missing;
+    for (const MarketScenario& scenario : scenarios.scenarios) {
+        for (const ScenarioMove& move : scenario.moves) {
+            const long pillars = factorPillars(base, move);
+            if (pillars < 0) {
+                if (missing.emplace(move.type, move.name).second) {
+                    std::cerr << "Warning: ScenarioEngine: " << moveTypeName(move.type) << " '" << move.name
+                              << "' is not in market '" << base.name << "'; its scenario moves are ignored." << std::endl;
+                }
+            } else if (move.type != MarketDataType::StockPrice && move.pillar >= pillars) {
+                throw std::out_of_range("ScenarioEngine: pillar " + std::to_string(move.pillar) + " out of range for " +
+                                        moveTypeName(move.type) + " '" + move.name + "' in scenario '" + scenario.id + "'.");
+            }
+        }
+    }
+
+    ScenarioPnl result;
+    result.scenarioIds.reserve(scenarioCount);
+    for (const MarketScenario& scenario : scenarios.scenarios) result.scenarioIds.push_back(scenario.id);
+    result.basePv.assign(tradeCount, nan);
+    result.errors.assign(tradeCount, std::string());
+
+    std::vector<const Trade*> trades(tradeCount);
+    for (size_t t = 0; t < tradeCount; ++t) trades[t] = portfolio[t].get();
+
+    auto forEach = [this](size_t count, size_t grain, const std::function<void(size_t, size_t, size_t)>& body) {
+        if (pool) {
+            pool->parallelFor(count, grain, body);
+        } else if (count > 0) {
+            body(0, count, 0);
+        }
+    };
+
+    forEach(tradeCount, settings.tradeBlock, [&](size_t begin, size_t end, size_t) {
+        pricer.PriceBatch(base, trades.data() + begin, end - begin, result.basePv.data() + begin,
+                          result.errors.data() + begin);
+    });
+
+    // values[s * tradeCount + t]: PV of trade t under scenario s; each block owns its rows.
+    std::vector<double> values(scenarioCount * tradeCount, nan);
+    const size_t blockCount = (scenarioCount + settings.scenarioBlock - 1) / settings.scenarioBlock;
+    std::vector<std::vector<ScenarioFailure>> failures(blockCount);
+    forEach(blockCount, 1, [&](size_t blockBegin, size_t blockEnd, size_t) {
+        std::vector<std::string> tileErrors(settings.tradeBlock);
+        std::vector<Market> markets;
+        for (size_t block = blockBegin; block < blockEnd; ++block) {
+            const size_t first = block * settings.scenarioBlock;
+            const size_t last = std::min(first + settings.scenarioBlock, scenarioCount);
+            markets.clear();
+            for (size_t s = first; s < last; ++s) markets.push_back(applyScenario(base, scenarios.scenarios[s]));
+
+            for (size_t tile = 0; tile < tradeCount; tile += settings.tradeBlock) {
+                const size_t n = std::min(settings.tradeBlock, tradeCount - tile);
+                for (size_t s = first; s < last; ++s) {
+                    pricer.PriceBatch(markets[s - first], trades.data() + tile, n,
+                                      values.data() + s * tradeCount + tile, tileErrors.data());
+                    for (size_t i = 0; i < n; ++i) {
+                        if (tileErrors[i].empty()) continue;
+                        failures[block].push_back(ScenarioFailure{tile + i, s, std::move(tileErrors[i])});
+                        tileErrors[i].clear();
+                    }
+                }
+            }
+        }
+    });
+
+    // Blocks are in scenario order and each lists its failures in tile order, so the first one
+    // recorded per trade is its earliest failing scenario.
+    std::vector<size_t> failedScenario(tradeCount, scenarioCount);
+    for (const auto& blockFailures : failures) {
+        for (const ScenarioFailure& failure : blockFailures) {
+            if (failure.scenario >= failedScenario[failure.trade]) continue;
+            failedScenario[failure.trade] = failure.scenario;
+            if (result.errors[failure.trade].empty()) { // A base failure takes precedence
+                result.errors[failure.trade] = "Scenario '" + scenarios.scenarios[failure.scenario].id + "': " + failure.message;
+            }
+        }
+    }
+
+    std::vector<char> included(tradeCount, 0);
+    for (size_t t = 0; t < tradeCount; ++t) {
+        included[t] = result.errors[t].empty() ? 1 : 0;
+        result.includedTrades += included[t];
+    }
+
+    result.pnl.assign(tradeCount, std::vector<double>(scenarioCount, nan));
+    forEach(tradeCount, settings.tradeBlock, [&](size_t begin, size_t end, size_t) {
+        for (size_t s = 0; s < scenarioCount; ++s) {
+            const double* row = values.data() + s * tradeCount;
+            for (size_t t = begin; t < end; ++t) result.pnl[t][s] = row[t] - result.basePv[t];
+        }
+    });
+
+    result.portfolioPnl.assign(scenarioCount, 0.0);
+    forEach(scenarioCount, 16, [&](size_t begin, size_t end, size_t) {
+        for (size_t s = begin; s < end; ++s) {
+            const double* row = values.data() + s * tradeCount;
+            double sum = 0.0;
+            for (size_t t = 0; t < tradeCount; ++t) {
+                if (included[t]) sum += row[t] - result.basePv[t];
+            }
+            result.portfolioPnl[s] = sum;
+        }
+    });
+    return result;
+}
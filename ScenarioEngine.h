@@ -0,0 +1,111 @@
+#ifndef SCENARIO_ENGINE_H
+#define SCENARIO_ENGINE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "Market.h"
+#include "Trade.h"
+#include "Pricer.h"
+#include "ThreadPool.h"
+
+// One market move of a scenario. Rate and vol shifts are absolute (0.0001 = 1bp, 0.01 = 1 vol
+// point) on one pillar, or on every pillar with pillar == -1; stock shifts are relative
+// returns, S -> S (1 + shift). Bond prices are not scenario factors.
+struct ScenarioMove {
+    MarketDataType type = MarketDataType::RateCurve;
+    std::string name;
+    int pillar = -1;
+    double shift = 0.0;
+};
+
+// A full-market scenario as a delta over the base market: only the moves are stored, and
+// applyScenario turns them into a copy-on-write overlay of the base.
+struct MarketScenario {
+    std::string id;
+    std::vector<ScenarioMove> moves;
+};
+
+struct ScenarioSet {
+    std::vector<MarketScenario> scenarios;
+
+    size_t size() const { return scenarios.size(); }
+};
+
+// Reads a ';'-separated scenario file with one move per line:
+//   scenario;type;name;pillar;shift
+// type is rate, vol or stock; pillar is a 0-based pillar index or "all" (ignored for stocks).
+// Lines of one scenario need not be adjacent; scenarios keep the order of their first line.
+// Blank lines, '#' comments and a header line starting with "scenario" are skipped; a
+// malformed line is reported with a warning and skipped. Returns false if the file cannot be
+// opened.
+bool loadScenarioFile(const std::string& filePath, ScenarioSet& scenarios);
+
+// Normally distributed scenarios moving every rate curve, vol curve and stock price held by
+// 'base' (its own entries; an overlay's base is not included): parallel rate moves with
+// standard deviation rateStdDev, vol moves with volStdDev and stock returns with stockStdDev,
+// all independent. The draws come from Philox4x32 streams keyed by 'seed', one counter per
+// (scenario, factor), so a set is reproducible. For stress tests and benchmarks.
+ScenarioSet generateScenarios(const Market& base, size_t count, uint64_t seed,
+                              double rateStdDev = 0.0010, double volStdDev = 0.02, double stockStdDev = 0.02);
+
+// Overlay of 'base' with the scenario applied (base must outlive it). Moves on one curve are
+// folded into a single setPillars on a fresh curve, so each shocked curve is built once.
+// Entries missing from 'base' are left alone; an out-of-range pillar throws std::out_of_range.
+Market applyScenario(const Market& base, const MarketScenario& scenario);
+
+// Per-trade scenario P&L from ScenarioEngine::run, indexed like the input portfolio.
+struct ScenarioPnl {
+    std::vector<std::string> scenarioIds;
+    std::vector<double> basePv;           // NaN where the base valuation failed
+    std::vector<std::vector<double>> pnl; // pnl[trade][scenario] = PV(scenario) - basePv; NaN if failed
+    std::vector<std::string> errors;      // Non-empty: first failure of that trade (base, then scenario order)
+    std::vector<double> portfolioPnl;     // Per scenario, summed over the trades without errors
+    size_t includedTrades = 0;            // Trades contributing to portfolioPnl
+};
+
+// Historical-simulation VaR and expected shortfall of a P&L sample, as positive losses.
+// With n scenarios and k = ceil((1 - confidence) n) (at least 1), VaR is minus the k-th worst
+// P&L and ES minus the mean of the k worst.
+struct VaRResult {
+    double confidence = 0.0;
+    double valueAtRisk = 0.0;
+    double expectedShortfall = 0.0;
+    size_t tailScenarios = 0; // k
+};
+
+// Throws std::invalid_argument for an empty sample or a confidence outside (0, 1).
+VaRResult computeVaR(const std::vector<double>& pnl, double confidence);
+
+// Tiling of the trades x scenarios revaluation.
+struct ScenarioRunSettings {
+    size_t scenarioBlock = 8; // Scenarios materialized together; one pool task per block
+    size_t tradeBlock = 256;  // Trades priced under every scenario of the block before moving on
+};
+
+// Revalues a portfolio under every scenario of a set. Each pool task takes a block of
+// scenarios, builds their overlays once, then walks the portfolio in tiles, pricing each tile
+// under every scenario of the block through Pricer::PriceBatch while the tile's trade data is
+// still in cache. Each task writes its own scenario rows of a scenario-major buffer, which is
+// transposed into per-trade vectors at the end, so results do not depend on the thread count.
+// The pricer is shared by all workers and must be thread-safe (the built-in pricers are).
+class ScenarioEngine {
+public:
+    explicit ScenarioEngine(const Pricer& pricer, ThreadPool* pool = nullptr,
+                            const ScenarioRunSettings& settings = ScenarioRunSettings());
+
+    // Names in 'scenarios' that 'base' does not hold are reported once each with a warning and
+    // their moves are ignored; an out-of-range pillar throws std::out_of_range before pricing.
+    ScenarioPnl run(const std::vector<std::shared_ptr<Trade>>& portfolio, const Market& base,
+                    const ScenarioSet& scenarios) const;
+
+private:
+    const Pricer& pricer;
+    ThreadPool* pool; // Not owned; may be null
+    ScenarioRunSettings settings;
+};
+
+#endif // SCENARIO_ENGINE_H
@@ -0,0 +1,291 @@
+#include "Sharding.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <map>
+#include <sstream>
+#include <stdexcept>
+#include <unordered_map>
+
+namespace {
+
+constexpr const char* kManifestMagic = "pricing-shard-manifest";
+constexpr int kManifestVersion = 1;
+
+// 64-bit FNV-1a: fixed across platforms and builds, unlike std::hash.
+class Fnv1a {
+public:
+    void add(const void* data, size_t n) {
+        const unsigned char* bytes = static_cast<const unsigned char*>(data);
+        for (size_t i = 0; i < n; ++i) {
+            state ^= bytes[i];
+            state *= 0x100000001B3ull;
+        }
+    }
+    void add(const std::string& s) {
+        add(s.data(), s.size());
+        add("\x1f", 1); // Field separator, so ("ab", "c") and ("a", "bc") differ
+    }
+    void add(long value) { add(&value, sizeof(value)); }
+    void add(double value) { add(&value, sizeof(value)); }
+
+    uint64_t value() const { return state; }
+
+private:
+    uint64_t state = 0xCBF29CE484222325ull;
+};
+
+const char* shardKeyName(ShardKey key) { return key == ShardKey::Curve ? "curve" : "id"; }
+
+std::string shardFileStem(const std::string& prefix, const ShardSpec& spec) {
+    return prefix + ".shard-" + std::to_string(spec.index) + "-of-" + std::to_string(spec.count);
+}
+
+template <typename Map>
+std::vector<std::string> sortedKeys(const Map& map) {
+    std::vector<std::string> keys;
+    keys.reserve(map.size());
+    for (const auto& entry : map) keys.push_back(entry.first);
+    std::sort(keys.begin(), keys.end());
+    return keys;
+}
+
+} // namespace
+
+ShardKey parseShardKey(const std::string& name) {
+    if (name == "id") return ShardKey::TradeId;
+    if (name == "curve") return ShardKey::Curve;
+    throw std::invalid_argument("Unknown shard key '" + name + "' (expected id or curve).");
+}
+
+ShardSpec parseShardSpec(const std::string& text, ShardKey key) {
+    const size_t slash = text.find('/');
+    ShardSpec spec;
+    spec.key = key;
+    try {
+        if (slash == std::string::npos) throw std::invalid_argument("missing '/'");
+        size_t used = 0;
+        spec.index = std::stoul(text.substr(0, slash), &used);
+        if (used != slash) throw std::invalid_argument("bad index");
+        spec.count = std::stoul(text.substr(slash + 1), &used);
+        if (used != text.size() - slash - 1) throw std::invalid_argument("bad count");
+    } catch (const std::exception&) {
+        throw std::invalid_argument("Invalid shard '" + text + "' (expected <index>/<count>, e.g. 0/8).");
+    }
+    if (spec.count == 0 || spec.index >= spec.count) {
+        throw std::invalid_argument("Invalid shard '" + text + "': need 0 <= index < count.");
+    }
+    return spec;
+}
+
+size_t shardOf(const TradeRecord& record, ShardKey key, size_t count) {
+    Fnv1a hash;
+    if (key == ShardKey::Curve) {
+        hash.add(record.discountCurve);
+        hash.add(record.volCurve);
+        if (record.type == "european" || record.type == "american") hash.add(record.instrument);
+    } else {
+        hash.add(record.id);
+    }
+    return static_cast<size_t>(hash.value() % count);
+}
+
+std::vector<size_t> selectShard(const std::vector<TradeRecord>& records, const ShardSpec& spec) {
+    std::vector<size_t> indices;
+    for (size_t i = 0; i < records.size(); ++i) {
+        if (shardOf(records[i], spec.key, spec.count) == spec.index) indices.push_back(i);
+    }
+    return indices;
+}
+
+std::string shardResultsPath(const std::string& prefix, const ShardSpec& spec) {
+    return shardFileStem(prefix, spec) + ".bin";
+}
+
+std::string shardManifestPath(const std::string& prefix, const ShardSpec& spec) {
+    return shardFileStem(prefix, spec) + ".manifest";
+}
+
+uint64_t marketFingerprint(const Market& market) {
+    Fnv1a hash;
+    hash.add(market.asOf.getSerialDate());
+    for (const std::string& name : market.getCurveNames()) {
+        std::shared_ptr<const RateCurve> curve = market.getCurve(name);
+        hash.add(name);
+        for (const Date& d : curve->getTenorDates()) hash.add(d.getSerialDate());
+        for (double r : curve->getRates()) hash.add(r);
+    }
+    for (const std::string& name : market.getVolCurveNames()) {
+        std::shared_ptr<const VolCurve> curve = market.getVolCurve(name);
+        hash.add(name);
+        for (const Date& d : curve->getTenors()) hash.add(d.getSerialDate());
+        for (double v : curve->getVols()) hash.add(v);
+    }
+    const std::unordered_map<std::string, double> stocks = market.getStockPrices();
+    for (const std::string& name : sortedKeys(stocks)) {
+        hash.add(name);
+        hash.add(stocks.at(name));
+    }
+    const std::unordered_map<std::string, double> bonds = market.getBondPrices();
+    for (const std::string& name : sortedKeys(bonds)) {
+        hash.add(name);
+        hash.add(bonds.at(name));
+    }
+    return hash.value();
+}
+
+void writeShardManifest(const std::string& filePath, const ShardManifest& manifest) {
+    const std::string tmpPath = filePath + ".tmp";
+    {
+        std::ofstream out(tmpPath, std::ios::trunc);
+        if (!out) throw std::runtime_error("Could not open shard manifest '" + tmpPath + "' for writing");
+        out << kManifestMagic << ' ' << kManifestVersion << '\n'
+            << "shard " << manifest.spec.index << ' ' << manifest.spec.count << '\n'
+            << "key " << shardKeyName(manifest.spec.key) << '\n'
+            << "records " << manifest.totalRecords << '\n'
+            << "market " << std::hex << std::setw(16) << std::setfill('0') << manifest.marketFingerprint << std::dec << '\n'
+            << "trades " << manifest.recordIndices.size() << '\n'
+            << "indices\n";
+        for (size_t i = 0; i < manifest.recordIndices.size(); ++i) {
+            out << manifest.recordIndices[i] << ((i % 32 == 31 || i + 1 == manifest.recordIndices.size()) ? '\n' : ' ');
+        }
+        out.flush();
+        if (!out) throw std::runtime_error("Write to shard manifest '" + tmpPath + "' failed");
+    }
+    if (std::rename(tmpPath.c_str(), filePath.c_str()) != 0) {
+        throw std::runtime_error("Could not move shard manifest into place at '" + filePath + "'");
+    }
+}
+
+bool readShardManifest(const std::string& filePath, ShardManifest& manifest) {
+    std::ifstream in(filePath);
+    if (!in) return false;
+    auto malformed = [&](const std::string& what) {
+        return std::runtime_error("Malformed shard manifest '" + filePath + "': " + what);
+    };
+    std::string word, keyName;
+    int version = 0;
+    if (!(in >> word >> version) || word != kManifestMagic) throw malformed("not a shard manifest");
+    if (version != kManifestVersion) throw malformed("unsupported version " + std::to_string(version));
+    size_t trades = 0;
+    if (!(in >> word >> manifest.spec.index >> manifest.spec.count) || word != "shard") throw malformed("shard line");
+    if (!(in >> word >> keyName) || word != "key") throw malformed("key line");
+    try {
+        manifest.spec.key = parseShardKey(keyName);
+    } catch (const std::invalid_argument& e) {
+        throw malformed(e.what());
+    }
+    if (!(in >> word >> manifest.totalRecords) || word != "records") throw malformed("records line");
+    if (!(in >> word >> std::hex >> manifest.marketFingerprint >> std::dec) || word != "market") throw malformed("market line");
+    if (!(in >> word >> trades) || word != "trades") throw malformed("trades line");
+    if (!(in >> word) || word != "indices") throw malformed("indices line");
+    manifest.recordIndices.resize(trades);
+    for (size_t i = 0; i < trades; ++i) {
+        if (!(in >> manifest.recordIndices[i])) throw malformed("expected " + std::to_string(trades) + " indices");
+    }
+    return true;
+}
+
+ShardMergeReport mergeShardResults(const std::string& prefix, size_t count, const std::string& outputPath,
+                                   ResultsFormat format) {
+    if (count == 0) throw std::invalid_argument("mergeShardResults: shard count must be positive.");
+    ShardMergeReport report;
+    std::vector<ShardManifest> manifests(count);
+    for (size_t i = 0; i < count; ++i) {
+        ShardSpec spec;
+        spec.index = i;
+        spec.count = count;
+        if (!readShardManifest(shardManifestPath(prefix, spec), manifests[i])) {
+            report.missingShards.push_back(i);
+        }
+    }
+    if (!report.missingShards.empty()) return report;
+
+    const ShardManifest& first = manifests.front();
+    std::vector<std::pair<size_t, TradeResult>> merged;
+    for (size_t i = 0; i < count; ++i) {
+        const ShardManifest& m = manifests[i];
+        const std::string name = shardManifestPath(prefix, m.spec);
+        if (m.spec.index != i || m.spec.count != count) {
+            throw std::runtime_error("Shard manifest '" + name + "' describes shard " + std::to_string(m.spec.index) +
+                                     "/" + std::to_string(m.spec.count));
+        }
+        if (m.spec.key != first.spec.key || m.totalRecords != first.totalRecords) {
+            throw std::runtime_error("Shard manifest '" + name + "' was partitioned differently from shard 0 "
+                                     "(shard key or trade file differ)");
+        }
+        if (m.marketFingerprint != first.marketFingerprint) {
+            throw std::runtime_error("Shard manifest '" + name + "' was priced against a different market from shard 0");
+        }
+        std::vector<TradeResult> results;
+        readBinaryResults(shardResultsPath(prefix, m.spec), results);
+        if (results.size() != m.recordIndices.size()) {
+            throw std::runtime_error("Shard results '" + shardResultsPath(prefix, m.spec) + "' hold " +
+                                     std::to_string(results.size()) + " trades, manifest lists " +
+                                     std::to_string(m.recordIndices.size()));
+        }
+        for (size_t t = 0; t < results.size(); ++t) {
+            if (m.recordIndices[t] >= m.totalRecords) {
+                throw std::runtime_error("Shard manifest '" + name + "' lists record " +
+                                         std::to_string(m.recordIndices[t]) + " beyond the trade file");
+            }
+            merged.emplace_back(m.recordIndices[t], std::move(results[t]));
+        }
+    }
+    std::sort(merged.begin(), merged.end(),
+              [](const auto& a, const auto& b) { return a.first < b.first; });
+    for (size_t t = 1; t < merged.size(); ++t) {
+        if (merged[t].first == merged[t - 1].first) {
+            throw std::runtime_error("Record " + std::to_string(merged[t].first) + " appears in more than one shard");
+        }
+    }
+
+    std::unique_ptr<ResultsSink> sink = makeResultsSink(format, outputPath);
+    if (!sink) throw std::runtime_error("Could not open " + outputPath + " for writing");
+    std::vector<TradeResult> ordered;
+    ordered.reserve(merged.size());
+    for (auto& entry : merged) {
+        sink->writeTradeResult(entry.second);
+        ordered.push_back(std::move(entry.second));
+    }
+    std::ostringstream notes;
+    notes << "\nMerged " << count << " shards (" << shardKeyName(first.spec.key) << " key) of "
+          << first.totalRecords << " trade records." << std::endl;
+    notes << aggregateRiskNotes(ordered);
+    sink->writeNotes(notes.str());
+    sink->close();
+    report.mergedTrades = ordered.size();
+    return report;
+}
+
+std::string aggregateRiskNotes(const std::vector<TradeResult>& results) {
+    double totalPv = 0.0;
+    size_t trades = 0, pvFailures = 0, dv01Failures = 0, vegaFailures = 0;
+    std::map<std::string, double> dv01, vega;
+    for (const TradeResult& r : results) {
+        if (!r.hasTrade) continue;
+        ++trades;
+        if (r.pvOk) totalPv += r.pv; else ++pvFailures;
+        if (r.dv01Ok) {
+            for (const auto& entry : r.dv01) dv01[entry.first] += entry.second;
+        } else {
+            ++dv01Failures;
+        }
+        if (r.vegaOk) {
+            for (const auto& entry : r.vega) vega[entry.first] += entry.second;
+        } else {
+            ++vegaFailures;
+        }
+    }
+    std::ostringstream os;
+    os << std::fixed << std::setprecision(6);
+    os << "\n--- Aggregated Risk ---" << std::endl;
+    os << "  Trades: " << trades << " (failed PV: " << pvFailures << ", DV01: " << dv01Failures
+       << ", Vega: " << vegaFailures << ")" << std::endl;
+    os << "  Total PV: " << totalPv << std::endl;
+    for (const auto& entry : dv01) os << "  DV01 (" << entry.first << "): " << entry.second << std::endl;
+    for (const auto& entry : vega) os << "  Vega (" << entry.first << "): " << entry.second << std::endl;
+    return os.str();
+}
@@ -0,0 +1,88 @@
+#ifndef SHARDING_H
+#define SHARDING_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "Market.h"
+#include "PortfolioEngine.h" // TradeResult
+#include "ResultsSink.h"
+#include "TradeLoader.h"     // TradeRecord
+
+// Sharded runs: the trade records are split into N shards by a stable hash, each shard is
+// priced by an independent process (any node, same market snapshot) and the per-shard
+// results are merged back into one results file in the original trade order.
+//
+//   main --snapshot eod.snap --shard 0/8 --shard-key curve   (one process per shard)
+//   ...
+//   main --merge-shards 8                                    (writes results.txt)
+//
+// A shard writes <prefix>.shard-<i>-of-<N>.bin (binary results, see BinaryResultsSink) and,
+// only once that file is complete, <prefix>.shard-<i>-of-<N>.manifest. A shard without a
+// manifest is unfinished; rerunning just that shard replaces both files.
+
+enum class ShardKey {
+    TradeId, // FNV-1a of the trade id: even spread
+    Curve    // Discount curve, vol curve and option underlying: trades sharing shocked markets stay together
+};
+
+// "id" or "curve"; throws std::invalid_argument otherwise.
+ShardKey parseShardKey(const std::string& name);
+
+struct ShardSpec {
+    size_t index = 0;
+    size_t count = 0; // 0: not sharded
+    ShardKey key = ShardKey::TradeId;
+
+    bool active() const { return count > 0; }
+};
+
+// "<i>/<N>" with 0 <= i < N; throws std::invalid_argument otherwise.
+ShardSpec parseShardSpec(const std::string& text, ShardKey key);
+
+// Shard of a record in [0, count). Depends only on the record's fields, not on the platform
+// or the position of the record in its file.
+size_t shardOf(const TradeRecord& record, ShardKey key, size_t count);
+
+// Indices (ascending) of the records that belong to 'spec'.
+std::vector<size_t> selectShard(const std::vector<TradeRecord>& records, const ShardSpec& spec);
+
+std::string shardResultsPath(const std::string& prefix, const ShardSpec& spec);
+std::string shardManifestPath(const std::string& prefix, const ShardSpec& spec);
+
+// Hash of the market contents (as-of date, every curve's pillars, stock and bond prices),
+// recorded by each shard so that a merge can reject shards priced against different data.
+uint64_t marketFingerprint(const Market& market);
+
+struct ShardManifest {
+    ShardSpec spec;
+    size_t totalRecords = 0;           // Records in the unsharded source
+    uint64_t marketFingerprint = 0;
+    std::vector<size_t> recordIndices; // Source record of each result in the shard's results file
+};
+
+// Written to a temporary file and renamed into place. Throws std::runtime_error on I/O failure.
+void writeShardManifest(const std::string& filePath, const ShardManifest& manifest);
+
+// False if the file does not exist; throws std::runtime_error if it is malformed.
+bool readShardManifest(const std::string& filePath, ShardManifest& manifest);
+
+struct ShardMergeReport {
+    std::vector<size_t> missingShards; // Without a manifest; nothing is written if non-empty
+    size_t mergedTrades = 0;
+};
+
+// Merges the shards <prefix>.shard-*-of-<count> into outputPath (in 'format'), trades in
+// source record order, followed by aggregateRiskNotes of the merged results. Throws
+// std::runtime_error if the shards are inconsistent (other shard count or key, different
+// record totals or market fingerprints, overlapping or truncated shards).
+ShardMergeReport mergeShardResults(const std::string& prefix, size_t count, const std::string& outputPath,
+                                   ResultsFormat format);
+
+// Portfolio totals for a results notes section: PV, DV01 and Vega summed per curve over the
+// trades whose measure succeeded, and failure counts.
+std::string aggregateRiskNotes(const std::vector<TradeResult>& results);
+
+#endif // SHARDING_H
@@ -14,7 +14,7 @@ Swap::Swap(const std::string& underlyingName_in,
            int paymentFrequency_in,
            const std::string& fixedLegDiscCurve,
            const std::string& floatLegFcstCurve)
-    : Trade("Swap", effectiveDate_in), 
+    : Trade("Swap", effectiveDate_in, InstrumentKind::Swap), 
       underlyingName(underlyingName_in),
       effectiveDate(effectiveDate_in),
       maturityDate(maturityDate_in),
@@ -22,7 +22,10 @@ Swap::Swap(const std::string& underlyingName_in,
       fixedRate(fixedRate_in),
       paymentFrequency(paymentFrequency_in),
       fixedLegDiscountCurveName(fixedLegDiscCurve),
-      floatLegForecastCurveName(floatLegFcstCurve) {
+      floatLegForecastCurveName(floatLegFcstCurve),
+      underlyingId(internMarketDataName(underlyingName)),
+      fixedLegDiscountCurveId(internMarketDataName(fixedLegDiscountCurveName)),
+      volCurveId(internMarketDataName("")) {
 
     if (paymentFrequency <= 0) {
         throw std::invalid_argument("Swap payment frequency must be positive.");
@@ -41,28 +44,29 @@ void Swap::generateSwapSchedule() {
         return;
     }
 
-    std::string tenorStr;
-    if (paymentFrequency == 1) tenorStr = "12M";
-    else if (paymentFrequency == 2) tenorStr = "6M";
-    else if (paymentFrequency == 4) tenorStr = "3M";
-    else if (paymentFrequency == 12) tenorStr = "1M";
+    Tenor tenor;
+    if (paymentFrequency == 1) tenor = Tenor("12M");
+    else if (paymentFrequency == 2) tenor = Tenor("6M");
+    else if (paymentFrequency == 4) tenor = Tenor("3M");
+    else if (paymentFrequency == 12) tenor = Tenor("1M");
     else {
         throw std::runtime_error("Unsupported payment frequency for swap schedule generation: " + std::to_string(paymentFrequency));
     }
 
     fixedLegSchedule.clear();
     fixedLegSchedule.push_back(effectiveDate); 
-    Date next_payment_date = effectiveDate;
-    while (next_payment_date < maturityDate) {
-        Date temp_next_payment_date = dateAddTenor(next_payment_date, tenorStr);
+    // Step on serials; a Date (with its year/month/day) is built only for the stored dates.
+    const SerialDate maturity(maturityDate);
+    SerialDate next_payment_date(effectiveDate);
+    while (next_payment_date < maturity) {
+        SerialDate temp_next_payment_date = next_payment_date + tenor;
         // If adding the full tenor overshoots or lands on maturity, set to maturityDate.
-        if (!(temp_next_payment_date < maturityDate) || temp_next_payment_date == maturityDate) { // temp_next_payment_date >= maturityDate
-            next_payment_date = maturityDate;
-        } else {
-            next_payment_date = temp_next_payment_date;
+        if (!(temp_next_payment_date < maturity)) { // temp_next_payment_date >= maturity
+            fixedLegSchedule.push_back(maturityDate);
+            break; // Stop at maturity
         }
-        fixedLegSchedule.push_back(next_payment_date);
-        if (next_payment_date == maturityDate) break; // Stop if we hit maturity exactly
+        next_payment_date = temp_next_payment_date;
+        fixedLegSchedule.push_back(next_payment_date.toDate());
     }
     
     // Clean up potential duplicates if maturityDate was hit exactly by dateAddTenor and also added
@@ -88,7 +92,7 @@ double Swap::getAnnuity(const Market& mkt) const {
         return 0.0;
     }
 
-    std::shared_ptr<const RateCurve> discCurve = mkt.getCurve(fixedLegDiscountCurveName);
+    std::shared_ptr<const RateCurve> discCurve = mkt.getCurve(fixedLegDiscountCurveId);
     if (!discCurve || discCurve->isEmpty()) {
         std::cerr << "Error: Discount curve '" << fixedLegDiscountCurveName << "' not found or empty for annuity." << std::endl;
         return 0.0;
@@ -124,7 +128,7 @@ double Swap::Pv(const Market& mkt) const {
         return 0.0; 
     }
 
-    std::shared_ptr<const RateCurve> discCurve = mkt.getCurve(fixedLegDiscountCurveName);
+    std::shared_ptr<const RateCurve> discCurve = mkt.getCurve(fixedLegDiscountCurveId);
     if (!discCurve || discCurve->isEmpty()) {
         std::cerr << "Error: Discount curve '" << fixedLegDiscountCurveName << "' not found or empty for Swap PV." << std::endl;
         return 0.0;
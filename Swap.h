@@ -25,12 +25,17 @@ public:
     Date getMaturityDate() const override;
     std::string getUnderlyingName() const override; 
     std::string getRateCurveName() const override;  // Primary discount curve (e.g., for fixed leg)
+    MarketDataId getUnderlyingId() const override { return underlyingId; }
+    MarketDataId getRateCurveId() const override { return fixedLegDiscountCurveId; }
     // getVolCurveName() will return empty string as swaps are not directly sensitive to vol in this model.
+    MarketDataId getVolCurveId() const override { return volCurveId; }
 
     // Swap specific methods
     double getNotional() const { return notional; }
     double getFixedRate() const { return fixedRate; }
     int getPaymentFrequency() const { return paymentFrequency; }
+    const Date& getEffectiveDate() const { return effectiveDate; }
+    const std::vector<Date>& getFixedLegSchedule() const { return fixedLegSchedule; }
 
 private:
     void generateSwapSchedule(); // Generates fixed leg payment schedule
@@ -46,6 +51,9 @@ private:
     
     std::string fixedLegDiscountCurveName;
     std::string floatLegForecastCurveName; // May be same as fixedLegDiscountCurveName
+    MarketDataId underlyingId;
+    MarketDataId fixedLegDiscountCurveId;
+    MarketDataId volCurveId;
 
     std::vector<Date> fixedLegSchedule; // Populated by generateSwapSchedule
 };
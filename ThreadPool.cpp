@@ -0,0 +1,146 @@
+#include "ThreadPool.h"
+#include <algorithm>
+#include <exception>
+
+namespace {
+    // Identifies the pool (and worker slot) the current thread belongs to, so nested
+    // parallelFor calls can run inline instead of blocking a worker on its own queue.
+    thread_local const ThreadPool* currentPool = nullptr;
+    thread_local size_t currentWorkerIndex = 0;
+
+    struct BatchState {
+        std::atomic<size_t> remaining{0};
+        std::mutex mtx;
+        std::condition_variable done;
+        std::exception_ptr firstError;
+    };
+}
+
+ThreadPool::ThreadPool(size_t numThreads) {
+    if (numThreads == 0) {
+        numThreads = std::max<size_t>(1, std::thread::hardware_concurrency());
+    }
+    queues.reserve(numThreads);
+    for (size_t i = 0; i < numThreads; ++i) {
+        queues.push_back(std::make_unique<WorkerQueue>());
+    }
+    workers.reserve(numThreads);
+    for (size_t i = 0; i < numThreads; ++i) {
+        workers.emplace_back(&ThreadPool::workerLoop, this, i);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(wakeMutex);
+        stopping = true;
+    }
+    wakeCv.notify_all();
+    for (auto& worker : workers) {
+        if (worker.joinable()) worker.join();
+    }
+}
+
+void ThreadPool::push(size_t queueIndex, Task task) {
+    {
+        std::lock_guard<std::mutex> lock(queues[queueIndex]->mtx);
+        queues[queueIndex]->tasks.push_back(std::move(task));
+    }
+    queuedTasks.fetch_add(1, std::memory_order_release);
+}
+
+bool ThreadPool::popOrSteal(size_t index, Task& task) {
+    // Own queue first, newest task (LIFO keeps the chunk we just split hot in cache).
+    {
+        WorkerQueue& own = *queues[index];
+        std::lock_guard<std::mutex> lock(own.mtx);
+        if (!own.tasks.empty()) {
+            task = std::move(own.tasks.back());
+            own.tasks.pop_back();
+            queuedTasks.fetch_sub(1, std::memory_order_acq_rel);
+            return true;
+        }
+    }
+    // Steal the oldest task from a victim, starting with our neighbour.
+    const size_t n = queues.size();
+    for (size_t k = 1; k < n; ++k) {
+        WorkerQueue& victim = *queues[(index + k) % n];
+        std::lock_guard<std::mutex> lock(victim.mtx);
+        if (!victim.tasks.empty()) {
+            task = std::move(victim.tasks.front());
+            victim.tasks.pop_front();
+            queuedTasks.fetch_sub(1, std::memory_order_acq_rel);
+            return true;
+        }
+    }
+    return false;
+}
+
+void ThreadPool::workerLoop(size_t index) {
+    currentPool = this;
+    currentWorkerIndex = index;
+    while (true) {
+        Task task;
+        if (popOrSteal(index, task)) {
+            task(index);
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(wakeMutex);
+        wakeCv.wait(lock, [this] {
+            return stopping || queuedTasks.load(std::memory_order_acquire) > 0;
+        });
+        if (stopping && queuedTasks.load(std::memory_order_acquire) == 0) {
+            return;
+        }
+    }
+}
+
+void ThreadPool::parallelFor(size_t count, size_t grainSize,
+                             const std::function<void(size_t, size_t, size_t)>& body) {
+    if (count == 0) return;
+    if (grainSize == 0) grainSize = 1;
+
+    if (currentPool == this) { // Nested call from one of our own workers
+        body(0, count, currentWorkerIndex);
+        return;
+    }
+
+    const size_t numChunks = (count + grainSize - 1) / grainSize;
+    auto batch = std::make_shared<BatchState>();
+    batch->remaining.store(numChunks);
+
+    // Deal contiguous blocks of chunks to each worker so that, absent stealing,
+    // every worker walks a contiguous slice of the range.
+    const size_t numQueues = queues.size();
+    const size_t chunksPerQueue = (numChunks + numQueues - 1) / numQueues;
+    // Chunks are pushed last-to-first so that the owner's LIFO pops walk its block front to back.
+    for (size_t c = numChunks; c-- > 0;) {
+        const size_t begin = c * grainSize;
+        const size_t end = std::min(count, begin + grainSize);
+        push(std::min(numQueues - 1, c / chunksPerQueue),
+             [batch, &body, begin, end](size_t workerIndex) {
+                 try {
+                     body(begin, end, workerIndex);
+                 } catch (...) {
+                     std::lock_guard<std::mutex> lock(batch->mtx);
+                     if (!batch->firstError) batch->firstError = std::current_exception();
+                 }
+                 if (batch->remaining.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                     std::lock_guard<std::mutex> lock(batch->mtx);
+                     batch->done.notify_all();
+                 }
+             });
+    }
+    {
+        // Taking the mutex orders the queuedTasks update against a worker that is
+        // between its predicate check and wait(), so the wake-up cannot be lost.
+        std::lock_guard<std::mutex> lock(wakeMutex);
+    }
+    wakeCv.notify_all();
+
+    std::unique_lock<std::mutex> lock(batch->mtx);
+    batch->done.wait(lock, [&batch] { return batch->remaining.load(std::memory_order_acquire) == 0; });
+    if (batch->firstError) {
+        std::rethrow_exception(batch->firstError);
+    }
+}
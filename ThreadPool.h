@@ -0,0 +1,58 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <atomic>
+#include <memory>
+#include <cstddef>
+
+// Fixed-size work-stealing thread pool.
+// Each worker owns a deque of tasks: it pops from the back of its own deque and, once that is
+// empty, steals from the front of the other workers' deques. This keeps neighbouring chunks of a
+// parallelFor on the same core while still balancing uneven work (e.g. trees vs. bonds).
+class ThreadPool {
+public:
+    // numThreads == 0 uses std::thread::hardware_concurrency() (at least 1).
+    explicit ThreadPool(size_t numThreads = 0);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    size_t size() const { return workers.size(); }
+
+    // Splits [0, count) into chunks of at most grainSize and runs body(begin, end, workerIndex)
+    // for each chunk on the pool. workerIndex is in [0, size()) and identifies the executing
+    // worker, so callers can keep per-worker scratch state without locking.
+    // Blocks until every chunk has finished; the first exception thrown by body is rethrown here.
+    // Calling parallelFor from inside a pool task runs the range inline on the current worker.
+    void parallelFor(size_t count, size_t grainSize,
+                     const std::function<void(size_t begin, size_t end, size_t workerIndex)>& body);
+
+private:
+    using Task = std::function<void(size_t workerIndex)>;
+
+    struct WorkerQueue {
+        std::mutex mtx;
+        std::deque<Task> tasks;
+    };
+
+    void workerLoop(size_t index);
+    bool popOrSteal(size_t index, Task& task);
+    void push(size_t queueIndex, Task task);
+
+    std::vector<std::unique_ptr<WorkerQueue>> queues;
+    std::vector<std::thread> workers;
+
+    std::mutex wakeMutex;
+    std::condition_variable wakeCv;
+    std::atomic<size_t> queuedTasks{0};
+    bool stopping = false; // Guarded by wakeMutex
+};
+
+#endif // THREAD_POOL_H
@@ -7,6 +7,7 @@
 #include <memory> // For std::shared_ptr later if needed for composition
 #include "Date.h"
 #include "Market.h" // Market reference for Pv function
+#include "Types.h"  // InstrumentKind
 
 // Forward declare Pricer if it's used in a way that causes circular dependency
 // class Pricer; 
@@ -14,13 +15,14 @@
 class Trade {
 public:
     Trade() : tradeType("UnknownTrade"), tradeDate(Date()) {}; // Default constructor
-    Trade(const std::string& type, const Date& date)
-        : tradeType(type), tradeDate(date) {};
+    Trade(const std::string& type, const Date& date, InstrumentKind instrumentKind = InstrumentKind::Other)
+        : tradeType(type), tradeDate(date), kind(instrumentKind) {};
     
     virtual ~Trade() = default; // Important for base class with virtual functions
 
     std::string getType() const { return tradeType; } // Made const
     Date getTradeDate() const { return tradeDate; } // Made const
+    InstrumentKind getKind() const { return kind; } // Set by concrete trade constructors
 
     // Pure virtual function for Present Value calculation
     virtual double Pv(const Market& mkt) const = 0;
@@ -40,9 +42,17 @@ public:
     virtual std::string getRateCurveName() const { return "USD-SOFR"; } // Example default, override as needed
     virtual std::string getVolCurveName() const { return ""; }   // Example default, override as needed
 
+    // The same names interned (MarketDataId.h), for Market lookups on pricing paths. Concrete
+    // trades intern them once, at construction, and return the stored IDs; a trade without a
+    // vol curve returns the ID of "" as its getVolCurveName does.
+    virtual MarketDataId getUnderlyingId() const = 0;
+    virtual MarketDataId getRateCurveId() const = 0;
+    virtual MarketDataId getVolCurveId() const = 0;
+
 protected:   
     std::string tradeType;
     Date tradeDate;
+    InstrumentKind kind = InstrumentKind::Other;
     // Consider adding a unique trade ID if managing many trades
     // std::string tradeId;
 };
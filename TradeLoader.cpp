@@ -0,0 +1,381 @@
+#include "TradeLoader.h"
+#include "MappedFile.h"
+#include "Instrumentation.h"
+
+#include <iostream>
+#include <stdexcept>
+#include <algorithm>
+#include <cmath>
+#include <cctype>
+#include <charconv>
+#include <string_view>
+#include <system_error>
+#include <unordered_map>
+
+namespace {
+    constexpr size_t kMaxColumns = 16;           // Columns beyond this are counted, not kept
+    constexpr size_t kMinChunkBytes = 64 * 1024; // Smaller files are not worth splitting
+
+    // Fields of one line, trimmed like splitString (" \t\r\n"); count is the number of
+    // ';'-separated fields, including a trailing empty one after a final separator.
+    struct LineTokens {
+        std::string_view field[kMaxColumns];
+        size_t count = 0;
+    };
+
+    std::string_view trimField(std::string_view s) {
+        const size_t first = s.find_first_not_of(" \t\r\n");
+        if (first == std::string_view::npos) return std::string_view();
+        const size_t last = s.find_last_not_of(" \t\r\n");
+        return s.substr(first, last - first + 1);
+    }
+
+    void tokenizeLine(std::string_view line, LineTokens& tokens) {
+        tokens.count = 0;
+        size_t start = 0;
+        while (true) {
+            const size_t pos = line.find(';', start);
+            const std::string_view raw = (pos == std::string_view::npos) ? line.substr(start) : line.substr(start, pos - start);
+            if (tokens.count < kMaxColumns) tokens.field[tokens.count] = trimField(raw);
+            ++tokens.count;
+            if (pos == std::string_view::npos) break;
+            start = pos + 1;
+        }
+    }
+
+    char lowerChar(char c) {
+        return static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+    }
+
+    std::string toLowerTradeLoader(std::string_view s) {
+        std::string out(s);
+        std::transform(out.begin(), out.end(), out.begin(), lowerChar);
+        return out;
+    }
+
+    bool equalsNoCase(std::string_view a, std::string_view b) {
+        if (a.size() != b.size()) return false;
+        for (size_t i = 0; i < a.size(); ++i) {
+            if (lowerChar(a[i]) != b[i]) return false;
+        }
+        return true;
+    }
+
+    // needle must be lowercase.
+    bool containsNoCase(std::string_view haystack, std::string_view needle) {
+        if (needle.size() > haystack.size()) return false;
+        for (size_t i = 0; i + needle.size() <= haystack.size(); ++i) {
+            if (equalsNoCase(haystack.substr(i, needle.size()), needle)) return true;
+        }
+        return false;
+    }
+
+    // Like std::stod on a trimmed field: parses the longest numeric prefix.
+    double parseDouble(std::string_view s) {
+        const char* first = s.data();
+        const char* last = s.data() + s.size();
+        if (first != last && *first == '+') ++first; // from_chars does not accept a leading '+'
+        double value = 0.0;
+        const std::from_chars_result res = std::from_chars(first, last, value);
+        if (res.ec == std::errc::result_out_of_range) {
+            throw std::out_of_range("Number out of range: '" + std::string(s) + "'");
+        }
+        if (res.ec != std::errc() || res.ptr == first) {
+            throw std::invalid_argument("Invalid number '" + std::string(s) + "'");
+        }
+        return value;
+    }
+
+    bool parseDigits(std::string_view s, int& value) {
+        value = 0;
+        for (char c : s) {
+            if (c < '0' || c > '9') return false;
+            value = value * 10 + (c - '0');
+        }
+        return true;
+    }
+
+    // Dates already built in this chunk, keyed by yyyymmdd; a book reuses few distinct dates
+    // and Date(y, m, d) is comparatively expensive.
+    using DateCache = std::unordered_map<int, Date>;
+
+    // Fixed-format YYYY-MM-DD, same acceptance rules as Date(const std::string&).
+    Date parseDate(std::string_view s, DateCache& cache) {
+        if (s.size() != 10 || s[4] != '-' || s[7] != '-') {
+            throw std::invalid_argument("Date string format must be YYYY-MM-DD: " + std::string(s));
+        }
+        int y = 0, m = 0, d = 0;
+        if (!parseDigits(s.substr(0, 4), y) || !parseDigits(s.substr(5, 2), m) || !parseDigits(s.substr(8, 2), d)) {
+            throw std::invalid_argument("Error parsing date string '" + std::string(s) + "': non-digit date component");
+        }
+        if (m < 1 || m > 12 || d < 1 || d > 31 || y < 1800 || y > 9999) {
+            throw std::invalid_argument("Error parsing date string '" + std::string(s) +
+                                        "': Date component out of valid range in string constructor.");
+        }
+        const int key = y * 10000 + m * 100 + d;
+        auto it = cache.find(key);
+        if (it == cache.end()) {
+            it = cache.emplace(key, Date(y, m, d)).first;
+        }
+        return it->second;
+    }
+
+    enum class LineStatus {
+        Parsed,        // record (and trade, if requested) filled
+        TooFewColumns,
+        UnknownType,
+        Error          // error holds the exception message
+    };
+
+    struct ParsedLine {
+        size_t localLine = 0;  // 1-based within the chunk
+        std::string_view text; // Points into the mapped file
+        bool headerLike = false;
+        LineStatus status = LineStatus::Parsed;
+        size_t columns = 0;
+        TradeRecord record;
+        std::shared_ptr<Trade> trade;
+        std::string error;
+    };
+
+    struct ChunkResult {
+        size_t begin = 0;     // Byte offsets into the file; begin is at the start of a line
+        size_t end = 0;
+        size_t lineCount = 0; // Physical lines in [begin, end), blank and comment lines included
+        std::vector<ParsedLine> lines;
+    };
+
+    struct Factories {
+        TradeFactory& bond;
+        TradeFactory& swap;
+        TradeFactory& euro;
+        TradeFactory& amer;
+    };
+
+    void parseLine(const LineTokens& tokens, ParsedLine& out, const Factories* factories, DateCache& dates) {
+        out.columns = tokens.count;
+        if (tokens.count < 13) {
+            out.status = LineStatus::TooFewColumns;
+            return;
+        }
+        try {
+            TradeRecord& rec = out.record;
+            rec.id = std::string(tokens.field[0]);
+            rec.type = toLowerTradeLoader(tokens.field[1]);
+            rec.tradeDate = parseDate(tokens.field[2], dates);
+            rec.startDate = parseDate(tokens.field[3], dates);
+            rec.endDate = parseDate(tokens.field[4], dates);
+            rec.notional = parseDouble(tokens.field[5]);
+            rec.instrument = std::string(tokens.field[6]);
+
+            double rate_param = 0.0;
+            double strike_param = 0.0;
+            double freq_decimal_param = 0.0;
+            if (!tokens.field[7].empty()) rate_param = parseDouble(tokens.field[7]);
+            if (!tokens.field[8].empty()) strike_param = parseDouble(tokens.field[8]);
+            if (!tokens.field[9].empty()) freq_decimal_param = parseDouble(tokens.field[9]);
+
+            int frequency_val = 0;
+            if (rec.type == "bond" || rec.type == "swap") {
+                if (std::abs(freq_decimal_param) > 1e-9) {
+                    if (std::abs(freq_decimal_param - static_cast<int>(freq_decimal_param)) < 1e-6) {
+                        frequency_val = static_cast<int>(freq_decimal_param);
+                    } else {
+                        frequency_val = static_cast<int>(std::round(1.0 / freq_decimal_param));
+                    }
+                    if (frequency_val <= 0 && std::abs(rate_param) > 1e-9) frequency_val = 1;
+                } else {
+                    frequency_val = (std::abs(rate_param) > 1e-9) ? 1 : 0; // If coupon/rate exists, assume freq 1 if not specified
+                }
+            }
+            rec.rate = rate_param;
+            rec.strike = strike_param;
+            rec.frequency = frequency_val;
+
+            const std::string_view optionType_str = tokens.field[10];
+            rec.discountCurve = std::string(tokens.field[11]);
+            rec.volCurve = std::string(tokens.field[12]);
+            rec.floatCurve = (tokens.count > 13 && !tokens.field[13].empty()) ? std::string(tokens.field[13]) : rec.discountCurve;
+
+            rec.optionType = OptionType::None;
+            if (rec.type == "european" || rec.type == "american") {
+                if (equalsNoCase(optionType_str, "call")) rec.optionType = OptionType::Call;
+                else if (equalsNoCase(optionType_str, "put")) rec.optionType = OptionType::Put;
+                else if (equalsNoCase(optionType_str, "binarycall")) rec.optionType = OptionType::BinaryCall;
+                else if (equalsNoCase(optionType_str, "binaryput")) rec.optionType = OptionType::BinaryPut;
+                else if (!equalsNoCase(optionType_str, "none") && !optionType_str.empty() && !equalsNoCase(optionType_str, "na")) {
+                    throw std::invalid_argument("Unknown option type in trade.txt: " + std::string(optionType_str));
+                }
+            }
+
+            if (rec.type != "bond" && rec.type != "swap" && rec.type != "european" && rec.type != "american") {
+                out.status = LineStatus::UnknownType;
+                return;
+            }
+            if (factories) {
+                out.trade = buildTradeFromRecord(rec, factories->bond, factories->swap, factories->euro, factories->amer);
+            }
+            out.status = LineStatus::Parsed;
+        } catch (const std::exception& e) {
+            out.status = LineStatus::Error;
+            out.error = e.what();
+        }
+    }
+
+    void parseChunk(std::string_view file, ChunkResult& chunk, const Factories* factories) {
+        LineTokens tokens;
+        DateCache dates;
+        size_t pos = chunk.begin;
+        size_t localLine = 0;
+        while (pos < chunk.end) {
+            size_t eol = file.find('\n', pos);
+            if (eol == std::string_view::npos || eol >= chunk.end) eol = chunk.end;
+            const std::string_view line = file.substr(pos, eol - pos);
+            pos = eol + 1;
+            ++localLine;
+            if (line.empty() || line.find_first_not_of(" \t\r\n") == std::string_view::npos || line[0] == '#') {
+                continue;
+            }
+            chunk.lines.emplace_back();
+            ParsedLine& parsed = chunk.lines.back();
+            parsed.localLine = localLine;
+            parsed.text = line;
+            parsed.headerLike = containsNoCase(line, "id;type;trade_dt") || containsNoCase(line, "discount_curve;vol_curve");
+            tokenizeLine(line, tokens);
+            parseLine(tokens, parsed, factories, dates);
+        }
+        chunk.lineCount = localLine;
+    }
+
+    // Splits [0, size) into about 'wanted' ranges, each starting right after a '\n'.
+    std::vector<ChunkResult> splitIntoChunks(std::string_view file, size_t wanted) {
+        std::vector<ChunkResult> chunks;
+        const size_t size = file.size();
+        wanted = std::max<size_t>(1, std::min(wanted, size / kMinChunkBytes + 1));
+        size_t begin = 0;
+        for (size_t i = 1; i <= wanted && begin < size; ++i) {
+            size_t end = size;
+            if (i < wanted) {
+                const size_t target = std::max(begin, size * i / wanted);
+                const size_t nl = file.find('\n', target);
+                end = (nl == std::string_view::npos) ? size : nl + 1;
+            }
+            ChunkResult chunk;
+            chunk.begin = begin;
+            chunk.end = end;
+            chunks.push_back(std::move(chunk));
+            begin = end;
+        }
+        return chunks;
+    }
+}
+
+std::shared_ptr<Trade> buildTradeFromRecord(const TradeRecord& record,
+                                            TradeFactory& bondFactory,
+                                            TradeFactory& swapFactory,
+                                            TradeFactory& euroOptFactory,
+                                            TradeFactory& amerOptFactory) {
+    TradeFactory* factory = nullptr;
+    double primary_rate_strike_for_factory = 0.0;
+    if (record.type == "bond") {
+        factory = &bondFactory;
+        primary_rate_strike_for_factory = record.rate;
+    } else if (record.type == "swap") {
+        factory = &swapFactory;
+        primary_rate_strike_for_factory = record.rate;
+    } else if (record.type == "european") {
+        factory = &euroOptFactory;
+        primary_rate_strike_for_factory = record.strike;
+    } else if (record.type == "american") {
+        factory = &amerOptFactory;
+        primary_rate_strike_for_factory = record.strike;
+    } else {
+        return nullptr;
+    }
+    return factory->createTrade(record.instrument, record.tradeDate, record.startDate, record.endDate,
+                                record.notional, primary_rate_strike_for_factory, record.frequency,
+                                record.optionType, record.discountCurve, record.volCurve, record.floatCurve);
+}
+
+bool parseTradeFile(const std::string& filePath,
+                    std::vector<TradeRecord>* records,
+                    std::vector<std::shared_ptr<Trade>>* portfolio,
+                    TradeFactory& bondFactory,
+                    TradeFactory& swapFactory,
+                    TradeFactory& euroOptFactory,
+                    TradeFactory& amerOptFactory,
+                    ThreadPool* pool) {
+    PRICING_SCOPED_TIMER(LoadTradeFile);
+    PRICING_COUNT(FileLoads, 1);
+    MappedFile file;
+    if (!file.open(filePath)) {
+        std::cerr << "Error: Could not open trade file: '" << filePath << "'." << std::endl;
+        return false;
+    }
+    const std::string_view text = file.view();
+    const Factories factories{bondFactory, swapFactory, euroOptFactory, amerOptFactory};
+    const Factories* factoriesToUse = portfolio ? &factories : nullptr;
+
+    // A few chunks per worker so stealing can even out lines of different cost.
+    std::vector<ChunkResult> chunks = splitIntoChunks(text, pool ? pool->size() * 4 : 1);
+    if (pool && chunks.size() > 1) {
+        pool->parallelFor(chunks.size(), 1, [&](size_t begin, size_t end, size_t) {
+            for (size_t c = begin; c < end; ++c) parseChunk(text, chunks[c], factoriesToUse);
+        });
+    } else {
+        for (ChunkResult& chunk : chunks) parseChunk(text, chunk, factoriesToUse);
+    }
+
+    // Report and collect in file order. The first header-like line is skipped wherever it is.
+    bool headerSkipped = false;
+    size_t lineBase = 0;
+    for (ChunkResult& chunk : chunks) {
+        for (ParsedLine& parsed : chunk.lines) {
+            const size_t lineNumber = lineBase + parsed.localLine;
+            if (!headerSkipped && parsed.headerLike) {
+                headerSkipped = true;
+                std::cout << "Info: Header line detected and skipped in '" << filePath << "': '" << parsed.text << "'" << std::endl;
+                continue;
+            }
+            if (!headerSkipped && lineNumber == 1) {
+                std::cout << "Info: First line of '" << filePath << "' ('" << parsed.text << "') is not a recognized header. Assuming data from line 1." << std::endl;
+            }
+            switch (parsed.status) {
+                case LineStatus::TooFewColumns:
+                    std::cerr << "Warning: Skipping line " << lineNumber << " in '" << filePath
+                              << "'. Incorrect number of columns. Expected at least 13, got " << parsed.columns
+                              << ". Line: '" << parsed.text << "'" << std::endl;
+                    break;
+                case LineStatus::UnknownType:
+                    std::cerr << "Warning: Skipping line " << lineNumber << ". Unknown trade type: '" << parsed.record.type << "'." << std::endl;
+                    break;
+                case LineStatus::Error:
+                    std::cerr << "Warning: Skipping line " << lineNumber << " in '" << filePath
+                              << "'. Error parsing trade data: " << parsed.error << ". Line: '" << parsed.text << "'" << std::endl;
+                    break;
+                case LineStatus::Parsed:
+                    parsed.record.lineNumber = lineNumber;
+                    if (portfolio && parsed.trade) portfolio->push_back(std::move(parsed.trade));
+                    if (records) records->push_back(std::move(parsed.record));
+                    break;
+            }
+        }
+        lineBase += chunk.lineCount;
+    }
+    return true;
+}
+
+bool loadTradesFromFile(
+    const std::string& filePath,
+    std::vector<std::shared_ptr<Trade>>& portfolio,
+    TradeFactory& bondFactory,
+    TradeFactory& swapFactory,
+    TradeFactory& euroOptFactory,
+    TradeFactory& amerOptFactory,
+    ThreadPool* pool
+) {
+    if (!parseTradeFile(filePath, nullptr, &portfolio, bondFactory, swapFactory, euroOptFactory, amerOptFactory, pool)) {
+        return false;
+    }
+    return !portfolio.empty();
+}
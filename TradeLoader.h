@@ -0,0 +1,75 @@
+#ifndef TRADE_LOADER_H
+#define TRADE_LOADER_H
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <cstddef>
+
+#include "Trade.h"
+#include "TradeFactory.h"
+#include "ThreadPool.h"
+#include "Date.h"
+#include "Types.h"
+
+// Typed fields of one data line of a trade file, after the defaulting rules of the loader
+// (frequency derived from the freq column, float curve defaulting to the discount curve).
+struct TradeRecord {
+    size_t lineNumber = 0; // 1-based line in the source file
+    std::string id;
+    std::string type;      // Lowercased: "bond", "swap", "european" or "american"
+    Date tradeDate;
+    Date startDate;
+    Date endDate;
+    double notional = 0.0;
+    std::string instrument;
+    double rate = 0.0;     // Coupon/fixed rate for bonds and swaps
+    double strike = 0.0;   // Strike for options
+    int frequency = 0;
+    OptionType optionType = OptionType::None;
+    std::string discountCurve;
+    std::string volCurve;
+    std::string floatCurve;
+};
+
+// Builds the Trade for a record through the factory matching record.type.
+// Returns nullptr for an unknown type; constructor errors propagate.
+std::shared_ptr<Trade> buildTradeFromRecord(const TradeRecord& record,
+                                            TradeFactory& bondFactory,
+                                            TradeFactory& swapFactory,
+                                            TradeFactory& euroOptFactory,
+                                            TradeFactory& amerOptFactory);
+
+// Parses a ';'-separated trade file (trade.txt layout) into records and, if 'portfolio' is
+// non-null, appends the corresponding trades built through the factories.
+// The file is memory-mapped and split into line-aligned chunks that are tokenized in place
+// (string_view) and parsed with std::from_chars and fixed-format YYYY-MM-DD dates. With a
+// pool the chunks (including trade construction) run in parallel; the factories must then be
+// safe to call concurrently, which the stateless factories in TradeFactory.h are.
+// Header detection and per-line Info/Warning messages are identical to the serial loader and
+// are printed in file order after parsing. Returns false if the file cannot be opened.
+// Columns: 0:id; 1:type; 2:trade_dt; 3:start_dt; 4:end_dt; 5:notional; 6:instrument;
+// 7:rate(bond/swap); 8:strike(option); 9:freq(bond/swap); 10:option_type;
+// 11:DiscountCurve; 12:VolCurve; 13:FloatForecastCurve(optional)
+bool parseTradeFile(const std::string& filePath,
+                    std::vector<TradeRecord>* records,
+                    std::vector<std::shared_ptr<Trade>>* portfolio,
+                    TradeFactory& bondFactory,
+                    TradeFactory& swapFactory,
+                    TradeFactory& euroOptFactory,
+                    TradeFactory& amerOptFactory,
+                    ThreadPool* pool = nullptr);
+
+// Appends the trades of a trade file to 'portfolio' (see parseTradeFile).
+// Returns false if the file cannot be opened or the portfolio is still empty afterwards.
+bool loadTradesFromFile(
+    const std::string& filePath,
+    std::vector<std::shared_ptr<Trade>>& portfolio,
+    TradeFactory& bondFactory,
+    TradeFactory& swapFactory,
+    TradeFactory& euroOptFactory,
+    TradeFactory& amerOptFactory,
+    ThreadPool* pool = nullptr
+);
+
+#endif // TRADE_LOADER_H
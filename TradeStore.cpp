@@ -0,0 +1,423 @@
+#include "TradeStore.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <stdexcept>
+
+#include "Bond.h"
+#include "Swap.h"
+#include "EuropeanTrade.h"
+#include "AmericanTrade.h"
+#include "MathUtils.h"
+#include "Payoff.h"
+
+BondTable::BondTable(std::pmr::memory_resource* arena)
+    : sourceIndex(arena), instrumentId(arena), discountCurveId(arena), issueSerial(arena),
+      maturitySerial(arena), principal(arena), couponRate(arena), frequency(arena),
+      cashflowBegin(1, 0, arena), cashflowSerials(arena), cashflowAmounts(arena) {}
+
+SwapTable::SwapTable(std::pmr::memory_resource* arena)
+    : sourceIndex(arena), instrumentId(arena), discountCurveId(arena), effectiveSerial(arena),
+      maturitySerial(arena), notional(arena), fixedRate(arena), frequency(arena),
+      scheduleBegin(1, 0, arena), scheduleSerials(arena) {}
+
+OptionTable::OptionTable(std::pmr::memory_resource* arena)
+    : sourceIndex(arena), optionType(arena), strike(arena), expirySerial(arena),
+      underlyingId(arena), discountCurveId(arena), volCurveId(arena) {}
+
+namespace {
+
+template <typename Table>
+void reserveOptionRows(Table& table, size_t rows) {
+    table.sourceIndex.reserve(rows);
+    table.optionType.reserve(rows);
+    table.strike.reserve(rows);
+    table.expirySerial.reserve(rows);
+    table.underlyingId.reserve(rows);
+    table.discountCurveId.reserve(rows);
+    table.volCurveId.reserve(rows);
+}
+
+} // namespace
+
+TradeStore::TradeStore(size_t initialArenaBytes)
+    : arena(std::make_unique<std::pmr::monotonic_buffer_resource>(std::max<size_t>(initialArenaBytes, 1024))),
+      bondTable(arena.get()),
+      swapTable(arena.get()),
+      europeanTable(arena.get()),
+      americanTable(arena.get()) {}
+
+TradeStore TradeStore::fromPortfolio(const std::vector<std::shared_ptr<Trade>>& portfolio) {
+    size_t bonds = 0, swaps = 0, europeans = 0, americans = 0;
+    for (const auto& trade : portfolio) {
+        if (!trade) continue;
+        switch (trade->getKind()) {
+        case InstrumentKind::Bond: ++bonds; break;
+        case InstrumentKind::Swap: ++swaps; break;
+        case InstrumentKind::EuropeanOption: ++europeans; break;
+        case InstrumentKind::AmericanOption: ++americans; break;
+        case InstrumentKind::Other: break;
+        }
+    }
+
+    // Row columns sized up front so the arena is not left holding abandoned growth steps.
+    const size_t rowBytes = 96;
+    TradeStore store((bonds + swaps + europeans + americans) * rowBytes);
+    BondTable& b = store.bondTable;
+    b.sourceIndex.reserve(bonds);
+    b.instrumentId.reserve(bonds);
+    b.discountCurveId.reserve(bonds);
+    b.issueSerial.reserve(bonds);
+    b.maturitySerial.reserve(bonds);
+    b.principal.reserve(bonds);
+    b.couponRate.reserve(bonds);
+    b.frequency.reserve(bonds);
+    b.cashflowBegin.reserve(bonds + 1);
+    SwapTable& s = store.swapTable;
+    s.sourceIndex.reserve(swaps);
+    s.instrumentId.reserve(swaps);
+    s.discountCurveId.reserve(swaps);
+    s.effectiveSerial.reserve(swaps);
+    s.maturitySerial.reserve(swaps);
+    s.notional.reserve(swaps);
+    s.fixedRate.reserve(swaps);
+    s.frequency.reserve(swaps);
+    s.scheduleBegin.reserve(swaps + 1);
+    reserveOptionRows(store.europeanTable, europeans);
+    reserveOptionRows(store.americanTable, americans);
+
+    for (size_t i = 0; i < portfolio.size(); ++i) {
+        if (portfolio[i]) store.append(*portfolio[i], i);
+    }
+    return store;
+}
+
+TradeStore TradeStore::fromRecords(const std::vector<TradeRecord>& records,
+                                   TradeFactory& bondFactory,
+                                   TradeFactory& swapFactory,
+                                   TradeFactory& euroOptFactory,
+                                   TradeFactory& amerOptFactory) {
+    TradeStore store;
+    for (size_t i = 0; i < records.size(); ++i) {
+        const TradeRecord& record = records[i];
+        try {
+            std::shared_ptr<Trade> trade = buildTradeFromRecord(record, bondFactory, swapFactory, euroOptFactory, amerOptFactory);
+            if (!trade) {
+                std::cerr << "Warning: Unknown trade type '" << record.type << "' for trade " << record.id << ". Skipping." << std::endl;
+                continue;
+            }
+            store.append(*trade, i);
+        } catch (const std::exception& e) {
+            std::cerr << "Error creating trade " << record.id << ": " << e.what() << ". Skipping." << std::endl;
+        }
+    }
+    return store;
+}
+
+bool TradeStore::append(const Trade& trade, size_t sourceIndex) {
+    switch (trade.getKind()) {
+    case InstrumentKind::Bond: {
+        const Bond& bond = static_cast<const Bond&>(trade);
+        BondTable& t = bondTable;
+        t.sourceIndex.push_back(sourceIndex);
+        t.instrumentId.push_back(internName(bond.getUnderlyingName()));
+        t.discountCurveId.push_back(internName(bond.getRateCurveName()));
+        t.issueSerial.push_back(bond.getIssueDate().getSerialDate());
+        t.maturitySerial.push_back(bond.getMaturityDate().getSerialDate());
+        t.principal.push_back(bond.getPrincipal());
+        t.couponRate.push_back(bond.getCouponRate());
+        t.frequency.push_back(bond.getCouponFrequency());
+        const std::vector<long>& serials = bond.getCashflowSerials();
+        const std::vector<double>& amounts = bond.getCashflowAmounts();
+        t.cashflowSerials.insert(t.cashflowSerials.end(), serials.begin(), serials.end());
+        t.cashflowAmounts.insert(t.cashflowAmounts.end(), amounts.begin(), amounts.end());
+        t.cashflowBegin.push_back(t.cashflowSerials.size());
+        return true;
+    }
+    case InstrumentKind::Swap: {
+        const Swap& swap = static_cast<const Swap&>(trade);
+        SwapTable& t = swapTable;
+        t.sourceIndex.push_back(sourceIndex);
+        t.instrumentId.push_back(internName(swap.getUnderlyingName()));
+        t.discountCurveId.push_back(internName(swap.getRateCurveName()));
+        t.effectiveSerial.push_back(swap.getEffectiveDate().getSerialDate());
+        t.maturitySerial.push_back(swap.getMaturityDate().getSerialDate());
+        t.notional.push_back(swap.getNotional());
+        t.fixedRate.push_back(swap.getFixedRate());
+        t.frequency.push_back(swap.getPaymentFrequency());
+        for (const Date& d : swap.getFixedLegSchedule()) {
+            t.scheduleSerials.push_back(d.getSerialDate());
+        }
+        t.scheduleBegin.push_back(t.scheduleSerials.size());
+        return true;
+    }
+    case InstrumentKind::EuropeanOption:
+    case InstrumentKind::AmericanOption: {
+        const bool european = trade.getKind() == InstrumentKind::EuropeanOption;
+        OptionTable& t = european ? europeanTable : americanTable;
+        OptionType type;
+        double strike;
+        if (european) {
+            const EuropeanOption& opt = static_cast<const EuropeanOption&>(trade);
+            type = opt.getOptionType();
+            strike = opt.getStrike();
+        } else {
+            const AmericanOption& opt = static_cast<const AmericanOption&>(trade);
+            type = opt.getOptionType();
+            strike = opt.getStrike();
+        }
+        t.sourceIndex.push_back(sourceIndex);
+        t.optionType.push_back(type);
+        t.strike.push_back(strike);
+        t.expirySerial.push_back(trade.getMaturityDate().getSerialDate());
+        t.underlyingId.push_back(internName(trade.getUnderlyingName()));
+        t.discountCurveId.push_back(internName(trade.getRateCurveName()));
+        t.volCurveId.push_back(internName(trade.getVolCurveName()));
+        return true;
+    }
+    case InstrumentKind::Other:
+        break;
+    }
+    std::cerr << "Warning: TradeStore cannot hold trade type " << trade.getType() << ". Skipping." << std::endl;
+    return false;
+}
+
+size_t TradeStore::size() const {
+    return bondTable.size() + swapTable.size() + europeanTable.size() + americanTable.size();
+}
+
+uint32_t TradeStore::internName(const std::string& name) {
+    auto it = nameIds.find(name);
+    if (it != nameIds.end()) return it->second;
+    const uint32_t id = static_cast<uint32_t>(names.size());
+    names.push_back(name);
+    marketIds.push_back(internMarketDataName(name));
+    nameIds.emplace(name, id);
+    return id;
+}
+
+std::vector<const RateCurve*> TradeStore::resolveRateCurves(const Market& mkt, const ArenaColumn<uint32_t>& ids) const {
+    std::vector<const RateCurve*> curves(names.size(), nullptr);
+    std::vector<char> resolved(names.size(), 0);
+    for (uint32_t id : ids) {
+        if (resolved[id]) continue;
+        resolved[id] = 1;
+        std::shared_ptr<const RateCurve> curve = mkt.getCurve(marketIds[id]);
+        if (curve && !curve->isEmpty()) curves[id] = curve.get(); // Owned by mkt for the pricing call
+    }
+    return curves;
+}
+
+std::vector<const VolCurve*> TradeStore::resolveVolCurves(const Market& mkt, const ArenaColumn<uint32_t>& ids) const {
+    std::vector<const VolCurve*> curves(names.size(), nullptr);
+    std::vector<char> resolved(names.size(), 0);
+    for (uint32_t id : ids) {
+        if (resolved[id]) continue;
+        resolved[id] = 1;
+        std::shared_ptr<const VolCurve> curve = mkt.getVolCurve(marketIds[id]);
+        if (curve && !curve->isEmpty()) curves[id] = curve.get();
+    }
+    return curves;
+}
+
+void TradeStore::priceBonds(const Market& mkt, double* pvs) const {
+    const BondTable& t = bondTable;
+    const long asOfSerial = mkt.asOf.getSerialDate();
+    const std::vector<const RateCurve*> curves = resolveRateCurves(mkt, t.discountCurveId);
+    std::vector<double> discountFactors;
+
+    for (size_t i = 0; i < t.size(); ++i) {
+        if (asOfSerial >= t.maturitySerial[i]) {
+            pvs[i] = 0.0;
+            continue;
+        }
+        const RateCurve* curve = curves[t.discountCurveId[i]];
+        if (!curve) {
+            std::cerr << "Error: Discount curve '" << names[t.discountCurveId[i]] << "' not found or empty in market for bond "
+                      << names[t.instrumentId[i]] << std::endl;
+            pvs[i] = 0.0;
+            continue;
+        }
+        // Same flows and discounting as Bond::Pv: strictly after the valuation date.
+        const long* begin = t.cashflowSerials.data() + t.cashflowBegin[i];
+        const long* end = t.cashflowSerials.data() + t.cashflowBegin[i + 1];
+        const long* first = std::upper_bound(begin, end, asOfSerial);
+        const size_t n = static_cast<size_t>(end - first);
+        if (discountFactors.size() < n) discountFactors.resize(n);
+        curve->getDiscountFactors(asOfSerial, first, discountFactors.data(), n);
+
+        const double* amounts = t.cashflowAmounts.data() + (first - t.cashflowSerials.data());
+        double pv = 0.0;
+        for (size_t k = 0; k < n; ++k) {
+            pv += amounts[k] * discountFactors[k];
+        }
+        pvs[i] = pv;
+    }
+}
+
+void TradeStore::priceSwaps(const Market& mkt, double* pvs) const {
+    const SwapTable& t = swapTable;
+    const long asOfSerial = mkt.asOf.getSerialDate();
+    const std::vector<const RateCurve*> curves = resolveRateCurves(mkt, t.discountCurveId);
+
+    for (size_t i = 0; i < t.size(); ++i) {
+        const size_t begin = t.scheduleBegin[i];
+        const size_t end = t.scheduleBegin[i + 1];
+        if (asOfSerial >= t.maturitySerial[i] || end - begin < 2) {
+            pvs[i] = 0.0;
+            continue;
+        }
+        const RateCurve* curve = curves[t.discountCurveId[i]];
+        if (!curve) {
+            std::cerr << "Error: Discount curve '" << names[t.discountCurveId[i]] << "' not found or empty for Swap PV." << std::endl;
+            pvs[i] = 0.0;
+            continue;
+        }
+        const CompiledCurve& compiled = curve->getCompiled();
+        const double notional = t.notional[i];
+
+        // Same period loop as Swap::Pv.
+        double fixedLegPv = 0.0;
+        for (size_t k = begin + 1; k < end; ++k) {
+            const long periodStart = t.scheduleSerials[k - 1];
+            const long periodEnd = t.scheduleSerials[k];
+            if (periodEnd <= asOfSerial) continue;
+
+            const double tau = static_cast<double>(periodEnd - periodStart) / 360.0;
+            if (tau <= 1e-9) continue;
+
+            const double timeToPayment = static_cast<double>(periodEnd - asOfSerial) / 365.0;
+            const double df = std::exp(-compiled.valueAt(periodEnd) * timeToPayment);
+            fixedLegPv += notional * t.fixedRate[i] * tau * df;
+        }
+
+        const long maturity = t.maturitySerial[i];
+        const double timeToMaturity = static_cast<double>(maturity - asOfSerial) / 365.0;
+        const double dfMaturity = std::exp(-compiled.valueAt(maturity) * timeToMaturity);
+        const double floatingLegPv = (-notional) + (notional * dfMaturity);
+        pvs[i] = fixedLegPv + floatingLegPv;
+    }
+}
+
+void TradeStore::priceEuropeans(const Market& mkt, double* pvs) const {
+    const OptionTable& t = europeanTable;
+    const long asOfSerial = mkt.asOf.getSerialDate();
+    const std::vector<const RateCurve*> rateCurves = resolveRateCurves(mkt, t.discountCurveId);
+    const std::vector<const VolCurve*> volCurves = resolveVolCurves(mkt, t.volCurveId);
+
+    // Spots resolved once per underlying; a missing one is reported once by Market.
+    std::vector<double> spots(names.size(), 0.0);
+    std::vector<char> spotResolved(names.size(), 0);
+
+    // Regular rows are gathered for one blackScholesBatch call; the rest are priced in place.
+    std::vector<size_t> rows;
+    std::vector<OptionType> types;
+    std::vector<double> S, K, T, r, sigma;
+    rows.reserve(t.size());
+
+    for (size_t i = 0; i < t.size(); ++i) {
+        const RateCurve* rateCurve = rateCurves[t.discountCurveId[i]];
+        const VolCurve* volCurve = volCurves[t.volCurveId[i]];
+        if (!rateCurve) {
+            std::cerr << "Error: Rate curve '" << names[t.discountCurveId[i]] << "' not found or empty for BS pricing of "
+                      << names[t.underlyingId[i]] << std::endl;
+            pvs[i] = 0.0;
+            continue;
+        }
+        if (!volCurve) {
+            std::cerr << "Error: Vol curve '" << names[t.volCurveId[i]] << "' not found or empty for BS pricing of "
+                      << names[t.underlyingId[i]] << std::endl;
+            pvs[i] = 0.0;
+            continue;
+        }
+
+        const uint32_t underlying = t.underlyingId[i];
+        if (!spotResolved[underlying]) {
+            spotResolved[underlying] = 1;
+            spots[underlying] = std::max(0.0, mkt.getStockPrice(marketIds[underlying]));
+        }
+        const double spot = spots[underlying];
+        const double strike = t.strike[i];
+        const long expiry = t.expirySerial[i];
+        if (asOfSerial >= expiry) {
+            pvs[i] = PAYOFF::VanillaOption(t.optionType[i], strike, spot);
+            continue;
+        }
+
+        const double tau = static_cast<double>(expiry - asOfSerial) / 365.0;
+        const double rate = rateCurve->getCompiled().valueAt(expiry);
+        const double vol = volCurve->getCompiled().valueAt(expiry);
+        const OptionType type = t.optionType[i];
+        if (spot <= 1e-9 || vol <= 1e-9 || tau <= 1e-9 || strike <= 1e-9 ||
+            (type != OptionType::Call && type != OptionType::Put)) {
+            pvs[i] = EuropeanOption::BlackScholesPv(type, spot, strike, tau, rate, vol);
+            continue;
+        }
+        rows.push_back(i);
+        types.push_back(type);
+        S.push_back(spot);
+        K.push_back(strike);
+        T.push_back(tau);
+        r.push_back(rate);
+        sigma.push_back(vol);
+    }
+
+    if (rows.empty()) return;
+    std::vector<double> prices(rows.size());
+    BlackScholesBatchInput in;
+    in.type = types.data();
+    in.S = S.data();
+    in.K = K.data();
+    in.T = T.data();
+    in.r = r.data();
+    in.sigma = sigma.data();
+    in.n = rows.size();
+    BlackScholesBatchOutput out;
+    out.price = prices.data();
+    blackScholesBatch(in, out);
+    for (size_t k = 0; k < rows.size(); ++k) {
+        pvs[rows[k]] = prices[k];
+    }
+}
+
+void TradeStore::priceAmericans(const Market& mkt, const BinomialTreePricer& treePricer, double* pvs) const {
+    // Early exercise needs the lattice; each row goes to the American kernel straight from its columns.
+    const OptionTable& t = americanTable;
+    TreeInputs inputs;
+    inputs.option.exercise = ExerciseStyle::American;
+    for (size_t i = 0; i < t.size(); ++i) {
+        inputs.expiry.setFromSerial(t.expirySerial[i]);
+        inputs.underlyingId = marketIds[t.underlyingId[i]];
+        inputs.rateCurveId = marketIds[t.discountCurveId[i]];
+        inputs.volCurveId = marketIds[t.volCurveId[i]];
+        inputs.option.type = t.optionType[i];
+        inputs.option.strike = t.strike[i];
+        pvs[i] = treePricer.PriceOption(mkt, inputs);
+    }
+}
+
+void TradeStore::priceAll(const Market& mkt, const BinomialTreePricer& treePricer, double* pvsBySource) const {
+    std::vector<double> pvs;
+    auto scatter = [&](const ArenaColumn<size_t>& sourceIndex) {
+        for (size_t i = 0; i < sourceIndex.size(); ++i) {
+            pvsBySource[sourceIndex[i]] = pvs[i];
+        }
+    };
+
+    pvs.assign(bondTable.size(), 0.0);
+    priceBonds(mkt, pvs.data());
+    scatter(bondTable.sourceIndex);
+
+    pvs.assign(swapTable.size(), 0.0);
+    priceSwaps(mkt, pvs.data());
+    scatter(swapTable.sourceIndex);
+
+    pvs.assign(europeanTable.size(), 0.0);
+    priceEuropeans(mkt, pvs.data());
+    scatter(europeanTable.sourceIndex);
+
+    pvs.assign(americanTable.size(), 0.0);
+    priceAmericans(mkt, treePricer, pvs.data());
+    scatter(americanTable.sourceIndex);
+}
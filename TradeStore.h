@@ -0,0 +1,141 @@
+#ifndef TRADE_STORE_H
+#define TRADE_STORE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <memory_resource>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "Market.h"
+#include "Trade.h"
+#include "TradeFactory.h"
+#include "TradeLoader.h"
+#include "Pricer.h"
+#include "Types.h"
+
+// Columns live in the store's arena (a monotonic buffer): appends are pointer bumps and the
+// whole store is released at once.
+template <typename T>
+using ArenaColumn = std::pmr::vector<T>;
+
+// Row i of every table refers to the trade at sourceIndex[i] of the portfolio it was built from.
+// Name columns (instrument, underlying, curves) hold ids from TradeStore::nameOf.
+
+struct BondTable {
+    explicit BondTable(std::pmr::memory_resource* arena);
+    size_t size() const { return sourceIndex.size(); }
+
+    ArenaColumn<size_t> sourceIndex;
+    ArenaColumn<uint32_t> instrumentId;
+    ArenaColumn<uint32_t> discountCurveId;
+    ArenaColumn<long> issueSerial;
+    ArenaColumn<long> maturitySerial;
+    ArenaColumn<double> principal;
+    ArenaColumn<double> couponRate;
+    ArenaColumn<int> frequency;
+    // Flattened Bond cashflow schedules: row i owns [cashflowBegin[i], cashflowBegin[i + 1]).
+    ArenaColumn<size_t> cashflowBegin; // size() + 1 entries
+    ArenaColumn<long> cashflowSerials;
+    ArenaColumn<double> cashflowAmounts;
+};
+
+struct SwapTable {
+    explicit SwapTable(std::pmr::memory_resource* arena);
+    size_t size() const { return sourceIndex.size(); }
+
+    ArenaColumn<size_t> sourceIndex;
+    ArenaColumn<uint32_t> instrumentId;
+    ArenaColumn<uint32_t> discountCurveId;
+    ArenaColumn<long> effectiveSerial;
+    ArenaColumn<long> maturitySerial;
+    ArenaColumn<double> notional;
+    ArenaColumn<double> fixedRate;
+    ArenaColumn<int> frequency;
+    // Flattened fixed-leg schedules (period boundaries): row i owns [scheduleBegin[i], scheduleBegin[i + 1]).
+    ArenaColumn<size_t> scheduleBegin; // size() + 1 entries
+    ArenaColumn<long> scheduleSerials;
+};
+
+// Shared layout of the European and American option tables.
+struct OptionTable {
+    explicit OptionTable(std::pmr::memory_resource* arena);
+    size_t size() const { return sourceIndex.size(); }
+
+    ArenaColumn<size_t> sourceIndex;
+    ArenaColumn<OptionType> optionType;
+    ArenaColumn<double> strike;
+    ArenaColumn<long> expirySerial;
+    ArenaColumn<uint32_t> underlyingId;
+    ArenaColumn<uint32_t> discountCurveId;
+    ArenaColumn<uint32_t> volCurveId;
+};
+
+// Columnar, arena-backed copy of a portfolio: one table per instrument kind, with strikes,
+// dates, notionals and curve ids in contiguous arrays. Built from Trade objects (e.g. straight
+// out of the TradeFactory classes) and priced table by table, so large books can be streamed
+// through the batch kernels (blackScholesBatch, discount factor batches) without pointer chasing.
+// Trades of InstrumentKind::Other are not representable and are reported by append().
+class TradeStore {
+public:
+    explicit TradeStore(size_t initialArenaBytes = 1 << 20);
+
+    TradeStore(const TradeStore&) = delete;
+    TradeStore& operator=(const TradeStore&) = delete;
+    TradeStore(TradeStore&&) = default;
+    // Not assignable: the target's columns would outlive the arena they were allocated from.
+    TradeStore& operator=(TradeStore&&) = delete;
+
+    // Null entries and InstrumentKind::Other trades are skipped (their pvs stay untouched).
+    static TradeStore fromPortfolio(const std::vector<std::shared_ptr<Trade>>& portfolio);
+
+    // Builds each record through the factories and keeps only its columns, so no Trade
+    // objects outlive the call. sourceIndex is the record index. Records that fail to build
+    // are reported on std::cerr and skipped.
+    static TradeStore fromRecords(const std::vector<TradeRecord>& records,
+                                  TradeFactory& bondFactory,
+                                  TradeFactory& swapFactory,
+                                  TradeFactory& euroOptFactory,
+                                  TradeFactory& amerOptFactory);
+
+    // Appends one trade as row of the table for its kind. Returns false for InstrumentKind::Other.
+    bool append(const Trade& trade, size_t sourceIndex);
+
+    size_t size() const;
+    const BondTable& bonds() const { return bondTable; }
+    const SwapTable& swaps() const { return swapTable; }
+    const OptionTable& europeans() const { return europeanTable; }
+    const OptionTable& americans() const { return americanTable; }
+
+    uint32_t internName(const std::string& name);
+    const std::string& nameOf(uint32_t id) const { return names[id]; }
+
+    // Table pricers, pvs indexed by row. Results equal Trade::Pv of the source trades.
+    void priceBonds(const Market& mkt, double* pvs) const;
+    void priceSwaps(const Market& mkt, double* pvs) const;
+    void priceEuropeans(const Market& mkt, double* pvs) const; // Closed form, via blackScholesBatch
+    void priceAmericans(const Market& mkt, const BinomialTreePricer& treePricer, double* pvs) const;
+
+    // Prices every table and scatters the results to pvsBySource[sourceIndex]; the array must
+    // cover the largest sourceIndex. Trees use treePricer.
+    void priceAll(const Market& mkt, const BinomialTreePricer& treePricer, double* pvsBySource) const;
+
+private:
+    // Curve pointers for every interned name, resolved once per pricing call.
+    std::vector<const RateCurve*> resolveRateCurves(const Market& mkt, const ArenaColumn<uint32_t>& ids) const;
+    std::vector<const VolCurve*> resolveVolCurves(const Market& mkt, const ArenaColumn<uint32_t>& ids) const;
+
+    std::unique_ptr<std::pmr::monotonic_buffer_resource> arena; // Heap-held so tables can move
+    BondTable bondTable;
+    SwapTable swapTable;
+    OptionTable europeanTable;
+    OptionTable americanTable;
+
+    std::vector<std::string> names;
+    std::vector<MarketDataId> marketIds; // marketIds[id]: the process-wide ID of names[id], for Market lookups
+    std::unordered_map<std::string, uint32_t> nameIds;
+};
+
+#endif // TRADE_STORE_H
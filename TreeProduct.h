@@ -3,16 +3,17 @@
 
 #include "Date.h"
 #include "Trade.h" // Trade::getUnderlyingName() is virtual here
+#include "Types.h" // OptionType
 #include <string> 
 
 class TreeProduct: public Trade
 {
 public:
-    TreeProduct(): Trade(), underlying("") { 
+    TreeProduct(): Trade(), underlying(""), underlyingId(internMarketDataName(underlying)) { 
         tradeType = "TreeProduct"; // Set tradeType from base Trade class
     }
     TreeProduct(const std::string& underlyingInstrument) 
-        : Trade(), underlying(underlyingInstrument) { 
+        : Trade(), underlying(underlyingInstrument), underlyingId(internMarketDataName(underlying)) { 
         tradeType = "TreeProduct";
         // Ensure the underlyingName in the base Trade part is also set if it's used anywhere,
         // though direct access to TreeProduct::underlying is better for options.
@@ -23,14 +24,21 @@ public:
     virtual const Date& GetExpiry() const = 0;
     virtual double ValueAtNode(double stockPrice, double t, double continuationValue) const = 0;
 
+    // Strike and payoff type for strike-aware lattices (Leisen-Reimer centring, the
+    // binomial Black-Scholes last step); products without them keep the defaults.
+    virtual double getStrike() const { return 0.0; }
+    virtual OptionType getOptionType() const { return None; }
+
     // This is the direct accessor for TreeProduct's own underlying string.
     const std::string& getUnderlying() const { return underlying; }
 
     // Override Trade's virtual function to return the correct underlying name.
     std::string getUnderlyingName() const override { return underlying; }
+    MarketDataId getUnderlyingId() const override { return underlyingId; }
 
 protected: 
     std::string underlying;
+    MarketDataId underlyingId;
 };
 
 #endif // _TREE_PRODUCT_H
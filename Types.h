@@ -10,6 +10,16 @@ enum OptionType
     None // Ensure this is present for non-options
 };
 
+// Concrete instrument family of a Trade, so pricers can dispatch on a tag instead of RTTI.
+enum class InstrumentKind
+{
+    Bond,
+    Swap,
+    EuropeanOption,
+    AmericanOption,
+    Other // Any other Trade/TreeProduct subclass; priced through the generic path
+};
+
 #endif // TYPES_H
 
 //Updated Again
@@ -0,0 +1,725 @@
+// Benchmark harness for the pricing stack.
+//
+// Generates a synthetic market and portfolio (Bond/Swap/EuropeanOption/AmericanOption built
+// through the TradeFactory classes), times the main entry points and writes a JSON report
+// that can be diffed across versions. Build from the repository root, e.g.
+//
+//   g++ -std=c++17 -O2 -pthread -I. bench/Benchmark.cpp $(ls *.cpp | grep -v '^main.cpp$') -o pricing_bench
+//
+// Usage:
+//   pricing_bench [--trades N] [--mix bond,swap,euro,amer] [--steps 50,200,1000]
+//                 [--samples N] [--underlyings N] [--seed S] [--out bench_report.json]
+//
+// --trades     portfolio size (1k .. 10M); analytic pricing and loading run over all of it
+// --mix        relative weights of the four trade types (default 40,30,20,10)
+// --steps      CRR tree step counts to benchmark
+// --samples    cap on operations for the expensive benchmarks (trees, risk, market copy)
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "Date.h"
+#include "Market.h"
+#include "Trade.h"
+#include "TradeFactory.h"
+#include "TradeLoader.h"
+#include "TradeStore.h"
+#include "Pricer.h"
+#include "TreeProduct.h"
+#include "AmericanTrade.h"
+#include "RiskEngine.h"
+#include "MonteCarloPricer.h"
+#include "MarketSnapshot.h"
+#include "ScenarioEngine.h"
+#include "ThreadPool.h"
+#include "Types.h"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+struct BenchConfig {
+    size_t trades = 10000;
+    double mix[4] = {40.0, 30.0, 20.0, 10.0}; // bond, swap, european, american
+    std::vector<int> steps = {50, 200, 1000};
+    size_t samples = 2000;
+    size_t underlyings = 50;
+    uint64_t seed = 42;
+    std::string out = "bench_report.json";
+};
+
+// One row of the report. Latencies are per operation, in microseconds.
+struct BenchResult {
+    std::string name;
+    std::string params;
+    size_t ops = 0;
+    double totalSeconds = 0.0;
+    double opsPerSecond = 0.0;
+    double p50 = 0.0;
+    double p90 = 0.0;
+    double p99 = 0.0;
+    double max = 0.0;
+};
+
+// Collects per-operation timings and reduces them to a BenchResult.
+class LatencyRecorder {
+public:
+    explicit LatencyRecorder(size_t expected) { nanos.reserve(expected); }
+
+    template <typename F>
+    void time(F&& op) {
+        const Clock::time_point start = Clock::now();
+        op();
+        nanos.push_back(std::chrono::duration<double, std::nano>(Clock::now() - start).count());
+    }
+
+    BenchResult summarize(const std::string& name, const std::string& params, size_t opsPerSample = 1) {
+        BenchResult result;
+        result.name = name;
+        result.params = params;
+        result.ops = nanos.size() * opsPerSample;
+        if (nanos.empty()) {
+            return result;
+        }
+        double total = 0.0;
+        for (double ns : nanos) total += ns;
+        result.totalSeconds = total * 1e-9;
+        result.opsPerSecond = (total > 0.0) ? static_cast<double>(result.ops) / result.totalSeconds : 0.0;
+        std::sort(nanos.begin(), nanos.end());
+        auto percentile = [this](double q) {
+            const size_t idx = std::min(nanos.size() - 1, static_cast<size_t>(q * static_cast<double>(nanos.size())));
+            return nanos[idx] * 1e-3;
+        };
+        result.p50 = percentile(0.50);
+        result.p90 = percentile(0.90);
+        result.p99 = percentile(0.99);
+        result.max = nanos.back() * 1e-3;
+        return result;
+    }
+
+private:
+    std::vector<double> nanos;
+};
+
+// Deterministic description of one synthetic trade; used both to build the Trade and to
+// write the equivalent trade.txt line for the loading benchmark.
+struct TradeSpec {
+    InstrumentKind kind = InstrumentKind::Bond;
+    std::string instrument;
+    long startSerial = 0;
+    long endSerial = 0;
+    double notional = 0.0;
+    double rateOrStrike = 0.0;
+    int frequency = 0;
+    OptionType optionType = OptionType::None;
+    std::string discountCurve;
+    std::string volCurve;
+};
+
+const char* const kRateCurves[] = {"USD-SOFR", "EUR-ESTR", "GBP-SONIA", "SGD-SORA"};
+const int kPillarDays[] = {30, 91, 182, 365, 730, 1095, 1826, 2557, 3652, 5479, 7305, 10957};
+
+Date dateFromSerial(long serial) {
+    Date d;
+    d.setFromSerial(serial);
+    return d;
+}
+
+std::string underlyingName(size_t i) {
+    std::ostringstream os;
+    os << "STK" << std::setw(4) << std::setfill('0') << i;
+    return os.str();
+}
+
+Market buildSyntheticMarket(const Date& asOf, const BenchConfig& config, std::mt19937_64& rng) {
+    std::uniform_real_distribution<double> unit(0.0, 1.0);
+    Market market(asOf, "BenchMarket");
+    for (const char* curveName : kRateCurves) {
+        auto curve = std::make_shared<RateCurve>(curveName);
+        const double level = 0.01 + 0.04 * unit(rng);
+        for (size_t k = 0; k < sizeof(kPillarDays) / sizeof(kPillarDays[0]); ++k) {
+            curve->addRate(dateFromSerial(asOf.getSerialDate() + kPillarDays[k]), level + 0.001 * k * unit(rng));
+        }
+        market.addCurve(curveName, curve);
+    }
+    for (size_t i = 0; i < config.underlyings; ++i) {
+        const std::string name = underlyingName(i);
+        market.addStockPrice(name, 20.0 + 480.0 * unit(rng));
+        auto vol = std::make_shared<VolCurve>("VOL_" + name);
+        const double level = 0.15 + 0.35 * unit(rng);
+        for (size_t k = 0; k < sizeof(kPillarDays) / sizeof(kPillarDays[0]); ++k) {
+            vol->addVol(dateFromSerial(asOf.getSerialDate() + kPillarDays[k]), level + 0.01 * unit(rng));
+        }
+        market.addVolCurve("VOL_" + name, vol);
+    }
+    return market;
+}
+
+std::vector<TradeSpec> generateSpecs(const Date& asOf, const Market& market, const BenchConfig& config,
+                                     std::mt19937_64& rng) {
+    std::uniform_real_distribution<double> unit(0.0, 1.0);
+    std::discrete_distribution<int> kindPick(std::begin(config.mix), std::end(config.mix));
+    const InstrumentKind kinds[] = {InstrumentKind::Bond, InstrumentKind::Swap,
+                                    InstrumentKind::EuropeanOption, InstrumentKind::AmericanOption};
+    const int frequencies[] = {1, 2, 4};
+    const long asOfSerial = asOf.getSerialDate();
+
+    std::vector<TradeSpec> specs(config.trades);
+    for (size_t i = 0; i < specs.size(); ++i) {
+        TradeSpec& s = specs[i];
+        s.kind = kinds[kindPick(rng)];
+        s.startSerial = asOfSerial;
+        s.discountCurve = kRateCurves[rng() % (sizeof(kRateCurves) / sizeof(kRateCurves[0]))];
+        if (s.kind == InstrumentKind::Bond || s.kind == InstrumentKind::Swap) {
+            s.instrument = (s.kind == InstrumentKind::Bond) ? "BOND" + std::to_string(i) : "SWAP" + std::to_string(i);
+            s.endSerial = asOfSerial + 365 * (1 + static_cast<long>(rng() % 30));
+            s.notional = 1e6 * (1.0 + 99.0 * unit(rng)) * ((s.kind == InstrumentKind::Swap && (rng() & 1)) ? -1.0 : 1.0);
+            s.rateOrStrike = 0.005 + 0.05 * unit(rng);
+            s.frequency = frequencies[rng() % 3];
+        } else {
+            const size_t u = static_cast<size_t>(rng() % std::max<size_t>(config.underlyings, 1));
+            s.instrument = underlyingName(u);
+            s.endSerial = asOfSerial + 30 + static_cast<long>(rng() % 1800);
+            s.notional = 1.0;
+            s.rateOrStrike = market.getStockPrice(s.instrument) * (0.7 + 0.6 * unit(rng));
+            s.optionType = (rng() & 1) ? OptionType::Call : OptionType::Put;
+            s.volCurve = "VOL_" + s.instrument;
+        }
+    }
+    return specs;
+}
+
+struct Factories {
+    BondFactory bond;
+    SwapFactory swap;
+    EuropeanOptionFactory euro;
+    AmericanOptionFactory amer;
+
+    TradeFactory& forKind(InstrumentKind kind) {
+        switch (kind) {
+            case InstrumentKind::Bond: return bond;
+            case InstrumentKind::Swap: return swap;
+            case InstrumentKind::EuropeanOption: return euro;
+            default: return amer;
+        }
+    }
+};
+
+std::shared_ptr<Trade> buildTrade(const TradeSpec& s, const Date& asOf, Factories& factories) {
+    return factories.forKind(s.kind).createTrade(s.instrument, asOf, dateFromSerial(s.startSerial),
+                                                 dateFromSerial(s.endSerial), s.notional, s.rateOrStrike,
+                                                 s.frequency, s.optionType, s.discountCurve, s.volCurve,
+                                                 s.discountCurve);
+}
+
+void writeTradeFile(const std::string& path, const std::vector<TradeSpec>& specs, const Date& asOf) {
+    std::ofstream out(path);
+    if (!out.is_open()) {
+        throw std::runtime_error("Could not open '" + path + "' for writing.");
+    }
+    out << std::setprecision(10);
+    out << "id;type;trade_dt;start_dt;end_dt;notional;instrument;rate;strike;freq;option_type;discount_curve;vol_curve\n";
+    for (size_t i = 0; i < specs.size(); ++i) {
+        const TradeSpec& s = specs[i];
+        const bool isOption = (s.kind == InstrumentKind::EuropeanOption || s.kind == InstrumentKind::AmericanOption);
+        const char* type = (s.kind == InstrumentKind::Bond) ? "bond"
+                         : (s.kind == InstrumentKind::Swap) ? "swap"
+                         : (s.kind == InstrumentKind::EuropeanOption) ? "european" : "american";
+        out << i << ';' << type << ';' << asOf.toString() << ';' << dateFromSerial(s.startSerial).toString() << ';'
+            << dateFromSerial(s.endSerial).toString() << ';' << s.notional << ';' << s.instrument << ';';
+        if (isOption) {
+            out << ';' << s.rateOrStrike << ";;" << (s.optionType == OptionType::Call ? "call" : "put") << ';';
+        } else {
+            out << s.rateOrStrike << ";;" << s.frequency << ";none;";
+        }
+        out << s.discountCurve << ';' << s.volCurve << '\n';
+    }
+}
+
+// Every 'stride'-th trade of the given kind, at most 'limit' of them.
+std::vector<std::shared_ptr<Trade>> sampleOfKind(const std::vector<std::shared_ptr<Trade>>& portfolio,
+                                                 InstrumentKind kind, size_t limit) {
+    std::vector<std::shared_ptr<Trade>> all;
+    for (const auto& t : portfolio) {
+        if (t && t->getKind() == kind) all.push_back(t);
+    }
+    if (all.size() <= limit) return all;
+    std::vector<std::shared_ptr<Trade>> picked;
+    picked.reserve(limit);
+    const double stride = static_cast<double>(all.size()) / static_cast<double>(limit);
+    for (size_t i = 0; i < limit; ++i) picked.push_back(all[static_cast<size_t>(i * stride)]);
+    return picked;
+}
+
+const char* kindName(InstrumentKind kind) {
+    switch (kind) {
+        case InstrumentKind::Bond: return "Bond";
+        case InstrumentKind::Swap: return "Swap";
+        case InstrumentKind::EuropeanOption: return "EuropeanOption";
+        case InstrumentKind::AmericanOption: return "AmericanOption";
+        default: return "Other";
+    }
+}
+
+std::vector<int> parseIntList(const std::string& text) {
+    std::vector<int> values;
+    std::stringstream ss(text);
+    std::string item;
+    while (std::getline(ss, item, ',')) {
+        if (!item.empty()) values.push_back(std::stoi(item));
+    }
+    return values;
+}
+
+BenchConfig parseArgs(int argc, char** argv) {
+    BenchConfig config;
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        auto next = [&]() -> std::string {
+            if (i + 1 >= argc) throw std::invalid_argument("Missing value for " + arg);
+            return argv[++i];
+        };
+        if (arg == "--trades") {
+            config.trades = static_cast<size_t>(std::stoull(next()));
+        } else if (arg == "--mix") {
+            const std::vector<int> weights = parseIntList(next());
+            if (weights.size() != 4) throw std::invalid_argument("--mix expects four weights: bond,swap,euro,amer");
+            for (int k = 0; k < 4; ++k) config.mix[k] = weights[k];
+        } else if (arg == "--steps") {
+            config.steps = parseIntList(next());
+        } else if (arg == "--samples") {
+            config.samples = static_cast<size_t>(std::stoull(next()));
+        } else if (arg == "--underlyings") {
+            config.underlyings = static_cast<size_t>(std::stoull(next()));
+        } else if (arg == "--seed") {
+            config.seed = std::stoull(next());
+        } else if (arg == "--out") {
+            config.out = next();
+        } else {
+            throw std::invalid_argument("Unknown argument: " + arg);
+        }
+    }
+    if (config.trades == 0) throw std::invalid_argument("--trades must be positive");
+    if (config.samples == 0) config.samples = 1;
+    return config;
+}
+
+std::string jsonEscape(const std::string& s) {
+    std::string out;
+    for (char c : s) {
+        if (c == '"' || c == '\\') out += '\\';
+        out += c;
+    }
+    return out;
+}
+
+void writeReport(const std::string& path, const BenchConfig& config, const std::vector<BenchResult>& results) {
+    std::ofstream out(path);
+    if (!out.is_open()) {
+        throw std::runtime_error("Could not open report file '" + path + "'.");
+    }
+    out << std::setprecision(6) << std::fixed;
+    out << "{\n  \"schema\": 1,\n";
+    out << "  \"config\": {\"trades\": " << config.trades << ", \"mix\": [" << config.mix[0] << ", " << config.mix[1]
+        << ", " << config.mix[2] << ", " << config.mix[3] << "], \"samples\": " << config.samples
+        << ", \"underlyings\": " << config.underlyings << ", \"seed\": " << config.seed << "},\n";
+    out << "  \"host\": {\"hardware_threads\": " << std::thread::hardware_concurrency()
+#if defined(__VERSION__)
+        << ", \"compiler\": \"" << jsonEscape(__VERSION__) << "\""
+#endif
+#if defined(__AVX2__)
+        << ", \"avx2\": true"
+#else
+        << ", \"avx2\": false"
+#endif
+        << "},\n";
+    out << "  \"results\": [\n";
+    for (size_t i = 0; i < results.size(); ++i) {
+        const BenchResult& r = results[i];
+        out << "    {\"name\": \"" << jsonEscape(r.name) << "\", \"params\": \"" << jsonEscape(r.params)
+            << "\", \"ops\": " << r.ops << ", \"total_s\": " << r.totalSeconds
+            << ", \"ops_per_s\": " << r.opsPerSecond << ", \"latency_us\": {\"p50\": " << r.p50
+            << ", \"p90\": " << r.p90 << ", \"p99\": " << r.p99 << ", \"max\": " << r.max << "}}"
+            << (i + 1 < results.size() ? "," : "") << "\n";
+    }
+    out << "  ]\n}\n";
+}
+
+void printResult(const BenchResult& r) {
+    std::cout << std::left << std::setw(28) << r.name << std::setw(22) << r.params << std::right
+              << std::setw(10) << r.ops << std::setw(14) << std::setprecision(0) << r.opsPerSecond
+              << std::setprecision(2) << std::setw(11) << r.p50 << std::setw(11) << r.p99
+              << std::setw(12) << r.max << std::endl;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    try {
+        const BenchConfig config = parseArgs(argc, argv);
+        std::mt19937_64 rng(config.seed);
+        const Date asOf(2025, 1, 2); // Fixed so that reports are comparable across runs
+        std::vector<BenchResult> results;
+        std::cout << std::fixed;
+
+        Market market = buildSyntheticMarket(asOf, config, rng);
+        const std::vector<TradeSpec> specs = generateSpecs(asOf, market, config, rng);
+
+        Factories factories;
+        std::vector<std::shared_ptr<Trade>> portfolio;
+        portfolio.reserve(specs.size());
+        {
+            LatencyRecorder rec(specs.size());
+            for (const TradeSpec& s : specs) rec.time([&] { portfolio.push_back(buildTrade(s, asOf, factories)); });
+            results.push_back(rec.summarize("trade_construction", "factories"));
+        }
+
+        std::cout << std::left << std::setw(28) << "benchmark" << std::setw(22) << "params" << std::right
+                  << std::setw(10) << "ops" << std::setw(14) << "ops/s" << std::setw(11) << "p50(us)"
+                  << std::setw(11) << "p99(us)" << std::setw(12) << "max(us)" << std::endl;
+        printResult(results.back());
+
+        // Pricer::Price over the whole book for the closed-form kinds (the tree pricer routes
+        // Bond/Swap/European to their own Pv). American trades run through the tree section.
+        CRRBinomialTreePricer defaultPricer(50);
+        const InstrumentKind analyticKinds[] = {InstrumentKind::Bond, InstrumentKind::Swap, InstrumentKind::EuropeanOption};
+        for (InstrumentKind kind : analyticKinds) {
+            const auto trades = sampleOfKind(portfolio, kind, portfolio.size());
+            LatencyRecorder rec(trades.size());
+            double sink = 0.0;
+            for (const auto& t : trades) rec.time([&] { sink += defaultPricer.Price(market, *t); });
+            results.push_back(rec.summarize("pricer_price", kindName(kind)));
+            printResult(results.back());
+            if (std::isnan(sink)) std::cout << "(NaN PV encountered)" << std::endl;
+        }
+
+        // Same closed-form kinds through the columnar store, one table at a time.
+        {
+            LatencyRecorder buildRec(1);
+            std::unique_ptr<TradeStore> store;
+            buildRec.time([&] { store = std::make_unique<TradeStore>(TradeStore::fromPortfolio(portfolio)); });
+            results.push_back(buildRec.summarize("tradestore_build", "fromPortfolio", portfolio.size()));
+            printResult(results.back());
+
+            struct TablePricer {
+                InstrumentKind kind;
+                size_t rows;
+                std::function<void(double*)> price;
+            };
+            const TablePricer tables[] = {
+                {InstrumentKind::Bond, store->bonds().size(), [&](double* pvs) { store->priceBonds(market, pvs); }},
+                {InstrumentKind::Swap, store->swaps().size(), [&](double* pvs) { store->priceSwaps(market, pvs); }},
+                {InstrumentKind::EuropeanOption, store->europeans().size(), [&](double* pvs) { store->priceEuropeans(market, pvs); }},
+            };
+            std::vector<double> pvs;
+            for (const TablePricer& table : tables) {
+                pvs.assign(table.rows, 0.0);
+                LatencyRecorder rec(1);
+                rec.time([&] { table.price(pvs.data()); });
+                results.push_back(rec.summarize("tradestore_price", kindName(table.kind), table.rows));
+                printResult(results.back());
+            }
+        }
+
+        // CRR trees at each requested step count.
+        for (int n : config.steps) {
+            CRRBinomialTreePricer treePricer(n);
+            const InstrumentKind treeKinds[] = {InstrumentKind::EuropeanOption, InstrumentKind::AmericanOption};
+            for (InstrumentKind kind : treeKinds) {
+                const auto trades = sampleOfKind(portfolio, kind, config.samples);
+                LatencyRecorder rec(trades.size());
+                double sink = 0.0;
+                for (const auto& t : trades) {
+                    const auto* product = dynamic_cast<const TreeProduct*>(t.get());
+                    rec.time([&] { sink += treePricer.PriceTreeWithGreeks(market, *product).pv; });
+                }
+                results.push_back(rec.summarize("crr_tree", std::string(kindName(kind)) + " N=" + std::to_string(n)));
+                printResult(results.back());
+            }
+        }
+
+        // One backward induction through the product callbacks (priceOnLattice) against the
+        // kernel specialized for the product (priceOptionOnLattice), on the same CRR tree.
+        for (int n : config.steps) {
+            if (n < 1) continue;
+            TreeParams params;
+            params.N = n;
+            params.deltaT = 1.0 / n;
+            params.rate = 0.03;
+            params.vol = 0.2;
+            params.u = std::exp(params.vol * std::sqrt(params.deltaT));
+            params.d = 1.0 / params.u;
+            params.p_up = (std::exp(params.rate * params.deltaT) - params.d) / (params.u - params.d);
+            params.p_down = 1.0 - params.p_up;
+            params.df_step = std::exp(-params.rate * params.deltaT);
+            const InstrumentKind treeKinds[] = {InstrumentKind::EuropeanOption, InstrumentKind::AmericanOption};
+            for (InstrumentKind kind : treeKinds) {
+                const auto trades = sampleOfKind(portfolio, kind, config.samples);
+                LatencyRecorder callbacks(trades.size()), kernel(trades.size());
+                double sink = 0.0;
+                for (const auto& t : trades) {
+                    const auto& product = static_cast<const TreeProduct&>(*t);
+                    const double S0 = product.getStrike() > 0.0 ? product.getStrike() : 100.0;
+                    LatticeWorkspace& ws = LatticeWorkspace::forThisThread();
+                    callbacks.time([&] { sink += priceOnLattice(params, S0, product, ws); });
+                    LatticeOption option;
+                    if (latticeOptionFor(product, option)) {
+                        kernel.time([&] { sink -= priceOptionOnLattice(params, S0, option, ws); });
+                    }
+                }
+                const std::string label = std::string(kindName(kind)) + " N=" + std::to_string(n);
+                results.push_back(callbacks.summarize("lattice_callbacks", label));
+                printResult(results.back());
+                results.push_back(kernel.summarize("lattice_kernel", label));
+                printResult(results.back());
+                if (std::abs(sink) > 1e-9 * trades.size()) {
+                    std::cerr << "Warning: specialized lattice kernels differ from priceOnLattice by " << sink << std::endl;
+                }
+            }
+        }
+
+        // Smallest doubling step count at which each tree model prices sampled Europeans within
+        // 1e-4 of their closed form, and the per-trade cost at that count.
+        {
+            const double target = 1e-4;
+            const auto europeans = sampleOfKind(portfolio, InstrumentKind::EuropeanOption, 20);
+            std::vector<double> closedForm;
+            for (const auto& t : europeans) closedForm.push_back(t->Pv(market));
+            const std::pair<TreeModel, const char*> models[] = {
+                {TreeModel::CRR, "crr"}, {TreeModel::LeisenReimer, "lr"}, {TreeModel::BBSR, "bbsr"}};
+            for (const auto& model : models) {
+                int n = 8;
+                std::unique_ptr<BinomialTreePricer> pricer;
+                for (; n <= 8192; n *= 2) {
+                    pricer = makeTreePricer(model.first, n);
+                    double worst = 0.0;
+                    for (size_t k = 0; k < europeans.size(); ++k) {
+                        const auto* product = dynamic_cast<const TreeProduct*>(europeans[k].get());
+                        worst = std::max(worst, std::abs(pricer->PriceTree(market, *product) - closedForm[k]));
+                    }
+                    if (worst < target) break;
+                }
+                LatencyRecorder rec(europeans.size());
+                double sink = 0.0;
+                for (const auto& t : europeans) {
+                    const auto* product = dynamic_cast<const TreeProduct*>(t.get());
+                    rec.time([&] { sink += pricer->PriceTree(market, *product); });
+                }
+                const std::string reached = (n <= 8192) ? " N=" + std::to_string(n) : " N>8192";
+                results.push_back(rec.summarize("tree_to_1e-4", std::string(model.second) + reached));
+                printResult(results.back());
+            }
+        }
+
+        // A 32-strike ladder of Americans on one underlying and expiry through PriceBatch, with
+        // one tree per trade and with strip pricing (one lattice, one lane per strike).
+        {
+            const auto americans = sampleOfKind(portfolio, InstrumentKind::AmericanOption, 1);
+            if (!americans.empty()) {
+                const auto& base = static_cast<const TreeProduct&>(*americans.front());
+                const double spot = market.getStockPrice(base.getUnderlyingName());
+                std::vector<std::unique_ptr<AmericanOption>> ladder;
+                std::vector<const Trade*> batch;
+                for (int k = 0; k < 32; ++k) {
+                    ladder.push_back(std::make_unique<AmericanOption>(
+                        (k % 2) ? Put : Call, spot * (0.7 + 0.02 * k), base.GetExpiry(), base.getUnderlyingName(),
+                        base.getRateCurveName(), base.getVolCurveName()));
+                    batch.push_back(ladder.back().get());
+                }
+                std::vector<double> pvs(batch.size());
+                for (int n : config.steps) {
+                    for (bool strip : {false, true}) {
+                        CRRBinomialTreePricer pricer(n);
+                        pricer.setStripPricing(strip);
+                        LatencyRecorder rec(config.samples);
+                        for (size_t i = 0; i < config.samples; ++i) {
+                            rec.time([&] { pricer.PriceBatch(market, batch.data(), batch.size(), pvs.data()); });
+                        }
+                        results.push_back(rec.summarize(strip ? "tree_strip" : "tree_per_trade",
+                                                        "32 strikes N=" + std::to_string(n), batch.size()));
+                        printResult(results.back());
+                    }
+                }
+            }
+        }
+
+        // Monte Carlo: a sampled European (vanilla control) and a 12-date arithmetic Asian on its
+        // underlying, pseudo-random vs Sobol' with antithetics, 2^16 samples each on 4 threads.
+        {
+            const auto europeans = sampleOfKind(portfolio, InstrumentKind::EuropeanOption, 1);
+            if (!europeans.empty()) {
+                const auto& option = static_cast<const TreeProduct&>(*europeans.front());
+                PathContract asian;
+                asian.underlying = option.getUnderlyingName();
+                asian.rateCurve = option.getRateCurveName();
+                asian.volCurve = option.getVolCurveName();
+                asian.expiry = option.GetExpiry();
+                asian.monitoringDates = 12;
+                asian.controlType = Call;
+                asian.controlStrike = option.getStrike();
+                const double strike = option.getStrike();
+                asian.payoff = [strike](const double* spots, int n) {
+                    double sum = 0.0;
+                    for (int i = 0; i < n; ++i) sum += spots[i];
+                    return std::max(sum / n - strike, 0.0);
+                };
+                ThreadPool mcPool(4);
+                const std::pair<MonteCarloSampler, const char*> samplers[] = {
+                    {MonteCarloSampler::Pseudo, "pseudo"}, {MonteCarloSampler::Sobol, "sobol"}};
+                for (const auto& sampler : samplers) {
+                    MonteCarloSettings mcSettings;
+                    mcSettings.sampler = sampler.first;
+                    mcSettings.maxPaths = 1 << 16;
+                    const MonteCarloPricer mc(mcSettings, &mcPool);
+                    MonteCarloResult result;
+                    LatencyRecorder rec(1);
+                    rec.time([&] { result = mc.PricePath(market, asian); });
+                    std::ostringstream params;
+                    params << sampler.second << " se=" << std::scientific << std::setprecision(1) << result.standardError;
+                    results.push_back(rec.summarize("mc_asian_12", params.str(), result.samples));
+                    printResult(results.back());
+                }
+            }
+        }
+
+        // Bump-and-reprice risk per trade.
+        RiskEngine riskEngine(0.0001, 0.01);
+        {
+            std::vector<std::shared_ptr<Trade>> trades;
+            for (InstrumentKind kind : analyticKinds) {
+                const auto part = sampleOfKind(portfolio, kind, std::max<size_t>(config.samples / 3, 1));
+                trades.insert(trades.end(), part.begin(), part.end());
+            }
+            LatencyRecorder dv01Rec(trades.size());
+            for (const auto& t : trades) dv01Rec.time([&] { riskEngine.computeDv01(t, market, defaultPricer); });
+            results.push_back(dv01Rec.summarize("risk_compute_dv01", "per trade"));
+            printResult(results.back());
+
+            std::vector<std::shared_ptr<Trade>> options = sampleOfKind(portfolio, InstrumentKind::EuropeanOption, config.samples);
+            LatencyRecorder vegaRec(options.size());
+            for (const auto& t : options) vegaRec.time([&] { riskEngine.computeVega(t, market, defaultPricer); });
+            results.push_back(vegaRec.summarize("risk_compute_vega", "EuropeanOption"));
+            printResult(results.back());
+
+            LatencyRecorder batchRec(1);
+            batchRec.time([&] { riskEngine.computeRisk(trades, market, defaultPricer, {RiskType::DV01, RiskType::Vega}); });
+            results.push_back(batchRec.summarize("risk_compute_batch", std::to_string(trades.size()) + " trades", trades.size()));
+            printResult(results.back());
+        }
+
+        // Scenario revaluation: trades x 256 full-market scenarios on 4 threads, then VaR/ES.
+        {
+            std::vector<std::shared_ptr<Trade>> trades;
+            for (InstrumentKind kind : analyticKinds) {
+                const auto part = sampleOfKind(portfolio, kind, std::max<size_t>(config.samples / 3, 1));
+                trades.insert(trades.end(), part.begin(), part.end());
+            }
+            const ScenarioSet scenarios = generateScenarios(market, 256, config.seed);
+            ThreadPool scenarioPool(4);
+            const ScenarioEngine scenarioEngine(defaultPricer, &scenarioPool);
+            ScenarioPnl pnl;
+            LatencyRecorder rec(1);
+            rec.time([&] { pnl = scenarioEngine.run(trades, market, scenarios); });
+            const VaRResult var = computeVaR(pnl.portfolioPnl, 0.99);
+            std::ostringstream params;
+            params << trades.size() << " trades x " << scenarios.size() << " scenarios var99=" << std::setprecision(4)
+                   << var.valueAtRisk;
+            results.push_back(rec.summarize("scenario_revalue", params.str(), trades.size() * scenarios.size()));
+            printResult(results.back());
+        }
+
+        // Snapshot reads (acquire + one curve lookup, 1000 per sample) while another thread
+        // republishes a stock price in a loop.
+        {
+            MarketSnapshotPublisher publisher;
+            {
+                MarketSnapshotBuilder initial(market.asOf, market.name);
+                initial.market() = market;
+                publisher.publish(initial);
+            }
+            const std::unordered_map<std::string, double> stocks = market.getStockPrices();
+            const std::string stock = stocks.empty() ? std::string() : stocks.begin()->first;
+            const std::vector<std::string> curveNames = market.getCurveNames();
+            std::atomic<bool> stopPublishing{false};
+            std::thread updater([&] {
+                MarketSnapshotBuilder next = publisher.beginUpdate();
+                for (double bump = 0.0; !stopPublishing.load(); bump += 1e-6) {
+                    if (!stock.empty()) next.market().addStockPrice(stock, 100.0 + bump);
+                    publisher.publish(next);
+                    std::this_thread::sleep_for(std::chrono::microseconds(50));
+                }
+            });
+            LatencyRecorder rec(config.samples);
+            double sink = 0.0;
+            for (size_t i = 0; i < config.samples; ++i) {
+                rec.time([&] {
+                    for (int k = 0; k < 1000; ++k) {
+                        MarketSnapshotPtr view = publisher.acquire();
+                        if (!curveNames.empty()) sink += view->market().getCurve(curveNames.front())->getRate(market.asOf);
+                    }
+                });
+            }
+            stopPublishing = true;
+            updater.join();
+            results.push_back(rec.summarize("snapshot_acquire", "with concurrent publish", 1000));
+            printResult(results.back());
+            if (std::isnan(sink)) std::cout << "(NaN rate encountered)" << std::endl;
+        }
+
+        // Full market copy (what the shock path used to do) and overlay construction.
+        {
+            LatencyRecorder copyRec(config.samples);
+            for (size_t i = 0; i < config.samples; ++i) copyRec.time([&] { Market copy(market); (void)copy; });
+            results.push_back(copyRec.summarize("market_copy", std::to_string(config.underlyings + 4) + " curves"));
+            printResult(results.back());
+
+            LatencyRecorder overlayRec(config.samples);
+            for (size_t i = 0; i < config.samples; ++i) overlayRec.time([&] { Market o = Market::overlayOf(market); (void)o; });
+            results.push_back(overlayRec.summarize("market_overlay", std::to_string(config.underlyings + 4) + " curves"));
+            printResult(results.back());
+        }
+
+        // Round trip through a trade.txt-format file.
+        {
+            const std::string tradePath = config.out + ".trades.txt";
+            writeTradeFile(tradePath, specs, asOf);
+            LatencyRecorder loadRec(3);
+            for (int rep = 0; rep < 3; ++rep) {
+                std::vector<std::shared_ptr<Trade>> loaded;
+                loaded.reserve(specs.size());
+                loadRec.time([&] {
+                    loadTradesFromFile(tradePath, loaded, factories.bond, factories.swap, factories.euro, factories.amer);
+                });
+                if (loaded.size() != specs.size()) {
+                    std::cerr << "Warning: loaded " << loaded.size() << " of " << specs.size() << " trades." << std::endl;
+                }
+            }
+            results.push_back(loadRec.summarize("trade_loading", "trade.txt format", specs.size()));
+            printResult(results.back());
+            std::remove(tradePath.c_str());
+        }
+
+        writeReport(config.out, config, results);
+        std::cout << "\nReport written to " << config.out << std::endl;
+    } catch (const std::exception& e) {
+        std::cerr << "Benchmark failed: " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -3,13 +3,14 @@
 #include <string>
 #include <memory>     // For std::shared_ptr, std::make_unique
 #include <fstream>    // For std::ofstream
-#include <sstream>    // For std::istringstream (in loadTradesFromFile)
 #include <iomanip>    // For std::fixed, std::setprecision
 #include <stdexcept>  // For std::exception handling
 #include <algorithm>  // For std::transform 
 #include <chrono>     // For system_clock to get current date
 #include <cmath>      // For std::round
 #include <ctime>      // For std::time_t, std::tm, localtime_s/localtime_r
+#include <sstream>    // For the comparison notes
+#include <cstdio>     // For std::remove, std::rename (shard outputs)
 
 // Project Headers
 #include "Date.h"
@@ -21,158 +22,151 @@
 #include "AmericanTrade.h"
 #include "TreeProduct.h"   
 #include "Pricer.h"
+#include "FiniteDifferencePricer.h"
 #include "TradeFactory.h"
 #include "MarketDecorators.h"
 #include "RiskEngine.h"
+#include "PortfolioEngine.h"
+#include "ScenarioEngine.h"
+#include "Sharding.h"
+#include "MarketDataLoader.h"
 #include "Types.h"         
 #include "MathUtils.h"     
 #include "Utils.h"         
+#include "TradeLoader.h"
+#include "BinarySnapshot.h"
+#include "ResultsSink.h"
+#include "Instrumentation.h"
 
-namespace {
-    std::string toLowerMainCpp(const std::string& str) { 
-        std::string data = str;
-        std::transform(data.begin(), data.end(), data.begin(),
-                       [](unsigned char c){ return std::tolower(c); });
-        return data;
-    }
-} 
-
-bool loadTradesFromFile(
-    const std::string& filePath,
-    std::vector<std::shared_ptr<Trade>>& portfolio,
-    TradeFactory& bondFactory,
-    TradeFactory& swapFactory,
-    TradeFactory& euroOptFactory,
-    TradeFactory& amerOptFactory
-) {
-    std::ifstream inputFile(filePath);
-    if (!inputFile.is_open()) {
-        std::cerr << "Error: Could not open trade file: '" << filePath << "'." << std::endl;
-        return false;
-    }
-    std::string line;
-    int lineNumber = 0;
-    bool headerSkipped = false;
-
-    // Expects 13 or 14 fields from your confirmed trade.txt format
-    // 0:id; 1:type; 2:trade_dt; 3:start_dt; 4:end_dt; 5:notional; 6:instrument; 
-    // 7:rate(bond/swap); 8:strike(option); 9:freq(bond/swap, decimal); 10:option_type; 
-    // 11:DiscountCurve; 12:VolCurve; 13:FloatForecastCurve(optional)
-
-    while (std::getline(inputFile, line)) {
-        lineNumber++;
-        if (line.empty() || line.find_first_not_of(" \t\r\n") == std::string::npos || line[0] == '#') {
-            continue; 
-        }
-        if (!headerSkipped && 
-            (toLowerMainCpp(line).find("id;type;trade_dt") != std::string::npos || 
-             toLowerMainCpp(line).find("discount_curve;vol_curve") != std::string::npos )) {
-            headerSkipped = true; 
-            std::cout << "Info: Header line detected and skipped in '" << filePath << "': '" << line << "'" << std::endl;
-            continue; 
-        }
-        if (!headerSkipped && lineNumber == 1) {
-            std::cout << "Info: First line of '" << filePath << "' ('" << line << "') is not a recognized header. Assuming data from line 1." << std::endl;
-        }
-
-        std::vector<std::string> tokens;
-        splitString(tokens, line, ';'); 
-
-        if (tokens.size() < 13) { // Need at least 13 fields (up to VolCurve)
-            std::cerr << "Warning: Skipping line " << lineNumber << " in '" << filePath 
-                      << "'. Incorrect number of columns. Expected at least 13, got " << tokens.size() 
-                      << ". Line: '" << line << "'" << std::endl;
-            continue;
-        }
-
-        try {
-            std::string type_str = toLowerMainCpp(tokens[1]);
-            Date tradeDate_obj(tokens[2]);
-            Date startDate_obj(tokens[3]);
-            Date endDate_obj(tokens[4]); 
-            double notional_val = std::stod(tokens[5]);
-            std::string instrument_str = tokens[6];
-            
-            double rate_param = 0.0;      
-            double strike_param = 0.0;    
-            double freq_decimal_param = 0.0; 
-            int frequency_val = 0;        
-
-            if (!tokens[7].empty()) rate_param = std::stod(tokens[7]);
-            if (!tokens[8].empty()) strike_param = std::stod(tokens[8]);
-            if (!tokens[9].empty()) freq_decimal_param = std::stod(tokens[9]);
-
-            if (type_str == "bond" || type_str == "swap") {
-                if (std::abs(freq_decimal_param) > 1e-9) { 
-                    if (std::abs(freq_decimal_param - static_cast<int>(freq_decimal_param)) < 1e-6 ) { 
-                        frequency_val = static_cast<int>(freq_decimal_param);
-                    } else { 
-                        frequency_val = static_cast<int>(std::round(1.0 / freq_decimal_param));
-                    }
-                    if (frequency_val <= 0 && std::abs(rate_param)>1e-9) frequency_val = 1; 
-                } else {
-                    frequency_val = (std::abs(rate_param) > 1e-9) ? 1 : 0; // If coupon/rate exists, assume freq 1 if not specified
+int main(int argc, char* argv[]) {
+    try {
+        // --snapshot <file>: take market data and trades from a binary snapshot (see tools/SnapshotTool.cpp)
+        // --results-format text|binary, --results <file>: results output (default results.txt / results.bin)
+        // --quiet: no per-trade console logging (errors are still reported)
+        // --risk-method bump|adjoint: DV01/Vega by bump-and-reprice (default) or adjoint (see RiskEngine.h)
+        // --tree-model crr|lr|bbsr, --tree-steps <N>: option tree (default CRR, 50 steps, see Pricer.h)
+        // --tree-tolerance <abs>: grow the tree from N steps until successive prices agree to <abs>
+        // --strip-pricing: options sharing underlying, expiry and curves priced on one tree (see Pricer.h)
+        // --option-pricer tree|pde: options on the tree (default) or the Crank-Nicolson grid, with
+        //   --pde-space-steps <M> (default 400) and --pde-time-steps <N> (default 200)
+        // --scenarios <file> or --random-scenarios <N>: revalue the portfolio under a scenario set
+        //   (see ScenarioEngine.h) and report VaR/ES at --var-confidence <c> (default 0.99);
+        //   --scenario-pnl <file> also writes the per-trade scenario P&L as CSV
+        // --shard <i>/<N> [--shard-key id|curve]: price only shard i of the trades (see Sharding.h)
+        //   into <prefix>.shard-<i>-of-<N>.bin/.manifest, prefix set by --shard-prefix (default results)
+        // --merge-shards <N>: merge N finished shards into --results (no pricing)
+        // --market-catalog <file>: market data files by curve name (see MarketDataLoader.h) instead of
+        //   the default six; only entries the portfolio references are read unless --load-all-market-data
+        // --instrument-report <file>, --instrument-format text|json: timers/counters written at exit
+        //   (needs a build with -DPRICING_INSTRUMENTATION, see Instrumentation.h)
+        std::string snapshotPath;
+        ResultsFormat resultsFormat = ResultsFormat::Text;
+        std::string resultsPath;
+        bool quiet = false;
+        SensitivityMethod riskMethod = SensitivityMethod::BumpAndReprice;
+        TreeModel treeModel = TreeModel::CRR;
+        int treeSteps = 50; // 50 steps as per requirement
+        double treeTolerance = 0.0;
+        bool stripPricing = false;
+        bool usePde = false;
+        int pdeSpaceSteps = 400;
+        int pdeTimeSteps = 200;
+        std::string scenarioPath;
+        size_t randomScenarios = 0;
+        double varConfidence = 0.99;
+        std::string scenarioPnlPath;
+        std::string shardText;
+        ShardKey shardKey = ShardKey::TradeId;
+        std::string shardPrefix = "results";
+        size_t mergeShards = 0;
+        std::string marketCatalogPath;
+        bool loadAllMarketData = false;
+        std::string instrumentReportPath;
+        instrumentation::ReportFormat instrumentFormat = instrumentation::ReportFormat::Text;
+        for (int i = 1; i < argc; ++i) {
+            const std::string arg = argv[i];
+            if (arg == "--snapshot" && i + 1 < argc) {
+                snapshotPath = argv[++i];
+            } else if (arg == "--results-format" && i + 1 < argc) {
+                resultsFormat = parseResultsFormat(argv[++i]);
+            } else if (arg == "--results" && i + 1 < argc) {
+                resultsPath = argv[++i];
+            } else if (arg == "--risk-method" && i + 1 < argc) {
+                riskMethod = parseSensitivityMethod(argv[++i]);
+            } else if (arg == "--tree-model" && i + 1 < argc) {
+                treeModel = parseTreeModel(argv[++i]);
+            } else if (arg == "--tree-steps" && i + 1 < argc) {
+                treeSteps = std::stoi(argv[++i]);
+            } else if (arg == "--tree-tolerance" && i + 1 < argc) {
+                treeTolerance = std::stod(argv[++i]);
+            } else if (arg == "--option-pricer" && i + 1 < argc) {
+                const std::string name = argv[++i];
+                if (name != "tree" && name != "pde") {
+                    throw std::invalid_argument("Unknown option pricer '" + name + "' (expected tree or pde)");
                 }
-            } else { 
-                frequency_val = 0;
+                usePde = (name == "pde");
+            } else if (arg == "--pde-space-steps" && i + 1 < argc) {
+                pdeSpaceSteps = std::stoi(argv[++i]);
+            } else if (arg == "--pde-time-steps" && i + 1 < argc) {
+                pdeTimeSteps = std::stoi(argv[++i]);
+            } else if (arg == "--scenarios" && i + 1 < argc) {
+                scenarioPath = argv[++i];
+            } else if (arg == "--random-scenarios" && i + 1 < argc) {
+                randomScenarios = static_cast<size_t>(std::stoul(argv[++i]));
+            } else if (arg == "--var-confidence" && i + 1 < argc) {
+                varConfidence = std::stod(argv[++i]);
+            } else if (arg == "--scenario-pnl" && i + 1 < argc) {
+                scenarioPnlPath = argv[++i];
+            } else if (arg == "--shard" && i + 1 < argc) {
+                shardText = argv[++i];
+            } else if (arg == "--shard-key" && i + 1 < argc) {
+                shardKey = parseShardKey(argv[++i]);
+            } else if (arg == "--shard-prefix" && i + 1 < argc) {
+                shardPrefix = argv[++i];
+            } else if (arg == "--merge-shards" && i + 1 < argc) {
+                mergeShards = static_cast<size_t>(std::stoul(argv[++i]));
+            } else if (arg == "--market-catalog" && i + 1 < argc) {
+                marketCatalogPath = argv[++i];
+            } else if (arg == "--load-all-market-data") {
+                loadAllMarketData = true;
+            } else if (arg == "--instrument-report" && i + 1 < argc) {
+                instrumentReportPath = argv[++i];
+            } else if (arg == "--instrument-format" && i + 1 < argc) {
+                instrumentFormat = instrumentation::parseReportFormat(argv[++i]);
+            } else if (arg == "--strip-pricing") {
+                stripPricing = true;
+            } else if (arg == "--quiet") {
+                quiet = true;
+            } else {
+                std::cerr << "Warning: Ignoring unknown argument '" << arg << "'." << std::endl;
             }
-
-            std::string optionType_str = toLowerMainCpp(tokens[10]);
-            std::string disc_curve_str = tokens[11];
-            std::string vol_curve_str = tokens[12]; 
-            std::string float_fcst_curve_str = (tokens.size() > 13 && !tokens[13].empty()) ? tokens[13] : disc_curve_str; 
-
-            OptionType optType_enum = OptionType::None; 
-            if (type_str == "european" || type_str == "american") {
-                if (optionType_str == "call") optType_enum = OptionType::Call;
-                else if (optionType_str == "put") optType_enum = OptionType::Put;
-                else if (optionType_str == "binarycall") optType_enum = OptionType::BinaryCall;
-                else if (optionType_str == "binaryput") optType_enum = OptionType::BinaryPut;
-                else if (optionType_str != "none" && !optionType_str.empty() && optionType_str != "na") {
-                     throw std::invalid_argument("Unknown option type in trade.txt: " + tokens[10]);
-                }
+        }
+        if (!instrumentReportPath.empty()) {
+            if (!instrumentation::enabled()) {
+                std::cerr << "Warning: Built without PRICING_INSTRUMENTATION; the instrumentation report will be empty." << std::endl;
             }
-
-            std::shared_ptr<Trade> newTrade = nullptr;
-            double primary_rate_strike_for_factory = 0.0;
-            if (type_str == "bond") primary_rate_strike_for_factory = rate_param; 
-            else if (type_str == "swap") primary_rate_strike_for_factory = rate_param; 
-            else if (type_str == "european" || type_str == "american") primary_rate_strike_for_factory = strike_param; 
-
-            if (type_str == "bond") {
-                newTrade = bondFactory.createTrade(instrument_str, tradeDate_obj, startDate_obj, endDate_obj, 
-                                                   notional_val, primary_rate_strike_for_factory, frequency_val, 
-                                                   optType_enum, disc_curve_str, vol_curve_str, float_fcst_curve_str);
-            } else if (type_str == "swap") {
-                newTrade = swapFactory.createTrade(instrument_str, tradeDate_obj, startDate_obj, endDate_obj, 
-                                                   notional_val, primary_rate_strike_for_factory, frequency_val, 
-                                                   optType_enum, disc_curve_str, vol_curve_str, float_fcst_curve_str);
-            } else if (type_str == "european") {
-                newTrade = euroOptFactory.createTrade(instrument_str, tradeDate_obj, startDate_obj, endDate_obj, 
-                                                      notional_val, primary_rate_strike_for_factory, frequency_val, 
-                                                      optType_enum, disc_curve_str, vol_curve_str, float_fcst_curve_str);
-            } else if (type_str == "american") {
-                newTrade = amerOptFactory.createTrade(instrument_str, tradeDate_obj, startDate_obj, endDate_obj, 
-                                                      notional_val, primary_rate_strike_for_factory, frequency_val, 
-                                                      optType_enum, disc_curve_str, vol_curve_str, float_fcst_curve_str);
-            } else {
-                std::cerr << "Warning: Skipping line " << lineNumber << ". Unknown trade type: '" << type_str << "'." << std::endl;
-                continue;
+            instrumentation::writeReportAtExit(instrumentReportPath, instrumentFormat);
+        }
+        const ShardSpec shard = shardText.empty() ? ShardSpec() : parseShardSpec(shardText, shardKey);
+        if (mergeShards > 0) {
+            if (resultsPath.empty()) {
+                resultsPath = (resultsFormat == ResultsFormat::Binary) ? "results.bin" : "results.txt";
             }
-            if (newTrade) {
-                portfolio.push_back(newTrade);
+            ShardMergeReport report = mergeShardResults(shardPrefix, mergeShards, resultsPath, resultsFormat);
+            if (!report.missingShards.empty()) {
+                std::cerr << "CRITICAL Error: Unfinished shards (no manifest):";
+                for (size_t s : report.missingShards) std::cerr << ' ' << s;
+                std::cerr << ". Rerun each with --shard <i>/" << mergeShards << " before merging." << std::endl;
+                return 1;
             }
-        } catch (const std::exception& e) {
-            std::cerr << "Warning: Skipping line " << lineNumber << " in '" << filePath 
-                      << "'. Error parsing trade data: " << e.what() << ". Line: '" << line << "'" << std::endl;
+            std::cout << "Merged " << mergeShards << " shards (" << report.mergedTrades << " trades) into "
+                      << resultsPath << std::endl;
+            return 0;
+        }
+        if (shard.active() && (!scenarioPath.empty() || randomScenarios > 0)) {
+            std::cerr << "Warning: Scenario VaR is not additive across shards; ignoring the scenario options in shard mode." << std::endl;
         }
-    }
-    inputFile.close();
-    return !portfolio.empty(); 
-}
 
-int main() {
-    try {
         Date valueDate;
         auto now_chrono = std::chrono::system_clock::now();
         std::time_t now_time_t = std::chrono::system_clock::to_time_t(now_chrono);
@@ -186,116 +180,186 @@ int main() {
         std::cout << "Valuation Date: " << valueDate.toString() << std::endl;
 
         Market market(valueDate, "GlobalMarket");
-        std::cout << "\nLoading Market Data..." << std::endl;
-        
-        // Load USD-SOFR from curve.txt (assuming curve.txt contains it and loader can find/use the name)
-        if (!market.loadCurveDataFromFile("curve.txt", "USD-SOFR" /* Hint for loader if file has no internal name */, "USD-SOFR" /* Key to store in market */)) { 
-             std::cerr << "Warning: Failed to load USD-SOFR curve data from curve.txt." << std::endl;
+        BinarySnapshotReader snapshot;
+        if (!snapshotPath.empty()) {
+            std::cout << "\nLoading market data and portfolio from snapshot '" << snapshotPath << "'..." << std::endl;
+            if (!snapshot.open(snapshotPath)) {
+                std::cerr << "CRITICAL Error: Could not open snapshot '" << snapshotPath << "'. Terminating." << std::endl;
+                return 1;
+            }
+            market = snapshot.buildMarket();
+            valueDate = market.asOf;
+            std::cout << "Valuation Date (from snapshot): " << valueDate.toString() << std::endl;
         }
-        // Attempt to load SGD-SORA if sgd_curve.txt exists
-        // User needs to provide this file or modify curve.txt and the loader for multiple curves in one file.
-        if (!market.loadCurveDataFromFile("sgd_curve.txt", "SGD-SORA", "SGD-SORA")) { 
-             std::cout << "Info: SGD-SORA curve data not loaded (e.g., sgd_curve.txt missing or empty)." << std::endl;
+        // Without a snapshot, market data is read after the portfolio: only what it references.
+
+        BondFactory bondFactory;
+        SwapFactory swapFactory;
+        EuropeanOptionFactory euroOptFactory;
+        AmericanOptionFactory amerOptFactory;
+
+        std::unique_ptr<Pricer> treePricer;
+        std::string treePriceLabel;
+        if (usePde) {
+            auto pdePricer = std::make_unique<FiniteDifferencePricer>(pdeSpaceSteps, pdeTimeSteps);
+            treePriceLabel = "Finite-Difference Price (" + std::to_string(pdePricer->getSpaceSteps()) + "x" +
+                             std::to_string(pdePricer->getTimeSteps()) + " grid)";
+            treePricer = std::move(pdePricer);
         } else {
-             std::cout << "Info: Successfully loaded SGD-SORA curve data from sgd_curve.txt." << std::endl;
+            std::unique_ptr<BinomialTreePricer> binomialPricer = makeTreePricer(treeModel, treeSteps);
+            if (treeTolerance > 0.0) {
+                binomialPricer->setTolerance(treeTolerance);
+            }
+            binomialPricer->setStripPricing(stripPricing);
+            treePriceLabel = "Binomial Tree Price (" + std::to_string(treeSteps) + " steps)";
+            treePricer = std::move(binomialPricer);
         }
+        RiskEngine riskEngine(0.0001, 0.01, riskMethod); // 1bp IR shock (0.0001), 1% Vol shock (0.01)
+        PortfolioEngine portfolioEngine(*treePricer, riskEngine);
 
-        // Load a default/generic Volatility Curve
-        if (!market.loadVolDataFromFile("vol.txt", "VOL_CURVE_DEFAULT", "VOL_CURVE_DEFAULT")) { 
-             std::cerr << "Warning: Failed to load default volatility curve data from vol.txt (VOL_CURVE_DEFAULT)." << std::endl;
-        }
-        // Load a specific vol curve for APPL if trade.txt uses VOL_APPL and you have a file for it
-        // For example, if you create vol_appl.txt with APPL specific vols.
-        if (!market.loadVolDataFromFile("vol_appl.txt", "VOL_APPL", "VOL_APPL")) { 
-             std::cout << "Info: VOL_APPL curve data not loaded (e.g., vol_appl.txt missing or empty). Trades referencing it will try VOL_CURVE_DEFAULT if not found." << std::endl;
+        std::vector<std::shared_ptr<Trade>> portfolio;
+        std::vector<size_t> shardRecordIndices; // Source record of each portfolio entry, in shard mode
+        size_t totalRecords = 0;
+        if (shard.active()) {
+            std::vector<TradeRecord> records;
+            if (snapshot.isOpen()) {
+                records = snapshot.readTradeRecords();
+            } else if (!parseTradeFile("trade.txt", &records, nullptr, bondFactory, swapFactory, euroOptFactory,
+                                       amerOptFactory, &portfolioEngine.threadPool())) {
+                std::cerr << "Warning: Could not read trade.txt. Portfolio may be empty." << std::endl;
+            }
+            totalRecords = records.size();
+            for (size_t index : selectShard(records, shard)) {
+                try {
+                    std::shared_ptr<Trade> trade = buildTradeFromRecord(records[index], bondFactory, swapFactory,
+                                                                        euroOptFactory, amerOptFactory);
+                    if (!trade) continue;
+                    portfolio.push_back(std::move(trade));
+                    shardRecordIndices.push_back(index);
+                } catch (const std::exception& e) {
+                    std::cerr << "Warning: Skipping line " << records[index].lineNumber << ". Error building trade: "
+                              << e.what() << std::endl;
+                }
+            }
+            std::cout << "Shard " << shard.index << "/" << shard.count << " holds " << portfolio.size() << " of "
+                      << totalRecords << " trades." << std::endl;
+        } else if (snapshot.isOpen()) {
+            snapshot.buildPortfolio(portfolio, bondFactory, swapFactory, euroOptFactory, amerOptFactory,
+                                    &portfolioEngine.threadPool());
+            std::cout << "Loaded " << portfolio.size() << " trades from the snapshot." << std::endl;
         } else {
-             std::cout << "Info: Successfully loaded VOL_APPL curve data from vol_appl.txt." << std::endl;
+            std::cout << "\nLoading Portfolio from trade.txt..." << std::endl;
+            if (!loadTradesFromFile("trade.txt", portfolio, bondFactory, swapFactory, euroOptFactory, amerOptFactory,
+                                    &portfolioEngine.threadPool())) {
+                std::cerr << "Warning: Could not load any trades from trade.txt or file not found. Portfolio may be empty." << std::endl;
+            } else {
+                std::cout << "Loaded " << portfolio.size() << " trades into the portfolio." << std::endl;
+            }
         }
 
-        if (!market.loadStockPricesFromFile("stockPrice.txt")) {
-             std::cerr << "Warning: Failed to load stock price data from stockPrice.txt." << std::endl;
-        }
-        if (!market.loadBondPricesFromFile("bondPrice.txt")) {
-            std::cerr << "Warning: Failed to load bond price data from bondPrice.txt." << std::endl;
+        if (!snapshot.isOpen()) {
+            std::cout << "\nLoading Market Data..." << std::endl;
+            MarketDataCatalog catalog = MarketDataCatalog::defaultCatalog();
+            if (!marketCatalogPath.empty()) {
+                catalog = MarketDataCatalog();
+                if (!catalog.loadFromFile(marketCatalogPath)) {
+                    std::cerr << "Warning: Could not read market data catalog " << marketCatalogPath << "." << std::endl;
+                }
+            }
+            // Shards load everything so that all of them see the same market (see Sharding.h).
+            ThreadPool ioPool(8);
+            const MarketDataLoadReport loadReport = loadMarketDataFor(portfolio, catalog, market, &ioPool,
+                                                                      loadAllMarketData || shard.active());
+            std::cout << "Info: Loaded " << loadReport.filesLoaded << " market data file(s) on " << ioPool.size()
+                      << " I/O thread(s); " << loadReport.filesSkipped << " catalog entr"
+                      << (loadReport.filesSkipped == 1 ? "y" : "ies") << " not referenced by the portfolio skipped." << std::endl;
+            for (const MarketDataKey& key : loadReport.unresolved) {
+                std::cerr << "Warning: " << (key.type == MarketDataType::RateCurve ? "Rate" : "Vol") << " curve '" << key.name
+                          << "' referenced by the portfolio has no market data." << std::endl;
+            }
         }
         market.Print();
 
-        BondFactory bondFactory;
-        SwapFactory swapFactory;
-        EuropeanOptionFactory euroOptFactory;
-        AmericanOptionFactory amerOptFactory;
-
-        std::vector<std::shared_ptr<Trade>> portfolio;
-        std::cout << "\nLoading Portfolio from trade.txt..." << std::endl;
-        if (!loadTradesFromFile("trade.txt", portfolio, bondFactory, swapFactory, euroOptFactory, amerOptFactory)) {
-            std::cerr << "Warning: Could not load any trades from trade.txt or file not found. Portfolio may be empty." << std::endl;
+        // Shard results are always binary (lossless for the merge) and are written under a
+        // temporary name, then renamed; the manifest, written last, marks the shard finished.
+        std::string sinkPath;
+        if (shard.active()) {
+            resultsFormat = ResultsFormat::Binary;
+            resultsPath = shardResultsPath(shardPrefix, shard);
+            std::remove(shardManifestPath(shardPrefix, shard).c_str());
+            sinkPath = resultsPath + ".tmp";
         } else {
-            std::cout << "Loaded " << portfolio.size() << " trades into the portfolio." << std::endl;
+            if (resultsPath.empty()) {
+                resultsPath = (resultsFormat == ResultsFormat::Binary) ? "results.bin" : "results.txt";
+            }
+            sinkPath = resultsPath;
         }
-
-        auto treePricer = std::make_unique<CRRBinomialTreePricer>(50); // 50 steps as per requirement
-        std::ofstream outputFile("results.txt");
-        if (!outputFile.is_open()) {
-            std::cerr << "CRITICAL Error: Could not open results.txt for writing. Terminating." << std::endl;
+        // Written from a background thread; the header line is emitted on open.
+        std::unique_ptr<ResultsSink> resultsSink = makeResultsSink(resultsFormat, sinkPath);
+        if (!resultsSink) {
+            std::cerr << "CRITICAL Error: Could not open " << resultsPath << " for writing. Terminating." << std::endl;
             return 1;
         }
-        outputFile << std::fixed << std::setprecision(6); 
         std::cout << std::fixed << std::setprecision(6);  
 
-        outputFile << "Instrument;Type;PV;DV01_Curve;DV01_Value;Vega_Curve;Vega_Value" << std::endl;
-
         std::cout << "\nCalculating PV and Greeks for Portfolio..." << std::endl;
-        RiskEngine riskEngine(0.0001, 0.01); // 1bp IR shock (0.0001), 1% Vol shock (0.01)
+        std::cout << "Using " << portfolioEngine.threadCount() << " worker thread(s)." << std::endl;
+        std::vector<TradeResult> tradeResults = portfolioEngine.run(portfolio, market);
 
-        for (const auto& trade : portfolio) {
-            if (!trade) continue;
-            std::string tradeIdForOutput = trade->getUnderlyingName(); // Default to underlying
+        for (const TradeResult& result : tradeResults) {
+            if (!result.hasTrade) continue;
+            const std::string& tradeIdForOutput = result.instrument; // Default to underlying
             // If your trades had a specific ID field you parsed, you could use that here.
-            std::cout << "Processing Trade: " << tradeIdForOutput << " (" << trade->getType() << ")" << std::endl;
-            outputFile << tradeIdForOutput << ";" << trade->getType() << ";";
-            double pv = 0.0;
-            try {
-                pv = treePricer->Price(market, trade);
-                std::cout << "  PV: " << pv << std::endl;
-                outputFile << pv << ";";
-            } catch (const std::exception& e) {
-                std::cerr << "  Error pricing trade " << tradeIdForOutput << " (" << trade->getType() << "): " << e.what() << std::endl;
-                outputFile << "ErrorPricing;" ;
+            // Console lines use '\n' (std::cerr is tied to std::cout, so errors still interleave in order).
+            if (!quiet) std::cout << "Processing Trade: " << tradeIdForOutput << " (" << result.type << ")" << '\n';
+            if (result.pvOk) {
+                if (!quiet) std::cout << "  PV: " << result.pv << '\n';
+            } else {
+                std::cerr << "  Error pricing trade " << tradeIdForOutput << " (" << result.type << "): " << result.pvError << std::endl;
             }
-            try {
-                auto dv01_map = riskEngine.computeDv01(trade, market, *treePricer);
-                if (!dv01_map.empty()) {
-                    for (const auto& dv_pair : dv01_map) {
-                        std::cout << "  DV01 (" << dv_pair.first << "): " << dv_pair.second << std::endl;
-                        outputFile << dv_pair.first << ";" << dv_pair.second << ";";
+            if (result.dv01Ok) {
+                if (!quiet) {
+                    for (const auto& dv_pair : result.dv01) {
+                        std::cout << "  DV01 (" << dv_pair.first << "): " << dv_pair.second << '\n';
                     }
-                } else {
-                    outputFile << "N/A;0.0;"; 
                 }
-            } catch (const std::exception& e) {
-                std::cerr << "  Error calculating DV01 for " << tradeIdForOutput << " (" << trade->getType() << "): " << e.what() << std::endl;
-                outputFile << "ErrorDV01;0.0;";
+            } else {
+                std::cerr << "  Error calculating DV01 for " << tradeIdForOutput << " (" << result.type << "): " << result.dv01Error << std::endl;
             }
-            try {
-                auto vega_map = riskEngine.computeVega(trade, market, *treePricer);
-                if (!vega_map.empty()) {
-                    for (const auto& v_pair : vega_map) {
-                        std::cout << "  Vega (" << v_pair.first << "): " << v_pair.second << std::endl;
-                        outputFile << v_pair.first << ";" << v_pair.second;
+            if (result.vegaOk) {
+                if (!quiet) {
+                    for (const auto& v_pair : result.vega) {
+                        std::cout << "  Vega (" << v_pair.first << "): " << v_pair.second << '\n';
                     }
-                } else {
-                    outputFile << "N/A;0.0"; 
                 }
-            } catch (const std::exception& e) {
-                std::cerr << "  Error calculating Vega for " << tradeIdForOutput << " (" << trade->getType() << "): " << e.what() << std::endl;
-                outputFile << "ErrorVega;0.0";
+            } else {
+                std::cerr << "  Error calculating Vega for " << tradeIdForOutput << " (" << result.type << "): " << result.vegaError << std::endl;
             }
-            outputFile << std::endl;
+            resultsSink->writeTradeResult(result);
         }
-        std::cout << "\nResults written to results.txt" << std::endl;
+        if (shard.active()) {
+            resultsSink->close();
+            if (std::rename(sinkPath.c_str(), resultsPath.c_str()) != 0) {
+                std::cerr << "CRITICAL Error: Could not move " << sinkPath << " to " << resultsPath << "." << std::endl;
+                return 1;
+            }
+            ShardManifest manifest;
+            manifest.spec = shard;
+            manifest.totalRecords = totalRecords;
+            manifest.marketFingerprint = marketFingerprint(market);
+            manifest.recordIndices = shardRecordIndices;
+            writeShardManifest(shardManifestPath(shardPrefix, shard), manifest);
+            std::cout << "\nShard results written to " << resultsPath << " (manifest "
+                      << shardManifestPath(shardPrefix, shard) << ")" << std::endl;
+            return 0;
+        }
+        std::cout << "\nResults written to " << resultsPath << std::endl;
 
+        // The comparison section goes to the results file as notes, after the per-trade results.
+        std::ostringstream outputNotes;
+        outputNotes << std::fixed << std::setprecision(6);
         std::cout << "\n--- Comparison Data for Write-up ---" << std::endl;
-        outputFile << "\n--- Comparison Data for Write-up ---" << std::endl;
+        outputNotes << "\n--- Comparison Data for Write-up ---" << std::endl;
         std::shared_ptr<EuropeanOption> euroCallForComparison = nullptr;
         std::shared_ptr<AmericanOption> amerCallForComparison = nullptr;
         std::string commonUnderlyingComp = "";
@@ -334,7 +398,7 @@ int main() {
             Date expiry = euroCallForComparison->GetExpiry();
             std::string title = "European Option vs. Black-Scholes: (" + ulyName + " K" + std::to_string(K) + " Exp:" + expiry.toString() + ")";
             std::cout << "\n" << title << std::endl;
-            outputFile << "\n" << title << std::endl;
+            outputNotes << "\n" << title << std::endl;
             double treePriceEuro = 0.0; 
             try { treePriceEuro = treePricer->Price(market, euroCallForComparison); } catch (const std::exception& e) { std::cerr << "Error pricing Euro Call for BS comparison: " << e.what() << std::endl; }
             
@@ -348,50 +412,100 @@ int main() {
                 double sigma = vCurve->getVol(expiry);
                 if (sigma <= 1e-9) {
                     std::cout << "  Warning: Volatility for Black-Scholes is zero or very low (" << sigma << "). BS price may be intrinsic only." << std::endl;
-                    outputFile << "  Warning: Volatility for Black-Scholes is zero or very low (" << sigma << "). BS price may be intrinsic only." << std::endl;
+                    outputNotes << "  Warning: Volatility for Black-Scholes is zero or very low (" << sigma << "). BS price may be intrinsic only." << std::endl;
                 }
                 try {
                     double bsPrice = blackScholesPrice(euroCallForComparison->getOptionType(), S, K, T, r, sigma);
                     std::cout << "  Parameters for BS: S=" << S << ", K=" << K << ", T=" << T << ", r=" << r << ", sigma=" << sigma << std::endl;
-                    outputFile << "  Parameters for BS: S=" << S << ", K=" << K << ", T=" << T << ", r=" << r << ", sigma=" << sigma << std::endl;
-                    std::cout << "  Binomial Tree Price (50 steps): " << treePriceEuro << std::endl;
+                    outputNotes << "  Parameters for BS: S=" << S << ", K=" << K << ", T=" << T << ", r=" << r << ", sigma=" << sigma << std::endl;
+                    std::cout << "  " << treePriceLabel << ": " << treePriceEuro << std::endl;
                     std::cout << "  Black-Scholes Price: " << bsPrice << std::endl;
                     std::cout << "  Difference (Tree - BS): " << (treePriceEuro - bsPrice) << std::endl;
-                    outputFile << "  Binomial Tree Price (50 steps): " << treePriceEuro << std::endl;
-                    outputFile << "  Black-Scholes Price: " << bsPrice << std::endl;
-                    outputFile << "  Difference (Tree - BS): " << (treePriceEuro - bsPrice) << std::endl;
+                    outputNotes << "  " << treePriceLabel << ": " << treePriceEuro << std::endl;
+                    outputNotes << "  Black-Scholes Price: " << bsPrice << std::endl;
+                    outputNotes << "  Difference (Tree - BS): " << (treePriceEuro - bsPrice) << std::endl;
                 } catch (const std::exception& e) {
                     std::cout << "  Error calculating Black-Scholes price: " << e.what() << std::endl;
-                    outputFile << "  Error calculating Black-Scholes price: " << e.what() << std::endl;
+                    outputNotes << "  Error calculating Black-Scholes price: " << e.what() << std::endl;
                 }
             } else {
                 std::cout << "  Could not calculate Black-Scholes price for " << ulyName << " (missing market data or T<0). RateCurve valid: " << (rCurve!=nullptr) << ", VolCurve valid: " << (vCurve!=nullptr) << ", T: " << T << std::endl;
-                outputFile << "  Could not calculate Black-Scholes price for " << ulyName << " (missing market data or T<0)." << std::endl;
+                outputNotes << "  Could not calculate Black-Scholes price for " << ulyName << " (missing market data or T<0)." << std::endl;
             }
             if (amerCallForComparison) {
                 std::string titleAmer = "American Call vs. European Call (Same Parameters - " + commonUnderlyingComp + " K" + std::to_string(commonStrikeComp) + " Exp:" + commonExpiryComp.toString() + ")";
                 std::cout << "\n" << titleAmer << std::endl;
-                outputFile << "\n" << titleAmer << std::endl;
+                outputNotes << "\n" << titleAmer << std::endl;
                 double treePriceAmer = 0.0;
                 try { treePriceAmer = treePricer->Price(market, amerCallForComparison); } catch (const std::exception& e) { std::cerr << "Error pricing Amer Call for comparison: " << e.what() << std::endl; }
                 std::cout << "  American Call (Tree Price): " << treePriceAmer << std::endl;
                 std::cout << "  European Call (Tree Price): " << treePriceEuro << std::endl;
                 std::cout << "  Early Exercise Premium (American - European): " << (treePriceAmer - treePriceEuro) << std::endl;
-                outputFile << "  American Call (Tree Price): " << treePriceAmer << std::endl;
-                outputFile << "  European Call (Tree Price): " << treePriceEuro << std::endl;
-                outputFile << "  Early Exercise Premium (American - European): " << (treePriceAmer - treePriceEuro) << std::endl;
+                outputNotes << "  American Call (Tree Price): " << treePriceAmer << std::endl;
+                outputNotes << "  European Call (Tree Price): " << treePriceEuro << std::endl;
+                outputNotes << "  Early Exercise Premium (American - European): " << (treePriceAmer - treePriceEuro) << std::endl;
             } else {
                 std::string missingAmerInfo = "\nMatching American Call for comparison not found in portfolio (Looked for Underlying: " + commonUnderlyingComp + ", K: " + std::to_string(commonStrikeComp) + ", Exp: " + commonExpiryComp.toString() + ").";
                 if (commonUnderlyingComp.empty() && euroCallForComparison) missingAmerInfo = "\nNo European call was found to base American option comparison on.";
                 else if (commonUnderlyingComp.empty()) missingAmerInfo = "\nNo European call was found, so no American option comparison attempted.";
                 std::cout << missingAmerInfo << std::endl;
-                outputFile << missingAmerInfo << std::endl;
+                outputNotes << missingAmerInfo << std::endl;
             }
         } else {
             std::cout << "\nNo European Call option found in portfolio for Black-Scholes/American comparison." << std::endl;
-            outputFile << "\nNo European Call option found in portfolio for Black-Scholes/American comparison." << std::endl;
+            outputNotes << "\nNo European Call option found in portfolio for Black-Scholes/American comparison." << std::endl;
+        }
+        if (!scenarioPath.empty() || randomScenarios > 0) {
+            ScenarioSet scenarios;
+            if (!scenarioPath.empty()) {
+                if (!loadScenarioFile(scenarioPath, scenarios)) {
+                    std::cerr << "Warning: Could not load scenarios from " << scenarioPath << "." << std::endl;
+                }
+            } else {
+                scenarios = generateScenarios(market, randomScenarios, 20240601);
+            }
+            if (scenarios.size() == 0) {
+                std::cerr << "Warning: Scenario set is empty; skipping VaR." << std::endl;
+            } else {
+                ScenarioEngine scenarioEngine(*treePricer, &portfolioEngine.threadPool());
+                ScenarioPnl scenarioPnl = scenarioEngine.run(portfolio, market, scenarios);
+                VaRResult var = computeVaR(scenarioPnl.portfolioPnl, varConfidence);
+                std::ostringstream summary;
+                summary << std::fixed << std::setprecision(6);
+                summary << "\nScenario VaR (" << scenarios.size() << " scenarios, " << scenarioPnl.includedTrades
+                        << " of " << portfolio.size() << " trades)" << std::endl;
+                summary << "  VaR " << (100.0 * varConfidence) << "%: " << var.valueAtRisk << std::endl;
+                summary << "  Expected Shortfall " << (100.0 * varConfidence) << "%: " << var.expectedShortfall
+                        << " (worst " << var.tailScenarios << " scenarios)" << std::endl;
+                std::cout << summary.str();
+                outputNotes << summary.str();
+                for (size_t t = 0; t < portfolio.size(); ++t) {
+                    if (portfolio[t] && !scenarioPnl.errors[t].empty()) {
+                        std::cerr << "  Trade " << tradeResults[t].instrument << " (" << tradeResults[t].type
+                                  << ") excluded from VaR: " << scenarioPnl.errors[t] << std::endl;
+                    }
+                }
+                if (!scenarioPnlPath.empty()) {
+                    std::ofstream pnlFile(scenarioPnlPath);
+                    if (!pnlFile) {
+                        std::cerr << "Warning: Could not open " << scenarioPnlPath << " for writing." << std::endl;
+                    } else {
+                        pnlFile << std::setprecision(10) << "trade,instrument,type";
+                        for (const std::string& id : scenarioPnl.scenarioIds) pnlFile << ',' << id;
+                        pnlFile << '\n';
+                        for (size_t t = 0; t < portfolio.size(); ++t) {
+                            if (!portfolio[t]) continue;
+                            pnlFile << t << ',' << tradeResults[t].instrument << ',' << tradeResults[t].type;
+                            for (double value : scenarioPnl.pnl[t]) pnlFile << ',' << value;
+                            pnlFile << '\n';
+                        }
+                        std::cout << "Scenario P&L written to " << scenarioPnlPath << std::endl;
+                    }
+                }
+            }
         }
-        outputFile.close();
+        resultsSink->writeNotes(outputNotes.str());
+        resultsSink->close();
         std::cout << "\nProject execution finished." << std::endl;
 
     } catch (const std::exception& e) {
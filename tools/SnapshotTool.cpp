@@ -0,0 +1,152 @@
+// Builds and inspects binary snapshots (BinarySnapshot.h) from the text market/trade files.
+//
+// Build from the repository root, e.g.
+//
+//   g++ -std=c++17 -O2 -pthread -I. tools/SnapshotTool.cpp $(ls *.cpp | grep -v '^main.cpp$') -o snapshot_tool
+//
+// Usage:
+//   snapshot_tool build <out.snap> [--asof YYYY-MM-DD] [--curve file:NAME]... [--vol file:NAME]...
+//                       [--stocks file] [--bonds file] [--trades file]
+//   snapshot_tool info <in.snap>
+//
+// Without --curve/--vol, build reads the same files as the main program (curve.txt as USD-SOFR,
+// optional sgd_curve.txt as SGD-SORA, vol.txt as VOL_CURVE_DEFAULT, optional vol_appl.txt as
+// VOL_APPL, stockPrice.txt, bondPrice.txt, trade.txt). --asof defaults to today.
+// Run the main program with --snapshot <file> to value from the snapshot.
+
+#include <chrono>
+#include <ctime>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "BinarySnapshot.h"
+#include "Market.h"
+#include "TradeFactory.h"
+#include "TradeLoader.h"
+
+namespace {
+
+struct NamedFile {
+    std::string path;
+    std::string name;
+    bool optional;
+};
+
+NamedFile parseNamedFile(const std::string& spec) {
+    const size_t colon = spec.rfind(':');
+    if (colon == std::string::npos || colon == 0 || colon + 1 == spec.size()) {
+        throw std::invalid_argument("Expected file:NAME, got '" + spec + "'");
+    }
+    return NamedFile{spec.substr(0, colon), spec.substr(colon + 1), false};
+}
+
+Date today() {
+    std::time_t now = std::chrono::system_clock::to_time_t(std::chrono::system_clock::now());
+    std::tm localTime;
+#if defined(_WIN32) || defined(_WIN64)
+    localtime_s(&localTime, &now);
+#else
+    localtime_r(&now, &localTime);
+#endif
+    return Date(localTime.tm_year + 1900, localTime.tm_mon + 1, localTime.tm_mday);
+}
+
+int buildCommand(int argc, char** argv) {
+    if (argc < 3) throw std::invalid_argument("build needs an output file");
+    const std::string outPath = argv[2];
+    Date asOf = today();
+    std::vector<NamedFile> curves, vols;
+    std::string stocksPath = "stockPrice.txt";
+    std::string bondsPath = "bondPrice.txt";
+    std::string tradesPath = "trade.txt";
+    for (int i = 3; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (i + 1 >= argc) throw std::invalid_argument("Missing value for " + arg);
+        const std::string value = argv[++i];
+        if (arg == "--asof") asOf = Date(value);
+        else if (arg == "--curve") curves.push_back(parseNamedFile(value));
+        else if (arg == "--vol") vols.push_back(parseNamedFile(value));
+        else if (arg == "--stocks") stocksPath = value;
+        else if (arg == "--bonds") bondsPath = value;
+        else if (arg == "--trades") tradesPath = value;
+        else throw std::invalid_argument("Unknown argument: " + arg);
+    }
+    if (curves.empty()) {
+        curves = {{"curve.txt", "USD-SOFR", false}, {"sgd_curve.txt", "SGD-SORA", true}};
+    }
+    if (vols.empty()) {
+        vols = {{"vol.txt", "VOL_CURVE_DEFAULT", false}, {"vol_appl.txt", "VOL_APPL", true}};
+    }
+
+    Market market(asOf, "GlobalMarket");
+    for (const NamedFile& f : curves) {
+        if (!market.loadCurveDataFromFile(f.path, f.name, f.name) && !f.optional) {
+            std::cerr << "Warning: Failed to load curve " << f.name << " from " << f.path << "." << std::endl;
+        }
+    }
+    for (const NamedFile& f : vols) {
+        if (!market.loadVolDataFromFile(f.path, f.name, f.name) && !f.optional) {
+            std::cerr << "Warning: Failed to load vol curve " << f.name << " from " << f.path << "." << std::endl;
+        }
+    }
+    if (!market.loadStockPricesFromFile(stocksPath)) {
+        std::cerr << "Warning: Failed to load stock prices from " << stocksPath << "." << std::endl;
+    }
+    if (!market.loadBondPricesFromFile(bondsPath)) {
+        std::cerr << "Warning: Failed to load bond prices from " << bondsPath << "." << std::endl;
+    }
+
+    BondFactory bondFactory;
+    SwapFactory swapFactory;
+    EuropeanOptionFactory euroOptFactory;
+    AmericanOptionFactory amerOptFactory;
+    std::vector<TradeRecord> records;
+    ThreadPool pool;
+    // Records only: trades are rebuilt by whoever reads the snapshot.
+    parseTradeFile(tradesPath, &records, nullptr, bondFactory, swapFactory, euroOptFactory, amerOptFactory, &pool);
+
+    writeBinarySnapshot(outPath, market, records);
+    std::cout << "Wrote " << outPath << ": as of " << asOf.toString() << ", "
+              << market.getCurveNames().size() << " rate curve(s), " << market.getVolCurveNames().size()
+              << " vol curve(s), " << records.size() << " trade(s)." << std::endl;
+    return 0;
+}
+
+int infoCommand(int argc, char** argv) {
+    if (argc < 3) throw std::invalid_argument("info needs a snapshot file");
+    BinarySnapshotReader reader;
+    if (!reader.open(argv[2])) {
+        std::cerr << "Error: Could not open snapshot '" << argv[2] << "'." << std::endl;
+        return 1;
+    }
+    const Market market = reader.buildMarket();
+    std::cout << "Snapshot version " << kBinarySnapshotVersion << ", as of " << reader.getAsOf().toString()
+              << ", " << reader.getTradeCount() << " trade(s)" << std::endl;
+    for (const std::string& name : market.getCurveNames()) {
+        std::cout << "  rate curve " << name << ": " << market.getCurve(name)->getTenorDates().size() << " pillars" << std::endl;
+    }
+    for (const std::string& name : market.getVolCurveNames()) {
+        std::cout << "  vol curve  " << name << ": " << market.getVolCurve(name)->getTenors().size() << " pillars" << std::endl;
+    }
+    std::cout << "  " << market.getStockPrices().size() << " stock price(s), "
+              << market.getBondPrices().size() << " bond price(s)" << std::endl;
+    return 0;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    try {
+        const std::string command = (argc > 1) ? argv[1] : "";
+        if (command == "build") return buildCommand(argc, argv);
+        if (command == "info") return infoCommand(argc, argv);
+        std::cerr << "Usage: snapshot_tool build <out.snap> [options] | snapshot_tool info <in.snap>" << std::endl;
+        return 2;
+    } catch (const std::exception& e) {
+        std::cerr << "snapshot_tool: " << e.what() << std::endl;
+        return 1;
+    }
+}